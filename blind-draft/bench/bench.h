@@ -0,0 +1,44 @@
+#include <stdio.h>
+#include <stdint.h>
+#include "port_posix.h"
+
+#ifndef BENCH_H
+#define BENCH_H
+
+
+/* Minimal benchmark reporting. An operation is measured with MeasureOperation_ROS over several
+   rounds (each restoring the kernel state), and the mean cost per call over all rounds is printed
+   in cycles and nanoseconds */
+
+typedef struct
+{
+	/* Operation name, as printed */
+	const char * name;
+	/* Sum over the rounds of the mean cycles per call */
+	uint64_t cycles;
+	/* Sum over the rounds of the mean nanoseconds per call */
+	uint64_t ns;
+	/* Number of rounds measured */
+	uint32_t rounds;
+} BenchResult_ROS;
+
+/* Measure count calls of an operation, and add them to the result as one round */
+static inline void MeasureRound_ROS(BenchResult_ROS * result, void (*operation)(void), uint32_t count)
+{
+	uint64_t cycles, ns;
+
+	MeasureOperation_ROS(operation, count, &cycles, &ns);
+	result->cycles += cycles;
+	result->ns += ns;
+	result->rounds++;
+}
+
+/* Print the mean cost per call of a result */
+static inline void PrintResult_ROS(const BenchResult_ROS * result)
+{
+	uint32_t rounds = result->rounds ? result->rounds : 1u;
+
+	printf("%-32s %10llu cycles %10llu ns per op\n", result->name,
+		   (unsigned long long)(result->cycles / rounds), (unsigned long long)(result->ns / rounds));
+}
+#endif
@@ -0,0 +1,182 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: bench_isr_latency.c
+* Description   	: Harness measuring the latency from an interrupt handler's
+*					  PostISRTask_ROS to the start of the posted task. A POSIX
+*					  timer raises SIGUSR1 every 200 us (the simulated
+*					  interrupt), whose handler stamps the time and posts the
+*					  ISR task, while the main loop dispatches. Measured with the
+*					  dispatch loop idle, and with a background task that runs
+*					  for about 20 us at a time.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+#include "tasks.h"
+#include "bench.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+
+/* Number of posts measured per scenario, and the simulated interrupt period */
+#define BENCH_SAMPLES					2000u
+#define BENCH_POST_PERIOD_NS			200000l
+
+/* Run length of the background task, in nanoseconds */
+#define BENCH_BACKGROUND_NS				20000u
+
+/* Task table memory block */
+static uint8_t gBenchTaskMemory[16384];
+
+/* ISR task handle, and the timer raising the simulated interrupt */
+static TaskID_ROS gISRHandle;
+static timer_t gPostTimer;
+
+/* Time and cycle count stamped by the last simulated interrupt */
+static volatile uint64_t gPostNs;
+static volatile uint64_t gPostCycles;
+
+/* Latencies measured so far, and the sum of their cycle counts */
+static uint64_t gLatencyNs[BENCH_SAMPLES];
+static uint64_t gLatencyCycles;
+static volatile uint32_t gNumSamples;
+static volatile bool gStopBackground;
+
+/* Set while a post has not yet been served, so each measured post is alone */
+static volatile bool gPostPending;
+
+static uint32_t gFailures;
+
+/* Simulated interrupt handler */
+static void PostHandler(int signal_number)
+{
+	(void)signal_number;
+	if(gPostPending || (gNumSamples >= BENCH_SAMPLES))
+	{
+		return;
+	}
+	gPostPending = true;
+	gPostNs = ReadNanoseconds_ROS();
+	gPostCycles = ReadCycleCounter_ROS();
+	gFailures += (PostISRTask_ROS(gISRHandle) != SUCCESS_ROS);
+}
+
+/* ISR task: records the latency of the post that queued it */
+static void ISRTask(void)
+{
+	uint64_t now_cycles = ReadCycleCounter_ROS();
+	uint64_t now_ns = ReadNanoseconds_ROS();
+
+	gLatencyCycles += now_cycles - gPostCycles;
+	gLatencyNs[gNumSamples] = now_ns - gPostNs;
+	gNumSamples++;
+	gPostPending = false;
+}
+
+/* Background task: busy for BENCH_BACKGROUND_NS, then queues itself again */
+static void BackgroundTask(void)
+{
+	uint64_t start = ReadNanoseconds_ROS();
+
+	while((ReadNanoseconds_ROS() - start) < BENCH_BACKGROUND_NS)
+	{
+	}
+	if(!gStopBackground)
+	{
+		gFailures += (QueueTask_ROS(6u) != SUCCESS_ROS);
+	}
+}
+
+static int CompareLatency(const void * a, const void * b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Run one scenario, and print the latency distribution */
+static void BenchScenario(const char * name, bool background)
+{
+	struct itimerspec period = { { 0, BENCH_POST_PERIOD_NS }, { 0, BENCH_POST_PERIOD_NS } };
+	struct itimerspec stop = { { 0, 0 }, { 0, 0 } };
+	uint64_t sum = 0u;
+	uint32_t i;
+
+	gNumSamples = 0u;
+	gLatencyCycles = 0u;
+	gStopBackground = !background;
+	if(background)
+	{
+		gFailures += (QueueTask_ROS(6u) != SUCCESS_ROS);
+	}
+
+	gPostPending = false;
+	timer_settime(gPostTimer, 0, &period, NULL);
+	while(gNumSamples < BENCH_SAMPLES)
+	{
+		(void)DispatchTask_ROS();
+	}
+	timer_settime(gPostTimer, 0, &stop, NULL);
+
+	/* Let the background task finish its last run */
+	gStopBackground = true;
+	while(DispatchTask_ROS() == SUCCESS_ROS)
+	{
+	}
+
+	qsort(gLatencyNs, BENCH_SAMPLES, sizeof(gLatencyNs[0]), CompareLatency);
+	for(i = 0u; i < BENCH_SAMPLES; i++)
+	{
+		sum += gLatencyNs[i];
+	}
+	printf("%-32s mean %8llu ns (%llu cycles), min %llu, p99 %llu, max %llu ns\n", name,
+		   (unsigned long long)(sum / BENCH_SAMPLES),
+		   (unsigned long long)(gLatencyCycles / BENCH_SAMPLES),
+		   (unsigned long long)gLatencyNs[0],
+		   (unsigned long long)gLatencyNs[(BENCH_SAMPLES * 99u) / 100u],
+		   (unsigned long long)gLatencyNs[BENCH_SAMPLES - 1u]);
+}
+
+int main(void)
+{
+	struct sigaction action;
+	struct sigevent event;
+	uint32_t used;
+
+	gFailures += (MountTaskTables_ROS(gBenchTaskMemory, sizeof(gBenchTaskMemory), 4u, 16u, \
+									  &used) != SUCCESS_ROS);
+	gFailures += (CreateTask_ROS(5u, 200u, 50u, false, (uint8_t *)"isr", ISRTask) != SUCCESS_ROS);
+	gFailures += (CreateTask_ROS(6u, 10u, 50u, false, (uint8_t *)"background", BackgroundTask) != \
+				  SUCCESS_ROS);
+	gFailures += (CreateISRTask_ROS(5u, &gISRHandle) != SUCCESS_ROS);
+
+	action.sa_handler = PostHandler;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGUSR1, &action, NULL);
+
+	event.sigev_notify = SIGEV_SIGNAL;
+	event.sigev_signo = SIGUSR1;
+	event.sigev_value.sival_ptr = NULL;
+	if(timer_create(CLOCK_MONOTONIC, &event, &gPostTimer) != 0)
+	{
+		printf("bench_isr_latency: no POSIX timer\n");
+		return 1;
+	}
+
+	BenchScenario("post to dispatch, idle loop", false);
+	BenchScenario("post to dispatch, 20 us task", true);
+
+	if(gFailures != 0u)
+	{
+		printf("bench_isr_latency: %u calls failed\n", gFailures);
+		return 1;
+	}
+	return 0;
+}
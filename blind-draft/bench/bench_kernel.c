@@ -0,0 +1,168 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: bench_kernel.c
+* Description   	: Benchmark of the core kernel calls: task creation and
+*					  destruction, message creation, reading and deletion, and
+*					  the dispatch loop. Prints cycles and nanoseconds per call.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include "tasks.h"
+#include "messages.h"
+#include "bench.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define MIN_TASK_VECTOR_ROS				5u
+
+/* Number of tasks created and destroyed per round */
+#define BENCH_TASKS						200u
+
+/* Number of tasks the dispatch loop rotates through */
+#define BENCH_DISPATCH_TASKS			16u
+
+/* Number of messages created per round (a full message table, index 0 being
+   the null message), and the size of each */
+#define BENCH_MSGS						(MAX_MSGS_ROS - 1u)
+#define BENCH_MSG_BYTES					(MAX_MSG_STOR_BYTES_ROS / MAX_MSGS_ROS)
+
+/* Number of rounds of each benchmark, and of dispatches per round */
+#define BENCH_ROUNDS					200u
+#define BENCH_DISPATCHES				10000u
+
+/* Task table memory block and message store */
+static uint8_t gBenchTaskMemory[65536];
+static uint8_t gBenchMsgStore[MSG_FS_BLOCK_BYTES_ROS];
+
+/* Next task vector or message ID used by the measured operation, and the
+   number of calls that did not succeed */
+static uint32_t gNext;
+static uint32_t gFailures;
+
+static uint8_t gMsgData[BENCH_MSG_BYTES];
+
+static void EmptyTask(void) { }
+
+static void CreateTaskOp(void)
+{
+	gFailures += (CreateTask_ROS((TaskID_ROS)(MIN_TASK_VECTOR_ROS + gNext++), 10u, 50u, false, \
+								 (uint8_t *)"bench", EmptyTask) != SUCCESS_ROS);
+}
+
+static void DestroyTaskOp(void)
+{
+	gFailures += (DestroyTask_ROS((TaskID_ROS)(MIN_TASK_VECTOR_ROS + gNext++)) != SUCCESS_ROS);
+}
+
+static void CreateMessageOp(void)
+{
+	gFailures += (CreateMessage_ROS((MsgID_ROS)(MIN_MSG_ID_ROS + gNext++), MSG_TARG_GLOBAL_ROS, 0u, \
+									BENCH_MSG_BYTES, gMsgData) != SUCCESS_ROS);
+}
+
+static void ReadMessageOp(void)
+{
+	gFailures += (ReadMessage_ROS((MsgID_ROS)(MIN_MSG_ID_ROS + gNext++), BENCH_MSG_BYTES, \
+								  gMsgData) != SUCCESS_ROS);
+}
+
+static void DeleteMessageOp(void)
+{
+	gFailures += (DeleteMessage_ROS((MsgID_ROS)(MIN_MSG_ID_ROS + gNext++)) != SUCCESS_ROS);
+}
+
+static void DispatchOp(void)
+{
+	gFailures += (QueueTask_ROS((TaskID_ROS)(MIN_TASK_VECTOR_ROS + \
+											 (gNext++ % BENCH_DISPATCH_TASKS))) != SUCCESS_ROS);
+	gFailures += (DispatchTask_ROS() != SUCCESS_ROS);
+}
+
+/* Task creation and destruction, over a full set of BENCH_TASKS tasks */
+static void BenchTasks(void)
+{
+	BenchResult_ROS create = { "CreateTask_ROS", 0u, 0u, 0u };
+	BenchResult_ROS destroy = { "DestroyTask_ROS", 0u, 0u, 0u };
+	uint32_t round;
+
+	for(round = 0u; round < BENCH_ROUNDS; round++)
+	{
+		gNext = 0u;
+		MeasureRound_ROS(&create, CreateTaskOp, BENCH_TASKS);
+		gNext = 0u;
+		MeasureRound_ROS(&destroy, DestroyTaskOp, BENCH_TASKS);
+	}
+	PrintResult_ROS(&create);
+	PrintResult_ROS(&destroy);
+}
+
+/* Message creation, reading and deletion, over a full message table */
+static void BenchMessages(void)
+{
+	BenchResult_ROS create = { "CreateMessage_ROS", 0u, 0u, 0u };
+	BenchResult_ROS read = { "ReadMessage_ROS", 0u, 0u, 0u };
+	BenchResult_ROS delete = { "DeleteMessage_ROS", 0u, 0u, 0u };
+	uint32_t round;
+
+	for(round = 0u; round < BENCH_ROUNDS; round++)
+	{
+		gNext = 0u;
+		MeasureRound_ROS(&create, CreateMessageOp, BENCH_MSGS);
+		gNext = 0u;
+		MeasureRound_ROS(&read, ReadMessageOp, BENCH_MSGS);
+		gNext = 0u;
+		MeasureRound_ROS(&delete, DeleteMessageOp, BENCH_MSGS);
+	}
+	PrintResult_ROS(&create);
+	PrintResult_ROS(&read);
+	PrintResult_ROS(&delete);
+}
+
+/* Dispatch loop: queue one of BENCH_DISPATCH_TASKS tasks, and dispatch it */
+static void BenchDispatch(void)
+{
+	BenchResult_ROS dispatch = { "QueueTask_ROS + DispatchTask_ROS", 0u, 0u, 0u };
+	uint32_t round;
+
+	for(gNext = 0u; gNext < BENCH_DISPATCH_TASKS; gNext++)
+	{
+		gFailures += (CreateTask_ROS((TaskID_ROS)(MIN_TASK_VECTOR_ROS + gNext), \
+									 (uint8_t)(gNext * 16u), 50u, false, (uint8_t *)"bench", \
+									 EmptyTask) != SUCCESS_ROS);
+	}
+	for(round = 0u; round < BENCH_ROUNDS; round++)
+	{
+		gNext = 0u;
+		MeasureRound_ROS(&dispatch, DispatchOp, BENCH_DISPATCHES);
+	}
+	PrintResult_ROS(&dispatch);
+}
+
+int main(void)
+{
+	uint32_t used, failed_at;
+
+	if((MountTaskTables_ROS(gBenchTaskMemory, sizeof(gBenchTaskMemory), BENCH_TASKS, \
+							MIN_TASK_VECTOR_ROS + BENCH_TASKS, &used) != SUCCESS_ROS) || \
+	   (MountMessageFileSystem_ROS(gBenchMsgStore, sizeof(gBenchMsgStore), 0u, 0u, &failed_at, \
+								   NULL, MSG_MOUNT_TRUSTED_ROS) != SUCCESS_ROS))
+	{
+		printf("bench_kernel: mount failed\n");
+		return 1;
+	}
+
+	BenchTasks();
+	BenchMessages();
+	BenchDispatch();
+
+	if(gFailures != 0u)
+	{
+		printf("bench_kernel: %u calls failed\n", gFailures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,108 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: bench_msg_index.c
+* Description   	: Benchmark of the message ID index: the static memory it
+*					  takes, and the cost of a message lookup that hits (read of
+*					  a stored message) and misses (read of an absent ID). Built
+*					  once per index mode (dense array and hash index), see the
+*					  Makefile.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include "tasks.h"
+#include "messages.h"
+#include "bench.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define F_MSG_ID_EMPTY_ROS				0x26
+#if (ENABLE_MSG_ID_HASH_ROS)
+extern MsgID_ROS gMsgIDHashKeyArray_ROS[MSG_ID_HASH_SLOTS_ROS];
+extern uint8_t gMsgIDHashIndexArray_ROS[MSG_ID_HASH_SLOTS_ROS];
+extern MsgID_ROS gMsgIDArray_ROS[MAX_MSGS_ROS];
+#else
+extern uint8_t gMsgIndexArray_ROS[MAX_MSG_ID_ROS + 1u];
+#endif
+
+/* Number of messages stored (a full message table, index 0 being the null
+   message), their size, and the stride between their IDs */
+#define BENCH_MSGS						(MAX_MSGS_ROS - 1u)
+#define BENCH_MSG_BYTES					(MAX_MSG_STOR_BYTES_ROS / MAX_MSGS_ROS)
+#define BENCH_ID_STRIDE					7u
+
+/* Number of rounds, and of lookups per round */
+#define BENCH_ROUNDS					200u
+#define BENCH_LOOKUPS					(BENCH_MSGS * 100u)
+
+/* Message store */
+static uint8_t gBenchMsgStore[MSG_FS_BLOCK_BYTES_ROS];
+
+static uint8_t gMsgData[BENCH_MSG_BYTES];
+static uint32_t gNext;
+static uint32_t gFailures;
+
+/* ID of the n-th stored message, spread over the 8 bit ID range */
+#define BENCH_MSG_ID(n)					((MsgID_ROS)(MIN_MSG_ID_ROS + ((n) * BENCH_ID_STRIDE)))
+
+static void LookupHitOp(void)
+{
+	gFailures += (ReadMessage_ROS(BENCH_MSG_ID(gNext), BENCH_MSG_BYTES, gMsgData) != SUCCESS_ROS);
+	gNext = (gNext + 1u) % BENCH_MSGS;
+}
+
+static void LookupMissOp(void)
+{
+	gFailures += (ReadMessage_ROS(BENCH_MSG_ID(gNext) + 1u, BENCH_MSG_BYTES, gMsgData) != \
+				  F_MSG_ID_EMPTY_ROS);
+	gNext = (gNext + 1u) % BENCH_MSGS;
+}
+
+int main(void)
+{
+	BenchResult_ROS hit = { "lookup hit (ReadMessage_ROS)", 0u, 0u, 0u };
+	BenchResult_ROS miss = { "lookup miss (ReadMessage_ROS)", 0u, 0u, 0u };
+	uint32_t failed_at, round, i;
+
+	if(MountMessageFileSystem_ROS(gBenchMsgStore, sizeof(gBenchMsgStore), 0u, 0u, &failed_at, \
+								  NULL, MSG_MOUNT_TRUSTED_ROS) != SUCCESS_ROS)
+	{
+		printf("bench_msg_index: mount failed\n");
+		return 1;
+	}
+	for(i = 0u; i < BENCH_MSGS; i++)
+	{
+		gFailures += (CreateMessage_ROS(BENCH_MSG_ID(i), MSG_TARG_GLOBAL_ROS, 0u, BENCH_MSG_BYTES, \
+										gMsgData) != SUCCESS_ROS);
+	}
+
+#if (ENABLE_MSG_ID_HASH_ROS)
+	printf("hash index, %u bit IDs: %u bytes static (keys %u, indexes %u, full IDs %u); a dense "
+		   "array for these IDs would take %lu bytes\n", (unsigned)(sizeof(MsgID_ROS) * 8u),
+		   (unsigned)(sizeof(gMsgIDHashKeyArray_ROS) + sizeof(gMsgIDHashIndexArray_ROS) + \
+					  sizeof(gMsgIDArray_ROS)),
+		   (unsigned)sizeof(gMsgIDHashKeyArray_ROS), (unsigned)sizeof(gMsgIDHashIndexArray_ROS),
+		   (unsigned)sizeof(gMsgIDArray_ROS), (unsigned long)MAX_MSG_ID_ROS + 1ul);
+#else
+	printf("dense array, %u bit IDs: %u bytes static\n", (unsigned)(sizeof(MsgID_ROS) * 8u),
+		   (unsigned)sizeof(gMsgIndexArray_ROS));
+#endif
+
+	for(round = 0u; round < BENCH_ROUNDS; round++)
+	{
+		MeasureRound_ROS(&hit, LookupHitOp, BENCH_LOOKUPS);
+		MeasureRound_ROS(&miss, LookupMissOp, BENCH_LOOKUPS);
+	}
+	PrintResult_ROS(&hit);
+	PrintResult_ROS(&miss);
+
+	if(gFailures != 0u)
+	{
+		printf("bench_msg_index: %u calls failed\n", gFailures);
+		return 1;
+	}
+	return 0;
+}
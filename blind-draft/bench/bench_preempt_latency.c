@@ -0,0 +1,176 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: bench_preempt_latency.c
+* Description   	: Harness measuring the preemptive kernel mode
+*					  (ENABLE_PREEMPTIVE_KERNEL_ROS). Times a queue and dispatch
+*					  of an empty task with its context reused, as the kernel
+*					  does, and rebuilt on every dispatch. Then measures the
+*					  latency from the simulated tick (1 ms) to the start of a
+*					  task released every tick, with the dispatch loop idle, and
+*					  while a low priority task runs for 3 ms at a time, which
+*					  the released task must preempt.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <stdlib.h>
+#include "tasks.h"
+#include "bench.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+extern TaskContext_ROS * gTaskContextArray_ROS;
+
+/* Number of rounds of the dispatch benchmark, and of dispatches per round */
+#define BENCH_ROUNDS					50u
+#define BENCH_DISPATCHES				2000u
+
+/* Number of releases measured per scenario, the tick period, and the run
+   length of the background task */
+#define BENCH_SAMPLES					500u
+#define BENCH_TICK_US					1000u
+#define BENCH_BACKGROUND_NS				3000000u
+
+/* Task table memory block, large enough for the task stacks */
+static uint8_t gBenchTaskMemory[131072];
+
+/* Latencies measured so far */
+static uint64_t gLatencyNs[BENCH_SAMPLES];
+static volatile uint32_t gNumSamples;
+static volatile bool gStopBackground;
+
+static uint32_t gFailures;
+
+/* Empty task, dispatched by the dispatch benchmark */
+static void EmptyTask(void)
+{
+}
+
+/* Released task: records the latency from the tick that released it */
+static void ReleasedTask(void)
+{
+	uint64_t latency = ReadTickLatency_ROS();
+
+	if(gNumSamples < BENCH_SAMPLES)
+	{
+		gLatencyNs[gNumSamples++] = latency;
+	}
+}
+
+/* Background task: busy for BENCH_BACKGROUND_NS, then queues itself again */
+static void BackgroundTask(void)
+{
+	uint64_t start = ReadNanoseconds_ROS();
+
+	while((ReadNanoseconds_ROS() - start) < BENCH_BACKGROUND_NS)
+	{
+	}
+	if(!gStopBackground)
+	{
+		gFailures += (KERNEL_CALL_ROS(QueueTask_ROS(6u)) != SUCCESS_ROS);
+	}
+}
+
+/* Queue and dispatch the empty task, reusing its context */
+static void OpDispatchReused(void)
+{
+	gFailures += (QueueTask_ROS(7u) != SUCCESS_ROS);
+	gFailures += (DispatchTask_ROS() != SUCCESS_ROS);
+}
+
+/* Queue and dispatch the empty task, dropping its context first so it is
+   rebuilt */
+static void OpDispatchRebuilt(void)
+{
+	gTaskContextArray_ROS[gTaskVectorLookupArray_ROS[7u]] = 0;
+	OpDispatchReused();
+}
+
+static int CompareLatency(const void * a, const void * b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Run one scenario, and print the latency distribution */
+static void BenchScenario(const char * name, bool background)
+{
+	uint64_t sum = 0u;
+	uint32_t i;
+
+	gNumSamples = 0u;
+	gStopBackground = !background;
+	if(background)
+	{
+		gFailures += (QueueTask_ROS(6u) != SUCCESS_ROS);
+	}
+
+	while(gNumSamples < BENCH_SAMPLES)
+	{
+		(void)ServiceSimulatedTick_ROS();
+		(void)DispatchTask_ROS();
+	}
+
+	/* Let the background task finish its last run */
+	gStopBackground = true;
+	while(DispatchTask_ROS() == SUCCESS_ROS)
+	{
+	}
+
+	qsort(gLatencyNs, BENCH_SAMPLES, sizeof(gLatencyNs[0]), CompareLatency);
+	for(i = 0u; i < BENCH_SAMPLES; i++)
+	{
+		sum += gLatencyNs[i];
+	}
+	printf("%-32s mean %8llu ns, min %llu, p99 %llu, max %llu ns\n", name,
+		   (unsigned long long)(sum / BENCH_SAMPLES),
+		   (unsigned long long)gLatencyNs[0],
+		   (unsigned long long)gLatencyNs[(BENCH_SAMPLES * 99u) / 100u],
+		   (unsigned long long)gLatencyNs[BENCH_SAMPLES - 1u]);
+}
+
+int main(void)
+{
+	BenchResult_ROS reused = { "dispatch, context reused", 0u, 0u, 0u };
+	BenchResult_ROS rebuilt = { "dispatch, context rebuilt", 0u, 0u, 0u };
+	uint32_t used, round;
+
+	gFailures += (MountTaskTables_ROS(gBenchTaskMemory, sizeof(gBenchTaskMemory), 4u, 16u, \
+									  &used) != SUCCESS_ROS);
+	gFailures += (CreateTask_ROS(5u, 200u, 50u, false, (uint8_t *)"released", ReleasedTask) != \
+				  SUCCESS_ROS);
+	gFailures += (CreateTask_ROS(6u, 10u, 50u, false, (uint8_t *)"background", BackgroundTask) != \
+				  SUCCESS_ROS);
+	gFailures += (CreateTask_ROS(7u, 100u, 50u, false, (uint8_t *)"empty", EmptyTask) != \
+				  SUCCESS_ROS);
+
+	for(round = 0u; round < BENCH_ROUNDS; round++)
+	{
+		MeasureRound_ROS(&reused, OpDispatchReused, BENCH_DISPATCHES);
+		MeasureRound_ROS(&rebuilt, OpDispatchRebuilt, BENCH_DISPATCHES);
+	}
+	PrintResult_ROS(&reused);
+	PrintResult_ROS(&rebuilt);
+
+	/* Release the measured task every tick */
+	gFailures += (CreatePeriodicTask_ROS(5u, 1u, 1u) != SUCCESS_ROS);
+	if(StartSimulatedTick_ROS(BENCH_TICK_US) != SUCCESS_ROS)
+	{
+		printf("bench_preempt_latency: no simulated tick\n");
+		return 1;
+	}
+	BenchScenario("tick to task, idle loop", false);
+	BenchScenario("tick to task, preempting 3 ms", true);
+	(void)StopSimulatedTick_ROS();
+
+	if(gFailures != 0u)
+	{
+		printf("bench_preempt_latency: %u calls failed\n", gFailures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: bench_ready_queue.c
+* Description   	: Benchmark of the dispatch cost of the ready lists (priority
+*					  bitmap and per level lists) against a linear task queue
+*					  scanned for the highest priority on every dispatch, at 16,
+*					  64 and 250 queued tasks.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <string.h>
+#include "tasks.h"
+#include "bench.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define MIN_TASK_VECTOR_ROS				5u
+
+/* Largest number of queued tasks measured */
+#define BENCH_MAX_TASKS					250u
+
+/* Number of rounds, and of dispatches per round */
+#define BENCH_ROUNDS					50u
+#define BENCH_DISPATCHES				10000u
+
+/* Task table memory block */
+static uint8_t gBenchTaskMemory[131072];
+
+/* Linear queue: task IDs in queuing order, scanned on every dispatch */
+static TaskID_ROS gLinearQueue[BENCH_MAX_TASKS];
+static uint32_t gLinearLength;
+static TaskID_ROS gLinearRunning;
+
+static uint32_t gFailures;
+
+/* Each task queues itself again, so every dispatch sees the same queue depth */
+static void RequeueSelf(void)
+{
+	gFailures += (QueueTask_ROS(TASK_VECTOR_ROS(RUNNING_TASK_ID_ROS)) != SUCCESS_ROS);
+}
+
+static void LinearRequeueSelf(void)
+{
+	gLinearQueue[gLinearLength++] = gLinearRunning;
+}
+
+static void ReadyListDispatchOp(void)
+{
+	gFailures += (DispatchTask_ROS() != SUCCESS_ROS);
+}
+
+/* Dispatch from the linear queue: the oldest task of the highest priority */
+static void LinearDispatchOp(void)
+{
+	uint32_t i, best = 0u;
+
+	for(i = 1u; i < gLinearLength; i++)
+	{
+		if(TASK_PRIORITY_ROS(gLinearQueue[i]) > TASK_PRIORITY_ROS(gLinearQueue[best]))
+		{
+			best = i;
+		}
+	}
+	gLinearRunning = gLinearQueue[best];
+	gLinearLength--;
+	memmove(&gLinearQueue[best], &gLinearQueue[best + 1u], (gLinearLength - best) * sizeof(TaskID_ROS));
+	LinearRequeueSelf();
+}
+
+/* Create and queue num_tasks tasks with spread priorities, and measure both queues */
+static void BenchQueueDepth(uint32_t num_tasks, const char * ready_name, const char * linear_name)
+{
+	BenchResult_ROS ready = { ready_name, 0u, 0u, 0u };
+	BenchResult_ROS linear = { linear_name, 0u, 0u, 0u };
+	uint32_t used, i, round, seed = 12345u;
+
+	gFailures += (MountTaskTables_ROS(gBenchTaskMemory, sizeof(gBenchTaskMemory), \
+									  (TaskID_ROS)num_tasks, \
+									  (TaskID_ROS)(MIN_TASK_VECTOR_ROS + num_tasks), \
+									  &used) != SUCCESS_ROS);
+	gLinearLength = 0u;
+	for(i = 0u; i < num_tasks; i++)
+	{
+		TaskID_ROS vector = (TaskID_ROS)(MIN_TASK_VECTOR_ROS + i);
+
+		seed = (seed * 1103515245u) + 12345u;
+		gFailures += (CreateTask_ROS(vector, (uint8_t)(seed >> 16), 50u, false, \
+									 (uint8_t *)"bench", RequeueSelf) != SUCCESS_ROS);
+		gFailures += (QueueTask_ROS(vector) != SUCCESS_ROS);
+		gLinearQueue[gLinearLength++] = gTaskVectorLookupArray_ROS[vector];
+	}
+
+	for(round = 0u; round < BENCH_ROUNDS; round++)
+	{
+		MeasureRound_ROS(&ready, ReadyListDispatchOp, BENCH_DISPATCHES);
+		MeasureRound_ROS(&linear, LinearDispatchOp, BENCH_DISPATCHES);
+	}
+	PrintResult_ROS(&ready);
+	PrintResult_ROS(&linear);
+}
+
+int main(void)
+{
+	BenchQueueDepth(16u, "ready lists, 16 tasks", "linear queue, 16 tasks");
+	BenchQueueDepth(64u, "ready lists, 64 tasks", "linear queue, 64 tasks");
+	BenchQueueDepth(250u, "ready lists, 250 tasks", "linear queue, 250 tasks");
+
+	if(gFailures != 0u)
+	{
+		printf("bench_ready_queue: %u calls failed\n", gFailures);
+		return 1;
+	}
+	return 0;
+}
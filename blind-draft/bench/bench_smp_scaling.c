@@ -0,0 +1,133 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: bench_smp_scaling.c
+* Description   	: Harness measuring how dispatch throughput scales with the
+*					  number of simulated cores in SMP mode (ENABLE_SMP_ROS). A
+*					  fixed number of short task runs (about 2 us of work each,
+*					  each task queuing itself again) is spread over 1 to 4
+*					  core threads, and the time per run and speedup over one
+*					  core are printed. Scaling is bounded by the host's own
+*					  processor count.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include "tasks.h"
+#include "bench.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define MIN_TASK_VECTOR_ROS				5u
+
+/* Number of tasks, task runs measured per core count, and the work done by
+   each run */
+#define BENCH_TASKS						32u
+#define BENCH_RUNS						40000u
+#define BENCH_RUN_NS					2000u
+
+/* Task table memory block */
+static uint8_t gBenchTaskMemory[16384];
+
+/* Runs completed, and the time the last measured run completed */
+static volatile uint32_t gRunsDone;
+static volatile uint64_t gEndNs;
+
+static uint32_t gFailures;
+
+/* Work task: busy for BENCH_RUN_NS, then queues itself again until every
+   measured run is done */
+static void WorkTask(void)
+{
+	uint64_t start = ReadNanoseconds_ROS();
+	uint32_t done;
+
+	while((ReadNanoseconds_ROS() - start) < BENCH_RUN_NS)
+	{
+	}
+	done = __atomic_add_fetch(&gRunsDone, 1u, __ATOMIC_ACQ_REL);
+	if(done == BENCH_RUNS)
+	{
+		gEndNs = ReadNanoseconds_ROS();
+	}
+	if(done < BENCH_RUNS)
+	{
+		if(KERNEL_CALL_ROS(QueueTask_ROS(TASK_VECTOR_ROS(RUNNING_TASK_ID_ROS))) != SUCCESS_ROS)
+		{
+			__atomic_add_fetch(&gFailures, 1u, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+/* Core loop: dispatch until every measured run is done */
+static void CoreLoop(void)
+{
+	while(__atomic_load_n(&gRunsDone, __ATOMIC_ACQUIRE) < BENCH_RUNS)
+	{
+		(void)DispatchTask_ROS();
+	}
+}
+
+/* Run the measured task runs on num_cores cores, and return the time taken in
+   nanoseconds */
+static uint64_t BenchCores(uint8_t num_cores)
+{
+	uint64_t start;
+	TaskID_ROS vector;
+
+	gRunsDone = 0u;
+	for(vector = MIN_TASK_VECTOR_ROS; vector < (MIN_TASK_VECTOR_ROS + BENCH_TASKS); vector++)
+	{
+		gFailures += (QueueTask_ROS(vector) != SUCCESS_ROS);
+	}
+
+	start = ReadNanoseconds_ROS();
+	if(StartSimulatedCores_ROS(num_cores, CoreLoop) != SUCCESS_ROS)
+	{
+		gFailures++;
+		return 1u;
+	}
+	JoinSimulatedCores_ROS();
+
+	/* Run what is still queued, so the next round starts empty */
+	while(DispatchTask_ROS() == SUCCESS_ROS)
+	{
+	}
+	return gEndNs - start;
+}
+
+int main(void)
+{
+	uint64_t ns, one_core_ns = 0u;
+	uint32_t used;
+	TaskID_ROS vector;
+	uint8_t num_cores;
+
+	gFailures += (MountTaskTables_ROS(gBenchTaskMemory, sizeof(gBenchTaskMemory), BENCH_TASKS, \
+									  MIN_TASK_VECTOR_ROS + BENCH_TASKS, &used) != SUCCESS_ROS);
+	for(vector = MIN_TASK_VECTOR_ROS; vector < (MIN_TASK_VECTOR_ROS + BENCH_TASKS); vector++)
+	{
+		gFailures += (CreateTask_ROS(vector, 10u, 50u, false, (uint8_t *)"work", WorkTask) != \
+					  SUCCESS_ROS);
+	}
+
+	for(num_cores = 1u; num_cores <= NUM_CORES_ROS; num_cores++)
+	{
+		ns = BenchCores(num_cores);
+		if(num_cores == 1u)
+		{
+			one_core_ns = ns;
+		}
+		printf("%u task runs on %u cores          %10llu ns per run, speedup %5.2f\n", BENCH_RUNS,
+			   num_cores, (unsigned long long)(ns / BENCH_RUNS), (double)one_core_ns / (double)ns);
+	}
+
+	if(gFailures != 0u)
+	{
+		printf("bench_smp_scaling: %u calls failed\n", gFailures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,88 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: bench_tcb_layout.c
+* Description   	: Benchmark of the dispatch loop under the task control block
+*					  layout it is built with (ENABLE_PACKED_TCB_ROS: packed hot
+*					  and cold blocks, or one array per field). Built once per
+*					  layout, see the Makefile.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include "tasks.h"
+#include "bench.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define MIN_TASK_VECTOR_ROS				5u
+
+/* Number of rounds, and of dispatches per round */
+#define BENCH_ROUNDS					100u
+#define BENCH_DISPATCHES				10000u
+
+/* Task table memory block */
+static uint8_t gBenchTaskMemory[131072];
+
+static uint32_t gFailures;
+
+/* Each task queues itself again, so every dispatch sees the same queue depth */
+static void RequeueSelf(void)
+{
+	gFailures += (QueueTask_ROS(TASK_VECTOR_ROS(RUNNING_TASK_ID_ROS)) != SUCCESS_ROS);
+}
+
+static void DispatchOp(void)
+{
+	gFailures += (DispatchTask_ROS() != SUCCESS_ROS);
+}
+
+/* Create and queue num_tasks tasks with spread priorities, and measure the
+   dispatch loop */
+static void BenchDispatchLoop(uint32_t num_tasks, const char * name)
+{
+	BenchResult_ROS dispatch = { name, 0u, 0u, 0u };
+	uint32_t used, i, round, seed = 12345u;
+
+	gFailures += (MountTaskTables_ROS(gBenchTaskMemory, sizeof(gBenchTaskMemory), \
+									  (TaskID_ROS)num_tasks, \
+									  (TaskID_ROS)(MIN_TASK_VECTOR_ROS + num_tasks), \
+									  &used) != SUCCESS_ROS);
+	for(i = 0u; i < num_tasks; i++)
+	{
+		TaskID_ROS vector = (TaskID_ROS)(MIN_TASK_VECTOR_ROS + i);
+
+		seed = (seed * 1103515245u) + 12345u;
+		gFailures += (CreateTask_ROS(vector, (uint8_t)(seed >> 16), 50u, false, \
+									 (uint8_t *)"bench", RequeueSelf) != SUCCESS_ROS);
+		gFailures += (QueueTask_ROS(vector) != SUCCESS_ROS);
+	}
+
+	for(round = 0u; round < BENCH_ROUNDS; round++)
+	{
+		MeasureRound_ROS(&dispatch, DispatchOp, BENCH_DISPATCHES);
+	}
+	PrintResult_ROS(&dispatch);
+}
+
+int main(void)
+{
+#if (ENABLE_PACKED_TCB_ROS)
+	printf("packed task control blocks: %u byte hot block, %u byte cold block\n",
+		   (unsigned)sizeof(TaskHotTCB_ROS), (unsigned)sizeof(TaskColdTCB_ROS));
+#else
+	printf("one array per task control block field\n");
+#endif
+	BenchDispatchLoop(16u, "dispatch loop, 16 tasks");
+	BenchDispatchLoop(64u, "dispatch loop, 64 tasks");
+	BenchDispatchLoop(250u, "dispatch loop, 250 tasks");
+
+	if(gFailures != 0u)
+	{
+		printf("bench_tcb_layout: %u calls failed\n", gFailures);
+		return 1;
+	}
+	return 0;
+}
@@ -14,21 +14,64 @@
 ***************************************************************************************************/
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include "messages.h"
+#include "tasks.h"
+
+/***************************************************************************************************
+* Imported Functions
+***************************************************************************************************/
+/* Queue task function (schedule.c) */
+extern uint8_t QueueTask_ROS(TaskID_ROS);
+
+/***************************************************************************************************
+* Local Macros
+***************************************************************************************************/
+#if (ENABLE_SMP_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+/* Takes the kernel lock for the rest of the calling function, releasing it on every return. In
+   SMP mode each message API function holds the lock itself, so the message store is safe to share
+   between cores even when a call is not wrapped in KERNEL_CALL_ROS (the lock is nestable). The
+   lock-free store needs no lock */
+#define LOCK_MSG_API_ROS() \
+		uint8_t msg_api_lock __attribute__((cleanup(_UnlockMsgAPI_ROS))) = _LockMsgAPI_ROS()
+#else
+#define LOCK_MSG_API_ROS()
+#endif
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+/* Owns the lock-free store for the rest of the calling function, settling it on entry and on
+   every return (see SettleMessageStore_ROS). Functions that walk the inboxes, wait lists, holes,
+   topics or expiry heap own the store, which the lock-free functions never touch. In SMP mode the
+   kernel lock is taken first */
+#define OWN_MSG_STORE_ROS() \
+		uint8_t msg_store_owner __attribute__((cleanup(_DisownMsgStore_ROS))) = _OwnMsgStore_ROS()
+#else
+#define OWN_MSG_STORE_ROS()
+#endif
 
 /***************************************************************************************************
 * Global Variables
 ***************************************************************************************************/
-/* Message data storage array */
-uint8_t gMsgStorArray_ROS[MAX_MSG_STOR_BYTES_ROS];
 /* Message packet table */
-uint8_t gMsgTOC_ROS[MAX_MSGS_ROS][MAX_MSG_ATTR_ROS];
+MsgField_ROS gMsgTOC_ROS[MAX_MSGS_ROS][MAX_MSG_ATTR_ROS];
 /* Deleted message packet table */
-uint8_t gMsgDTOC_ROS[MAX_DEL_MSGS_ROS][MAX_DEL_MSG_ATTR_ROS];
+MsgField_ROS gMsgDTOC_ROS[MAX_DEL_MSGS_ROS][MAX_DEL_MSG_ATTR_ROS];
+#if (ENABLE_MSG_ID_HASH_ROS)
+#if !(ENABLE_LOCK_FREE_MSGS_ROS)
+/* Message ID hash index keys, valid where the matching index slot is not null */
+MsgID_ROS gMsgIDHashKeyArray_ROS[MSG_ID_HASH_SLOTS_ROS];
+/* Message ID hash index values (message table index, null = empty slot) */
+uint8_t gMsgIDHashIndexArray_ROS[MSG_ID_HASH_SLOTS_ROS];
+#endif
+/* Full width ID of each message, indexed by message index (gMsgTOC_ROS only holds the low byte).
+   The lock-free store finds IDs by scanning it */
+MsgID_ROS gMsgIDArray_ROS[MAX_MSGS_ROS];
+#else
 /* Message ID lookup table */
-uint8_t gMsgIndexArray_ROS[MAX_MSG_ID_ROS];
+uint8_t gMsgIndexArray_ROS[MAX_MSG_ID_ROS + 1u];
+#endif
 /* Next free message location global variable */
-uint8_t gNextFreeMsgLoc_ROS = 1u;
+MsgLoc_ROS gNextFreeMsgLoc_ROS = 1u;
 /* Next free message index number */
 uint8_t gNextFreeMsgIndex_ROS = 1u;
 /* Number of messages global variable */
@@ -36,699 +79,6682 @@ uint8_t gNumMsg_ROS = 0u;
 /* Total number of deleted messages */
 uint8_t gNumDelMsg_ROS = 0u;
 /* Total number of deleted bytes */
-uint8_t gNumDelBytes_ROS = 0u;
+MsgLoc_ROS gNumDelBytes_ROS = 0u;
+/* First deleted message entry (hole) in each size class, valid only when the class's bit is set
+   in gMsgHoleClassBitmap_ROS. Class n holds holes of 2^n to 2^(n+1)-1 bytes */
+uint8_t gMsgHoleClassHead_ROS[NUM_MSG_SIZE_CLASSES_ROS];
+/* Bitmap of size classes holding at least one hole (bit n = class n) */
+MsgLoc_ROS gMsgHoleClassBitmap_ROS = 0u;
+/* Stack of message table indexes released by deleted messages */
+uint8_t gMsgFreeIndexArray_ROS[MAX_MSGS_ROS];
+/* Number of message table indexes on the free index stack */
+uint8_t gNumFreeMsgIndex_ROS = 0u;
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+/* Slot word of each message table index: state, pin count and version (see messages.h). The pin
+   count is the number of outstanding borrows and reads, plus one while the message is written. A
+   pinned message cannot be moved by the defragmenter or deleted */
+uint32_t gMsgSlotArray_ROS[MAX_MSGS_ROS];
+/* Settled (delivered to its inbox and written through to the backend) status of each message,
+   indexed by message index */
+bool gMsgSettledArray_ROS[MAX_MSGS_ROS];
+/* Stack of message indexes waiting to be settled, pushed with compare and swap and taken whole.
+   Each index is on it at most once (while its pending status is set) */
+uint8_t gMsgSettleHead_ROS = NULL_MSG_ROS;
+uint8_t gMsgSettleNextArray_ROS[MAX_MSGS_ROS];
+bool gMsgSettlePendingArray_ROS[MAX_MSGS_ROS];
+/* Store owner status, true while a function owns the store (see OWN_MSG_STORE_ROS) */
+bool gMsgStoreOwned_ROS = false;
+/* Status of deleted messages whose space could not be released, retried by the next settle */
+bool gMsgSettleRetry_ROS = false;
+/* Result of the settles since SettleMessageStore_ROS or FlushMessageStorage_ROS last reported it
+   (F_MSG_STORAGE_FAILED_ROS once a backend write fails) */
+uint8_t gMsgSettleResult_ROS = SUCCESS_ROS;
+#else
+/* Number of outstanding borrows and reservations of each message, indexed by message index. A
+   pinned message cannot be moved by the defragmenter or deleted */
+uint8_t gMsgPinCountArray_ROS[MAX_MSGS_ROS];
+#endif
+/* Reserved (written in place, not yet committed) status of each message, indexed by message index */
+bool gMsgReservedArray_ROS[MAX_MSGS_ROS];
+/* Oldest and newest committed message index addressed to each target vector (null = empty inbox).
+   Inbox order is threaded through gMsgTOC_ROS by MSG_INBOX_NEXT_ROS and MSG_INBOX_PREV_ROS */
+uint8_t gMsgInboxHeadArray_ROS[NUM_MSG_INBOXES_ROS];
+uint8_t gMsgInboxTailArray_ROS[NUM_MSG_INBOXES_ROS];
+/* Status of each target vector's task waiting for a message (queued when one arrives) */
+bool gMsgInboxWaitArray_ROS[NUM_MSG_INBOXES_ROS];
+/* Wait started by each target vector's task with WaitForMessage_ROS: its state (see messages.h),
+   the message ID waited for (MSG_WAIT_INBOX_ROS = any message in the inbox), the task vector lent
+   the task's priority meanwhile (MSG_TARG_GLOBAL_ROS = none), and whether a timeout is armed */
+uint8_t gMsgWaitStateArray_ROS[NUM_MSG_INBOXES_ROS];
+MsgID_ROS gMsgWaitIDArray_ROS[NUM_MSG_INBOXES_ROS];
+uint8_t gMsgWaitServerArray_ROS[NUM_MSG_INBOXES_ROS];
+bool gMsgWaitTimedArray_ROS[NUM_MSG_INBOXES_ROS];
+/* First task vector waiting in each wait list (ID modulo NUM_MSG_WAIT_BUCKETS_ROS). A list holds
+   the first waiter of each ID in it, threaded through gMsgWaitGroupArray_ROS, and each ID's other
+   waiters follow it in arrival order, threaded through gMsgWaitNextArray_ROS (null = last) */
+uint8_t gMsgWaitHeadArray_ROS[NUM_MSG_WAIT_BUCKETS_ROS];
+uint8_t gMsgWaitGroupArray_ROS[NUM_MSG_INBOXES_ROS];
+uint8_t gMsgWaitNextArray_ROS[NUM_MSG_INBOXES_ROS];
+#if (ENABLE_MSG_TOPICS_ROS)
+/* Subscriber task vectors of each topic, indexed by topic then subscriber slot (null = free) */
+uint8_t gMsgTopicSubscriberArray_ROS[NUM_MSG_TOPICS_ROS + 1u][MAX_TOPIC_SUBSCRIBERS_ROS];
+/* Oldest and newest live message published to each topic (null = none) */
+uint8_t gMsgTopicHeadArray_ROS[NUM_MSG_TOPICS_ROS + 1u];
+uint8_t gMsgTopicTailArray_ROS[NUM_MSG_TOPICS_ROS + 1u];
+/* Topic each message was published to (null = not published), indexed by message index */
+uint8_t gMsgTopicArray_ROS[MAX_MSGS_ROS];
+/* Subscriber slots that have not yet taken each published message (bit n = slot n), indexed by
+   message index. With the pin count this is the message's reference count: the single copy is
+   deleted once the mask is clear and the last taker has released it */
+uint8_t gMsgUnreadMaskArray_ROS[MAX_MSGS_ROS];
+#endif
+#if (ENABLE_MSG_EXPIRY_ROS)
+/* Message expiry clock, advanced once per call to TickMessageExpiry_ROS */
+uint32_t gMsgExpiryTick_ROS = 0u;
+/* Expiry tick of each message with a time to live, indexed by message index */
+uint32_t gMsgExpiryTickArray_ROS[MAX_MSGS_ROS];
+/* Min-heap of message indexes ordered by expiry tick, stored from element 1 (the root) so that
+   the parent of element n is n / 2 */
+uint8_t gMsgExpiryHeap_ROS[MAX_MSGS_ROS];
+/* Heap element holding each message, indexed by message index (NULL_HEAP_POS_ROS = no expiry) */
+uint8_t gMsgExpiryHeapPosArray_ROS[MAX_MSGS_ROS];
+/* Number of messages in the expiry heap */
+uint8_t gNumExpiryMsg_ROS = 0u;
+#endif
 
 uint8_t * gMsgFileSysPtr_ROS;
 
 uint32_t gMsgFileSysMaxBytes_ROS = 0;
 
+/* Storage backend the store image is written through to (null = image only) */
+MsgStorageBackend_ROS * gMsgStorageBackend_ROS = 0;
+
 
 bool gMsgFileSysMounted_R0S = false;
 
 /***************************************************************************************************
 * Local Function Prototypes
 ***************************************************************************************************/
+#if (ENABLE_SMP_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+/* Take and release the kernel lock for a message API function */
+uint8_t _LockMsgAPI_ROS(void);
+void _UnlockMsgAPI_ROS(uint8_t *);
+#endif
 /* Check message owner function */
 uint8_t _IsMessageOwner_ROS(uint8_t);
 /* Check message ID is valid function */
-uint8_t _IsMessageIDValid_ROS(uint8_t);
+uint8_t _IsMessageIDValid_ROS(MsgID_ROS);
 /* Check message ID is empty function */
-uint8_t _IsMessageIDEmpty_ROS(uint8_t);
+uint8_t _IsMessageIDEmpty_ROS(MsgID_ROS);
 /* Check message size is valid function */
-uint8_t _IsMessageSizeValid_ROS(uint8_t);
+uint8_t _IsMessageSizeValid_ROS(MsgSize_ROS);
 /* Find a space for a new message function */
-uint8_t _FindMsgSpace_ROS(uint8_t, uint8_t *, uint8_t *, bool *, uint8_t *);
+uint8_t _FindMsgSpace_ROS(MsgSize_ROS, MsgLoc_ROS *, uint8_t *, bool *, uint8_t *);
+/* Allocate message table entry and space function */
+uint8_t _AllocateMessage_ROS(MsgID_ROS, uint8_t, uint8_t, MsgSize_ROS);
+/* Enter message into the tables and claim its space function */
+uint8_t _PlaceMessage_ROS(MsgID_ROS, uint8_t, uint8_t, MsgSize_ROS, MsgLoc_ROS, uint8_t, bool, uint8_t);
+/* Claim found message space and index function */
+void _ClaimMsgSpace_ROS(MsgSize_ROS, bool, uint8_t);
+/* Total size of a (chained) message function */
+MsgSize_ROS _MsgTotalSize_ROS(uint8_t);
+/* Copy message data out of / into a (chained) message's segments functions */
+void _GatherMessageData_ROS(uint8_t, uint8_t *, MsgSize_ROS);
+uint8_t _ScatterMessageData_ROS(uint8_t, uint8_t *);
 /* Erase message table entry function */
 void _EraseMsgEntry_ROS(uint8_t);
 /* Erase delete message table entry function */
 void _EraseDelMsgEntry_ROS(uint8_t);
+/* Message size class function */
+uint8_t _MsgSizeClass_ROS(MsgSize_ROS);
+/* File hole in its size class list function */
+void _FileMsgHole_ROS(uint8_t);
+/* Remove hole from its size class list function */
+void _UnfileMsgHole_ROS(uint8_t);
+/* Allocate message space from a hole function */
+void _TakeMsgHoleSpace_ROS(uint8_t, MsgSize_ROS);
+/* Return message space to the free space function */
+uint8_t _ReleaseMsgSpace_ROS(MsgLoc_ROS, MsgSize_ROS);
+/* Single defragmentation step function */
+uint8_t _DefragStep_ROS(void);
+/* Delete message by index function */
+uint8_t _DeleteMsgIndex_ROS(uint8_t);
+/* Add message to / remove message from its target's inbox functions */
+void _LinkMsgInbox_ROS(uint8_t);
+void _UnlinkMsgInbox_ROS(uint8_t);
+/* Running task's inbox function */
+uint8_t _RunningTaskInbox_ROS(uint8_t *);
+/* Find a message ID's first waiter, and add waiting task to / remove waiting task from its message
+   wait functions */
+uint8_t _FindMsgWaitGroup_ROS(MsgID_ROS, uint8_t *);
+void _LinkMsgWaiter_ROS(uint8_t);
+void _UnlinkMsgWaiter_ROS(uint8_t);
+/* Wake waiting task, wake highest priority waiter on a message ID, and end wait functions */
+void _WakeMsgWaiter_ROS(uint8_t);
+void _WakeMsgIDWaiter_ROS(uint8_t);
+void _EndMsgWait_ROS(uint8_t);
+/* Check if a waited for message has arrived function */
+uint8_t _IsMsgWaitOver_ROS(uint8_t, MsgID_ROS);
 
+#if (ENABLE_MSG_CHAINS_ROS)
+/* Allocate message split over several free spaces function */
+uint8_t _AllocateMsgChain_ROS(MsgID_ROS, uint8_t, uint8_t, MsgSize_ROS);
+/* Next segment of a chained message */
+#define _NextMsgSegment_ROS(message_index)			(gMsgTOC_ROS[(message_index)][MSG_CHAIN_ROS])
+#else
+/* Messages are never chained */
+#define _NextMsgSegment_ROS(message_index)			(NULL_MSG_ROS)
+#endif
 
-uint8_t _WriteMessageData_ROS(uint8_t *, uint8_t *, uint8_t);
+#if (ENABLE_MSG_TOPICS_ROS)
+/* Remove message from its topic list function */
+void _UnlinkMsgTopic_ROS(uint8_t);
+/* Delete published message once unreferenced function */
+void _ReclaimTopicMessage_ROS(uint8_t);
+/* Subscriber slot of a task vector function */
+uint8_t _TopicSubscriberSlot_ROS(uint8_t, uint8_t);
+#endif
 
+#if (ENABLE_MSG_EXPIRY_ROS)
+/* Expiry heap insert, remove and reorder functions */
+void _PushMsgExpiry_ROS(uint8_t, uint32_t);
+void _RemoveMsgExpiry_ROS(uint8_t);
+void _SiftMsgExpiry_ROS(uint8_t);
+#endif
 
+#if (ENABLE_MSG_ID_HASH_ROS) && (ENABLE_LOCK_FREE_MSGS_ROS)
+/* Table scan lookup, and insert by publishing the ID then scanning for a rival, which fails if
+   another creator holds or is claiming the ID. Nothing to remove, a freed slot drops its ID */
+uint8_t _LookupMsgIndex_ROS(MsgID_ROS);
+uint8_t _InsertMsgIndex_ROS(MsgID_ROS, uint8_t);
+#define _RemoveMsgIndex_ROS(message_id)				((void)(message_id))
+/* Full width ID of a message index */
+#define _MsgIDOfIndex_ROS(message_index)			\
+		(__atomic_load_n(&gMsgIDArray_ROS[(message_index)], __ATOMIC_ACQUIRE))
+#elif (ENABLE_MSG_ID_HASH_ROS)
+/* Hash index lookup, insert and remove functions */
+uint8_t _LookupMsgIndex_ROS(MsgID_ROS);
+uint8_t _InsertMsgIndex_ROS(MsgID_ROS, uint8_t);
+void _RemoveMsgIndex_ROS(MsgID_ROS);
+/* Full width ID of a message index */
+#define _MsgIDOfIndex_ROS(message_index)			(gMsgIDArray_ROS[(message_index)])
+#elif (ENABLE_LOCK_FREE_MSGS_ROS)
+/* Dense array lookup and remove as atomic accesses, and insert by compare and swap from null,
+   which fails if another creator claimed the ID first */
+#define _LookupMsgIndex_ROS(message_id)				\
+		(__atomic_load_n(&gMsgIndexArray_ROS[(message_id)], __ATOMIC_ACQUIRE))
+uint8_t _InsertMsgIndex_ROS(MsgID_ROS, uint8_t);
+#define _RemoveMsgIndex_ROS(message_id)				\
+		(__atomic_store_n(&gMsgIndexArray_ROS[(message_id)], NULL_ID_ROS, __ATOMIC_RELEASE))
+/* Dense IDs fit in gMsgTOC_ROS */
+#define _MsgIDOfIndex_ROS(message_index)			(gMsgTOC_ROS[(message_index)][MSG_ID_ROS])
+#else
+/* Dense array lookup, insert and remove, which cannot fail */
+#define _LookupMsgIndex_ROS(message_id)				(gMsgIndexArray_ROS[(message_id)])
+#define _InsertMsgIndex_ROS(message_id, message_index)	\
+		(gMsgIndexArray_ROS[(message_id)] = (message_index), SUCCESS_ROS)
+#define _RemoveMsgIndex_ROS(message_id)				(gMsgIndexArray_ROS[(message_id)] = NULL_ID_ROS)
+/* Dense IDs fit in gMsgTOC_ROS */
+#define _MsgIDOfIndex_ROS(message_index)			(gMsgTOC_ROS[(message_index)][MSG_ID_ROS])
+#endif
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+/* Pin count, pin and unpin of a message index, kept in its slot word */
+#define _MsgPinCount_ROS(message_index)				\
+		((uint8_t)((__atomic_load_n(&gMsgSlotArray_ROS[(message_index)], __ATOMIC_ACQUIRE) >> \
+					MSG_SLOT_PIN_SHIFT_ROS) & 0xFFu))
+#define _PinMsgIndex_ROS(message_index)				\
+		(__atomic_fetch_add(&gMsgSlotArray_ROS[(message_index)], MSG_SLOT_PIN_ROS, __ATOMIC_ACQ_REL))
+#define _UnpinMsgIndex_ROS(message_index)			\
+		(__atomic_fetch_sub(&gMsgSlotArray_ROS[(message_index)], MSG_SLOT_PIN_ROS, __ATOMIC_ACQ_REL))
+/* State and pin count fields of a slot word */
+#define _MsgSlotState_ROS(slot)						((slot) & MSG_SLOT_STATE_MASK_ROS)
+#define _MsgSlotPins_ROS(slot)						(((slot) >> MSG_SLOT_PIN_SHIFT_ROS) & 0xFFu)
+/* Let go of a held message index, making it live again */
+#define _UnholdMsgSlot_ROS(message_index)			\
+		(__atomic_store_n(&gMsgSlotArray_ROS[(message_index)], \
+						  (__atomic_load_n(&gMsgSlotArray_ROS[(message_index)], __ATOMIC_ACQUIRE) & \
+						   MSG_SLOT_VERSION_MASK_ROS) | MSG_SLOT_LIVE_ROS, __ATOMIC_RELEASE))
+/* Claim a free message table slot function */
+uint8_t _ClaimMsgSlot_ROS(uint8_t *);
+/* Return a claimed, never published slot function */
+void _ReleaseMsgSlot_ROS(uint8_t);
+/* Take bytes from the top of the store function */
+uint8_t _BumpMsgStoreTop_ROS(MsgSize_ROS, MsgLoc_ROS *);
+/* Load the slot word of a message ID function */
+uint8_t _LoadMsgSlot_ROS(MsgID_ROS, uint8_t *, uint32_t *);
+/* Pin a committed message by ID function */
+uint8_t _PinMsgID_ROS(MsgID_ROS, uint8_t *);
+/* Hold an unpinned committed message for a maintenance function */
+uint8_t _HoldMsgSlot_ROS(uint8_t, uint32_t);
+/* Mark a message deleted, leaving its space to be settled function */
+uint8_t _RetireMsgSlot_ROS(uint8_t, uint32_t);
+/* Make a written message readable function */
+void _PublishMsgSlot_ROS(uint8_t);
+/* Queue a message index for SettleMessageStore_ROS function */
+void _PushMsgSettle_ROS(uint8_t);
+/* Settle a new message at once if a task waits for it function */
+void _SettleWaitedMsg_ROS(uint8_t, MsgID_ROS);
+/* Take and give up ownership of the store (see OWN_MSG_STORE_ROS) */
+uint8_t _OwnMsgStore_ROS(void);
+void _DisownMsgStore_ROS(uint8_t *);
+/* Let go of the store, settling whatever was queued meanwhile, function */
+void _ReleaseMsgStore_ROS(void);
+/* Settle everything queued, as the store's owner, function */
+void _SettleMsgStore_ROS(void);
+/* Settle one message index, as the store's owner, function */
+void _SettleMsgIndex_ROS(uint8_t);
+#else
+/* Pin count, pin and unpin of a message index */
+#define _MsgPinCount_ROS(message_index)				(gMsgPinCountArray_ROS[(message_index)])
+#define _PinMsgIndex_ROS(message_index)				(gMsgPinCountArray_ROS[(message_index)]++)
+#define _UnpinMsgIndex_ROS(message_index)			(gMsgPinCountArray_ROS[(message_index)]--)
+#endif
+/* Lower the top of the store, if it has not moved, function */
+uint8_t _LowerMsgStoreTop_ROS(MsgLoc_ROS, MsgLoc_ROS);
+
+
+uint8_t _WriteMessageData_ROS(uint8_t *, uint8_t *, MsgSize_ROS);
+/* Write store image region through to the storage backend function */
+uint8_t _StoreMessageData_ROS(uint32_t, uint32_t);
+/* Mount march test function */
+uint8_t _MarchTestMsgStore_ROS(uint8_t *, uint32_t, uint32_t, uint32_t *);
+/* Empty the message tables function */
+void _ResetMsgTables_ROS(void);
+/* Write message record to the on-media header function */
+uint8_t _StoreMsgRecord_ROS(uint8_t);
+/* Rebuild message tables from the on-media header function */
+uint8_t _RebuildMsgTables_ROS(void);
+/* Check restored message space is in range and unused function */
+uint8_t _IsMsgSpaceRestorable_ROS(MsgSize_ROS, MsgLoc_ROS);
+/* On-media header field store and load functions */
+void _PutMsgFSField_ROS(uint8_t *, uint32_t, uint8_t);
+uint32_t _GetMsgFSField_ROS(const uint8_t *, uint8_t);
+
+
+/***************************************************************************************************
+* Name			: MountMessageFileSystem_ROS
+* Type			: API function, message system
+* Description	: This function mounts the message store on a block of memory, at least
+*				  MSG_FS_BLOCK_BYTES_ROS bytes long, optionally written through to a storage backend
+*				  (null = none). The mount mode selects how the block is prepared:
+*					- MSG_MOUNT_FULL_TEST_ROS: march test every word, then wipe the store.
+*					- MSG_MOUNT_SAMPLED_TEST_ROS: march test one word every
+*					  MSG_MOUNT_SAMPLE_STRIDE_ROS bytes, then wipe the store.
+*					- MSG_MOUNT_TRUSTED_ROS: wipe the store without testing.
+*					- MSG_MOUNT_PERSISTENT_ROS: keep the store, reading it back from the backend if
+*					  there is one, and rebuild the message tables from its header.
+*				  If a test fails, the offset of the first failing byte is output. A persistent
+*				  mount fails if the block holds no header, or the header is inconsistent.
+* Notes			: The persistent mode is for restarting with messages intact, e.g. after a watchdog
+*				  reset with the block in memory that is not cleared at start up, or from a
+*				  non-volatile backend. Every mode empties the message tables before preparing the
+*				  block, so messages held before a remount are dropped (or, for a persistent mount,
+*				  replaced by those restored); task waits and topic subscriptions are kept. Restored
+*				  messages get a fresh time to live, and each inbox is restored in message table
+*				  order.
+***************************************************************************************************/
 uint8_t MountMessageFileSystem_ROS
 		(
+			/* Pointer to the start of the block */
 			uint8_t * start_pointer, \
+			/* Size of the block in bytes */
 			uint32_t block_size, \
 			uint32_t max_messages, \
 			uint32_t max_deleted_messsages, \
-			uint32_t * first_fail_location
+			/* Pointer to variable that will store the offset of the first failing byte */
+			uint32_t * first_fail_location, \
+			/* Pointer to the storage backend (null = none) */
+			MsgStorageBackend_ROS * storage_backend, \
+			/* Mount mode */
+			uint8_t mount_mode
 		)
 {
-	uint32_t i;
-	uint8_t * test_pointer = start_pointer;
-	
-	for(i = 0; i < block_size; i++)
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Declare mount step result container variable */
+	uint8_t result = SUCCESS_ROS;
+
+	/* Table sizes are fixed at build time (MAX_MSGS_ROS, MAX_DEL_MSGS_ROS) */
+	(void)max_messages;
+	(void)max_deleted_messsages;
+
+	/* Check if the block cannot hold the store and its header */
+	if(block_size < MSG_FS_BLOCK_BYTES_ROS)
+	{
+		return F_MSG_FS_BLOCK_TOO_SMALL_ROS;
+	}
+	/* Check if the whole block is to be march tested */
+	else if(mount_mode == MSG_MOUNT_FULL_TEST_ROS)
+	{
+		result = _MarchTestMsgStore_ROS(start_pointer, block_size, 1u, first_fail_location);
+	}
+	/* Check if sampled words of the block are to be march tested */
+	else if(mount_mode == MSG_MOUNT_SAMPLED_TEST_ROS)
+	{
+		result = _MarchTestMsgStore_ROS(start_pointer, block_size, \
+										MSG_MOUNT_SAMPLE_STRIDE_ROS / sizeof(uintptr_t), \
+										first_fail_location);
+	}
+	/* Check if the mode is not one of the untested modes */
+	else if((mount_mode != MSG_MOUNT_TRUSTED_ROS) && (mount_mode != MSG_MOUNT_PERSISTENT_ROS))
 	{
+		return F_MSG_FS_MODE_INVALID_ROS;
+	}
 
-		*test_pointer = 0xAA;
-		
-		if(*test_pointer != 0xAA)
-		{
-			*first_fail_location = i;
-			
-			return F_MSG_FS_MOUNT_TEST_FAIL_ROS;
-		}
-		
-		test_pointer++;
+	/* Check if the test failed */
+	if(result != SUCCESS_ROS)
+	{
+		return result;
 	}
 
-	memset(start_pointer, 0xFF, block_size);
+	/* Drop any messages from an earlier mount, the store is unmounted until this one succeeds */
+	_ResetMsgTables_ROS();
 
-	gMsgFileSysMounted_R0S = true;
-		
 	gMsgFileSysPtr_ROS = start_pointer;
 		
 	gMsgFileSysMaxBytes_ROS = block_size;	
-		
-	return 0;
-}
- 
-uint8_t ReadMessage_ROS
-		(
-			uint8_t message_id, \
-			uint8_t num_bytes, \
-			uint8_t * pointer_to_destination
-		)
-{
-	uint8_t is_empty;
-	
-	is_empty = _IsMessageIDEmpty_ROS(message_id);
-	
-	if(is_empty == TRUE_ROS)
-	{
-		return F_MSG_ID_EMPTY_ROS;
-	}
-	else if(is_empty != FALSE_ROS)
+
+	/* Check if the store is to be kept */
+	if(mount_mode == MSG_MOUNT_PERSISTENT_ROS)
 	{
-		return is_empty;
+		/* Check if the backend copy of the store could not be read back into the block */
+		if((storage_backend != 0) && \
+		   (storage_backend->read(storage_backend->context, 0u, start_pointer, block_size) != \
+			SUCCESS_ROS))
+		{
+			return F_MSG_STORAGE_FAILED_ROS;
+		}
+
+		/* Rebuild the tables from the header, and check for failure */
+		result = _RebuildMsgTables_ROS();
+		if(result != SUCCESS_ROS)
+		{
+			return result;
+		}
 	}
+	/* Store is to be wiped */
 	else
 	{
-		uint8_t message_index;
-		
-		message_index = gMsgIndexArray_ROS[message_id];
-		
-		if(num_bytes > gMsgTOC_ROS[message_index][MSG_SIZE_ROS])
-		{
-			return F_READ_GREATER_MSG_SIZE_ROS;
-		}
-		else
+		memset(start_pointer, 0xFF, block_size);
+
+		/* Check if a storage backend was given, and its copy of the store could not be erased to
+		   match the image */
+		if((storage_backend != 0) && \
+		   (storage_backend->erase(storage_backend->context, 0u, block_size) != SUCCESS_ROS))
 		{
-			uint8_t * message_location = gMsgFileSysPtr_ROS;
-			
-			message_location += gMsgTOC_ROS[message_index][MSG_LOC_ROS];
-			
-			num_bytes = num_bytes == 0 ? gMsgTOC_ROS[message_index][MSG_SIZE_ROS] : num_bytes;
-		
-			strncpy(pointer_to_destination, message_location, num_bytes);
-			
-			return SUCCESS_ROS;
+			return F_MSG_STORAGE_FAILED_ROS;
 		}
+
+		/* Format the header, every record is left erased (invalid) */
+		start_pointer[MSG_FS_HEADER_LOC_ROS] = (uint8_t)MSG_FS_MAGIC_ROS;
+		start_pointer[MSG_FS_HEADER_LOC_ROS + 1u] = (uint8_t)(MSG_FS_MAGIC_ROS >> 8);
+		start_pointer[MSG_FS_HEADER_LOC_ROS + 2u] = (uint8_t)(MSG_FS_MAGIC_ROS >> 16);
+		start_pointer[MSG_FS_HEADER_LOC_ROS + 3u] = (uint8_t)(MSG_FS_MAGIC_ROS >> 24);
 	}
-	
-	return 0;
+
+	gMsgStorageBackend_ROS = storage_backend;
+
+	/* Check if the formatted header could not be written through to the backend */
+	if((mount_mode != MSG_MOUNT_PERSISTENT_ROS) && \
+	   (_StoreMessageData_ROS(MSG_FS_HEADER_LOC_ROS, MSG_FS_MAGIC_BYTES_ROS) != SUCCESS_ROS))
+	{
+		return F_MSG_STORAGE_FAILED_ROS;
+	}
+
+	gMsgFileSysMounted_R0S = true;
+		
+	return SUCCESS_ROS;
 }
+/***************************************************************************************************
+* End of MountMessageFileSystem_ROS
+***************************************************************************************************/
 
 /***************************************************************************************************
-* Name			: CreateMessage_ROS
-* Type			: API function, message system
-* Description	: This function creates new messages at the API level. The function will return
-*				  prematurely if input validation fails with an error code. The following conditions
-*				  will cause the function to fail:
-*					- Message ID already occupied
-*					- Any of the parameters out of range (see message.h for limits).
-*					- Insufficent memory space
-*					- Insufficent available memory space (defragmentation required).
-*					- Maximum number of messages reached (see message.h for maximum).
-*				  If the function succeeds, the message data is either stored in a deleted message's
-*				  location, or ontop of the last created message. The details of the message are 
-*				  stored in gMsgTOC_ROS, and a lookup entry inserted into gMsgIndexArray_ROS. 
-* Notes			: 1. If this function is interrupted by any other message function, the created 
-*					 message may be corrupted.
-*				  2. Time to live and message targets have not been fully implemented, although they
-*				     are enterted into gMsgTOC_ROS.
-* DEV			: [OK] Develop a FastCreateMessage_ROS function that always puts the message ontop
-*					   of the last (bypass looking for deleted locations)?
-***************************************************************************************************/		
-uint8_t CreateMessage_ROS
+* Name			: _ResetMsgTables_ROS
+* Type			: Internal function, message system
+* Description	: Returns the message tables to their start up (empty) state: no messages, holes,
+*				  inboxes, published topic messages or expiries, and the whole store free. Marks the
+*				  store unmounted.
+* Notes			: Task waits, topic subscriptions and the expiry clock are not message table state,
+*				  and are kept. Used by MountMessageFileSystem_ROS only.
+***************************************************************************************************/
+void _ResetMsgTables_ROS
 		(
-			/* Desired ID for new message */
-			uint8_t message_id, \
-			/* Target task vector to address message to */
-			uint8_t target_vector, \
-			/* New messages maximum time to live */
-			uint8_t time_to_live, \
-			/* Size of the new message in bytes */
-			uint8_t message_size, \
-			/* Pointer to the message data */
-			uint8_t * pointer_to_message
+			void
 		)
 {
-	/* Declare input validation result container variables */
-	uint8_t id_empty, message_size_valid;
+	gMsgFileSysMounted_R0S = false;
 
-	/* Check if the message ID is valid and if it is empty with the IsIDEmpty function, store result
-	   in container variable */
-	id_empty = _IsMessageIDEmpty_ROS(message_id);
+	/* Empty the message and deleted message tables, and the ID index */
+	memset(gMsgTOC_ROS, 0, sizeof(gMsgTOC_ROS));
+	memset(gMsgDTOC_ROS, 0, sizeof(gMsgDTOC_ROS));
+#if (ENABLE_MSG_ID_HASH_ROS)
+#if !(ENABLE_LOCK_FREE_MSGS_ROS)
+	memset(gMsgIDHashKeyArray_ROS, 0, sizeof(gMsgIDHashKeyArray_ROS));
+	memset(gMsgIDHashIndexArray_ROS, 0, sizeof(gMsgIDHashIndexArray_ROS));
+#endif
+	memset(gMsgIDArray_ROS, 0, sizeof(gMsgIDArray_ROS));
+#else
+	memset(gMsgIndexArray_ROS, 0, sizeof(gMsgIndexArray_ROS));
+#endif
 
-	/* Check if the message size is in range, and store result in container variable */
-	message_size_valid = _IsMessageSizeValid_ROS(message_size);
+	/* Free the whole store and every message index */
+	gNextFreeMsgLoc_ROS = 1u;
+	gNextFreeMsgIndex_ROS = 1u;
+	gNumMsg_ROS = 0u;
+	gNumDelMsg_ROS = 0u;
+	gNumDelBytes_ROS = 0u;
+	gMsgHoleClassBitmap_ROS = 0u;
+	gNumFreeMsgIndex_ROS = 0u;
 
-	if(!gMsgFileSysMounted_R0S)
+	/* Clear the pins, reservations and inboxes */
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	memset(gMsgSlotArray_ROS, 0, sizeof(gMsgSlotArray_ROS));
+	memset(gMsgSettledArray_ROS, 0, sizeof(gMsgSettledArray_ROS));
+	memset(gMsgSettlePendingArray_ROS, 0, sizeof(gMsgSettlePendingArray_ROS));
+	gMsgSettleHead_ROS = NULL_MSG_ROS;
+	gMsgSettleRetry_ROS = false;
+	gMsgSettleResult_ROS = SUCCESS_ROS;
+#else
+	memset(gMsgPinCountArray_ROS, 0, sizeof(gMsgPinCountArray_ROS));
+#endif
+	memset(gMsgReservedArray_ROS, 0, sizeof(gMsgReservedArray_ROS));
+	memset(gMsgInboxHeadArray_ROS, 0, sizeof(gMsgInboxHeadArray_ROS));
+	memset(gMsgInboxTailArray_ROS, 0, sizeof(gMsgInboxTailArray_ROS));
+
+#if (ENABLE_MSG_TOPICS_ROS)
+	/* Empty every topic's published messages */
+	memset(gMsgTopicHeadArray_ROS, 0, sizeof(gMsgTopicHeadArray_ROS));
+	memset(gMsgTopicTailArray_ROS, 0, sizeof(gMsgTopicTailArray_ROS));
+	memset(gMsgTopicArray_ROS, 0, sizeof(gMsgTopicArray_ROS));
+	memset(gMsgUnreadMaskArray_ROS, 0, sizeof(gMsgUnreadMaskArray_ROS));
+#endif
+#if (ENABLE_MSG_EXPIRY_ROS)
+	/* Empty the expiry heap */
+	memset(gMsgExpiryHeapPosArray_ROS, 0, sizeof(gMsgExpiryHeapPosArray_ROS));
+	gNumExpiryMsg_ROS = 0u;
+#endif
+}
+/***************************************************************************************************
+* End of _ResetMsgTables_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _MarchTestMsgStore_ROS
+* Type			: Internal function, message system
+* Description	: Runs a march test over a block: every stride'th native word is written with an
+*				  alternating bit pattern, then read back and inverted in ascending order, read back
+*				  and restored in descending order, and read back once more. This catches stuck,
+*				  coupled and transition faults in the words tested. Bytes before the first and after
+*				  the last whole word are tested one at a time. Returns success, or
+*				  F_MSG_FS_MOUNT_TEST_FAIL_ROS with the offset of the first failing byte.
+* Notes			: Accesses are volatile, so none are optimised away. The block contents are lost.
+***************************************************************************************************/
+uint8_t _MarchTestMsgStore_ROS
+		(
+			/* Pointer to the start of the block */
+			uint8_t * start_pointer, \
+			/* Size of the block in bytes */
+			uint32_t block_size, \
+			/* Words between tested words (1 = test every word) */
+			uint32_t stride, \
+			/* Pointer to variable that will store the offset of the first failing byte */
+			uint32_t * first_fail_location
+		)
+{
+	/* Declare byte and word views of the block, and the test pattern (0x55... at any width) */
+	volatile uint8_t * bytes = (volatile uint8_t *)start_pointer;
+	volatile uintptr_t * words;
+	const uintptr_t pattern = UINTPTR_MAX / 3u;
+	uint32_t head, num_words, last, i;
+
+	/* Split the block into leading bytes, whole words and trailing bytes */
+	head = (uint32_t)((sizeof(uintptr_t) - ((uintptr_t)start_pointer % sizeof(uintptr_t))) % \
+					  sizeof(uintptr_t));
+	head = (head > block_size) ? block_size : head;
+	num_words = (block_size - head) / sizeof(uintptr_t);
+	words = (volatile uintptr_t *)(start_pointer + head);
+
+	/* Test the leading and trailing bytes one at a time */
+	for(i = 0u; i < block_size; i++)
 	{
-		return F_MSG_FS_NOT_MOUNTED_ROS;
+		/* Skip over the whole words */
+		if(i == head)
+		{
+			i += num_words * sizeof(uintptr_t);
+			if(i >= block_size)
+			{
+				break;
+			}
+		}
+
+		/* Check if either pattern does not read back */
+		bytes[i] = 0x55;
+		if(bytes[i] != 0x55)
+		{
+			*first_fail_location = i;
+			return F_MSG_FS_MOUNT_TEST_FAIL_ROS;
+		}
+		bytes[i] = 0xAA;
+		if(bytes[i] != 0xAA)
+		{
+			*first_fail_location = i;
+			return F_MSG_FS_MOUNT_TEST_FAIL_ROS;
+		}
 	}
-	/* Check if empty message check returned false */
-	else if(id_empty == FALSE_ROS)
+
+	/* Check if there are no whole words to test */
+	if(num_words == 0u)
 	{
-		/* Message ID is already occupied, return failure */
-		return F_MSG_ID_OCCUPIED_ROS;
+		return SUCCESS_ROS;
 	}
-	/* Check if empty message check did not return true or false (must be error code) */
-	else if(id_empty != TRUE_ROS)
+
+	/* Find the last word tested */
+	last = ((num_words - 1u) / stride) * stride;
+
+	/* Ascending, write the pattern */
+	for(i = 0u; i <= last; i += stride)
 	{
-		/* Message ID invalid, return failure */
-		return id_empty;
+		words[i] = pattern;
 	}
-	/* Check if message size valid check did not return true (must be error code) */
-	else if(message_size_valid != TRUE_ROS)
+
+	/* Ascending, read the pattern and write its inverse */
+	for(i = 0u; i <= last; i += stride)
 	{
-		/* Message size invalid, return failure */
-		return message_size_valid;
+		if(words[i] != pattern)
+		{
+			break;
+		}
+		words[i] = ~pattern;
 	}
-	/* Input validation successful, proceed to create message */
-	else
-	{
-		/* Declare space found result container variable */
-		uint8_t is_space_found;
-
-		/* Declare variables to contain the found space's location, index and old deleted index */
-		uint8_t message_location, message_index, deleted_message_index;
-
-		/* Declare flag to signal whether location found is a deleted location (true = yes) */
-		bool is_deleted_location;
 
-		/* Call the FindMsgSpace internal function, and store the found space's details in the 
-		   container variables. Store the functions return code in the is_space_found variable */
-		is_space_found = _FindMsgSpace_ROS
-						(
-							message_size, \
-							&message_location, \
-							&message_index, \
-							&is_deleted_location, \
-							&deleted_message_index
-						);
-		/* Check the is_space_found variable, to see if the find space operation was successful */
-		if(is_space_found == SUCCESS_ROS)
+	/* Check if the ascending pass completed */
+	if(i > last)
+	{
+		/* Descending, read the inverse and write the pattern */
+		for(i = last; ; i -= stride)
 		{
-			/* Declare variable to store the write message operation result */
-			uint8_t write_result;
-			
-			/* Store the new message index into the ID -> index lookup table */
-			gMsgIndexArray_ROS[message_id] = message_index;
-
-			/* Store the message parameteres in the message table */
-			gMsgTOC_ROS[message_index][MSG_ID_ROS] = message_id;
-			gMsgTOC_ROS[message_index][MSG_SIZE_ROS] = message_size;
-			gMsgTOC_ROS[message_index][MSG_LOC_ROS] = message_location;
-			gMsgTOC_ROS[message_index][MSG_TTL_ROS] = time_to_live;
-			gMsgTOC_ROS[message_index][MSG_TARG_ROS] = target_vector;
-
-			/**
-			 * DEV: [OK] Message storage should move towards a pointer based location, so that the
-			 * 			 message file system can be mount in a startup routine, to a user defined 
-			 *			 location.
-			 * 
-			 *      [OK] Define a memory start address with a pointer, and user pointer arithmetic
-			 *			 to address different memory locations?
-			 **/
-			 
-			write_result =	_WriteMessageData_ROS
-							(
-								pointer_to_message, \
-								(gMsgFileSysPtr_ROS + message_location), \
-								message_size
-							);
-							
-			if(write_result != SUCCESS_ROS)
-			{
-				return write_result;
-			}		
-			/* Check the is_deleted_location flag, to check if the new message is in a deleted 
-			   location */
-			else if(is_deleted_location)
+			if(words[i] != (uintptr_t)~pattern)
 			{
-			
-			
-			/**
-			* DEV: [OK] If deleted message space is larger than message size, bytes are wasted
-			*            no longer retrievable. Need to check this, and update deleted message
-			*           entry, not always delete it.
-			**/
-				/* Decrease the number of deleted bytes by the size of the message now created */
-				gNumDelBytes_ROS -= message_size;
-
-				/* Decrement the total number of deleted messages by one */
-				gNumDelMsg_ROS--;
-
-				/* Call the erase function to erase the parameters of the deleted message from the
-				   deleted message table */
-				_EraseDelMsgEntry_ROS(deleted_message_index);
+				break;
 			}
-			/* New message was not created in a deleted message location */
-			else
-			{
-				/* Increase the next free message location by the number of bytes of the new message
-				   (the next free location) */
-				gNextFreeMsgLoc_ROS += message_size;
+			words[i] = pattern;
 
-				/* Increment the next free message index by one (the next free index) */
-				gNextFreeMsgIndex_ROS++;
+			/* Check if the first word has been done */
+			if(i == 0u)
+			{
+				/* Ascending, read the pattern */
+				for(i = 0u; (i <= last) && (words[i] == pattern); i += stride)
+				{
+				}
+				break;
 			}
-
-			/* Increase the total number of messages by one */
-			gNumMsg_ROS++;
-
-			/* Message created, return success */
-			return SUCCESS_ROS;
-		}
-		/* Could not find space for the new message */
-		else
-		{
-			/* Cannot find space for new message, is_space_found contains the error code detailing
-			   why the find space operation failed. Return failure */
-			return is_space_found;
 		}
 	}
-	
-	/**
-	 * DEV: [OK] Code should never reach this point. Do we need a return value?
-	 **/
-	 
-	return 0;
+
+	/* Check if a word failed (every loop leaves i past the last word on success) */
+	if(i <= last)
+	{
+		*first_fail_location = head + (i * (uint32_t)sizeof(uintptr_t));
+		return F_MSG_FS_MOUNT_TEST_FAIL_ROS;
+	}
+
+	/* Every tested word passed, return success */
+	return SUCCESS_ROS;
 }
 /***************************************************************************************************
-* End of CreateMessage_ROS
+* End of _MarchTestMsgStore_ROS
 ***************************************************************************************************/
 
 /***************************************************************************************************
-* Name			: DeleteMessage_ROS
-* Type			: API function, message system
-* Description	: This function deletes messages from the message ID, which is passed as the
-*				  function's only arguement. The following conditions will cause the delete
-*				  operation to fail:
-*					- Invalid message ID
-*					- Empty message ID
-*					- Maximum number of deleted messages reached
-*				  The function stores the contains of the message to delete into a free deleted 
-*				  messages slot, then clears the entries from the main message table. The message
-*				  data is not cleared.
-* Notes			: Repeatedly deleting small messages in odd locations (i.e. 1 byte deleted from 
-*				  locations 1, 3, 5, 7...), and creating larger messages will make inefficent usage
-*				  of the memory space. The small deleted messages leave 'holes' which must be need 
-*				  to be removed by defragementation. Deleting and creating messages of the same size
-*				  or multiples of the same size helps to alleiveate this problem.
-* DEV			: [OK] Need to setup a defrag function. Perform defrag as part of the delete to 
-*					   ensure a delete always happens? Or request a defrag once number of deleted
-*					   messages reaches a threshold?
+* Name			: _StoreMsgRecord_ROS
+* Type			: Internal function, message system
+* Description	: Writes a message table index's record in the on-media header from gMsgTOC_ROS,
+*				  and writes it through to the storage backend. Empty, reserved and published
+*				  messages get an invalid record, and the segments of a chained message get a record
+*				  with a null ID. Returns the backend write result.
+* Notes			: Call after the message's data is written, so a restored record never points at
+*				  data that was not stored. Store a chained message's segment records before its
+*				  first record.
 ***************************************************************************************************/
-uint8_t DeleteMessage_ROS
+uint8_t _StoreMsgRecord_ROS
 		(
-			/* Message ID to delete */
-			uint8_t message_id
+			/* Message table index to store */
+			uint8_t message_index
 		)
 {
-	/* Declare input validation result container variable */
-	uint8_t is_id_empty;
-	
-	/* Check if message ID is valid, and contains a message. Store result in container variable */
-	is_id_empty = _IsMessageIDEmpty_ROS(message_id);
+	/* Find the record, and the message's ID */
+	uint32_t location = MSG_FS_HEADER_LOC_ROS + MSG_FS_MAGIC_BYTES_ROS + \
+						((uint32_t)message_index * MSG_FS_RECORD_BYTES_ROS);
+	uint8_t * record = gMsgFileSysPtr_ROS + location;
+	uint32_t message_id = (uint32_t)_MsgIDOfIndex_ROS(message_index);
 
-	if(!gMsgFileSysMounted_R0S)
+	/* Store the message's size and next segment in container variables */
+	MsgSize_ROS message_size = gMsgTOC_ROS[message_index][MSG_SIZE_ROS];
+	uint8_t next_segment = _NextMsgSegment_ROS(message_index);
+
+	/* Check if the message should not be restored */
+	if((gMsgTOC_ROS[message_index][MSG_SIZE_ROS] == NULL_SIZE_ROS) || \
+	   gMsgReservedArray_ROS[message_index]
+#if (ENABLE_MSG_TOPICS_ROS)
+	   || (gMsgTopicArray_ROS[message_index] != NULL_TOPIC_ROS)
+#endif
+	   )
 	{
-		return F_MSG_FS_NOT_MOUNTED_ROS;
+		/* Invalidate the record with a null ID and size */
+		message_id = NULL_ID_ROS;
+		message_size = NULL_SIZE_ROS;
+		next_segment = NULL_MSG_ROS;
 	}
-	/* Check message empty check result is true */
-	else if(is_id_empty == TRUE_ROS)
-	{
-		/* Message ID does not contain a message, cannot delete. Return failure */
-		return F_MSG_ID_EMPTY_ROS;
-	}
-	/* Check if message empty check result is not true or false (must be error code) */
-	else if(is_id_empty != FALSE_ROS)
+
+	/* Pack the record */
+	_PutMsgFSField_ROS(record, message_id, 4u);
+	_PutMsgFSField_ROS(record + MSG_FS_REC_SIZE_ROS, message_size, sizeof(MsgSize_ROS));
+	_PutMsgFSField_ROS(record + MSG_FS_REC_LOC_ROS, gMsgTOC_ROS[message_index][MSG_LOC_ROS], \
+					   sizeof(MsgLoc_ROS));
+	record[MSG_FS_REC_TARG_ROS] = (uint8_t)gMsgTOC_ROS[message_index][MSG_TARG_ROS];
+	record[MSG_FS_REC_TTL_ROS] = (uint8_t)gMsgTOC_ROS[message_index][MSG_TTL_ROS];
+	record[MSG_FS_REC_CHAIN_ROS] = next_segment;
+
+	/* Write the record through, and return the result */
+	return _StoreMessageData_ROS(location, MSG_FS_RECORD_BYTES_ROS);
+}
+/***************************************************************************************************
+* End of _StoreMsgRecord_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _RebuildMsgTables_ROS
+* Type			: Internal function, message system
+* Description	: Rebuilds gMsgTOC_ROS, the ID index, the holes, the inboxes and the expiry heap from
+*				  the on-media header of the mounted block. Invalid records are skipped, as are
+*				  records whose ID is a duplicate, whose data overlaps a restored record, or whose
+*				  chain of segment records is broken. Gaps between the restored messages become
+*				  holes. Returns success, F_MSG_FS_NOT_FORMATTED_ROS if the block has no header, or
+*				  F_MAX_DEL_MSGS_REACHED_ROS if the gaps need more holes than there are entries.
+* Notes			: The tables must be in their start up (empty) state.
+***************************************************************************************************/
+uint8_t _RebuildMsgTables_ROS
+		(
+			void
+		)
+{
+	/* Declare loop counters, record pointer and highest restored index */
+	uint8_t i, j = NULL_MSG_ROS, highest_index = 0u;
+	uint8_t * record = gMsgFileSysPtr_ROS + MSG_FS_HEADER_LOC_ROS;
+	uint32_t location;
+
+	/* Declare chain walk variables */
+	uint8_t segment_index;
+	uint32_t total_size;
+#if (ENABLE_MSG_CHAINS_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+	uint8_t num_segments;
+#endif
+
+	/* Check if the magic word is missing (or the store has a different field width) */
+	if(_GetMsgFSField_ROS(record, MSG_FS_MAGIC_BYTES_ROS) != MSG_FS_MAGIC_ROS)
 	{
-		/* Message ID invalid, container variable contains error code to return. Return failure */
-		return is_id_empty;
+		/* Block was never formatted, return failure */
+		return F_MSG_FS_NOT_FORMATTED_ROS;
 	}
-	/* Input validation successful, begin delete operation */
-	else
+
+	/* Restore every valid record (index 0 is the null message) */
+	for(i = 1u; i < MAX_MSGS_ROS; i++)
 	{
-		/* Declare loop counter varaible, and deletion index container variable */
-		uint8_t i, del_index;
+		/* Unpack the record */
+		uint32_t message_id;
+		MsgSize_ROS message_size;
+		MsgLoc_ROS message_location;
+		record = gMsgFileSysPtr_ROS + MSG_FS_HEADER_LOC_ROS + MSG_FS_MAGIC_BYTES_ROS + \
+				 ((uint32_t)i * MSG_FS_RECORD_BYTES_ROS);
+		message_id = _GetMsgFSField_ROS(record, 4u);
+		message_size = (MsgSize_ROS)_GetMsgFSField_ROS(record + MSG_FS_REC_SIZE_ROS, \
+													   sizeof(MsgSize_ROS));
+		message_location = (MsgLoc_ROS)_GetMsgFSField_ROS(record + MSG_FS_REC_LOC_ROS, \
+														  sizeof(MsgLoc_ROS));
 
-		/* Declare deleted slot found boolean status flag (true = slot found), intialise to false */
-		bool found_del_slot = false;
+		/* Check if the ID is out of range or already restored, the target has no inbox, the index
+		   was restored as a segment, or the space is out of range or overlaps a restored
+		   message */
+		if((message_id > MAX_MSG_ID_ROS) || \
+		   (_IsMessageIDEmpty_ROS((MsgID_ROS)message_id) != TRUE_ROS) || \
+		   !IS_MSG_INBOX_ROS(record[MSG_FS_REC_TARG_ROS]) || \
+		   (gMsgTOC_ROS[i][MSG_SIZE_ROS] != NULL_SIZE_ROS) || \
+		   (_IsMsgSpaceRestorable_ROS(message_size, message_location) != TRUE_ROS))
+		{
+			/* Record invalid, skip it */
+			continue;
+		}
 
-		/* Begin a for loop to check each deleted message table entry for an empty slot */
-		for(i = 0; i < MAX_DEL_MSGS_ROS; i++)
+		/* Enter the message's space into the message table, so its segments cannot overlap it */
+		gMsgTOC_ROS[i][MSG_SIZE_ROS] = message_size;
+		gMsgTOC_ROS[i][MSG_LOC_ROS] = message_location;
+		total_size = message_size;
+		segment_index = record[MSG_FS_REC_CHAIN_ROS];
+
+#if (ENABLE_MSG_CHAINS_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+		/* Follow the chain, entering each segment whose record is consistent (the lock-free store
+		   makes no chains, so drops chained records) */
+		j = i;
+		num_segments = 1u;
+		while(segment_index != NULL_MSG_ROS)
 		{
-			/* Check if deleted message ID is null value (deleted slot is free) */
-			if(gMsgDTOC_ROS[i][MSG_ID_ROS] == NULL_ID_ROS)
+			/* Unpack the segment's record */
+			uint8_t * segment_record = gMsgFileSysPtr_ROS + MSG_FS_HEADER_LOC_ROS + \
+									   MSG_FS_MAGIC_BYTES_ROS + \
+									   ((uint32_t)segment_index * MSG_FS_RECORD_BYTES_ROS);
+			message_size = (MsgSize_ROS)_GetMsgFSField_ROS(segment_record + MSG_FS_REC_SIZE_ROS, \
+														   sizeof(MsgSize_ROS));
+			message_location = (MsgLoc_ROS)_GetMsgFSField_ROS(segment_record + MSG_FS_REC_LOC_ROS, \
+															  sizeof(MsgLoc_ROS));
+
+			/* Check if the chain is too long, or the segment's index is out of range or already
+			   restored (which also ends a looped chain), its ID is not null, or its space is out
+			   of range or overlaps a restored message */
+			if((num_segments == MAX_MSG_SEGMENTS_ROS) || (segment_index >= MAX_MSGS_ROS) || \
+			   (gMsgTOC_ROS[segment_index][MSG_SIZE_ROS] != NULL_SIZE_ROS) || \
+			   (_GetMsgFSField_ROS(segment_record, 4u) != NULL_ID_ROS) || \
+			   (_IsMsgSpaceRestorable_ROS(message_size, message_location) != TRUE_ROS))
+			{
+				/* Chain broken, stop following it */
+				break;
+			}
+
+			/* Enter the segment, and link it onto the chain */
+			gMsgTOC_ROS[segment_index][MSG_SIZE_ROS] = message_size;
+			gMsgTOC_ROS[segment_index][MSG_LOC_ROS] = message_location;
+			gMsgTOC_ROS[j][MSG_CHAIN_ROS] = segment_index;
+			total_size += message_size;
+			num_segments++;
+
+			/* Move to the next segment */
+			j = segment_index;
+			segment_index = segment_record[MSG_FS_REC_CHAIN_ROS];
+		}
+#endif
+
+		/* Check if the chain is broken (or chains are disabled), the message is too large, or it
+		   has no ID index slot */
+		if((segment_index != NULL_MSG_ROS) || (total_size > MAX_MSG_BYTES_ROS) || \
+		   (_InsertMsgIndex_ROS((MsgID_ROS)message_id, i) != SUCCESS_ROS))
+		{
+			/* Record inconsistent, erase whatever was entered and skip it */
+			for(j = i; j != NULL_MSG_ROS; j = segment_index)
 			{
-				/* Store the empty deleted message index */
-				del_index = i;
+				segment_index = _NextMsgSegment_ROS(j);
+				_EraseMsgEntry_ROS(j);
+			}
+			continue;
+		}
 
-				/* Set the boolean deleted slot found flag to true */
-				found_del_slot = true;
+		/* Enter the rest of the message into the message table */
+		gMsgTOC_ROS[i][MSG_ID_ROS] = (uint8_t)message_id;
+		gMsgTOC_ROS[i][MSG_TARG_ROS] = record[MSG_FS_REC_TARG_ROS];
+		gMsgTOC_ROS[i][MSG_TTL_ROS] = record[MSG_FS_REC_TTL_ROS];
+#if (ENABLE_MSG_ID_HASH_ROS)
+		gMsgIDArray_ROS[i] = (MsgID_ROS)message_id;
+#endif
+#if (ENABLE_MSG_EXPIRY_ROS)
+		/* Check if the message has a time to live */
+		if(record[MSG_FS_REC_TTL_ROS] != NULL_TTL_ROS)
+		{
+			/* Schedule the message's expiry */
+			_PushMsgExpiry_ROS(i, gMsgExpiryTick_ROS + record[MSG_FS_REC_TTL_ROS]);
+		}
+#endif
 
-				/* Break from the for loop prematurely, slot found */
-				break;
+		/* Deliver the message to its target's inbox */
+		_LinkMsgInbox_ROS(i);
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+		/* Mark the message's slot live, with nothing left to settle */
+		gMsgSlotArray_ROS[i] = MSG_SLOT_LIVE_ROS;
+		gMsgSettledArray_ROS[i] = true;
+#endif
+
+		/* Count the message */
+		gNumMsg_ROS++;
+
+		/* Raise the highest restored index and the next free location over every segment */
+		for(j = i; j != NULL_MSG_ROS; j = _NextMsgSegment_ROS(j))
+		{
+			if(j > highest_index)
+			{
+				highest_index = j;
+			}
+			if((gMsgTOC_ROS[j][MSG_LOC_ROS] + gMsgTOC_ROS[j][MSG_SIZE_ROS]) > gNextFreeMsgLoc_ROS)
+			{
+				gNextFreeMsgLoc_ROS = gMsgTOC_ROS[j][MSG_LOC_ROS] + gMsgTOC_ROS[j][MSG_SIZE_ROS];
 			}
 		}
+	}
 
-		/* Check if slot found flag is false */
-		if(!found_del_slot)
+	/* Indexes above the highest restored one are fresh, unused ones below it are reusable */
+	gNextFreeMsgIndex_ROS = highest_index + 1u;
+	for(i = highest_index; i > 0u; i--)
+	{
+		if(gMsgTOC_ROS[i][MSG_SIZE_ROS] == NULL_SIZE_ROS)
 		{
-			/**
-			 * DEV: [OK] Raise defrag request here? 
-			 **/
-		
-			/* Need to defrag, no deleted table space left */
-			return F_MAX_DEL_MSGS_REACHED_ROS;
+			gMsgFreeIndexArray_ROS[gNumFreeMsgIndex_ROS] = i;
+			gNumFreeMsgIndex_ROS++;
 		}
-		/* Slot found flag is true, continue delete operation */
-		else
+	}
+
+	/* Turn every gap below the next free location into a hole, walking up the store */
+	location = 1u;
+	while(location < gNextFreeMsgLoc_ROS)
+	{
+		/* Find the lowest message at or above the location */
+		uint32_t next_location = gNextFreeMsgLoc_ROS;
+		for(i = 1u; i <= highest_index; i++)
+		{
+			if((gMsgTOC_ROS[i][MSG_SIZE_ROS] != NULL_SIZE_ROS) && \
+			   (gMsgTOC_ROS[i][MSG_LOC_ROS] >= location) && \
+			   (gMsgTOC_ROS[i][MSG_LOC_ROS] < next_location))
+			{
+				next_location = gMsgTOC_ROS[i][MSG_LOC_ROS];
+				j = i;
+			}
+		}
+
+		/* Check if no message remains above the location (cannot happen with consistent
+		   tables) */
+		if(next_location == gNextFreeMsgLoc_ROS)
 		{
-			/* Retrieve message to delete's index, and store in container variable */
-			uint8_t message_index = gMsgIndexArray_ROS[message_id];
+			break;
+		}
 
-			/* Remove lookup table entry for the message to delete, and set to null value */
-			gMsgIndexArray_ROS[message_id] = NULL_ID_ROS;
+		/* Check if there is a gap below the message, and it could not be made a hole */
+		if((next_location > location) && \
+		   (_ReleaseMsgSpace_ROS((MsgLoc_ROS)location, (MsgSize_ROS)(next_location - location)) != \
+			SUCCESS_ROS))
+		{
+			return F_MAX_DEL_MSGS_REACHED_ROS;
+		}
 
-			/* Increment the number of deleted messages by one */
-			gNumDelMsg_ROS++;
+		/* Move above the message */
+		location = next_location + gMsgTOC_ROS[j][MSG_SIZE_ROS];
+	}
 
-			/* Increase the number of deleted bytes by the size of the message now being deleted */
-			gNumDelBytes_ROS += gMsgTOC_ROS[message_index][MSG_SIZE_ROS];
+	/* Tables rebuilt, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _RebuildMsgTables_ROS
+***************************************************************************************************/
 
-			/* Copy the message to delete's parameters to the deleted message table */
-			gMsgDTOC_ROS[del_index][MSG_ID_ROS] = gMsgTOC_ROS[message_index][MSG_ID_ROS];
-	 		gMsgDTOC_ROS[del_index][MSG_SIZE_ROS] = gMsgTOC_ROS[message_index][MSG_SIZE_ROS];
-			gMsgDTOC_ROS[del_index][MSG_LOC_ROS] = gMsgTOC_ROS[message_index][MSG_LOC_ROS];
-			gMsgDTOC_ROS[del_index][MSG_TTL_ROS] = gMsgTOC_ROS[message_index][MSG_TTL_ROS];
-			gMsgDTOC_ROS[del_index][MSG_TARG_ROS] = gMsgTOC_ROS[message_index][MSG_TARG_ROS];
-			gMsgDTOC_ROS[del_index][MSG_OLDINDEX_ROS] = message_index;
+/***************************************************************************************************
+* Name			: _IsMsgSpaceRestorable_ROS
+* Type			: Internal function, message system
+* Description	: Checks a message (or segment) space read from the on-media header. Returns true if
+*				  the size and location are in range (the same limits the allocator keeps to), and
+*				  the space does not overlap any message or segment already restored; otherwise
+*				  returns false.
+* Notes			: Used by _RebuildMsgTables_ROS only.
+***************************************************************************************************/
+uint8_t _IsMsgSpaceRestorable_ROS
+		(
+			/* Size of the space in bytes */
+			MsgSize_ROS message_size, \
+			/* Location of the space */
+			MsgLoc_ROS message_location
+		)
+{
+	/* Declare loop counter */
+	uint8_t i;
 
-			/* Erase the deleted message's parameters from the main message table */
-			_EraseMsgEntry_ROS(message_index);
+	/* Check if the size or location is out of range */
+	if((_IsMessageSizeValid_ROS(message_size) != TRUE_ROS) || \
+	   (message_location == NULL_LOC_ROS) || \
+	   (((uint32_t)message_location + message_size) >= MAX_MSG_STOR_BYTES_ROS))
+	{
+		/* Space invalid, return false */
+		return FALSE_ROS;
+	}
 
-			/* Deletion operation successful, return success */
-			return SUCCESS_ROS;
+	/* Search the restored messages for one overlapping the space */
+	for(i = 1u; i < MAX_MSGS_ROS; i++)
+	{
+		if((gMsgTOC_ROS[i][MSG_SIZE_ROS] != NULL_SIZE_ROS) && \
+		   (message_location < (gMsgTOC_ROS[i][MSG_LOC_ROS] + gMsgTOC_ROS[i][MSG_SIZE_ROS])) && \
+		   (gMsgTOC_ROS[i][MSG_LOC_ROS] < (message_location + message_size)))
+		{
+			/* Overlap found, return false */
+			return FALSE_ROS;
 		}
 	}
+
+	/* Space free, return true */
+	return TRUE_ROS;
 }
 /***************************************************************************************************
-* End of DeleteMessage_ROS
+* End of _IsMsgSpaceRestorable_ROS
 ***************************************************************************************************/
 
 /***************************************************************************************************
-* Name			: _FindMsgSpace_ROS
+* Name			: _PutMsgFSField_ROS
 * Type			: Internal function, message system
-* Description	: This function attempts to find a space for a message of a specified size.
-*				  function first looks for a deleted message space, and then looks finding a space
-*				  on top of the last message. If the function is succesful, it will return 
-*				  SUCCESS_ROS, and output the message location and index to the pointers passed. If
-*				  slot was a deleted message, it will also set the is_deleted_location pointer 
-*				  variable to true, and specify the delte message's index. If function cannot find 
-*				  space for the message, or the maximium number of messages has been reached - the
-*				  function will return failure with an error code.
-* Notes			: In a large deleted message array, finding a free deleted message location can be
-*				  instruction heavy.
-* DEV			: [OK] Include input validation for message size?
+* Description	: Stores a value, little endian, in the specified number of on-media header bytes.
+* Notes			: None
 ***************************************************************************************************/
-uint8_t _FindMsgSpace_ROS
+void _PutMsgFSField_ROS
 		(
-			/* All output values are invalid in function does not return SUCCESS_ROS */
-			/* Size of message to find space for */
-			uint8_t message_size, \
-			/* Pointer to variable that will store the message space's location */
-			uint8_t * output_location, \
-			/* Pointer to variable that will store the message space's index */
-			uint8_t * message_index, \
-			/* Pointer to variable that will store a status flag to indicate whether the message
-			   space is a deleted location (true = yes) */
-			bool * is_deleted_location, \
-			/* Pointer to variable that will store index of the deleted message the new space 
-			   occupies (value only valid when is_deleted_location is true) */
-			uint8_t * deleted_message_index 
+			/* Pointer to the field */
+			uint8_t * location, \
+			/* Value to store */
+			uint32_t value, \
+			/* Field width in bytes (1 to 4) */
+			uint8_t num_bytes
 		)
 {
-	/* Check if the maximum number of messages has been reached */
-	if(gNumMsg_ROS >= MAX_MSGS_ROS)
+	/* Store the bytes, lowest first */
+	while(num_bytes-- > 0u)
 	{
-		/* Maximum number of messages reached, return failure */
-		return F_MAX_MSGS_REACHED_ROS;
+		*location++ = (uint8_t)value;
+		value >>= 8;
+	}
+}
+/***************************************************************************************************
+* End of _PutMsgFSField_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _GetMsgFSField_ROS
+* Type			: Internal function, message system
+* Description	: Returns the little endian value held in the specified number of on-media header
+*				  bytes.
+* Notes			: None
+***************************************************************************************************/
+uint32_t _GetMsgFSField_ROS
+		(
+			/* Pointer to the field */
+			const uint8_t * location, \
+			/* Field width in bytes (1 to 4) */
+			uint8_t num_bytes
+		)
+{
+	/* Declare value container variable */
+	uint32_t value = 0u;
+
+	/* Assemble the bytes, highest first */
+	while(num_bytes-- > 0u)
+	{
+		value = (value << 8) | location[num_bytes];
+	}
+
+	/* Return the value */
+	return value;
+}
+/***************************************************************************************************
+* End of _GetMsgFSField_ROS
+***************************************************************************************************/
+ 
+uint8_t ReadMessage_ROS
+		(
+			MsgID_ROS message_id, \
+			MsgSize_ROS num_bytes, \
+			uint8_t * pointer_to_destination
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	uint8_t is_empty;
+	
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	uint8_t message_index;
+
+	/* Pin the message, so it cannot be deleted, moved or reused while it is copied */
+	is_empty = _PinMsgID_ROS(message_id, &message_index);
+
+	if(is_empty != SUCCESS_ROS)
+	{
+		return is_empty;
+	}
+	else if(_IsMessageOwner_ROS(message_index) != TRUE_ROS)
+	{
+		is_empty = F_MSG_ACCESS_DENIED_ROS;
+	}
+	else if(num_bytes > gMsgTOC_ROS[message_index][MSG_SIZE_ROS])
+	{
+		is_empty = F_READ_GREATER_MSG_SIZE_ROS;
 	}
-	/* Input validation complete, continue to find message space */
 	else
 	{
-		/* Declare space found status flag (true = space found), initialise to false */
-		bool space_found = false;
+		num_bytes = num_bytes == 0 ? gMsgTOC_ROS[message_index][MSG_SIZE_ROS] : num_bytes;
+
+		_GatherMessageData_ROS(message_index, pointer_to_destination, num_bytes);
+	}
+
+	/* Drop the pin, and return the result */
+	_UnpinMsgIndex_ROS(message_index);
+	return is_empty;
+#else
+	is_empty = _IsMessageIDEmpty_ROS(message_id);
 	
-		/* Check if the total number of deleted bytes is greater than or equal to the message size
-		   (if total number of deleted bytes is lower, there can't be enough space in deleted 
-		   messages */
-		if(gNumDelBytes_ROS >= message_size)
+	if(is_empty == TRUE_ROS)
+	{
+		return F_MSG_ID_EMPTY_ROS;
+	}
+	else if(is_empty != FALSE_ROS)
+	{
+		return is_empty;
+	}
+	else if(gMsgReservedArray_ROS[_LookupMsgIndex_ROS(message_id)])
+	{
+		return F_MSG_NOT_COMMITTED_ROS;
+	}
+	else if(_IsMessageOwner_ROS(_LookupMsgIndex_ROS(message_id)) != TRUE_ROS)
+	{
+		return F_MSG_ACCESS_DENIED_ROS;
+	}
+	else
+	{
+		uint8_t message_index;
+		
+		message_index = _LookupMsgIndex_ROS(message_id);
+		
+		if(num_bytes > _MsgTotalSize_ROS(message_index))
+		{
+			return F_READ_GREATER_MSG_SIZE_ROS;
+		}
+		else
 		{
-			/* Declare temporary loop counter variable */
-			uint8_t i;
+			num_bytes = num_bytes == 0 ? _MsgTotalSize_ROS(message_index) : num_bytes;
+		
+			/* Copy the data out, across every segment of a chained message */
+			_GatherMessageData_ROS(message_index, pointer_to_destination, num_bytes);
+			
+			return SUCCESS_ROS;
+		}
+	}
 	
-			/* Iterate through the entire deleted messages table */
-			for(i = 0u; i < MAX_DEL_MSGS_ROS; i++)
-			{
-				/* Check if the deleted message entry [i] is big enough to store the message */
-				if(gMsgDTOC_ROS[i][MSG_SIZE_ROS] >= message_size)
-				{
-					/* Deleted message entry is big enough to fit message, set the output location
-					   pointer to the location of the deleted message */
-					*output_location = gMsgDTOC_ROS[i][MSG_LOC_ROS];
+	return 0;
+#endif
+}
+
+/***************************************************************************************************
+* Name			: CreateMessage_ROS
+* Type			: API function, message system
+* Description	: This function creates new messages at the API level. The function will return
+*				  prematurely if input validation fails with an error code. The following conditions
+*				  will cause the function to fail:
+*					- Message ID already occupied
+*					- Any of the parameters out of range (see message.h for limits).
+*					- Insufficent memory space
+*					- Insufficent available memory space (defragmentation required).
+*					- Maximum number of messages reached (see message.h for maximum).
+*				  If the function succeeds, the message data is either stored in a deleted message's
+*				  location, or ontop of the last created message. The details of the message are 
+*				  stored in gMsgTOC_ROS, and a lookup entry inserted into the ID index. If no single
+*				  space is large enough, the message is split over several (see
+*				  ENABLE_MSG_CHAINS_ROS), and only fails with insufficent available memory space if
+*				  it needs more than MAX_MSG_SEGMENTS_ROS.
+* Notes			: 1. If this function is interrupted by any other message function, the created 
+*					 message may be corrupted, unless ENABLE_LOCK_FREE_MSGS_ROS is set. The message
+*					 is then readable once this function returns, and is delivered to its target's
+*					 inbox by the next SettleMessageStore_ROS (at once, if a task waits for it).
+*				  2. A message addressed to a target vector (not MSG_TARG_GLOBAL_ROS) is added to
+*				     the target's inbox, and can only be read by that task. A non-zero time to
+*				     live deletes the message after that many calls to TickMessageExpiry_ROS (see
+*				     ENABLE_MSG_EXPIRY_ROS).
+*				  3. With ENABLE_LOCK_FREE_MSGS_ROS set, a message is never chained, and its space
+*					 is always taken from the top of the store.
+* DEV			: [OK] Develop a FastCreateMessage_ROS function that always puts the message ontop
+*					   of the last (bypass looking for deleted locations)?
+***************************************************************************************************/		
+uint8_t CreateMessage_ROS
+		(
+			/* Desired ID for new message */
+			MsgID_ROS message_id, \
+			/* Target task vector to address message to */
+			uint8_t target_vector, \
+			/* New messages maximum time to live */
+			uint8_t time_to_live, \
+			/* Size of the new message in bytes */
+			MsgSize_ROS message_size, \
+			/* Pointer to the message data */
+			uint8_t * pointer_to_message
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Allocate the message's table entry and space, and store the result in a container
+	   variable */
+	uint8_t is_allocated = _AllocateMessage_ROS
+						   (
+								message_id, \
+								target_vector, \
+								time_to_live, \
+								message_size
+						   );
+
+#if (ENABLE_MSG_CHAINS_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Check if no single free space is large enough for the message */
+	if(is_allocated == F_INSUFF_FREE_MEM_ROS)
+	{
+		/* Split the message over several free spaces instead */
+		is_allocated = _AllocateMsgChain_ROS
+					   (
+							message_id, \
+							target_vector, \
+							time_to_live, \
+							message_size
+					   );
+	}
+#endif
+
+	/* Check if the allocation failed */
+	if(is_allocated != SUCCESS_ROS)
+	{
+		/* Allocation failed, return error code */
+		return is_allocated;
+	}
+	/* Allocation successful, copy the message data in */
+	else
+	{
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+		/* Look up the new message's index (the ID stays claimed while the message is unpublished) */
+		uint8_t message_index = _LookupMsgIndex_ROS(message_id);
+
+		/* Copy the data into the store image, and make the message readable. Delivery, and the
+		   write through to the storage backend, are left to SettleMessageStore_ROS, which runs
+		   now if a task waits for the message */
+		memcpy(gMsgFileSysPtr_ROS + gMsgTOC_ROS[message_index][MSG_LOC_ROS], pointer_to_message, \
+			   message_size);
+		_PublishMsgSlot_ROS(message_index);
+		_SettleWaitedMsg_ROS(target_vector, message_id);
+		return SUCCESS_ROS;
+#else
+		/* Deliver the message to its target's inbox */
+		_LinkMsgInbox_ROS(_LookupMsgIndex_ROS(message_id));
+
+		/**
+		 * DEV: [OK] Message storage should move towards a pointer based location, so that the
+		 * 			 message file system can be mount in a startup routine, to a user defined 
+		 *			 location.
+		 * 
+		 *      [OK] Define a memory start address with a pointer, and user pointer arithmetic
+		 *			 to address different memory locations?
+		 **/
+
+		/* Write the message data into its allocated location (or segments), and check for
+		   failure */
+		if(_ScatterMessageData_ROS(_LookupMsgIndex_ROS(message_id), pointer_to_message) != \
+		   SUCCESS_ROS)
+		{
+			return F_MSG_STORAGE_FAILED_ROS;
+		}
+
+		/* Record the message in the on-media header, and return the write result */
+		return _StoreMsgRecord_ROS(_LookupMsgIndex_ROS(message_id));
+#endif
+	}
+}
+/***************************************************************************************************
+* End of CreateMessage_ROS
+***************************************************************************************************/
 
-					/* Set the deleted location status flag pointer to true */
-					*is_deleted_location = true;
+/***************************************************************************************************
+* Name			: _AllocateMessage_ROS
+* Type			: Internal function, message system
+* Description	: Validates a new message's parameters, finds space for it, and enters it into
+*				  gMsgTOC_ROS and the ID index. The message data is not written. Returns 
+*				  success, or the error code of the first failed check (see CreateMessage_ROS).
+* Notes			: Shared by CreateMessage_ROS and ReserveMessage_ROS.
+***************************************************************************************************/
+uint8_t _AllocateMessage_ROS
+		(
+			/* Desired ID for new message */
+			MsgID_ROS message_id, \
+			/* Target task vector to address message to */
+			uint8_t target_vector, \
+			/* New messages maximum time to live */
+			uint8_t time_to_live, \
+			/* Size of the new message in bytes */
+			MsgSize_ROS message_size
+		)
+{
+	/* Declare input validation result container variables */
+	uint8_t id_empty, message_size_valid;
 
-					/* Set the deleted message index pointer to i */
-					*deleted_message_index = i;
+	/* Check if the message ID is valid and if it is empty with the IsIDEmpty function, store result
+	   in container variable */
+	id_empty = _IsMessageIDEmpty_ROS(message_id);
 
-					/* Set the new message index value to the deleted message's index */
-					*message_index = gMsgDTOC_ROS[i][MSG_OLDINDEX_ROS];
+	/* Check if the message size is in range, and store result in container variable */
+	message_size_valid = _IsMessageSizeValid_ROS(message_size);
+
+	if(!gMsgFileSysMounted_R0S)
+	{
+		return F_MSG_FS_NOT_MOUNTED_ROS;
+	}
+	/* Check if empty message check returned false */
+	else if(id_empty == FALSE_ROS)
+	{
+		/* Message ID is already occupied, return failure */
+		return F_MSG_ID_OCCUPIED_ROS;
+	}
+	/* Check if empty message check did not return true or false (must be error code) */
+	else if(id_empty != TRUE_ROS)
+	{
+		/* Message ID invalid, return failure */
+		return id_empty;
+	}
+	/* Check if message size valid check did not return true (must be error code) */
+	else if(message_size_valid != TRUE_ROS)
+	{
+		/* Message size invalid, return failure */
+		return message_size_valid;
+	}
+	/* Check if the target vector has no inbox */
+	else if(!IS_MSG_INBOX_ROS(target_vector))
+	{
+		/* Target out of range, return failure */
+		return F_MSG_TARGET_INVALID_ROS;
+	}
+	/* Input validation successful, proceed to allocate message */
+	else
+	{
+		/* Declare space found result container variable */
+		uint8_t is_space_found;
+
+		/* Declare variables to contain the found space's location, index and old deleted index */
+		MsgLoc_ROS message_location;
+		uint8_t message_index, deleted_message_index;
+
+		/* Declare flag to signal whether location found is a deleted location (true = yes) */
+		bool is_deleted_location;
+
+		/* Call the FindMsgSpace internal function, and store the found space's details in the 
+		   container variables. Store the functions return code in the is_space_found variable */
+		is_space_found = _FindMsgSpace_ROS
+						(
+							message_size, \
+							&message_location, \
+							&message_index, \
+							&is_deleted_location, \
+							&deleted_message_index
+						);
+		/* Check the is_space_found variable, to see if the find space operation was successful */
+		if(is_space_found == SUCCESS_ROS)
+		{
+			/* Enter the message into the tables and claim the space found, and return the
+			   result */
+			return _PlaceMessage_ROS
+				   (
+						message_id, \
+						target_vector, \
+						time_to_live, \
+						message_size, \
+						message_location, \
+						message_index, \
+						is_deleted_location, \
+						deleted_message_index
+				   );
+		}
+		/* Could not find space for the new message */
+		else
+		{
+			/* Cannot find space for new message, is_space_found contains the error code detailing
+			   why the find space operation failed. Return failure */
+			return is_space_found;
+		}
+	}
+	
+	/**
+	 * DEV: [OK] Code should never reach this point. Do we need a return value?
+	 **/
+	 
+	return 0;
+}
+/***************************************************************************************************
+* End of _AllocateMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _PlaceMessage_ROS
+* Type			: Internal function, message system
+* Description	: Enters a validated message into gMsgTOC_ROS, the ID index and the expiry heap, and
+*				  claims the space and message index found for it (from a hole, or the top of the
+*				  store). Returns success, or F_MSG_ID_TABLE_FULL_ROS if the ID index has no slot
+*				  (nothing is changed).
+* Notes			: The message data is not written. Shared by _AllocateMessage_ROS and
+*				  CreateMessages_ROS. With ENABLE_LOCK_FREE_MSGS_ROS set, the index is a slot already
+*				  claimed by _FindMsgSpace_ROS, the space is taken from the top of the store here
+*				  (the location passed in is ignored), and the function fails with
+*				  F_MSG_ID_OCCUPIED_ROS if another creator claims the ID first, F_MSG_BUSY_ROS if
+*				  another creator is claiming it with the hashed index, or F_INSUFF_FREE_MEM_ROS if
+*				  the top of the store runs out. The slot is released on
+*				  failure.
+***************************************************************************************************/
+uint8_t _PlaceMessage_ROS
+		(
+			/* New message ID */
+			MsgID_ROS message_id, \
+			/* Target task vector to address message to */
+			uint8_t target_vector, \
+			/* New messages maximum time to live */
+			uint8_t time_to_live, \
+			/* Size of the new message in bytes */
+			MsgSize_ROS message_size, \
+			/* Location of the space found for the message */
+			MsgLoc_ROS message_location, \
+			/* Message index found for the message */
+			uint8_t message_index, \
+			/* Status flag, true if the space is in a deleted message location (hole) */
+			bool is_deleted_location, \
+			/* Index of the hole the space is in (only valid if is_deleted_location is true) */
+			uint8_t deleted_message_index
+		)
+{
+	/* Declare ID insert result container variable */
+	uint8_t is_inserted;
+
+	/* Store the new message index into the ID -> index lookup, and check it succeeded (a
+	   hashed index can run out of probe slots) */
+	if((is_inserted = _InsertMsgIndex_ROS(message_id, message_index)) != SUCCESS_ROS)
+	{
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+		/* Another creator holds or is claiming the ID, give the slot back and return the
+		   insert's error code */
+		_ReleaseMsgSlot_ROS(message_index);
+		return is_inserted;
+#else
+		/* No index slot for the ID, return failure before anything is committed */
+		return F_MSG_ID_TABLE_FULL_ROS;
+#endif
+	}
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Take the message's space from the top of the store, and check it was not used up by other
+	   creators since the space was found */
+	else if(_BumpMsgStoreTop_ROS(message_size, &message_location) != SUCCESS_ROS)
+	{
+		/* Give the ID and slot back, and return failure */
+		_RemoveMsgIndex_ROS(message_id);
+		_ReleaseMsgSlot_ROS(message_index);
+		return F_INSUFF_FREE_MEM_ROS;
+	}
+#endif
+
+	/* Store the message parameteres in the message table */
+	gMsgTOC_ROS[message_index][MSG_ID_ROS] = (uint8_t)message_id;
+	gMsgTOC_ROS[message_index][MSG_SIZE_ROS] = message_size;
+	gMsgTOC_ROS[message_index][MSG_LOC_ROS] = message_location;
+	gMsgTOC_ROS[message_index][MSG_TTL_ROS] = time_to_live;
+	gMsgTOC_ROS[message_index][MSG_TARG_ROS] = target_vector;
+#if (ENABLE_MSG_ID_HASH_ROS)
+	gMsgIDArray_ROS[message_index] = message_id;
+#endif
+#if (ENABLE_MSG_EXPIRY_ROS) && (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Record when the message expires, SettleMessageStore_ROS schedules it */
+	gMsgExpiryTickArray_ROS[message_index] = __atomic_load_n(&gMsgExpiryTick_ROS, __ATOMIC_RELAXED) + \
+											 time_to_live;
+#elif (ENABLE_MSG_EXPIRY_ROS)
+	/* Check if the message has a time to live */
+	if(time_to_live != NULL_TTL_ROS)
+	{
+		/* Schedule the message's expiry */
+		_PushMsgExpiry_ROS(message_index, gMsgExpiryTick_ROS + time_to_live);
+	}
+#endif
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* The space and slot are already claimed, increase the total number of messages by one */
+	(void)is_deleted_location;
+	(void)deleted_message_index;
+	__atomic_fetch_add(&gNumMsg_ROS, 1u, __ATOMIC_RELAXED);
+#else
+	/* Claim the space and message index found */
+	_ClaimMsgSpace_ROS(message_size, is_deleted_location, deleted_message_index);
+
+	/* Increase the total number of messages by one */
+	gNumMsg_ROS++;
+#endif
+
+	/* Message space allocated, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _PlaceMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _ClaimMsgSpace_ROS
+* Type			: Internal function, message system
+* Description	: Claims space found for a message (or chained message segment), from the front of
+*				  a hole or the top of the store, and the message index found for it.
+* Notes			: The index claimed is the one _FindMsgSpace_ROS outputs: the top of the free index
+*				  stack, or the next fresh index.
+***************************************************************************************************/
+void _ClaimMsgSpace_ROS
+		(
+			/* Size of the space in bytes */
+			MsgSize_ROS message_size, \
+			/* Status flag, true if the space is in a deleted message location (hole) */
+			bool is_deleted_location, \
+			/* Index of the hole the space is in (only valid if is_deleted_location is true) */
+			uint8_t deleted_message_index
+		)
+{
+	/* Check the is_deleted_location flag, to check if the new message is in a deleted 
+	   location */
+	if(is_deleted_location)
+	{
+		/* Allocate the message from the front of the hole, any bytes left over remain a
+		   (smaller) hole */
+		_TakeMsgHoleSpace_ROS(deleted_message_index, message_size);
+	}
+	/* New message was not created in a deleted message location */
+	else
+	{
+		/* Increase the next free message location by the number of bytes of the new message
+		   (the next free location) */
+		gNextFreeMsgLoc_ROS += message_size;
+	}
+
+	/* Check if the message index was reused from a deleted message */
+	if(gNumFreeMsgIndex_ROS != 0u)
+	{
+		/* Pop the reused index from the free index stack */
+		gNumFreeMsgIndex_ROS--;
+	}
+	/* Message index is a fresh index */
+	else
+	{
+		/* Increment the next free message index by one (the next free index) */
+		gNextFreeMsgIndex_ROS++;
+	}
+}
+/***************************************************************************************************
+* End of _ClaimMsgSpace_ROS
+***************************************************************************************************/
+
+#if (ENABLE_MSG_CHAINS_ROS)
+/***************************************************************************************************
+* Name			: _AllocateMsgChain_ROS
+* Type			: Internal function, message system
+* Description	: Allocates a validated message that fits no single free space as a chain of
+*				  segments, each in a hole or on top of the last message. The largest free spaces
+*				  are used first, so the chain is as short as possible. The first segment is entered
+*				  as the message, and the rest as table entries with a null ID, linked through
+*				  MSG_CHAIN_ROS. Returns success, F_INSUFF_MEM_SPACE_ROS if the free space is too
+*				  small in total, F_INSUFF_FREE_MEM_ROS if it needs more than MAX_MSG_SEGMENTS_ROS
+*				  segments, or F_MAX_MSGS_REACHED_ROS / F_MSG_ID_TABLE_FULL_ROS if there are not
+*				  enough message indexes or ID index slots. Nothing is changed on failure.
+* Notes			: Called by CreateMessage_ROS after _AllocateMessage_ROS fails with
+*				  F_INSUFF_FREE_MEM_ROS, so the parameters are already validated. The message data
+*				  is not written. Worst case cost is one scan of the deleted message table per
+*				  segment.
+***************************************************************************************************/
+uint8_t _AllocateMsgChain_ROS
+		(
+			/* New message ID */
+			MsgID_ROS message_id, \
+			/* Target task vector to address message to */
+			uint8_t target_vector, \
+			/* New messages maximum time to live */
+			uint8_t time_to_live, \
+			/* Size of the new message in bytes */
+			MsgSize_ROS message_size
+		)
+{
+	/* Declare loop counters, and the index of the segment before the one being placed */
+	uint8_t i, num_segments = 0u, message_index, previous_index = NULL_MSG_ROS;
+
+	/* Declare the planned segments: the hole each is in (NULL_HOLE_ROS = top of the store), and
+	   its size */
+	uint8_t segment_holes[MAX_MSG_SEGMENTS_ROS];
+	MsgSize_ROS segment_sizes[MAX_MSG_SEGMENTS_ROS];
+
+	/* Declare status flags, true once a hole (or the top of the store) is planned */
+	bool is_hole_planned[MAX_DEL_MSGS_ROS];
+	bool is_top_planned = false;
+
+	/* Declare bytes still to plan, and bytes free on top of the last message (the allocator keeps
+	   the last byte of the store free) */
+	MsgSize_ROS remaining_bytes = message_size;
+	MsgSize_ROS top_bytes = (MsgSize_ROS)(MAX_MSG_STOR_BYTES_ROS - 1u - gNextFreeMsgLoc_ROS);
+
+	/* Check if the free space is too small in total */
+	if(((uint32_t)gNumDelBytes_ROS + top_bytes) < message_size)
+	{
+		/* Not enough memory even when split, return failure */
+		return F_INSUFF_MEM_SPACE_ROS;
+	}
+
+	/* Clear the planned hole flags */
+	for(i = 0u; i < MAX_DEL_MSGS_ROS; i++)
+	{
+		is_hole_planned[i] = false;
+	}
+
+	/* Plan segments in the largest free spaces until the message is covered */
+	while((remaining_bytes != 0u) && (num_segments < MAX_MSG_SEGMENTS_ROS))
+	{
+		/* Start with the top of the store as the largest free space, unless already planned */
+		uint8_t largest_hole = NULL_HOLE_ROS;
+		MsgSize_ROS largest_size = is_top_planned ? 0u : top_bytes;
+
+		/* Search the deleted message table for a larger unplanned hole */
+		for(i = 0u; i < MAX_DEL_MSGS_ROS; i++)
+		{
+			if((gMsgDTOC_ROS[i][MSG_ID_ROS] != NULL_ID_ROS) && !is_hole_planned[i] && \
+			   (gMsgDTOC_ROS[i][MSG_SIZE_ROS] > largest_size))
+			{
+				largest_hole = i;
+				largest_size = gMsgDTOC_ROS[i][MSG_SIZE_ROS];
+			}
+		}
+
+		/* Plan a segment of the free space, or of the bytes remaining if fewer */
+		segment_holes[num_segments] = largest_hole;
+		segment_sizes[num_segments] = (largest_size < remaining_bytes) ? largest_size : \
+									  remaining_bytes;
+		remaining_bytes -= segment_sizes[num_segments];
+		num_segments++;
+
+		/* Mark the free space planned */
+		if(largest_hole == NULL_HOLE_ROS)
+		{
+			is_top_planned = true;
+		}
+		else
+		{
+			is_hole_planned[largest_hole] = true;
+		}
+	}
+
+	/* Check if the message needs more segments than allowed */
+	if(remaining_bytes != 0u)
+	{
+		/* Too fragmented, defragmentation required. Return failure */
+		return F_INSUFF_FREE_MEM_ROS;
+	}
+	/* Check if there are not enough message indexes for the segments */
+	else if(((uint16_t)gNumFreeMsgIndex_ROS + (MAX_MSGS_ROS - gNextFreeMsgIndex_ROS)) < num_segments)
+	{
+		/* Not enough indexes, return failure */
+		return F_MAX_MSGS_REACHED_ROS;
+	}
+
+	/* Place every planned segment. Taking space from one hole does not move any other hole, so
+	   the plan stays valid */
+	for(i = 0u; i < num_segments; i++)
+	{
+		/* Find the segment's index (as _FindMsgSpace_ROS does) and location */
+		MsgLoc_ROS message_location = (segment_holes[i] == NULL_HOLE_ROS) ? gNextFreeMsgLoc_ROS : \
+									  gMsgDTOC_ROS[segment_holes[i]][MSG_LOC_ROS];
+		message_index = (gNumFreeMsgIndex_ROS != 0u) ? \
+						gMsgFreeIndexArray_ROS[gNumFreeMsgIndex_ROS - 1u] : gNextFreeMsgIndex_ROS;
+
+		/* Check if this is the first segment */
+		if(i == 0u)
+		{
+			/* Enter the message itself, and check for failure (nothing is changed yet) */
+			uint8_t is_placed = _PlaceMessage_ROS
+								(
+									message_id, \
+									target_vector, \
+									time_to_live, \
+									segment_sizes[0], \
+									message_location, \
+									message_index, \
+									(segment_holes[0] != NULL_HOLE_ROS), \
+									segment_holes[0]
+								);
+			if(is_placed != SUCCESS_ROS)
+			{
+				return is_placed;
+			}
+		}
+		/* Following segment */
+		else
+		{
+			/* Enter the segment with a null ID, outside the ID index, and claim its space */
+			gMsgTOC_ROS[message_index][MSG_SIZE_ROS] = segment_sizes[i];
+			gMsgTOC_ROS[message_index][MSG_LOC_ROS] = message_location;
+#if (ENABLE_MSG_ID_HASH_ROS)
+			gMsgIDArray_ROS[message_index] = NULL_ID_ROS;
+#endif
+			_ClaimMsgSpace_ROS(segment_sizes[i], (segment_holes[i] != NULL_HOLE_ROS), \
+							   segment_holes[i]);
+
+			/* Link the segment onto the chain */
+			gMsgTOC_ROS[previous_index][MSG_CHAIN_ROS] = message_index;
+		}
+
+		previous_index = message_index;
+	}
+
+	/* Chained message allocated, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _AllocateMsgChain_ROS
+***************************************************************************************************/
+#endif
+
+/***************************************************************************************************
+* Name			: _MsgTotalSize_ROS
+* Type			: Internal function, message system
+* Description	: Returns the size of a message in bytes, adding up the segments of a chained
+*				  message.
+* Notes			: The message must exist.
+***************************************************************************************************/
+MsgSize_ROS _MsgTotalSize_ROS
+		(
+			/* Message table index of the message */
+			uint8_t message_index
+		)
+{
+	/* Declare size container variable */
+	MsgSize_ROS message_size = 0u;
+
+	/* Add up every segment */
+	for(; message_index != NULL_MSG_ROS; message_index = _NextMsgSegment_ROS(message_index))
+	{
+		message_size += gMsgTOC_ROS[message_index][MSG_SIZE_ROS];
+	}
+
+	/* Return the size */
+	return message_size;
+}
+/***************************************************************************************************
+* End of _MsgTotalSize_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _GatherMessageData_ROS
+* Type			: Internal function, message system
+* Description	: Copies the first bytes of a message to a destination, across the segments of a
+*				  chained message.
+* Notes			: The number of bytes must not exceed the message's total size.
+***************************************************************************************************/
+void _GatherMessageData_ROS
+		(
+			/* Message table index of the message */
+			uint8_t message_index, \
+			/* Pointer to the destination */
+			uint8_t * pointer_to_destination, \
+			/* Number of bytes to copy */
+			MsgSize_ROS number_bytes
+		)
+{
+	/* Copy segment by segment until the bytes run out */
+	while(number_bytes != 0u)
+	{
+		/* Copy the whole segment, or the bytes remaining if fewer */
+		MsgSize_ROS segment_bytes = (gMsgTOC_ROS[message_index][MSG_SIZE_ROS] < number_bytes) ? \
+									gMsgTOC_ROS[message_index][MSG_SIZE_ROS] : number_bytes;
+		memcpy(pointer_to_destination, \
+			   gMsgFileSysPtr_ROS + gMsgTOC_ROS[message_index][MSG_LOC_ROS], \
+			   segment_bytes);
+
+		/* Move on to the next segment */
+		pointer_to_destination += segment_bytes;
+		number_bytes -= segment_bytes;
+		message_index = _NextMsgSegment_ROS(message_index);
+	}
+}
+/***************************************************************************************************
+* End of _GatherMessageData_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _ScatterMessageData_ROS
+* Type			: Internal function, message system
+* Description	: Writes a message's data into its allocated space, across the segments of a chained
+*				  message, and stores the segments' on-media records. Returns success, or
+*				  F_MSG_STORAGE_FAILED_ROS if a backend write failed.
+* Notes			: The first segment's record is not stored, the caller stores it last.
+***************************************************************************************************/
+uint8_t _ScatterMessageData_ROS
+		(
+			/* Message table index of the message */
+			uint8_t message_index, \
+			/* Pointer to the message data */
+			uint8_t * pointer_to_data
+		)
+{
+	/* Declare segment walk variable */
+	uint8_t i;
+
+	/* Write every segment */
+	for(i = message_index; i != NULL_MSG_ROS; i = _NextMsgSegment_ROS(i))
+	{
+		/* Write the segment's share of the data, and check for failure */
+		if(_WriteMessageData_ROS(pointer_to_data, gMsgFileSysPtr_ROS + gMsgTOC_ROS[i][MSG_LOC_ROS], \
+								 gMsgTOC_ROS[i][MSG_SIZE_ROS]) != SUCCESS_ROS)
+		{
+			return F_MSG_STORAGE_FAILED_ROS;
+		}
+		/* Check if a following segment's record could not be stored */
+		else if((i != message_index) && (_StoreMsgRecord_ROS(i) != SUCCESS_ROS))
+		{
+			return F_MSG_STORAGE_FAILED_ROS;
+		}
+
+		/* Move past the segment's share of the data */
+		pointer_to_data += gMsgTOC_ROS[i][MSG_SIZE_ROS];
+	}
+
+	/* Data written, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _ScatterMessageData_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: DeleteMessage_ROS
+* Type			: API function, message system
+* Description	: This function deletes messages from the message ID, which is passed as the
+*				  function's only arguement. The following conditions will cause the delete
+*				  operation to fail:
+*					- Invalid message ID
+*					- Empty message ID
+*					- Message borrowed or reserved (pinned)
+*				  The function returns the message's bytes to the free space (merging them with any
+*				  neighbouring holes, or with the top of the store), then clears the entries from
+*				  the main message table. The message data is not cleared.
+* Notes			: Repeatedly deleting small messages in odd locations (i.e. 1 byte deleted from 
+*				  locations 1, 3, 5, 7...), and creating larger messages will make inefficent usage
+*				  of the memory space. Holes are merged with their neighbours as messages are
+*				  deleted, but holes separated by live messages can only be removed by
+*				  defragmentation. If the deleted message table is full, the delete runs
+*				  defragmentation steps until an entry is freed; call OptimizeMessageStorage_ROS
+*				  from the idle task to keep this off the delete path. With ENABLE_LOCK_FREE_MSGS_ROS
+*				  set, the message is only marked deleted, and its space is released by the next
+*				  SettleMessageStore_ROS.
+***************************************************************************************************/
+uint8_t DeleteMessage_ROS
+		(
+			/* Message ID to delete */
+			MsgID_ROS message_id
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Declare input validation result container variable */
+	uint8_t is_id_empty;
+	
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Declare message index and slot word container variables */
+	uint8_t message_index;
+	uint32_t slot;
+
+	if(!gMsgFileSysMounted_R0S)
+	{
+		return F_MSG_FS_NOT_MOUNTED_ROS;
+	}
+
+	/* Retry until the slot word is swapped, or the message is found unable to be deleted */
+	while(true)
+	{
+		/* Load the message's slot word, and check the message exists */
+		is_id_empty = _LoadMsgSlot_ROS(message_id, &message_index, &slot);
+		if(is_id_empty != SUCCESS_ROS)
+		{
+			return is_id_empty;
+		}
+		/* Check if the message is borrowed, or still being written */
+		else if(_MsgSlotPins_ROS(slot) != 0u)
+		{
+			/* Message data is still in use, cannot delete. Return failure */
+			return F_MSG_PINNED_ROS;
+		}
+		/* Check if the slot word is unchanged, and mark the message deleted */
+		else if(_RetireMsgSlot_ROS(message_index, slot) == TRUE_ROS)
+		{
+			/* Deletion operation successful, return success */
+			return SUCCESS_ROS;
+		}
+	}
+#else
+	/* Check if message ID is valid, and contains a message. Store result in container variable */
+	is_id_empty = _IsMessageIDEmpty_ROS(message_id);
+
+	if(!gMsgFileSysMounted_R0S)
+	{
+		return F_MSG_FS_NOT_MOUNTED_ROS;
+	}
+	/* Check message empty check result is true */
+	else if(is_id_empty == TRUE_ROS)
+	{
+		/* Message ID does not contain a message, cannot delete. Return failure */
+		return F_MSG_ID_EMPTY_ROS;
+	}
+	/* Check if message empty check result is not true or false (must be error code) */
+	else if(is_id_empty != FALSE_ROS)
+	{
+		/* Message ID invalid, container variable contains error code to return. Return failure */
+		return is_id_empty;
+	}
+	/* Check if the message is borrowed or reserved */
+	else if(_MsgPinCount_ROS(_LookupMsgIndex_ROS(message_id)) != 0u)
+	{
+		/* Message data is still in use, cannot delete. Return failure */
+		return F_MSG_PINNED_ROS;
+	}
+	/* Input validation successful, delete the message and return the result */
+	else
+	{
+		return _DeleteMsgIndex_ROS(_LookupMsgIndex_ROS(message_id));
+	}
+#endif
+}
+/***************************************************************************************************
+* End of DeleteMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _DeleteMsgIndex_ROS
+* Type			: Internal function, message system
+* Description	: Deletes the message at a message table index: returns its bytes to the free space,
+*				  removes it from the ID index and expiry heap, and erases its table entry (and those
+*				  of a chained message's segments). Returns success, or F_MAX_DEL_MSGS_REACHED_ROS if
+*				  the space could not be released (nothing is changed).
+* Notes			: The message must exist and must not be pinned. Shared by DeleteMessage_ROS and
+*				  TickMessageExpiry_ROS. With ENABLE_LOCK_FREE_MSGS_ROS set, the message must be
+*				  held, or claimed and unpublished, by the caller; it is only marked deleted, and
+*				  always succeeds.
+***************************************************************************************************/
+uint8_t _DeleteMsgIndex_ROS
+		(
+			/* Message table index to delete */
+			uint8_t message_index
+		)
+{
+	/* Declare space released result container variable */
+	uint8_t is_space_released;
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* The caller holds the slot, so its word cannot change. Mark the message deleted */
+	(void)is_space_released;
+	_RetireMsgSlot_ROS(message_index, __atomic_load_n(&gMsgSlotArray_ROS[message_index], \
+													  __ATOMIC_ACQUIRE));
+	return SUCCESS_ROS;
+#else
+
+#if (ENABLE_MSG_CHAINS_ROS)
+	/* Check if the message is chained */
+	if(_NextMsgSegment_ROS(message_index) != NULL_MSG_ROS)
+	{
+		/* Declare segment walk variables, and count the segments */
+		uint8_t i, next_index, num_segments = 0u;
+		for(i = message_index; i != NULL_MSG_ROS; i = _NextMsgSegment_ROS(i))
+		{
+			num_segments++;
+		}
+
+		/* Each segment may need a deleted message entry of its own, so defragment until there
+		   are enough for all of them; a chain is never left part deleted */
+		while(((gNumDelMsg_ROS + num_segments) > MAX_DEL_MSGS_ROS) && (_DefragStep_ROS() == TRUE_ROS))
+		{
+		}
+
+		/* Check if there are still not enough free deleted message entries */
+		if((gNumDelMsg_ROS + num_segments) > MAX_DEL_MSGS_ROS)
+		{
+			/* Cannot release the chain, return failure */
+			return F_MAX_DEL_MSGS_REACHED_ROS;
+		}
+
+		/* Release and erase every segment after the first (the defragmenter may have moved
+		   them, so their locations are read now) */
+		for(i = _NextMsgSegment_ROS(message_index); i != NULL_MSG_ROS; i = next_index)
+		{
+			next_index = _NextMsgSegment_ROS(i);
+			_ReleaseMsgSpace_ROS(gMsgTOC_ROS[i][MSG_LOC_ROS], gMsgTOC_ROS[i][MSG_SIZE_ROS]);
+			gMsgFreeIndexArray_ROS[gNumFreeMsgIndex_ROS] = i;
+			gNumFreeMsgIndex_ROS++;
+			_EraseMsgEntry_ROS(i);
+			_StoreMsgRecord_ROS(i);
+		}
+
+		/* The first segment is now the whole message */
+		gMsgTOC_ROS[message_index][MSG_CHAIN_ROS] = NULL_MSG_ROS;
+	}
+#endif
+
+	/* Return the message's bytes to the free space, merging with neighbouring holes, and store
+	   the result in a container variable */
+	is_space_released = _ReleaseMsgSpace_ROS
+								(
+									gMsgTOC_ROS[message_index][MSG_LOC_ROS], \
+									gMsgTOC_ROS[message_index][MSG_SIZE_ROS]
+								);
+
+	/* Check if the deleted message table is full */
+	if(is_space_released == F_MAX_DEL_MSGS_REACHED_ROS)
+	{
+		/* Defragment until a deleted message entry is freed. Every step either frees an entry
+		   or moves one message, so this is bounded by MAX_MSGS_ROS steps */
+		while((gNumDelMsg_ROS >= MAX_DEL_MSGS_ROS) && (_DefragStep_ROS() == TRUE_ROS))
+		{
+		}
+
+		/* Retry the release, the message may have been moved by the defragmenter */
+		is_space_released = _ReleaseMsgSpace_ROS
+							(
+								gMsgTOC_ROS[message_index][MSG_LOC_ROS], \
+								gMsgTOC_ROS[message_index][MSG_SIZE_ROS]
+							);
+	}
+
+	/* Check if the space could not be released */
+	if(is_space_released != SUCCESS_ROS)
+	{
+		/* Space could not be released, return failure */
+		return is_space_released;
+	}
+	/* Space released, continue delete operation */
+	else
+	{
+		/* Remove lookup table entry for the message to delete, and set to null value */
+		_RemoveMsgIndex_ROS(_MsgIDOfIndex_ROS(message_index));
+
+		/* Push the message's index onto the free index stack for reuse */
+		gMsgFreeIndexArray_ROS[gNumFreeMsgIndex_ROS] = message_index;
+		gNumFreeMsgIndex_ROS++;
+
+		/* Decrease the total number of messages by one */
+		gNumMsg_ROS--;
+
+		/* Remove the message from its target's inbox, if it was delivered */
+		_UnlinkMsgInbox_ROS(message_index);
+
+#if (ENABLE_MSG_TOPICS_ROS)
+		/* Check if the message was published to a topic */
+		if(gMsgTopicArray_ROS[message_index] != NULL_TOPIC_ROS)
+		{
+			/* Remove the message from the topic list, dropping any unread references */
+			_UnlinkMsgTopic_ROS(message_index);
+		}
+#endif
+
+#if (ENABLE_MSG_EXPIRY_ROS)
+		/* Check if the message is waiting to expire */
+		if(gMsgExpiryHeapPosArray_ROS[message_index] != NULL_HEAP_POS_ROS)
+		{
+			/* Cancel the message's expiry */
+			_RemoveMsgExpiry_ROS(message_index);
+		}
+#endif
+
+		/* Erase the deleted message's parameters from the main message table, and invalidate its
+		   on-media record (a backend failure is reported by the next FlushMessageStorage_ROS) */
+		_EraseMsgEntry_ROS(message_index);
+		_StoreMsgRecord_ROS(message_index);
+
+		/* Deletion operation successful, return success */
+		return SUCCESS_ROS;
+	}
+#endif
+}
+/***************************************************************************************************
+* End of _DeleteMsgIndex_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _IsMessageOwner_ROS
+* Type			: Internal function, input validation.
+* Description	: Checks if the running task may read a message. Returns true if the message is
+*				  global, is addressed to the running task's vector, or no task is running (kernel
+*				  and start up code); otherwise returns false.
+* Notes			: None.
+***************************************************************************************************/
+uint8_t _IsMessageOwner_ROS
+		(
+			/* Message table index to check */
+			uint8_t message_index
+		)
+{
+	/* Look up the message's target vector */
+	uint8_t target_vector = gMsgTOC_ROS[message_index][MSG_TARG_ROS];
+
+	/* Check if the message is global, or the caller is not a task */
+	if((target_vector == MSG_TARG_GLOBAL_ROS) || (RUNNING_TASK_ID_ROS == NULL_TASK_ROS))
+	{
+		/* Readable by anyone, return true */
+		return TRUE_ROS;
+	}
+	/* Check if the target vector holds the running task */
+	else if((target_vector < gTaskVectorTableSize_ROS) && \
+			(gTaskVectorLookupArray_ROS[target_vector] == RUNNING_TASK_ID_ROS))
+	{
+		/* Message addressed to the running task, return true */
+		return TRUE_ROS;
+	}
+	/* Message addressed to another task */
+	else
+	{
+		/* Access denied, return false */
+		return FALSE_ROS;
+	}
+}
+/***************************************************************************************************
+* End of _IsMessageOwner_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _RunningTaskInbox_ROS
+* Type			: Internal function, message inbox.
+* Description	: Outputs the inbox of the running task (its task vector). Returns success, or
+*				  F_MSG_NO_RUNNING_TASK_ROS if no task is running.
+* Notes			: Task vectors above the message target range have no inbox, and are denied.
+***************************************************************************************************/
+uint8_t _RunningTaskInbox_ROS
+		(
+			/* Pointer to variable that will store the inbox */
+			uint8_t * inbox
+		)
+{
+	/* Check if no task is running */
+	if(RUNNING_TASK_ID_ROS == NULL_TASK_ROS)
+	{
+		/* No caller task, return failure */
+		return F_MSG_NO_RUNNING_TASK_ROS;
+	}
+	/* Check if the task's vector cannot be a message target */
+	else if(TASK_VECTOR_ROS(RUNNING_TASK_ID_ROS) >= NUM_MSG_INBOXES_ROS)
+	{
+		/* No inbox, return failure */
+		return F_MSG_ACCESS_DENIED_ROS;
+	}
+	/* Task has an inbox */
+	else
+	{
+		/* Output the inbox, and return success */
+		*inbox = (uint8_t)TASK_VECTOR_ROS(RUNNING_TASK_ID_ROS);
+		return SUCCESS_ROS;
+	}
+}
+/***************************************************************************************************
+* End of _RunningTaskInbox_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _LinkMsgInbox_ROS
+* Type			: Internal function, message inbox.
+* Description	: Appends a committed message to its target vector's inbox, and queues the target
+*				  task if it is waiting for a message. Global messages are not linked. The highest
+*				  priority task waiting for the message's ID is queued as well.
+* Notes			: None.
+***************************************************************************************************/
+void _LinkMsgInbox_ROS
+		(
+			/* Message table index to link */
+			uint8_t message_index
+		)
+{
+	/* Look up the message's target vector (its inbox) */
+	uint8_t inbox = gMsgTOC_ROS[message_index][MSG_TARG_ROS];
+
+	/* Check if the message is addressed to a task */
+	if(inbox != MSG_TARG_GLOBAL_ROS)
+	{
+		/* Append the message after the current tail */
+		gMsgTOC_ROS[message_index][MSG_INBOX_NEXT_ROS] = NULL_MSG_ROS;
+		gMsgTOC_ROS[message_index][MSG_INBOX_PREV_ROS] = gMsgInboxTailArray_ROS[inbox];
+
+		/* Check if the inbox was empty */
+		if(gMsgInboxTailArray_ROS[inbox] == NULL_MSG_ROS)
+		{
+			/* Message is the new head */
+			gMsgInboxHeadArray_ROS[inbox] = message_index;
+		}
+		/* Inbox held messages */
+		else
+		{
+			/* Forward link the old tail */
+			gMsgTOC_ROS[gMsgInboxTailArray_ROS[inbox]][MSG_INBOX_NEXT_ROS] = message_index;
+		}
+
+		/* Message is the new tail */
+		gMsgInboxTailArray_ROS[inbox] = message_index;
+
+		/* Check if the target task is waiting for a message */
+		if(gMsgInboxWaitArray_ROS[inbox])
+		{
+			/* Wake the task */
+			gMsgInboxWaitArray_ROS[inbox] = false;
+			_WakeMsgWaiter_ROS(inbox);
+		}
+	}
+
+	/* Wake the highest priority task waiting for the message's ID, if any */
+	_WakeMsgIDWaiter_ROS(message_index);
+}
+/***************************************************************************************************
+* End of _LinkMsgInbox_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _UnlinkMsgInbox_ROS
+* Type			: Internal function, message inbox.
+* Description	: Removes a message from its target vector's inbox. Global messages, and targeted
+*				  messages that were never linked, are ignored.
+* Notes			: A message is linked if it has a previous message, or is its inbox's head.
+***************************************************************************************************/
+void _UnlinkMsgInbox_ROS
+		(
+			/* Message table index to unlink */
+			uint8_t message_index
+		)
+{
+	/* Look up the message's inbox and neighbours */
+	uint8_t inbox = gMsgTOC_ROS[message_index][MSG_TARG_ROS];
+	uint8_t prev = gMsgTOC_ROS[message_index][MSG_INBOX_PREV_ROS];
+	uint8_t next = gMsgTOC_ROS[message_index][MSG_INBOX_NEXT_ROS];
+
+	/* Check if the message is addressed to a task, and is in its inbox (a batch rolled back by
+	   CreateMessages_ROS is deleted before it is delivered) */
+	if((inbox != MSG_TARG_GLOBAL_ROS) && \
+	   ((prev != NULL_MSG_ROS) || (gMsgInboxHeadArray_ROS[inbox] == message_index)))
+	{
+		/* Bypass the message going forwards */
+		if(prev == NULL_MSG_ROS)
+		{
+			gMsgInboxHeadArray_ROS[inbox] = next;
+		}
+		else
+		{
+			gMsgTOC_ROS[prev][MSG_INBOX_NEXT_ROS] = next;
+		}
+
+		/* Bypass the message going backwards */
+		if(next == NULL_MSG_ROS)
+		{
+			gMsgInboxTailArray_ROS[inbox] = prev;
+		}
+		else
+		{
+			gMsgTOC_ROS[next][MSG_INBOX_PREV_ROS] = prev;
+		}
+	}
+}
+/***************************************************************************************************
+* End of _UnlinkMsgInbox_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _FindMsgWaitGroup_ROS
+* Type			: Internal function, message wait.
+* Description	: Looks up the first task waiting for a message ID in the ID's wait list. The
+*				  search passes one waiter per other ID sharing the list, however many tasks wait
+*				  for it. Returns the task vector (null = no task waits for the ID), and outputs
+*				  the first waiter of the ID listed before it (null = head of the list).
+* Notes			: None.
+***************************************************************************************************/
+uint8_t _FindMsgWaitGroup_ROS
+		(
+			/* Message ID waited for */
+			MsgID_ROS message_id, \
+			/* First waiter of the ID listed before, output */
+			uint8_t *prev_pointer
+		)
+{
+	/* Look up the ID's wait list, and declare the list walk variables */
+	uint8_t bucket = (uint8_t)(message_id & (NUM_MSG_WAIT_BUCKETS_ROS - 1u));
+	uint8_t prev = NULL_TARG_ROS;
+	uint8_t first = gMsgWaitHeadArray_ROS[bucket];
+
+	/* Pass the first waiter of every other ID sharing the list */
+	while((first != NULL_TARG_ROS) && (gMsgWaitIDArray_ROS[first] != message_id))
+	{
+		prev = first;
+		first = gMsgWaitGroupArray_ROS[first];
+	}
+
+	/* Output the first waiter of the ID listed before, and return the ID's first waiter */
+	*prev_pointer = prev;
+	return first;
+}
+/***************************************************************************************************
+* End of _FindMsgWaitGroup_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _LinkMsgWaiter_ROS
+* Type			: Internal function, message wait.
+* Description	: Arms the wake up of a task waiting with WaitForMessage_ROS. An inbox wait is
+*				  flagged on the inbox. An ID wait is appended behind the ID's other waiters, or
+*				  heads its wait list if no other task waits for the ID.
+* Notes			: The task's wait ID must be stored. Waiters are not kept in priority order, as a
+*				  priority lent to a waiting task would leave the order stale.
+***************************************************************************************************/
+void _LinkMsgWaiter_ROS
+		(
+			/* Task vector (inbox) of the waiting task */
+			uint8_t task_vector
+		)
+{
+	/* Look up the message ID waited for */
+	MsgID_ROS message_id = gMsgWaitIDArray_ROS[task_vector];
+
+	/* Check if the task waits for its inbox */
+	if(message_id == MSG_WAIT_INBOX_ROS)
+	{
+		/* Flag the inbox, so the next message queues the task */
+		gMsgInboxWaitArray_ROS[task_vector] = true;
+	}
+	/* Task waits for a message ID */
+	else
+	{
+		/* Look up the ID's wait list and its first waiter */
+		uint8_t bucket = (uint8_t)(message_id & (NUM_MSG_WAIT_BUCKETS_ROS - 1u));
+		uint8_t prev;
+		uint8_t last = _FindMsgWaitGroup_ROS(message_id, &prev);
+
+		/* Check if no other task waits for the ID */
+		if(last == NULL_TARG_ROS)
+		{
+			/* Head the list with the task */
+			gMsgWaitGroupArray_ROS[task_vector] = gMsgWaitHeadArray_ROS[bucket];
+			gMsgWaitHeadArray_ROS[bucket] = task_vector;
+		}
+		/* Other tasks wait for the ID */
+		else
+		{
+			/* Find the ID's last waiter, and link the task in behind it */
+			while(gMsgWaitNextArray_ROS[last] != NULL_TARG_ROS)
+			{
+				last = gMsgWaitNextArray_ROS[last];
+			}
+			gMsgWaitNextArray_ROS[last] = task_vector;
+		}
+	}
+}
+/***************************************************************************************************
+* End of _LinkMsgWaiter_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _UnlinkMsgWaiter_ROS
+* Type			: Internal function, message wait.
+* Description	: Disarms the wake up of a task waiting with WaitForMessage_ROS, clearing its inbox
+*				  flag or removing it from its ID's waiters. If it is the ID's first waiter, the
+*				  next one takes its place in the wait list.
+* Notes			: The wait must be armed.
+***************************************************************************************************/
+void _UnlinkMsgWaiter_ROS
+		(
+			/* Task vector (inbox) of the waiting task */
+			uint8_t task_vector
+		)
+{
+	/* Look up the message ID waited for */
+	MsgID_ROS message_id = gMsgWaitIDArray_ROS[task_vector];
+
+	/* Check if the task waits for its inbox */
+	if(message_id == MSG_WAIT_INBOX_ROS)
+	{
+		/* Clear the inbox flag */
+		gMsgInboxWaitArray_ROS[task_vector] = false;
+	}
+	/* Task waits for a message ID */
+	else
+	{
+		/* Look up the ID's wait list and its first waiter */
+		uint8_t bucket = (uint8_t)(message_id & (NUM_MSG_WAIT_BUCKETS_ROS - 1u));
+		uint8_t prev_group;
+		uint8_t prev = _FindMsgWaitGroup_ROS(message_id, &prev_group);
+		uint8_t next = gMsgWaitNextArray_ROS[task_vector];
+
+		/* Check if the task is the ID's first waiter */
+		if(prev == task_vector)
+		{
+			/* Check if another task waits for the ID, and hand it the task's place */
+			if(next != NULL_TARG_ROS)
+			{
+				gMsgWaitGroupArray_ROS[next] = gMsgWaitGroupArray_ROS[task_vector];
+			}
+			/* No other waiter, the next ID's first waiter takes the task's place */
+			else
+			{
+				next = gMsgWaitGroupArray_ROS[task_vector];
+			}
+
+			/* Bypass the task in the wait list */
+			if(prev_group == NULL_TARG_ROS)
+			{
+				gMsgWaitHeadArray_ROS[bucket] = next;
+			}
+			else
+			{
+				gMsgWaitGroupArray_ROS[prev_group] = next;
+			}
+			gMsgWaitGroupArray_ROS[task_vector] = NULL_TARG_ROS;
+		}
+		/* Task is further down the ID's waiters */
+		else
+		{
+			/* Find the waiter before the task, and bypass the task */
+			while(gMsgWaitNextArray_ROS[prev] != task_vector)
+			{
+				prev = gMsgWaitNextArray_ROS[prev];
+			}
+			gMsgWaitNextArray_ROS[prev] = next;
+		}
+
+		/* Clear the task's link */
+		gMsgWaitNextArray_ROS[task_vector] = NULL_TARG_ROS;
+	}
+}
+/***************************************************************************************************
+* End of _UnlinkMsgWaiter_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _WakeMsgWaiter_ROS
+* Type			: Internal function, message wait.
+* Description	: Queues a task whose wake up has been disarmed by a message arriving. A wait
+*				  started with WaitForMessage_ROS is marked woken, and the priority it lent its
+*				  server is taken back straight away, as the server has delivered.
+* Notes			: Also wakes tasks waiting with WaitForInbox_ROS, which lend no priority.
+***************************************************************************************************/
+void _WakeMsgWaiter_ROS
+		(
+			/* Task vector (inbox) of the waiting task */
+			uint8_t task_vector
+		)
+{
+	/* Check if the wait was started by WaitForMessage_ROS */
+	if(gMsgWaitStateArray_ROS[task_vector] == MSG_WAIT_ARMED_ROS)
+	{
+		/* Check if a server holds the task's priority, and take it back */
+		if(gMsgWaitServerArray_ROS[task_vector] != MSG_TARG_GLOBAL_ROS)
+		{
+			(void)RestoreTaskPriority_ROS(gMsgWaitServerArray_ROS[task_vector]);
+			gMsgWaitServerArray_ROS[task_vector] = MSG_TARG_GLOBAL_ROS;
+		}
+
+		/* Wait is over, once the task resumes */
+		gMsgWaitStateArray_ROS[task_vector] = MSG_WAIT_WOKEN_ROS;
+	}
+
+	/* Queue the task */
+	QueueTask_ROS(task_vector);
+}
+/***************************************************************************************************
+* End of _WakeMsgWaiter_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _WakeMsgIDWaiter_ROS
+* Type			: Internal function, message wait.
+* Description	: Wakes the highest priority task waiting for a new message's ID, if any, the
+*				  longest waiting among equals. Priorities are compared now, so a priority lent to
+*				  a waiter since it started waiting counts. Other waiters on the ID stay waiting
+*				  for a later message.
+* Notes			: None.
+***************************************************************************************************/
+void _WakeMsgIDWaiter_ROS
+		(
+			/* Message table index of the new message */
+			uint8_t message_index
+		)
+{
+	/* Look up the message ID's first waiter, and declare the waiter walk variable */
+	uint8_t prev;
+	uint8_t task_vector = _FindMsgWaitGroup_ROS(_MsgIDOfIndex_ROS(message_index), &prev);
+	uint8_t next;
+
+	/* Check if a task waits for the ID */
+	if(task_vector != NULL_TARG_ROS)
+	{
+		/* Pick the highest priority waiter, keeping the earlier of equals */
+		for(next = gMsgWaitNextArray_ROS[task_vector]; next != NULL_TARG_ROS; \
+			next = gMsgWaitNextArray_ROS[next])
+		{
+			if(TASK_PRIORITY_ROS(gTaskVectorLookupArray_ROS[next]) > \
+			   TASK_PRIORITY_ROS(gTaskVectorLookupArray_ROS[task_vector]))
+			{
+				task_vector = next;
+			}
+		}
+
+		/* Disarm and wake the task */
+		_UnlinkMsgWaiter_ROS(task_vector);
+		_WakeMsgWaiter_ROS(task_vector);
+	}
+}
+/***************************************************************************************************
+* End of _WakeMsgIDWaiter_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _EndMsgWait_ROS
+* Type			: Internal function, message wait.
+* Description	: Ends a wait started with WaitForMessage_ROS. A wait still armed is disarmed, and
+*				  takes back the priority it lent its server.
+* Notes			: The caller cancels the timeout.
+***************************************************************************************************/
+void _EndMsgWait_ROS
+		(
+			/* Task vector (inbox) of the waiting task */
+			uint8_t task_vector
+		)
+{
+	/* Check if the wait is still armed */
+	if(gMsgWaitStateArray_ROS[task_vector] == MSG_WAIT_ARMED_ROS)
+	{
+		/* Disarm the wake up */
+		_UnlinkMsgWaiter_ROS(task_vector);
+
+		/* Check if a server holds the task's priority, and take it back */
+		if(gMsgWaitServerArray_ROS[task_vector] != MSG_TARG_GLOBAL_ROS)
+		{
+			(void)RestoreTaskPriority_ROS(gMsgWaitServerArray_ROS[task_vector]);
+			gMsgWaitServerArray_ROS[task_vector] = MSG_TARG_GLOBAL_ROS;
+		}
+	}
+
+	/* Task is no longer waiting */
+	gMsgWaitStateArray_ROS[task_vector] = MSG_WAIT_IDLE_ROS;
+	gMsgWaitTimedArray_ROS[task_vector] = false;
+}
+/***************************************************************************************************
+* End of _EndMsgWait_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _IsMsgWaitOver_ROS
+* Type			: Internal function, message wait.
+* Description	: Checks if a message a task waits for is there: any message in its inbox, or a
+*				  committed message with the ID. Returns true or false.
+* Notes			: In lock-free store mode a message only counts once it has been settled.
+***************************************************************************************************/
+uint8_t _IsMsgWaitOver_ROS
+		(
+			/* Task vector (inbox) of the waiting task */
+			uint8_t task_vector, \
+			/* Message ID waited for (MSG_WAIT_INBOX_ROS = any message in the inbox) */
+			MsgID_ROS message_id
+		)
+{
+	/* Declare message index container variable */
+	uint8_t message_index;
+
+	/* Check if the task waits for its inbox */
+	if(message_id == MSG_WAIT_INBOX_ROS)
+	{
+		/* Over if the inbox holds a message */
+		return (gMsgInboxHeadArray_ROS[task_vector] != NULL_MSG_ROS) ? TRUE_ROS : FALSE_ROS;
+	}
+	/* Check if the ID holds no message */
+	else if((message_index = _LookupMsgIndex_ROS(message_id)) == NULL_MSG_ROS)
+	{
+		return FALSE_ROS;
+	}
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Check if the message is reserved, or not yet settled */
+	else if(gMsgReservedArray_ROS[message_index] || !gMsgSettledArray_ROS[message_index])
+#else
+	/* Check if the message is reserved (not yet committed) */
+	else if(gMsgReservedArray_ROS[message_index])
+#endif
+	{
+		return FALSE_ROS;
+	}
+	/* Message is there */
+	else
+	{
+		return TRUE_ROS;
+	}
+}
+/***************************************************************************************************
+* End of _IsMsgWaitOver_ROS
+***************************************************************************************************/
+
+#if (ENABLE_MSG_TOPICS_ROS)
+/***************************************************************************************************
+* Name			: _TopicSubscriberSlot_ROS
+* Type			: Internal function, message topics.
+* Description	: Returns the subscriber slot holding a task vector on a topic, or
+*				  MAX_TOPIC_SUBSCRIBERS_ROS if there is none. Pass MSG_TARG_GLOBAL_ROS to find a
+*				  free slot.
+* Notes			: None.
+***************************************************************************************************/
+uint8_t _TopicSubscriberSlot_ROS
+		(
+			/* Topic to search */
+			uint8_t topic, \
+			/* Task vector to find */
+			uint8_t task_vector
+		)
+{
+	/* Declare slot loop variable */
+	uint8_t slot;
+
+	/* Search the topic's slots for the vector */
+	for(slot = 0u; slot < MAX_TOPIC_SUBSCRIBERS_ROS; slot++)
+	{
+		if(gMsgTopicSubscriberArray_ROS[topic][slot] == task_vector)
+		{
+			break;
+		}
+	}
+
+	/* Return slot found (MAX_TOPIC_SUBSCRIBERS_ROS if not found) */
+	return slot;
+}
+/***************************************************************************************************
+* End of _TopicSubscriberSlot_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _ReclaimTopicMessage_ROS
+* Type			: Internal function, message topics.
+* Description	: Deletes a published message if no subscriber still has to take it, and no taker
+*				  still holds it (its reference count has reached zero).
+* Notes			: Does nothing for messages that were not published. In lock-free store mode the
+*				  message is held before it is deleted, so a taker cannot pin it meanwhile.
+***************************************************************************************************/
+void _ReclaimTopicMessage_ROS
+		(
+			/* Message table index to check */
+			uint8_t message_index
+		)
+{
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Check if the message is published and unreferenced, and hold it if it is live and
+	   unpinned */
+	if((gMsgTopicArray_ROS[message_index] != NULL_TOPIC_ROS) && \
+	   (gMsgUnreadMaskArray_ROS[message_index] == 0u) && \
+	   (_HoldMsgSlot_ROS(message_index, (__atomic_load_n(&gMsgSlotArray_ROS[message_index], \
+						 __ATOMIC_ACQUIRE) & MSG_SLOT_VERSION_MASK_ROS) | MSG_SLOT_LIVE_ROS) == TRUE_ROS))
+#else
+	/* Check if the message is published, and unreferenced */
+	if((gMsgTopicArray_ROS[message_index] != NULL_TOPIC_ROS) && \
+	   (gMsgUnreadMaskArray_ROS[message_index] == 0u) && \
+	   (_MsgPinCount_ROS(message_index) == 0u))
+#endif
+	{
+		/* Delete the single copy */
+		_DeleteMsgIndex_ROS(message_index);
+	}
+}
+/***************************************************************************************************
+* End of _ReclaimTopicMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _UnlinkMsgTopic_ROS
+* Type			: Internal function, message topics.
+* Description	: Removes a published message from its topic list, and clears its references.
+* Notes			: The message must be published.
+***************************************************************************************************/
+void _UnlinkMsgTopic_ROS
+		(
+			/* Message table index to unlink */
+			uint8_t message_index
+		)
+{
+	/* Look up the message's topic and neighbours */
+	uint8_t topic = gMsgTopicArray_ROS[message_index];
+	uint8_t prev = gMsgTOC_ROS[message_index][MSG_TOPIC_PREV_ROS];
+	uint8_t next = gMsgTOC_ROS[message_index][MSG_TOPIC_NEXT_ROS];
+
+	/* Bypass the message going forwards */
+	if(prev == NULL_MSG_ROS)
+	{
+		gMsgTopicHeadArray_ROS[topic] = next;
+	}
+	else
+	{
+		gMsgTOC_ROS[prev][MSG_TOPIC_NEXT_ROS] = next;
+	}
+
+	/* Bypass the message going backwards */
+	if(next == NULL_MSG_ROS)
+	{
+		gMsgTopicTailArray_ROS[topic] = prev;
+	}
+	else
+	{
+		gMsgTOC_ROS[next][MSG_TOPIC_PREV_ROS] = prev;
+	}
+
+	/* Clear the message's topic and references */
+	gMsgTopicArray_ROS[message_index] = NULL_TOPIC_ROS;
+	gMsgUnreadMaskArray_ROS[message_index] = 0u;
+}
+/***************************************************************************************************
+* End of _UnlinkMsgTopic_ROS
+***************************************************************************************************/
+#endif
+
+/***************************************************************************************************
+* Name			: CreateMessages_ROS
+* Type			: API function, message system
+* Description	: This function creates a batch of messages, all or nothing. Every descriptor is
+*				  validated before anything is allocated; if the whole batch fits on top of the last
+*				  message it is allocated there as one contiguous run, otherwise each message is
+*				  placed like CreateMessage_ROS (split into a chain if no single space is large
+*				  enough, see ENABLE_MSG_CHAINS_ROS). Fails for the same conditions as
+*				  CreateMessage_ROS (or if an ID appears twice in the batch), outputting the
+*				  position of the failing descriptor; no message is created.
+* Notes			: The mounted check and index availability are checked once per batch. With
+*				  ENABLE_LOCK_FREE_MSGS_ROS set, slots are claimed one message at a time instead, and
+*				  each message is placed on top of the store.
+***************************************************************************************************/
+uint8_t CreateMessages_ROS
+		(
+			/* Pointer to the batch's message descriptors */
+			MsgDescriptor_ROS * messages, \
+			/* Number of messages in the batch */
+			uint8_t num_messages, \
+			/* Pointer to variable that will store the position of the failing descriptor */
+			uint8_t * failed_message
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Declare loop variables, batch byte total and result container variable */
+	uint8_t i, j, result;
+	uint32_t total_bytes = 0u;
+
+	/* Check if the message file system is mounted */
+	if(!gMsgFileSysMounted_R0S)
+	{
+		return F_MSG_FS_NOT_MOUNTED_ROS;
+	}
+#if !(ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Check if there are not enough free message indexes for the batch */
+	else if((uint16_t)num_messages > (uint16_t)gNumFreeMsgIndex_ROS + \
+			(uint16_t)(MAX_MSGS_ROS - gNextFreeMsgIndex_ROS))
+	{
+		/* Batch too large, return failure */
+		*failed_message = 0u;
+		return F_MAX_MSGS_REACHED_ROS;
+	}
+#endif
+
+	/* Validate every descriptor before anything is allocated */
+	for(i = 0u; i < num_messages; i++)
+	{
+		/* Check if the ID is valid and empty */
+		result = _IsMessageIDEmpty_ROS(messages[i].message_id);
+		if(result != TRUE_ROS)
+		{
+			*failed_message = i;
+			return (result == FALSE_ROS) ? F_MSG_ID_OCCUPIED_ROS : result;
+		}
+
+		/* Check if the size is in range */
+		result = _IsMessageSizeValid_ROS(messages[i].message_size);
+		if(result != TRUE_ROS)
+		{
+			*failed_message = i;
+			return result;
+		}
+
+		/* Check if the target vector has an inbox */
+		if(!IS_MSG_INBOX_ROS(messages[i].target_vector))
+		{
+			*failed_message = i;
+			return F_MSG_TARGET_INVALID_ROS;
+		}
+
+		/* Check if an earlier descriptor uses the same ID */
+		for(j = 0u; j < i; j++)
+		{
+			if(messages[j].message_id == messages[i].message_id)
+			{
+				*failed_message = i;
+				return F_MSG_ID_OCCUPIED_ROS;
+			}
+		}
+
+		/* Add to the batch total */
+		total_bytes += messages[i].message_size;
+	}
+
+	/* Place every message, undoing the batch if a placement fails */
+	for(i = 0u; i < num_messages; i++)
+	{
+#if !(ENABLE_LOCK_FREE_MSGS_ROS)
+		/* Check if the whole batch fits on top of the last message (a lock-free store can have
+		   space taken from the top by other creators at any time, so places each message on its
+		   own) */
+		if(((uint32_t)gNextFreeMsgLoc_ROS + total_bytes) < MAX_MSG_STOR_BYTES_ROS)
+		{
+			/* Place the message on top, taking the next index the same way as
+			   _FindMsgSpace_ROS */
+			result = _PlaceMessage_ROS
+					 (
+						messages[i].message_id, \
+						messages[i].target_vector, \
+						messages[i].time_to_live, \
+						messages[i].message_size, \
+						gNextFreeMsgLoc_ROS, \
+						(gNumFreeMsgIndex_ROS != 0u) ? \
+						gMsgFreeIndexArray_ROS[gNumFreeMsgIndex_ROS - 1u] : gNextFreeMsgIndex_ROS, \
+						false, \
+						NULL_HOLE_ROS
+					 );
+		}
+		/* Batch does not fit on top, place each message in the best space available */
+		else
+#endif
+		{
+			/* Declare found space container variables */
+			MsgLoc_ROS message_location;
+			uint8_t message_index, deleted_message_index;
+			bool is_deleted_location;
+
+			/* Find space for the message */
+			result = _FindMsgSpace_ROS
+					 (
+						messages[i].message_size, \
+						&message_location, \
+						&message_index, \
+						&is_deleted_location, \
+						&deleted_message_index
+					 );
+
+			/* Check if space was found */
+			if(result == SUCCESS_ROS)
+			{
+				/* Place the message in the space found */
+				result = _PlaceMessage_ROS
+						 (
+							messages[i].message_id, \
+							messages[i].target_vector, \
+							messages[i].time_to_live, \
+							messages[i].message_size, \
+							message_location, \
+							message_index, \
+							is_deleted_location, \
+							deleted_message_index
+						 );
+			}
+#if (ENABLE_MSG_CHAINS_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+			/* Check if no single free space is large enough for the message */
+			else if(result == F_INSUFF_FREE_MEM_ROS)
+			{
+				/* Split the message over several free spaces, as CreateMessage_ROS does */
+				result = _AllocateMsgChain_ROS
+						 (
+							messages[i].message_id, \
+							messages[i].target_vector, \
+							messages[i].time_to_live, \
+							messages[i].message_size
+						 );
+			}
+#endif
+		}
+
+		/* Check if the placement failed */
+		if(result != SUCCESS_ROS)
+		{
+			/* Output the failing descriptor */
+			*failed_message = i;
+
+			/* Delete the messages already placed, newest first so space on top merges back. None
+			   is delivered yet, so no inbox is changed (a lock-free store still holds them
+			   claimed, so they are only marked deleted) */
+			while(i != 0u)
+			{
+				i--;
+				_DeleteMsgIndex_ROS(_LookupMsgIndex_ROS(messages[i].message_id));
+			}
+
+			/* Batch not created, return failure */
+			return result;
+		}
+
+		/* Remove the message from the remaining batch total */
+		total_bytes -= messages[i].message_size;
+	}
+
+	/* Every message is placed, write the data in and deliver targeted messages */
+	for(i = 0u; i < num_messages; i++)
+	{
+		/* Look up the message's index */
+		uint8_t message_index = _LookupMsgIndex_ROS(messages[i].message_id);
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+		/* Copy the data into the store image, and make the message readable. Delivery, and the
+		   write through to the storage backend, are left to SettleMessageStore_ROS, which runs
+		   now if a task waits for the message */
+		memcpy(gMsgFileSysPtr_ROS + gMsgTOC_ROS[message_index][MSG_LOC_ROS], \
+			   messages[i].pointer_to_message, messages[i].message_size);
+		_PublishMsgSlot_ROS(message_index);
+		_SettleWaitedMsg_ROS(messages[i].target_vector, messages[i].message_id);
+#else
+		/* Write the message data (across its segments, if chained), and record the message in
+		   the on-media header. A backend failure is reported by the next
+		   FlushMessageStorage_ROS */
+		_ScatterMessageData_ROS(message_index, messages[i].pointer_to_message);
+		_StoreMsgRecord_ROS(message_index);
+
+		/* Deliver the message to its target's inbox */
+		_LinkMsgInbox_ROS(message_index);
+#endif
+	}
+
+	/* Batch created, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of CreateMessages_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: DeleteMessages_ROS
+* Type			: API function, message system
+* Description	: This function deletes a batch of messages by ID, all or nothing. Every ID is
+*				  checked (valid, occupied, not pinned, not repeated) before any is deleted. On
+*				  failure, the position of the failing ID is output and nothing is deleted.
+* Notes			: The mounted check is made once per batch. With ENABLE_LOCK_FREE_MSGS_ROS set,
+*				  every message is held before any is deleted, so other contexts see the batch
+*				  deleted at once (a repeated ID is found held, F_MSG_BUSY_ROS).
+***************************************************************************************************/
+uint8_t DeleteMessages_ROS
+		(
+			/* Pointer to the batch's message IDs */
+			MsgID_ROS * message_ids, \
+			/* Number of messages in the batch */
+			uint8_t num_messages, \
+			/* Pointer to variable that will store the position of the failing ID */
+			uint8_t * failed_message
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Declare loop variables and result container variable */
+	uint8_t i, j, result;
+
+	/* Check if the message file system is mounted */
+	if(!gMsgFileSysMounted_R0S)
+	{
+		return F_MSG_FS_NOT_MOUNTED_ROS;
+	}
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Hold every message before any is deleted, so no other context can pin or delete it
+	   meanwhile */
+	for(i = 0u; i < num_messages; i++)
+	{
+		/* Declare message index and slot word container variables */
+		uint8_t message_index;
+		uint32_t slot;
+
+		/* Retry until the slot word is swapped, or the message is found unable to be held */
+		do
+		{
+			/* Load the message's slot word, and check the message exists and is not borrowed
+			   or still being written */
+			result = _LoadMsgSlot_ROS(message_ids[i], &message_index, &slot);
+			if((result == SUCCESS_ROS) && (_MsgSlotPins_ROS(slot) != 0u))
+			{
+				result = F_MSG_PINNED_ROS;
+			}
+		}
+		while((result == SUCCESS_ROS) && (_HoldMsgSlot_ROS(message_index, slot) != TRUE_ROS));
+
+		/* Check if the message could not be held */
+		if(result != SUCCESS_ROS)
+		{
+			/* Output the failing ID, and let go of the messages already held */
+			*failed_message = i;
+			while(i != 0u)
+			{
+				i--;
+				_UnholdMsgSlot_ROS(_LookupMsgIndex_ROS(message_ids[i]));
+			}
+			return result;
+		}
+	}
+	(void)j;
+#else
+	/* Validate every ID before anything is deleted */
+	for(i = 0u; i < num_messages; i++)
+	{
+		/* Check if the ID is valid and occupied */
+		result = _IsMessageIDEmpty_ROS(message_ids[i]);
+		if(result != FALSE_ROS)
+		{
+			*failed_message = i;
+			return (result == TRUE_ROS) ? F_MSG_ID_EMPTY_ROS : result;
+		}
+
+		/* Check if the message is borrowed or reserved */
+		if(_MsgPinCount_ROS(_LookupMsgIndex_ROS(message_ids[i])) != 0u)
+		{
+			*failed_message = i;
+			return F_MSG_PINNED_ROS;
+		}
+
+		/* Check if an earlier entry deletes the same ID (it would be empty by now) */
+		for(j = 0u; j < i; j++)
+		{
+			if(message_ids[j] == message_ids[i])
+			{
+				*failed_message = i;
+				return F_MSG_ID_EMPTY_ROS;
+			}
+		}
+	}
+#endif
+
+	/* Delete every message. A delete can only fail if the deleted message table is full and
+	   cannot be defragmented, which a validated, unpinned batch cannot cause */
+	for(i = 0u; i < num_messages; i++)
+	{
+		result = _DeleteMsgIndex_ROS(_LookupMsgIndex_ROS(message_ids[i]));
+		if(result != SUCCESS_ROS)
+		{
+			*failed_message = i;
+			return result;
+		}
+	}
+
+	/* Batch deleted, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of DeleteMessages_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: ReadMessages_ROS
+* Type			: API function, message system
+* Description	: This function reads a batch of messages, all or nothing. Every descriptor is
+*				  checked (ID valid and occupied, message committed and readable by the running task,
+*				  read size within the message) before any data is copied. A message_size of 0 reads
+*				  the whole message, and is replaced by the size read. On failure, the position of
+*				  the failing descriptor is output and no data is copied.
+* Notes			: The mounted check is made once per batch. With ENABLE_LOCK_FREE_MSGS_ROS set,
+*				  every message is pinned while the batch is checked and copied.
+***************************************************************************************************/
+uint8_t ReadMessages_ROS
+		(
+			/* Pointer to the batch's read descriptors */
+			MsgDescriptor_ROS * messages, \
+			/* Number of messages in the batch */
+			uint8_t num_messages, \
+			/* Pointer to variable that will store the position of the failing descriptor */
+			uint8_t * failed_message
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Declare loop variable and result container variable */
+	uint8_t i, result;
+
+	/* Check if the message file system is mounted */
+	if(!gMsgFileSysMounted_R0S)
+	{
+		return F_MSG_FS_NOT_MOUNTED_ROS;
+	}
+
+	/* Validate every descriptor before any data is copied */
+	for(i = 0u; i < num_messages; i++)
+	{
+		/* Declare message index container variable */
+		uint8_t message_index;
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+		/* Pin the message, so it cannot be deleted, moved or reused until the batch is copied */
+		result = _PinMsgID_ROS(messages[i].message_id, &message_index);
+		if(result == SUCCESS_ROS)
+		{
+			/* Check if the message is addressed to another task */
+			if(_IsMessageOwner_ROS(message_index) != TRUE_ROS)
+			{
+				result = F_MSG_ACCESS_DENIED_ROS;
+			}
+			/* Check if more bytes are requested than the message holds */
+			else if(messages[i].message_size > _MsgTotalSize_ROS(message_index))
+			{
+				result = F_READ_GREATER_MSG_SIZE_ROS;
+			}
+
+			/* Check if the pinned message failed a check */
+			if(result != SUCCESS_ROS)
+			{
+				_UnpinMsgIndex_ROS(message_index);
+			}
+		}
+
+		/* Check if the message cannot be read */
+		if(result != SUCCESS_ROS)
+		{
+			/* Output the failing descriptor, and unpin the messages already checked */
+			*failed_message = i;
+			while(i != 0u)
+			{
+				i--;
+				_UnpinMsgIndex_ROS(_LookupMsgIndex_ROS(messages[i].message_id));
+			}
+			return result;
+		}
+#else
+		/* Check if the ID is valid and occupied */
+		result = _IsMessageIDEmpty_ROS(messages[i].message_id);
+		if(result != FALSE_ROS)
+		{
+			*failed_message = i;
+			return (result == TRUE_ROS) ? F_MSG_ID_EMPTY_ROS : result;
+		}
+
+		/* Look up the message's index */
+		message_index = _LookupMsgIndex_ROS(messages[i].message_id);
+
+		/* Check if the message is still being written */
+		if(gMsgReservedArray_ROS[message_index])
+		{
+			*failed_message = i;
+			return F_MSG_NOT_COMMITTED_ROS;
+		}
+		/* Check if the message is addressed to another task */
+		else if(_IsMessageOwner_ROS(message_index) != TRUE_ROS)
+		{
+			*failed_message = i;
+			return F_MSG_ACCESS_DENIED_ROS;
+		}
+		/* Check if more bytes are requested than the message holds */
+		else if(messages[i].message_size > _MsgTotalSize_ROS(message_index))
+		{
+			*failed_message = i;
+			return F_READ_GREATER_MSG_SIZE_ROS;
+		}
+#endif
+	}
+
+	/* Copy every message out */
+	for(i = 0u; i < num_messages; i++)
+	{
+		/* Look up the message's index */
+		uint8_t message_index = _LookupMsgIndex_ROS(messages[i].message_id);
+
+		/* Check if the whole message is requested */
+		if(messages[i].message_size == 0u)
+		{
+			/* Read the whole message, and report its size */
+			messages[i].message_size = _MsgTotalSize_ROS(message_index);
+		}
+
+		/* Copy the data out (across every segment of a chained message) */
+		_GatherMessageData_ROS(message_index, messages[i].pointer_to_message, \
+							   messages[i].message_size);
+	}
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Unpin every message */
+	for(i = 0u; i < num_messages; i++)
+	{
+		_UnpinMsgIndex_ROS(_LookupMsgIndex_ROS(messages[i].message_id));
+	}
+#endif
+
+	/* Batch read, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of ReadMessages_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: OptimizeMessageStorage_ROS
+* Type			: API function, message system
+* Description	: This function defragments the message store in small steps. Each step slides the
+*				  live message above the lowest hole down over it (or merges the hole into the next
+*				  hole or the top of the store), and patches the message's location in gMsgTOC_ROS.
+*				  At most max_steps steps are run. Returns success once no holes remain, or
+*				  F_MSG_DEFRAG_PENDING_ROS if more steps are needed.
+* Notes			: A step moves at most MAX_MSG_BYTES_ROS bytes and scans each table once, so its
+*				  worst case cost is fixed. Intended to be called from the idle task.
+***************************************************************************************************/
+uint8_t OptimizeMessageStorage_ROS
+		(
+			/* Maximum number of defragmentation steps to run */
+			uint8_t max_steps
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Check if the message file system is mounted */
+	if(!gMsgFileSysMounted_R0S)
+	{
+		return F_MSG_FS_NOT_MOUNTED_ROS;
+	}
+	/* File system mounted, run defragmentation steps */
+	else
+	{
+		/* Run steps until the budget is spent or no holes remain */
+		while((max_steps != 0u) && (_DefragStep_ROS() == TRUE_ROS))
+		{
+			max_steps--;
+		}
+
+		/* Check if any holes remain */
+		if(gNumDelMsg_ROS != 0u)
+		{
+			/* Defragmentation not complete, return pending */
+			return F_MSG_DEFRAG_PENDING_ROS;
+		}
+		/* Store is fully compacted */
+		else
+		{
+			/* Defragmentation complete, return success */
+			return SUCCESS_ROS;
+		}
+	}
+}
+/***************************************************************************************************
+* End of OptimizeMessageStorage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: FlushMessageStorage_ROS
+* Type			: API function, message system
+* Description	: This function commits any writes buffered by the storage backend to the medium.
+*				  Succeeds without doing anything if the file system was mounted without a backend.
+* Notes			: Buffering backends coalesce small writes until flushed, so intended to be called
+*				  from the idle task, and before power down.
+***************************************************************************************************/
+uint8_t FlushMessageStorage_ROS
+		(
+			void
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Check if the message file system is mounted */
+	if(!gMsgFileSysMounted_R0S)
+	{
+		return F_MSG_FS_NOT_MOUNTED_ROS;
+	}
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Check if writes left to settle by lock-free creates and deletes failed, clearing the
+	   failure */
+	else if(__atomic_exchange_n(&gMsgSettleResult_ROS, SUCCESS_ROS, __ATOMIC_RELAXED) != SUCCESS_ROS)
+	{
+		/* Medium out of date, return failure */
+		return F_MSG_STORAGE_FAILED_ROS;
+	}
+#endif
+	/* Check if there is no storage backend */
+	else if(gMsgStorageBackend_ROS == 0)
+	{
+		/* Nothing buffered, return success */
+		return SUCCESS_ROS;
+	}
+	/* Check if the backend flush failed */
+	else if(gMsgStorageBackend_ROS->flush(gMsgStorageBackend_ROS->context) != SUCCESS_ROS)
+	{
+		/* Medium out of date, return failure */
+		return F_MSG_STORAGE_FAILED_ROS;
+	}
+	/* Backend flushed */
+	else
+	{
+		/* Medium up to date, return success */
+		return SUCCESS_ROS;
+	}
+}
+/***************************************************************************************************
+* End of FlushMessageStorage_ROS
+***************************************************************************************************/
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+/***************************************************************************************************
+* Name			: SettleMessageStore_ROS
+* Type			: API function, message system
+* Description	: This function finishes the work the lock-free functions leave behind, for every
+*				  message created or deleted since the last call, oldest first. A created message is
+*				  delivered to its target's inbox (queueing the target task if it is waiting),
+*				  scheduled to expire, and written through to the storage backend. A deleted message
+*				  is removed from its inbox, topic and the expiry heap, its space is returned to the
+*				  free space, its on-media record is invalidated, and its slot is freed for reuse.
+*				  Returns success, or F_MSG_STORAGE_FAILED_ROS if a backend write failed since the
+*				  failure was last returned (here or by FlushMessageStorage_ROS).
+* Notes			: Only with ENABLE_LOCK_FREE_MSGS_ROS set. Every function that owns the store settles
+*				  on entry and on return, and a create settles at once if a task waits for the
+*				  message; call this from the idle task, so other messages are written through
+*				  promptly. Only one context owns the store at a time: a call made while another
+*				  owns it (from an interrupt handler) returns success at once, and the owner settles
+*				  the work before it lets go. A deleted message whose space cannot be released
+*				  (deleted message table full and not defragmentable) is retried on the next call.
+***************************************************************************************************/
+uint8_t SettleMessageStore_ROS
+		(
+			void
+		)
+{
+	/* Declare result container variable */
+	uint8_t result = SUCCESS_ROS;
+
+	/* Check if the message file system is mounted */
+	if(!gMsgFileSysMounted_R0S)
+	{
+		return F_MSG_FS_NOT_MOUNTED_ROS;
+	}
+
+#if (ENABLE_SMP_ROS)
+	/* Take the kernel lock, which every owner on another core holds */
+	_LockKernel_ROS();
+#endif
+
+	/* Take the store, and check if no other context owns it (an owner settles the work before
+	   it lets go, so there is nothing to wait for) */
+	if(!__atomic_exchange_n(&gMsgStoreOwned_ROS, true, __ATOMIC_ACQUIRE))
+	{
+		/* Settle, and take the result of the settles since the last report */
+		_SettleMsgStore_ROS();
+		result = __atomic_exchange_n(&gMsgSettleResult_ROS, SUCCESS_ROS, __ATOMIC_RELAXED);
+
+		/* Give the store up */
+		_ReleaseMsgStore_ROS();
+	}
+
+#if (ENABLE_SMP_ROS)
+	(void)_UnlockKernel_ROS(SUCCESS_ROS);
+#endif
+
+	/* Return the result */
+	return result;
+}
+/***************************************************************************************************
+* End of SettleMessageStore_ROS
+***************************************************************************************************/
+#endif
+
+/***************************************************************************************************
+* Name			: ReserveMessage_ROS
+* Type			: API function, message system
+* Description	: This function creates a new message like CreateMessage_ROS, but instead of copying
+*				  the data in, outputs a pointer to the message's space in the store so the caller
+*				  can write the data in place. The message cannot be read or deleted, and will not
+*				  be moved, until CommitMessage_ROS is called. Fails for the same conditions as
+*				  CreateMessage_ROS.
+* Notes			: The pointer is only valid until CommitMessage_ROS is called.
+***************************************************************************************************/
+uint8_t ReserveMessage_ROS
+		(
+			/* Desired ID for new message */
+			MsgID_ROS message_id, \
+			/* Target task vector to address message to */
+			uint8_t target_vector, \
+			/* New messages maximum time to live */
+			uint8_t time_to_live, \
+			/* Size of the new message in bytes */
+			MsgSize_ROS message_size, \
+			/* Pointer to variable that will store the pointer to the message's space */
+			uint8_t ** pointer_to_space
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Allocate the message's table entry and space, and store the result in a container
+	   variable */
+	uint8_t is_allocated = _AllocateMessage_ROS
+						   (
+								message_id, \
+								target_vector, \
+								time_to_live, \
+								message_size
+						   );
+
+	/* Check if the allocation failed */
+	if(is_allocated != SUCCESS_ROS)
+	{
+		/* Allocation failed, return error code */
+		return is_allocated;
+	}
+	/* Allocation successful, hand out the space */
+	else
+	{
+		/* Look up the new message's index */
+		uint8_t message_index = _LookupMsgIndex_ROS(message_id);
+
+		/* Mark the message reserved, and pin it while the caller writes (a lock-free store's
+		   message keeps the pin taken when its slot was claimed) */
+		gMsgReservedArray_ROS[message_index] = true;
+#if !(ENABLE_LOCK_FREE_MSGS_ROS)
+		_PinMsgIndex_ROS(message_index);
+#endif
+
+		/* Output a pointer to the message's space */
+		*pointer_to_space = gMsgFileSysPtr_ROS + gMsgTOC_ROS[message_index][MSG_LOC_ROS];
+
+		/* Message reserved, return success */
+		return SUCCESS_ROS;
+	}
+}
+/***************************************************************************************************
+* End of ReserveMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: CommitMessage_ROS
+* Type			: API function, message system
+* Description	: This function publishes a message reserved with ReserveMessage_ROS, once its data
+*				  has been written in place. Fails if the ID is invalid, empty or not reserved.
+* Notes			: None.
+***************************************************************************************************/
+uint8_t CommitMessage_ROS
+		(
+			/* Reserved message ID to commit */
+			MsgID_ROS message_id
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Check if message ID is valid, and contains a message. Store result in container variable */
+	uint8_t is_id_empty = _IsMessageIDEmpty_ROS(message_id);
+
+	/* Check message empty check result is true */
+	if(is_id_empty == TRUE_ROS)
+	{
+		/* Message ID does not contain a message, return failure */
+		return F_MSG_ID_EMPTY_ROS;
+	}
+	/* Check if message empty check result is not true or false (must be error code) */
+	else if(is_id_empty != FALSE_ROS)
+	{
+		/* Message ID invalid, return failure */
+		return is_id_empty;
+	}
+	/* Check if the message is reserved */
+	else if(!gMsgReservedArray_ROS[_LookupMsgIndex_ROS(message_id)])
+	{
+		/* Message already committed, return failure */
+		return F_MSG_NOT_RESERVED_ROS;
+	}
+	/* Input validation successful, publish the message */
+	else
+	{
+		/* Look up the message's index */
+		uint8_t message_index = _LookupMsgIndex_ROS(message_id);
+
+		/* Clear the reservation */
+		gMsgReservedArray_ROS[message_index] = false;
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+		/* Look up the message's target before it is readable (and can be deleted) */
+		uint8_t target_vector = gMsgTOC_ROS[message_index][MSG_TARG_ROS];
+
+		/* Make the message readable, dropping its pin. Delivery, and the write through to the
+		   storage backend, are left to SettleMessageStore_ROS, which runs now if a task waits for
+		   the message */
+		_PublishMsgSlot_ROS(message_index);
+		_SettleWaitedMsg_ROS(target_vector, message_id);
+		return SUCCESS_ROS;
+#else
+		/* Drop the reservation's pin */
+		_UnpinMsgIndex_ROS(message_index);
+
+		/* Deliver the message to its target's inbox */
+		_LinkMsgInbox_ROS(message_index);
+
+		/* The data was written in place, so write it through to the storage backend now, and
+		   check for failure */
+		if(_StoreMessageData_ROS(gMsgTOC_ROS[message_index][MSG_LOC_ROS], \
+								 gMsgTOC_ROS[message_index][MSG_SIZE_ROS]) != SUCCESS_ROS)
+		{
+			return F_MSG_STORAGE_FAILED_ROS;
+		}
+
+		/* Record the message in the on-media header, and return the write result */
+		return _StoreMsgRecord_ROS(message_index);
+#endif
+	}
+}
+/***************************************************************************************************
+* End of CommitMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: BorrowMessage_ROS
+* Type			: API function, message system
+* Description	: This function outputs a pointer to a message's data in the store, and its size,
+*				  without copying it. The message is pinned (cannot be moved or deleted) until a
+*				  matching ReleaseMessage_ROS call. Fails if the ID is invalid, empty, not yet
+*				  committed, the message already has MAX_MSG_PINS_ROS pins, or it is chained
+*				  (F_MSG_CHAINED_ROS, borrow it with BorrowMessageSegments_ROS instead).
+* Notes			: The data must be treated as read only.
+***************************************************************************************************/
+uint8_t BorrowMessage_ROS
+		(
+			/* Message ID to borrow */
+			MsgID_ROS message_id, \
+			/* Pointer to variable that will store the pointer to the message's data */
+			uint8_t ** pointer_to_data, \
+			/* Pointer to variable that will store the message's size in bytes */
+			MsgSize_ROS * message_size
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Declare single element scatter / gather list, and segment counter */
+	MsgSegment_ROS segment;
+	uint8_t num_segments;
+
+	/* Borrow the message as a list of one segment, and store the result in a container
+	   variable */
+	uint8_t is_borrowed = BorrowMessageSegments_ROS(message_id, &segment, 1u, &num_segments);
+
+	/* Check if the borrow succeeded */
+	if(is_borrowed == SUCCESS_ROS)
+	{
+		/* Output the message's data pointer and size */
+		*pointer_to_data = segment.pointer_to_data;
+		*message_size = segment.segment_size;
+	}
+
+	/* Return the result */
+	return is_borrowed;
+}
+/***************************************************************************************************
+* End of BorrowMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: BorrowMessageSegments_ROS
+* Type			: API function, message system
+* Description	: This function outputs a message's data in the store as a scatter / gather list,
+*				  one element (pointer and size) per segment, without copying it. A message that is
+*				  not chained has one segment. The message is pinned (cannot be moved or deleted)
+*				  until a matching ReleaseMessage_ROS call. Fails if the ID is invalid, empty, not
+*				  yet committed, the message already has MAX_MSG_PINS_ROS pins, or has more segments
+*				  than the list holds (F_MSG_CHAINED_ROS).
+* Notes			: The data must be treated as read only. A list of MAX_MSG_SEGMENTS_ROS elements
+*				  holds any message.
+***************************************************************************************************/
+uint8_t BorrowMessageSegments_ROS
+		(
+			/* Message ID to borrow */
+			MsgID_ROS message_id, \
+			/* Pointer to the scatter / gather list to fill */
+			MsgSegment_ROS * segments, \
+			/* Number of elements in the list */
+			uint8_t max_segments, \
+			/* Pointer to variable that will store the number of segments output */
+			uint8_t * num_segments
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Declare segment walk and counter variables */
+	uint8_t i, segment_count = 0u;
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Pin the message (messages are never chained, so it is a single segment), and store the
+	   result in a container variable */
+	uint8_t is_id_empty = _PinMsgID_ROS(message_id, &i);
+
+	/* Check if the message could not be pinned */
+	if(is_id_empty != SUCCESS_ROS)
+	{
+		/* Return the error code */
+		return is_id_empty;
+	}
+	/* Check if the message is addressed to another task */
+	else if(_IsMessageOwner_ROS(i) != TRUE_ROS)
+	{
+		/* Message is not readable by the running task, unpin it and return failure */
+		_UnpinMsgIndex_ROS(i);
+		return F_MSG_ACCESS_DENIED_ROS;
+	}
+	/* Check if the list has no elements */
+	else if(max_segments == 0u)
+	{
+		/* Message cannot be lent in this list, unpin it and return failure */
+		_UnpinMsgIndex_ROS(i);
+		return F_MSG_CHAINED_ROS;
+	}
+	/* Message pinned, lend it */
+	else
+	{
+		/* Output the message's only segment */
+		segments[0].pointer_to_data = gMsgFileSysPtr_ROS + gMsgTOC_ROS[i][MSG_LOC_ROS];
+		segments[0].segment_size = gMsgTOC_ROS[i][MSG_SIZE_ROS];
+		*num_segments = 1u;
+		(void)segment_count;
+
+		/* Message borrowed, return success */
+		return SUCCESS_ROS;
+	}
+#else
+	/* Check if message ID is valid, and contains a message. Store result in container variable */
+	uint8_t is_id_empty = _IsMessageIDEmpty_ROS(message_id);
+
+	/* Check message empty check result is true */
+	if(is_id_empty == TRUE_ROS)
+	{
+		/* Message ID does not contain a message, return failure */
+		return F_MSG_ID_EMPTY_ROS;
+	}
+	/* Check if message empty check result is not true or false (must be error code) */
+	else if(is_id_empty != FALSE_ROS)
+	{
+		/* Message ID invalid, return failure */
+		return is_id_empty;
+	}
+
+	/* Count the message's segments */
+	for(i = _LookupMsgIndex_ROS(message_id); i != NULL_MSG_ROS; i = _NextMsgSegment_ROS(i))
+	{
+		segment_count++;
+	}
+
+	/* Check if the message is still being written */
+	if(gMsgReservedArray_ROS[_LookupMsgIndex_ROS(message_id)])
+	{
+		/* Message not committed, return failure */
+		return F_MSG_NOT_COMMITTED_ROS;
+	}
+	/* Check if the message is addressed to another task */
+	else if(_IsMessageOwner_ROS(_LookupMsgIndex_ROS(message_id)) != TRUE_ROS)
+	{
+		/* Message is not readable by the running task, return failure */
+		return F_MSG_ACCESS_DENIED_ROS;
+	}
+	/* Check if the pin count is saturated */
+	else if(_MsgPinCount_ROS(_LookupMsgIndex_ROS(message_id)) == MAX_MSG_PINS_ROS)
+	{
+		/* Cannot pin again, return failure */
+		return F_MSG_PINNED_ROS;
+	}
+	/* Check if the list is too short for the message's segments */
+	else if(segment_count > max_segments)
+	{
+		/* Message cannot be lent in this list, return failure */
+		return F_MSG_CHAINED_ROS;
+	}
+	/* Input validation successful, lend the message */
+	else
+	{
+		/* Pin every segment (so none can be moved by the defragmenter), and output it */
+		segment_count = 0u;
+		for(i = _LookupMsgIndex_ROS(message_id); i != NULL_MSG_ROS; i = _NextMsgSegment_ROS(i))
+		{
+			_PinMsgIndex_ROS(i);
+			segments[segment_count].pointer_to_data = gMsgFileSysPtr_ROS + gMsgTOC_ROS[i][MSG_LOC_ROS];
+			segments[segment_count].segment_size = gMsgTOC_ROS[i][MSG_SIZE_ROS];
+			segment_count++;
+		}
+
+		/* Output the number of segments */
+		*num_segments = segment_count;
+
+		/* Message borrowed, return success */
+		return SUCCESS_ROS;
+	}
+#endif
+}
+/***************************************************************************************************
+* End of BorrowMessageSegments_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: ReleaseMessage_ROS
+* Type			: API function, message system
+* Description	: This function ends a borrow started with BorrowMessage_ROS,
+*				  BorrowMessageSegments_ROS or TakeTopicMessage_ROS, dropping its pin. A published
+*				  message is deleted when its last subscriber releases it. Fails if the ID is
+*				  invalid, empty, or the message is not borrowed.
+* Notes			: The borrowed pointer must not be used after this call.
+***************************************************************************************************/
+uint8_t ReleaseMessage_ROS
+		(
+			/* Borrowed message ID to release */
+			MsgID_ROS message_id
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Declare message index and slot word container variables */
+	uint8_t message_index;
+	uint32_t slot;
+
+	/* Retry until the slot word is swapped, or the message is found not borrowed */
+	while(true)
+	{
+		/* Load the message's slot word, and check the message exists */
+		uint8_t is_id_empty = _LoadMsgSlot_ROS(message_id, &message_index, &slot);
+		if(is_id_empty != SUCCESS_ROS)
+		{
+			return is_id_empty;
+		}
+		/* Check if the message is still being written (only its writer pins it), or holds no
+		   pins */
+		else if((_MsgSlotState_ROS(slot) != MSG_SLOT_LIVE_ROS) || (_MsgSlotPins_ROS(slot) == 0u))
+		{
+			/* Message not borrowed, return failure */
+			return F_MSG_NOT_BORROWED_ROS;
+		}
+		/* Check if the slot word is unchanged, and drop the pin */
+		else if(__atomic_compare_exchange_n(&gMsgSlotArray_ROS[message_index], &slot, \
+											slot - MSG_SLOT_PIN_ROS, false, __ATOMIC_ACQ_REL, \
+											__ATOMIC_ACQUIRE))
+		{
+#if (ENABLE_MSG_TOPICS_ROS)
+			/* Check if this was the last pin of a published message, and have the settle delete
+			   it if it was also its last reference */
+			if((_MsgSlotPins_ROS(slot) == 1u) && \
+			   (gMsgTopicArray_ROS[message_index] != NULL_TOPIC_ROS))
+			{
+				_PushMsgSettle_ROS(message_index);
+				(void)SettleMessageStore_ROS();
+			}
+#endif
+
+			/* Message released, return success */
+			return SUCCESS_ROS;
+		}
+	}
+#else
+	/* Check if message ID is valid, and contains a message. Store result in container variable */
+	uint8_t is_id_empty = _IsMessageIDEmpty_ROS(message_id);
+
+	/* Check message empty check result is true */
+	if(is_id_empty == TRUE_ROS)
+	{
+		/* Message ID does not contain a message, return failure */
+		return F_MSG_ID_EMPTY_ROS;
+	}
+	/* Check if message empty check result is not true or false (must be error code) */
+	else if(is_id_empty != FALSE_ROS)
+	{
+		/* Message ID invalid, return failure */
+		return is_id_empty;
+	}
+	/* Check if the message holds any borrow pins (a reservation pin is not a borrow) */
+	else if(_MsgPinCount_ROS(_LookupMsgIndex_ROS(message_id)) <= \
+			(gMsgReservedArray_ROS[_LookupMsgIndex_ROS(message_id)] ? 1u : 0u))
+	{
+		/* Message not borrowed, return failure */
+		return F_MSG_NOT_BORROWED_ROS;
+	}
+	/* Input validation successful, drop the pin */
+	else
+	{
+		/* Declare segment walk variable */
+		uint8_t i;
+
+		/* Unpin the message, and every segment of a chained message */
+		for(i = _LookupMsgIndex_ROS(message_id); i != NULL_MSG_ROS; i = _NextMsgSegment_ROS(i))
+		{
+			_UnpinMsgIndex_ROS(i);
+		}
+
+#if (ENABLE_MSG_TOPICS_ROS)
+		/* Delete a published message if this was its last reference */
+		_ReclaimTopicMessage_ROS(_LookupMsgIndex_ROS(message_id));
+#endif
+
+		/* Message released, return success */
+		return SUCCESS_ROS;
+	}
+#endif
+}
+/***************************************************************************************************
+* End of ReleaseMessage_ROS
+***************************************************************************************************/
+
+#if (ENABLE_MSG_EXPIRY_ROS)
+/***************************************************************************************************
+* Name			: TickMessageExpiry_ROS
+* Type			: API function, message system
+* Description	: This function advances the message expiry clock by one tick, and deletes every
+*				  message whose time to live has run out, returning its space to the free space.
+*				  Returns the number of messages deleted.
+* Notes			: Only the root of the expiry heap is examined until it is not yet due, so the cost
+*				  depends on the number of messages expiring, not the number stored. A pinned
+*				  message (borrowed or reserved) cannot be deleted, so its expiry is retried on the
+*				  next tick. Call once per system tick, outside interrupt context.
+***************************************************************************************************/
+uint8_t TickMessageExpiry_ROS
+		(
+			void
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+
+	/* Advance the expiry clock by one tick */
+	return AdvanceMessageExpiry_ROS(1u);
+}
+/***************************************************************************************************
+* End of TickMessageExpiry_ROS
+***************************************************************************************************/
+#endif
+
+/***************************************************************************************************
+* Name			: AdvanceMessageExpiry_ROS
+* Type			: API function, message system
+* Description	: This function advances the message expiry clock by a number of ticks at once, and
+*				  deletes every message whose time to live ran out meanwhile, as that many calls to
+*				  TickMessageExpiry_ROS would. Returns the number of messages deleted.
+* Notes			: Used to catch up after a tickless idle sleep. Does nothing without
+*				  ENABLE_MSG_EXPIRY_ROS.
+***************************************************************************************************/
+uint8_t AdvanceMessageExpiry_ROS
+		(
+			/* Number of ticks to advance the expiry clock by */
+			uint32_t ticks
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+#if (ENABLE_MSG_EXPIRY_ROS)
+	/* Declare expired message counter */
+	uint8_t num_expired = 0u;
+
+	/* Advance the expiry clock (read by lock-free creates) */
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	__atomic_fetch_add(&gMsgExpiryTick_ROS, ticks, __ATOMIC_RELAXED);
+#else
+	gMsgExpiryTick_ROS += ticks;
+#endif
+
+	/* Check if the message file system is mounted */
+	if(!gMsgFileSysMounted_R0S)
+	{
+		return 0u;
+	}
+
+	/* Expire messages from the root of the heap while the earliest expiry is due (the signed
+	   difference keeps the comparison correct when the clock wraps) */
+	while((gNumExpiryMsg_ROS != 0u) && \
+		  ((int32_t)(gMsgExpiryTickArray_ROS[gMsgExpiryHeap_ROS[1]] - gMsgExpiryTick_ROS) <= 0))
+	{
+		/* Look up the earliest expiring message */
+		uint8_t message_index = gMsgExpiryHeap_ROS[1];
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+		/* Load the message's slot word */
+		uint32_t slot = __atomic_load_n(&gMsgSlotArray_ROS[message_index], __ATOMIC_ACQUIRE);
+
+		/* Check if the message was deleted since the store was settled */
+		if(_MsgSlotState_ROS(slot) == MSG_SLOT_DELETED_ROS)
+		{
+			/* Cancel its expiry, the settle does the rest */
+			_RemoveMsgExpiry_ROS(message_index);
+		}
+		/* Check if the message is pinned or held, and hold it so it cannot be pinned meanwhile */
+		else if((_MsgSlotState_ROS(slot) != MSG_SLOT_LIVE_ROS) || (_MsgSlotPins_ROS(slot) != 0u) || \
+				(_HoldMsgSlot_ROS(message_index, slot) != TRUE_ROS))
+		{
+			/* Retry the expiry on the next tick */
+			gMsgExpiryTickArray_ROS[message_index] = gMsgExpiryTick_ROS + 1u;
+			_SiftMsgExpiry_ROS(1u);
+		}
+		/* Message held */
+		else
+		{
+			/* Delete it (its space is released when the store is settled), and cancel its
+			   expiry */
+			_DeleteMsgIndex_ROS(message_index);
+			_RemoveMsgExpiry_ROS(message_index);
+			num_expired++;
+		}
+#else
+		/* Check if the message is pinned, or its space cannot be released */
+		if((_MsgPinCount_ROS(message_index) != 0u) || \
+		   (_DeleteMsgIndex_ROS(message_index) != SUCCESS_ROS))
+		{
+			/* Retry the expiry on the next tick */
+			gMsgExpiryTickArray_ROS[message_index] = gMsgExpiryTick_ROS + 1u;
+			_SiftMsgExpiry_ROS(1u);
+		}
+		/* Message deleted */
+		else
+		{
+			num_expired++;
+		}
+#endif
+	}
+
+	/* Return number of messages deleted */
+	return num_expired;
+#else
+	/* No expiry clock to advance */
+	(void)ticks;
+	return 0u;
+#endif
+}
+/***************************************************************************************************
+* End of AdvanceMessageExpiry_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: NextMessageExpiry_ROS
+* Type			: API function, message system
+* Description	: This function returns the number of expiry clock ticks until the next message is
+*				  due to expire (0 if one is due now), or 0xFFFFFFFF if no message has a time to
+*				  live. Used by the scheduler's tickless idle to find when it must wake.
+* Notes			: The root of the expiry heap is the earliest expiry, so this runs in constant time.
+*				  Returns 0xFFFFFFFF without ENABLE_MSG_EXPIRY_ROS.
+***************************************************************************************************/
+uint32_t NextMessageExpiry_ROS
+		(
+			void
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+#if (ENABLE_MSG_EXPIRY_ROS)
+	/* Check if no message is waiting to expire */
+	if(!gMsgFileSysMounted_R0S || (gNumExpiryMsg_ROS == 0u))
+	{
+		/* No expiry due, return none */
+		return 0xFFFFFFFFul;
+	}
+	/* Check if the earliest expiry is already due */
+	else if((int32_t)(gMsgExpiryTickArray_ROS[gMsgExpiryHeap_ROS[1]] - gMsgExpiryTick_ROS) <= 0)
+	{
+		/* Expiry due now, return 0 */
+		return 0u;
+	}
+	/* Earliest expiry is ahead */
+	else
+	{
+		/* Return ticks until it is due */
+		return gMsgExpiryTickArray_ROS[gMsgExpiryHeap_ROS[1]] - gMsgExpiryTick_ROS;
+	}
+#else
+	/* No message expires, return none */
+	return 0xFFFFFFFFul;
+#endif
+}
+/***************************************************************************************************
+* End of NextMessageExpiry_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: PeekMessage_ROS
+* Type			: API function, message system
+* Description	: This function outputs the ID and size of the oldest message in the running task's
+*				  inbox, without removing it. Fails with F_MSG_INBOX_EMPTY_ROS if the inbox is empty,
+*				  or F_MSG_NO_RUNNING_TASK_ROS if called outside a task.
+* Notes			: Only messages addressed to the task's vector are in its inbox; global messages are
+*				  read by ID.
+***************************************************************************************************/
+uint8_t PeekMessage_ROS
+		(
+			/* Pointer to variable that will store the message ID */
+			MsgID_ROS * message_id, \
+			/* Pointer to variable that will store the message size */
+			MsgSize_ROS * message_size
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Declare inbox container variable, and look up the running task's inbox */
+	uint8_t inbox;
+	uint8_t is_inbox_found = _RunningTaskInbox_ROS(&inbox);
+
+	/* Check if the running task has no inbox */
+	if(is_inbox_found != SUCCESS_ROS)
+	{
+		/* No inbox, return failure */
+		return is_inbox_found;
+	}
+	/* Check if the inbox is empty */
+	else if(gMsgInboxHeadArray_ROS[inbox] == NULL_MSG_ROS)
+	{
+		/* Nothing to peek, return failure */
+		return F_MSG_INBOX_EMPTY_ROS;
+	}
+	/* Inbox holds at least one message */
+	else
+	{
+		/* Output the oldest message's ID and size */
+		*message_id = _MsgIDOfIndex_ROS(gMsgInboxHeadArray_ROS[inbox]);
+		*message_size = _MsgTotalSize_ROS(gMsgInboxHeadArray_ROS[inbox]);
+
+		/* Peek successful, return success */
+		return SUCCESS_ROS;
+	}
+}
+/***************************************************************************************************
+* End of PeekMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: ReceiveMessage_ROS
+* Type			: API function, message system
+* Description	: This function copies the oldest message in the running task's inbox into the
+*				  destination buffer, outputs its ID and size, and deletes it. The following
+*				  conditions will cause the receive to fail, leaving the message in the inbox:
+*					- Called outside a task
+*					- Inbox empty
+*					- Message larger than buffer_size
+*					- Message borrowed (pinned)
+* Notes			: The oldest message is the inbox head, so the cost does not depend on the number of
+*				  messages stored.
+***************************************************************************************************/
+uint8_t ReceiveMessage_ROS
+		(
+			/* Size of the destination buffer, in bytes */
+			MsgSize_ROS buffer_size, \
+			/* Pointer to the destination buffer */
+			uint8_t * pointer_to_destination, \
+			/* Pointer to variable that will store the message ID */
+			MsgID_ROS * message_id, \
+			/* Pointer to variable that will store the message size */
+			MsgSize_ROS * message_size
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Declare inbox and message index container variables, and look up the running task's
+	   inbox */
+	uint8_t inbox, message_index;
+	uint8_t is_inbox_found = _RunningTaskInbox_ROS(&inbox);
+
+	/* Check if the running task has no inbox */
+	if(is_inbox_found != SUCCESS_ROS)
+	{
+		/* No inbox, return failure */
+		return is_inbox_found;
+	}
+
+	/* Look up the oldest message */
+	message_index = gMsgInboxHeadArray_ROS[inbox];
+
+	/* Check if the inbox is empty */
+	if(message_index == NULL_MSG_ROS)
+	{
+		/* Nothing to receive, return failure */
+		return F_MSG_INBOX_EMPTY_ROS;
+	}
+	/* Check if the message does not fit the buffer */
+	else if(_MsgTotalSize_ROS(message_index) > buffer_size)
+	{
+		/* Buffer too small, return failure */
+		return F_MSG_SIZE_TOO_LARGE_ROS;
+	}
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Check if the message is borrowed, or held by another function, and hold it so it cannot be
+	   pinned or deleted meanwhile (it was settled, so it is committed) */
+	else if(_HoldMsgSlot_ROS(message_index, (__atomic_load_n(&gMsgSlotArray_ROS[message_index], \
+							 __ATOMIC_ACQUIRE) & MSG_SLOT_VERSION_MASK_ROS) | \
+							 MSG_SLOT_LIVE_ROS) != TRUE_ROS)
+#else
+	/* Check if the message is borrowed */
+	else if(_MsgPinCount_ROS(message_index) != 0u)
+#endif
+	{
+		/* Message data is still in use, cannot delete. Return failure */
+		return F_MSG_PINNED_ROS;
+	}
+	/* Input validation successful, receive the message */
+	else
+	{
+		/* Copy the message data out, and output its ID and size */
+		*message_size = _MsgTotalSize_ROS(message_index);
+		_GatherMessageData_ROS(message_index, pointer_to_destination, *message_size);
+		*message_id = _MsgIDOfIndex_ROS(message_index);
+
+		/* Delete the message (removing it from the inbox, in lock-free store mode as the store
+		   is settled on return), and return the result */
+		return _DeleteMsgIndex_ROS(message_index);
+	}
+}
+/***************************************************************************************************
+* End of ReceiveMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: WaitForInbox_ROS
+* Type			: API function, message system
+* Description	: This function blocks the running task on an empty inbox. Returns true if messages
+*				  are already waiting (nothing is armed). Otherwise returns false, and the task is
+*				  queued by the next message addressed to it, so it can return instead of polling.
+* Notes			: Tasks run to completion, so the caller must return after a false result; it is
+*				  dispatched again once a message arrives.
+***************************************************************************************************/
+uint8_t WaitForInbox_ROS
+		(
+			void
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Declare inbox container variable, and look up the running task's inbox */
+	uint8_t inbox;
+	uint8_t is_inbox_found = _RunningTaskInbox_ROS(&inbox);
+
+	/* Check if the running task has no inbox */
+	if(is_inbox_found != SUCCESS_ROS)
+	{
+		/* No inbox, return failure */
+		return is_inbox_found;
+	}
+	/* Check if messages are already waiting */
+	else if(gMsgInboxHeadArray_ROS[inbox] != NULL_MSG_ROS)
+	{
+		/* No need to block, return true */
+		return TRUE_ROS;
+	}
+	/* Inbox is empty */
+	else
+	{
+		/* Arm the wake up, and return false */
+		gMsgInboxWaitArray_ROS[inbox] = true;
+		return FALSE_ROS;
+	}
+}
+/***************************************************************************************************
+* End of WaitForInbox_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: WaitForMessage_ROS
+* Type			: API function, message system
+* Description	: This function blocks the running task until a message with the ID is committed
+*				  (or, with MSG_WAIT_INBOX_ROS, until a message arrives in its inbox), for up to
+*				  timeout ticks (0 = no timeout). Returns true if the message is already there
+*				  (nothing is armed). Otherwise returns false, and the task is queued by the
+*				  message or the timeout, whichever comes first; it then calls ResumeMessageWait_ROS.
+*				  Meanwhile the task's priority is lent to server_vector (MSG_TARG_GLOBAL_ROS =
+*				  none), the task expected to send the message, so a lower priority server cannot
+*				  be held off by medium priority tasks while a high priority client waits on it.
+* Notes			: A message wakes its highest priority waiter only, at the priority each waiter has
+*				  when the message arrives. A lent priority only helps a server at a lower ready
+*				  level than the client. Each priority has its own level by default; with
+*				  ENABLE_FINE_PRIORITY_LEVELS_ROS (schedule.c) set to 0, a client and server whose
+*				  priorities differ only in the low 3 bits share one of 32 levels, so the server
+*				  gains nothing. The timeout uses the task's sleep timer, so periodic tasks cannot wait
+*				  with a timeout. Returns an error code outside a task, for an invalid ID or
+*				  server, or if the task is already waiting.
+***************************************************************************************************/
+uint8_t WaitForMessage_ROS
+		(
+			/* Message ID to wait for (MSG_WAIT_INBOX_ROS = any message in the inbox) */
+			MsgID_ROS message_id, \
+			/* Task vector expected to send the message, lent the waiting task's priority */
+			uint8_t server_vector, \
+			/* Longest wait, in scheduler ticks (0 = no timeout) */
+			uint32_t timeout
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Declare inbox and result container variables, and look up the running task's inbox */
+	uint8_t inbox;
+	uint8_t is_inbox_found = _RunningTaskInbox_ROS(&inbox);
+	uint8_t result;
+
+	/* Check if the running task has no inbox */
+	if(is_inbox_found != SUCCESS_ROS)
+	{
+		/* No inbox, return failure */
+		return is_inbox_found;
+	}
+	/* Check if the message ID is invalid */
+	else if((message_id != MSG_WAIT_INBOX_ROS) && \
+			((result = _IsMessageIDValid_ROS(message_id)) != TRUE_ROS))
+	{
+		/* Message ID invalid, return error code */
+		return result;
+	}
+	/* Check if the task is already waiting */
+	else if(gMsgWaitStateArray_ROS[inbox] != MSG_WAIT_IDLE_ROS)
+	{
+		/* Wait in progress, return failure */
+		return F_MSG_ALREADY_WAITING_ROS;
+	}
+	/* Check if the message is already there */
+	else if(_IsMsgWaitOver_ROS(inbox, message_id) == TRUE_ROS)
+	{
+		/* No need to block, return true */
+		return TRUE_ROS;
+	}
+	/* Check if a server is named, and lend it the task's priority */
+	else if((server_vector != MSG_TARG_GLOBAL_ROS) && \
+			((result = InheritTaskPriority_ROS(server_vector, \
+											   TASK_PRIORITY_ROS(RUNNING_TASK_ID_ROS))) != SUCCESS_ROS))
+	{
+		/* Server invalid, return error code */
+		return result;
+	}
+	/* Check if a timeout is given, and arm the task's timer for it */
+	else if((timeout != 0u) && ((result = SleepUntilTick_ROS(gSystemTick_ROS + timeout)) != FALSE_ROS))
+	{
+		/* Timer not armed, take the lent priority back */
+		if(server_vector != MSG_TARG_GLOBAL_ROS)
+		{
+			(void)RestoreTaskPriority_ROS(server_vector);
+		}
+
+		/* Return the timeout if it is too long to measure, or the timer's error code */
+		return (result == TRUE_ROS) ? F_MSG_WAIT_TIMEOUT_ROS : result;
+	}
+	/* Input validation successful, arm the wake up */
+	else
+	{
+		/* Record the wait, and list the task for the message */
+		gMsgWaitIDArray_ROS[inbox] = message_id;
+		gMsgWaitServerArray_ROS[inbox] = server_vector;
+		gMsgWaitTimedArray_ROS[inbox] = (timeout != 0u);
+		gMsgWaitStateArray_ROS[inbox] = MSG_WAIT_ARMED_ROS;
+		_LinkMsgWaiter_ROS(inbox);
+
+		/* Task blocked, return false */
+		return FALSE_ROS;
+	}
+}
+/***************************************************************************************************
+* End of WaitForMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: ResumeMessageWait_ROS
+* Type			: API function, message system
+* Description	: This function checks whether the running task's wait, started by
+*				  WaitForMessage_ROS, is over once it is dispatched again. Returns true if the
+*				  message has arrived, or F_MSG_WAIT_TIMEOUT_ROS if the timeout has passed, ending
+*				  the wait either way. Otherwise returns false (the task was queued by something
+*				  else), and the task stays waiting.
+* Notes			: Returns F_MSG_NOT_WAITING_ROS if the task is not waiting.
+***************************************************************************************************/
+uint8_t ResumeMessageWait_ROS
+		(
+			void
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Declare inbox container variable, and look up the running task's inbox */
+	uint8_t inbox;
+	uint8_t is_inbox_found = _RunningTaskInbox_ROS(&inbox);
+
+	/* Check if the running task has no inbox */
+	if(is_inbox_found != SUCCESS_ROS)
+	{
+		/* No inbox, return failure */
+		return is_inbox_found;
+	}
+	/* Check if the task is not waiting */
+	else if(gMsgWaitStateArray_ROS[inbox] == MSG_WAIT_IDLE_ROS)
+	{
+		/* Nothing to resume, return failure */
+		return F_MSG_NOT_WAITING_ROS;
+	}
+	/* Check if a message woke the task, or has arrived since */
+	else if((gMsgWaitStateArray_ROS[inbox] == MSG_WAIT_WOKEN_ROS) || \
+			(_IsMsgWaitOver_ROS(inbox, gMsgWaitIDArray_ROS[inbox]) == TRUE_ROS))
+	{
+		/* Cancel the timeout, so it does not queue the task later */
+		if(gMsgWaitTimedArray_ROS[inbox])
+		{
+			(void)CancelSleep_ROS();
+		}
+
+		/* End the wait, and return true */
+		_EndMsgWait_ROS(inbox);
+		return TRUE_ROS;
+	}
+	/* Check if the timeout has passed (the timer is re-armed if not) */
+	else if(gMsgWaitTimedArray_ROS[inbox] && (ResumeSleep_ROS() == TRUE_ROS))
+	{
+		/* End the wait, and return the timeout */
+		_EndMsgWait_ROS(inbox);
+		return F_MSG_WAIT_TIMEOUT_ROS;
+	}
+	/* Task queued early */
+	else
+	{
+		/* Keep waiting, return false */
+		return FALSE_ROS;
+	}
+}
+/***************************************************************************************************
+* End of ResumeMessageWait_ROS
+***************************************************************************************************/
+
+#if (ENABLE_MSG_TOPICS_ROS)
+/***************************************************************************************************
+* Name			: SubscribeTopic_ROS
+* Type			: API function, message system
+* Description	: This function subscribes a task vector to a topic. The task can take every message
+*				  published to the topic from then on. Subscribing twice has no effect. Fails if the
+*				  topic or vector is invalid, or the topic has MAX_TOPIC_SUBSCRIBERS_ROS subscribers.
+* Notes			: None.
+***************************************************************************************************/
+uint8_t SubscribeTopic_ROS
+		(
+			/* Topic to subscribe to */
+			uint8_t topic, \
+			/* Subscribing task vector */
+			uint8_t task_vector
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Check if the topic is out of range */
+	if((topic == NULL_TOPIC_ROS) || (topic > NUM_MSG_TOPICS_ROS))
+	{
+		/* Topic invalid, return failure */
+		return F_MSG_TOPIC_INVALID_ROS;
+	}
+	/* Check if the vector is the global target */
+	else if(task_vector == MSG_TARG_GLOBAL_ROS)
+	{
+		/* Vector invalid, return failure */
+		return F_MSG_ACCESS_DENIED_ROS;
+	}
+	/* Check if the vector has no inbox to be woken through */
+	else if(!IS_MSG_INBOX_ROS(task_vector))
+	{
+		/* Vector out of range, return failure */
+		return F_MSG_TARGET_INVALID_ROS;
+	}
+	/* Check if the vector is already subscribed */
+	else if(_TopicSubscriberSlot_ROS(topic, task_vector) != MAX_TOPIC_SUBSCRIBERS_ROS)
+	{
+		/* Nothing to do, return success */
+		return SUCCESS_ROS;
+	}
+	/* Input validation successful, take a free slot */
+	else
+	{
+		/* Look up a free subscriber slot */
+		uint8_t slot = _TopicSubscriberSlot_ROS(topic, MSG_TARG_GLOBAL_ROS);
+
+		/* Check if every slot is taken */
+		if(slot == MAX_TOPIC_SUBSCRIBERS_ROS)
+		{
+			/* Topic full, return failure */
+			return F_MSG_TOPIC_FULL_ROS;
+		}
+
+		/* Store the subscriber, and return success */
+		gMsgTopicSubscriberArray_ROS[topic][slot] = task_vector;
+		return SUCCESS_ROS;
+	}
+}
+/***************************************************************************************************
+* End of SubscribeTopic_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: UnsubscribeTopic_ROS
+* Type			: API function, message system
+* Description	: This function unsubscribes a task vector from a topic, dropping its references to
+*				  every message it has not yet taken (deleting any message left unreferenced). Fails
+*				  if the topic is invalid, or the vector is not subscribed.
+* Notes			: Messages the task has taken stay valid until it releases them.
+***************************************************************************************************/
+uint8_t UnsubscribeTopic_ROS
+		(
+			/* Topic to unsubscribe from */
+			uint8_t topic, \
+			/* Unsubscribing task vector */
+			uint8_t task_vector
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Check if the topic is out of range */
+	if((topic == NULL_TOPIC_ROS) || (topic > NUM_MSG_TOPICS_ROS))
+	{
+		/* Topic invalid, return failure */
+		return F_MSG_TOPIC_INVALID_ROS;
+	}
+	/* Check if the vector is not subscribed (the global target never is) */
+	else if((task_vector == MSG_TARG_GLOBAL_ROS) || \
+			(_TopicSubscriberSlot_ROS(topic, task_vector) == MAX_TOPIC_SUBSCRIBERS_ROS))
+	{
+		/* Not subscribed, return failure */
+		return F_MSG_ACCESS_DENIED_ROS;
+	}
+	/* Input validation successful, remove the subscriber */
+	else
+	{
+		/* Look up the subscriber's slot, and the oldest message */
+		uint8_t slot = _TopicSubscriberSlot_ROS(topic, task_vector);
+		uint8_t message_index = gMsgTopicHeadArray_ROS[topic];
+
+		/* Free the slot */
+		gMsgTopicSubscriberArray_ROS[topic][slot] = MSG_TARG_GLOBAL_ROS;
+
+		/* Drop the slot's unread reference from every message */
+		while(message_index != NULL_MSG_ROS)
+		{
+			/* Store the next message first, as this one may be deleted */
+			uint8_t next = gMsgTOC_ROS[message_index][MSG_TOPIC_NEXT_ROS];
+
+			gMsgUnreadMaskArray_ROS[message_index] &= (uint8_t)~(1u << slot);
+			_ReclaimTopicMessage_ROS(message_index);
+
+			message_index = next;
+		}
+
+		/* Unsubscribed, return success */
+		return SUCCESS_ROS;
+	}
+}
+/***************************************************************************************************
+* End of UnsubscribeTopic_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: PublishMessage_ROS
+* Type			: API function, message system
+* Description	: This function stores one copy of a global message for every current subscriber of
+*				  a topic, and wakes subscribers waiting on their inbox. The message is deleted once
+*				  every subscriber has taken and released it (or unsubscribed). Fails for the same
+*				  conditions as CreateMessage_ROS, or if the topic is invalid or has no subscribers
+*				  (nothing is stored).
+* Notes			: The message can also be read by ID, like any global message.
+***************************************************************************************************/
+uint8_t PublishMessage_ROS
+		(
+			/* Topic to publish to */
+			uint8_t topic, \
+			/* Desired ID for new message */
+			MsgID_ROS message_id, \
+			/* New messages maximum time to live */
+			uint8_t time_to_live, \
+			/* Size of the new message in bytes */
+			MsgSize_ROS message_size, \
+			/* Pointer to the message data */
+			uint8_t * pointer_to_message
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Declare slot loop variable and subscriber mask */
+	uint8_t slot, subscriber_mask = 0u;
+
+	/* Check if the topic is out of range */
+	if((topic == NULL_TOPIC_ROS) || (topic > NUM_MSG_TOPICS_ROS))
+	{
+		/* Topic invalid, return failure */
+		return F_MSG_TOPIC_INVALID_ROS;
+	}
+
+	/* Collect the occupied subscriber slots */
+	for(slot = 0u; slot < MAX_TOPIC_SUBSCRIBERS_ROS; slot++)
+	{
+		if(gMsgTopicSubscriberArray_ROS[topic][slot] != MSG_TARG_GLOBAL_ROS)
+		{
+			subscriber_mask |= (uint8_t)(1u << slot);
+		}
+	}
+
+	/* Check if nobody would read the message */
+	if(subscriber_mask == 0u)
+	{
+		/* No subscribers, return failure */
+		return F_MSG_NO_SUBSCRIBERS_ROS;
+	}
+	/* Topic has subscribers, store the message */
+	else
+	{
+		/* Allocate the message's table entry and space as a global message, and store the result
+		   in a container variable */
+		uint8_t is_allocated = _AllocateMessage_ROS
+							   (
+									message_id, \
+									MSG_TARG_GLOBAL_ROS, \
+									time_to_live, \
+									message_size
+							   );
+
+		/* Check if the allocation failed */
+		if(is_allocated != SUCCESS_ROS)
+		{
+			/* Allocation failed, return error code */
+			return is_allocated;
+		}
+		/* Allocation successful, publish the message */
+		else
+		{
+			/* Look up the message's index */
+			uint8_t message_index = _LookupMsgIndex_ROS(message_id);
+
+			/* Reference the message from every subscriber */
+			gMsgTopicArray_ROS[message_index] = topic;
+			gMsgUnreadMaskArray_ROS[message_index] = subscriber_mask;
+
+			/* Append the message to the topic list */
+			gMsgTOC_ROS[message_index][MSG_TOPIC_NEXT_ROS] = NULL_MSG_ROS;
+			gMsgTOC_ROS[message_index][MSG_TOPIC_PREV_ROS] = gMsgTopicTailArray_ROS[topic];
+			if(gMsgTopicTailArray_ROS[topic] == NULL_MSG_ROS)
+			{
+				gMsgTopicHeadArray_ROS[topic] = message_index;
+			}
+			else
+			{
+				gMsgTOC_ROS[gMsgTopicTailArray_ROS[topic]][MSG_TOPIC_NEXT_ROS] = message_index;
+			}
+			gMsgTopicTailArray_ROS[topic] = message_index;
+
+			/* Wake every subscriber waiting for a message */
+			for(slot = 0u; slot < MAX_TOPIC_SUBSCRIBERS_ROS; slot++)
+			{
+				/* Look up the slot's subscriber */
+				uint8_t task_vector = gMsgTopicSubscriberArray_ROS[topic][slot];
+
+				if((task_vector != MSG_TARG_GLOBAL_ROS) && gMsgInboxWaitArray_ROS[task_vector])
+				{
+					gMsgInboxWaitArray_ROS[task_vector] = false;
+					_WakeMsgWaiter_ROS(task_vector);
+				}
+			}
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+			/* Copy the data into the store image, and make the message readable (the store is
+			   settled on return, writing it through to the backend) */
+			memcpy(gMsgFileSysPtr_ROS + gMsgTOC_ROS[message_index][MSG_LOC_ROS], pointer_to_message, \
+				   message_size);
+			_PublishMsgSlot_ROS(message_index);
+			return SUCCESS_ROS;
+#else
+			/* Write the message data into its allocated location, and return the write result */
+			return _WriteMessageData_ROS
+				   (
+						pointer_to_message, \
+						gMsgFileSysPtr_ROS + gMsgTOC_ROS[message_index][MSG_LOC_ROS], \
+						message_size
+				   );
+#endif
+		}
+	}
+}
+/***************************************************************************************************
+* End of PublishMessage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: TakeTopicMessage_ROS
+* Type			: API function, message system
+* Description	: This function outputs the ID, data pointer and size of the oldest message on a
+*				  topic that the running task has not yet taken, and pins it in place until the
+*				  task calls ReleaseMessage_ROS. The following conditions will cause it to fail:
+*					- Topic invalid
+*					- Called outside a task, or by a task not subscribed to the topic
+*					- No untaken messages (F_MSG_INBOX_EMPTY_ROS)
+*					- Message already has MAX_MSG_PINS_ROS pins
+* Notes			: No data is copied. The data must be treated as read only.
+***************************************************************************************************/
+uint8_t TakeTopicMessage_ROS
+		(
+			/* Topic to take from */
+			uint8_t topic, \
+			/* Pointer to variable that will store the message ID */
+			MsgID_ROS * message_id, \
+			/* Pointer to variable that will store the pointer to the message data */
+			uint8_t ** pointer_to_data, \
+			/* Pointer to variable that will store the message size */
+			MsgSize_ROS * message_size
+		)
+{
+	/* Hold the kernel lock until the function returns (see LOCK_MSG_API_ROS) */
+	LOCK_MSG_API_ROS();
+	/* Own the lock-free store until the function returns (see OWN_MSG_STORE_ROS) */
+	OWN_MSG_STORE_ROS();
+
+	/* Declare running task vector and subscriber slot container variables */
+	uint8_t task_vector, slot, is_inbox_found;
+
+	/* Check if the topic is out of range */
+	if((topic == NULL_TOPIC_ROS) || (topic > NUM_MSG_TOPICS_ROS))
+	{
+		/* Topic invalid, return failure */
+		return F_MSG_TOPIC_INVALID_ROS;
+	}
+
+	/* Look up the running task's vector */
+	is_inbox_found = _RunningTaskInbox_ROS(&task_vector);
+
+	/* Check if no task is running */
+	if(is_inbox_found != SUCCESS_ROS)
+	{
+		/* No caller task, return failure */
+		return is_inbox_found;
+	}
+
+	/* Look up the task's subscriber slot */
+	slot = _TopicSubscriberSlot_ROS(topic, task_vector);
+
+	/* Check if the task is not subscribed */
+	if(slot == MAX_TOPIC_SUBSCRIBERS_ROS)
+	{
+		/* Not a subscriber, return failure */
+		return F_MSG_ACCESS_DENIED_ROS;
+	}
+	/* Task is subscribed, find its oldest untaken message */
+	else
+	{
+		/* Start at the oldest message */
+		uint8_t message_index = gMsgTopicHeadArray_ROS[topic];
+
+		/* Skip messages the slot has already taken */
+		while((message_index != NULL_MSG_ROS) && \
+			  ((gMsgUnreadMaskArray_ROS[message_index] & (1u << slot)) == 0u))
+		{
+			message_index = gMsgTOC_ROS[message_index][MSG_TOPIC_NEXT_ROS];
+		}
+
+		/* Check if every message has been taken */
+		if(message_index == NULL_MSG_ROS)
+		{
+			/* Nothing to take, return failure */
+			return F_MSG_INBOX_EMPTY_ROS;
+		}
+		/* Check if the pin count is saturated */
+		else if(_MsgPinCount_ROS(message_index) == MAX_MSG_PINS_ROS)
+		{
+			/* Cannot pin again, return failure */
+			return F_MSG_PINNED_ROS;
+		}
+		/* Untaken message found */
+		else
+		{
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+			/* Pin the message by swapping its slot word, checking it was not deleted or held, or
+			   pinned to the limit, since the store was settled */
+			uint32_t slot_word = __atomic_load_n(&gMsgSlotArray_ROS[message_index], __ATOMIC_ACQUIRE);
+			do
+			{
+				if((_MsgSlotState_ROS(slot_word) != MSG_SLOT_LIVE_ROS) || \
+				   (_MsgSlotPins_ROS(slot_word) == MAX_MSG_PINS_ROS))
+				{
+					/* Message busy, return failure */
+					return F_MSG_BUSY_ROS;
+				}
+			}
+			while(!__atomic_compare_exchange_n(&gMsgSlotArray_ROS[message_index], &slot_word, \
+											   slot_word + MSG_SLOT_PIN_ROS, false, __ATOMIC_ACQ_REL, \
+											   __ATOMIC_ACQUIRE));
+
+			/* Move the slot's reference from unread to pinned */
+			gMsgUnreadMaskArray_ROS[message_index] &= (uint8_t)~(1u << slot);
+#else
+			/* Move the slot's reference from unread to pinned */
+			gMsgUnreadMaskArray_ROS[message_index] &= (uint8_t)~(1u << slot);
+			_PinMsgIndex_ROS(message_index);
+#endif
+
+			/* Output the message's ID, data pointer and size */
+			*message_id = _MsgIDOfIndex_ROS(message_index);
+			*pointer_to_data = gMsgFileSysPtr_ROS + gMsgTOC_ROS[message_index][MSG_LOC_ROS];
+			*message_size = gMsgTOC_ROS[message_index][MSG_SIZE_ROS];
+
+			/* Message taken, return success */
+			return SUCCESS_ROS;
+		}
+	}
+}
+/***************************************************************************************************
+* End of TakeTopicMessage_ROS
+***************************************************************************************************/
+#endif
+
+/***************************************************************************************************
+* Name			: _FindMsgSpace_ROS
+* Type			: Internal function, message system
+* Description	: This function attempts to find a space for a message of a specified size.
+*				  function first looks for a deleted message space, and then looks finding a space
+*				  on top of the last message. If the function is succesful, it will return 
+*				  SUCCESS_ROS, and output the message location and index to the pointers passed. If
+*				  slot was a deleted message, it will also set the is_deleted_location pointer 
+*				  variable to true, and specify the delte message's index. Nothing is committed;
+*				  the caller claims the space and index once the message is written. If function cannot find 
+*				  space for the message, or the maximium number of messages has been reached - the
+*				  function will return failure with an error code.
+* Notes			: Holes are kept in power of two size class lists, so a hole that is guaranteed to
+*				  fit is found in constant time. Only if none exists is the message's own class
+*				  walked for a hole that happens to fit. With ENABLE_LOCK_FREE_MSGS_ROS set, only the
+*				  top of the store is checked, and the index output is a slot claimed for the caller
+*				  (see _PlaceMessage_ROS). Holes are not reused there: taking part of a hole cannot
+*				  be done with one compare and swap, as the top can. Freed space is only reused once
+*				  it reaches the top, when the messages above it are deleted or slid down by
+*				  OptimizeMessageStorage_ROS, so a store with deleted messages below the top fails
+*				  with F_INSUFF_FREE_MEM_ROS until it is defragmented. If no slot or no space on top
+*				  is free, SettleMessageStore_ROS is run to free those of deleted messages first.
+* DEV			: [OK] Include input validation for message size?
+***************************************************************************************************/
+uint8_t _FindMsgSpace_ROS
+		(
+			/* All output values are invalid in function does not return SUCCESS_ROS */
+			/* Size of message to find space for */
+			MsgSize_ROS message_size, \
+			/* Pointer to variable that will store the message space's location */
+			MsgLoc_ROS * output_location, \
+			/* Pointer to variable that will store the message space's index */
+			uint8_t * message_index, \
+			/* Pointer to variable that will store a status flag to indicate whether the message
+			   space is a deleted location (true = yes) */
+			bool * is_deleted_location, \
+			/* Pointer to variable that will store index of the deleted message the new space 
+			   occupies (value only valid when is_deleted_location is true) */
+			uint8_t * deleted_message_index 
+		)
+{
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Declare top of store container variable */
+	MsgLoc_ROS top;
+
+	/* Claim a free message table slot, and check one was found */
+	if(_ClaimMsgSlot_ROS(message_index) != TRUE_ROS)
+	{
+		/* Free the slots of messages deleted since the last settle, and retry */
+		(void)SettleMessageStore_ROS();
+		if(_ClaimMsgSlot_ROS(message_index) != TRUE_ROS)
+		{
+			/* Maximum number of messages reached, return failure */
+			return F_MAX_MSGS_REACHED_ROS;
+		}
+	}
+
+	/* Check for space on top of the last message, lowering the top over messages deleted there
+	   since the last settle if there is none */
+	top = __atomic_load_n(&gNextFreeMsgLoc_ROS, __ATOMIC_ACQUIRE);
+	if(((uint32_t)top + message_size) >= MAX_MSG_STOR_BYTES_ROS)
+	{
+		(void)SettleMessageStore_ROS();
+		top = __atomic_load_n(&gNextFreeMsgLoc_ROS, __ATOMIC_ACQUIRE);
+	}
+	if(((uint32_t)top + message_size) < MAX_MSG_STOR_BYTES_ROS)
+	{
+		*output_location = top;
+		*is_deleted_location = false;
+		*deleted_message_index = NULL_HOLE_ROS;
+		return SUCCESS_ROS;
+	}
+	/* Top of the store is full */
+	else
+	{
+		/* Give the slot back, and return failure */
+		_ReleaseMsgSlot_ROS(*message_index);
+		return F_INSUFF_FREE_MEM_ROS;
+	}
+#else
+	/* Check if the maximum number of messages has been reached */
+	if(gNumMsg_ROS >= MAX_MSGS_ROS)
+	{
+		/* Maximum number of messages reached, return failure */
+		return F_MAX_MSGS_REACHED_ROS;
+	}
+	/* Input validation complete, continue to find message space */
+	else
+	{
+		/* Check if an index released by a deleted message is available */
+		if(gNumFreeMsgIndex_ROS != 0u)
+		{
+			/* Reuse the most recently released index */
+			*message_index = gMsgFreeIndexArray_ROS[gNumFreeMsgIndex_ROS - 1u];
+		}
+		/* Check if the fresh indexes have run out */
+		else if(gNextFreeMsgIndex_ROS >= MAX_MSGS_ROS)
+		{
+			/* No index available, return failure */
+			return F_MAX_MSGS_REACHED_ROS;
+		}
+		/* Use the next fresh index */
+		else
+		{
+			*message_index = gNextFreeMsgIndex_ROS;
+		}
+
+		/* Check if the total number of deleted bytes is greater than or equal to the message size
+		   (if total number of deleted bytes is lower, there can't be enough space in deleted 
+		   messages */
+		if(gNumDelBytes_ROS >= message_size)
+		{
+			/* Find the smallest size class whose holes are all large enough: the message's own 
+			   class if its size is a power of two, otherwise the class above */
+			uint8_t size_class = _MsgSizeClass_ROS(message_size);
+			MsgLoc_ROS fit_classes;
+
+			/* Check if message size is not a power of two */
+			if((message_size & (message_size - 1u)) != 0u)
+			{
+				/* Holes in the message's own class may be too small, start one class up */
+				size_class++;
+			}
+
+			/* Mask off the classes too small to guarantee a fit */
+			fit_classes = (size_class < NUM_MSG_SIZE_CLASSES_ROS) ? \
+						  (MsgLoc_ROS)(gMsgHoleClassBitmap_ROS & (MAX_MSG_LOC_ROS << size_class)) : 0u;
+
+			/* Check if any guaranteed fit class holds a hole */
+			if(fit_classes != 0u)
+			{
+				/* Take the head hole of the lowest guaranteed fit class */
+				*deleted_message_index = gMsgHoleClassHead_ROS[_MsgSizeClass_ROS
+										 (fit_classes & (MsgLoc_ROS)(0u - fit_classes))];
+				*output_location = gMsgDTOC_ROS[*deleted_message_index][MSG_LOC_ROS];
+				*is_deleted_location = true;
+
+				/* Suitable deleted message space found, return success */
+				return SUCCESS_ROS;
+			}
+			/* Check if the message's own class holds any holes (some may still fit) */
+			else if(gMsgHoleClassBitmap_ROS & (1u << _MsgSizeClass_ROS(message_size)))
+			{
+				/* Declare list walk variable, starting at the head of the message's own class */
+				uint8_t i = gMsgHoleClassHead_ROS[_MsgSizeClass_ROS(message_size)];
+
+				/* Walk the class list for a hole large enough (bounded by MAX_DEL_MSGS_ROS) */
+				while(i != NULL_HOLE_ROS)
+				{
+					/* Check if the hole is big enough to store the message */
+					if(gMsgDTOC_ROS[i][MSG_SIZE_ROS] >= message_size)
+					{
+						/* Output the hole's details */
+						*deleted_message_index = i;
+						*output_location = gMsgDTOC_ROS[i][MSG_LOC_ROS];
+						*is_deleted_location = true;
+
+						/* Suitable deleted message space found, return success */
+						return SUCCESS_ROS;
+					}
+
+					/* Move to the next hole in the class */
+					i = gMsgDTOC_ROS[i][DEL_MSG_NEXT_ROS];
+				}
+			}
+		}
+
+		/* No suitable hole, check for space on top of the last message */
+		if((gNextFreeMsgLoc_ROS + message_size) < MAX_MSG_STOR_BYTES_ROS)
+		{
+			*output_location = gNextFreeMsgLoc_ROS;
+			
+			*is_deleted_location = false;
+			
+			return SUCCESS_ROS;
+		}
+		else
+		{
+			return F_INSUFF_FREE_MEM_ROS;
+		}
+	}
+	return 0;
+#endif
+}
+				
+uint8_t _WriteMessageData_ROS
+		(
+			uint8_t * pointer_to_data, \
+			uint8_t * pointer_to_destination, \
+			MsgSize_ROS number_bytes
+		)
+{
+	if(0)
+	{
+		/* Input validation */
+	}
+	else
+	{
+		
+
+		memmove(pointer_to_destination, pointer_to_data, number_bytes);	
+			
+		/* Write the changed region of the image through to the storage backend (EEPROM, flash
+		   etc.), and return the write result */
+		return _StoreMessageData_ROS((uint32_t)(pointer_to_destination - gMsgFileSysPtr_ROS), \
+									 number_bytes);
+	}
+	
+	return 0;	
+}
+
+/***************************************************************************************************
+* Name			: _StoreMessageData_ROS
+* Type			: Internal function, message system
+* Description	: This function writes a region of the store image through to the storage backend
+*				  mounted with the message file system. Does nothing if there is no backend.
+* Notes			: None
+***************************************************************************************************/
+uint8_t _StoreMessageData_ROS
+		(
+			/* Offset of the region from the start of the store */
+			uint32_t location, \
+			/* Size of the region in bytes */
+			uint32_t number_bytes
+		)
+{
+	/* Check if there is no storage backend */
+	if(gMsgStorageBackend_ROS == 0)
+	{
+		/* Image only, return success */
+		return SUCCESS_ROS;
+	}
+	/* Check if the backend write failed */
+	else if(gMsgStorageBackend_ROS->write(gMsgStorageBackend_ROS->context, location, \
+										  gMsgFileSysPtr_ROS + location, number_bytes) != SUCCESS_ROS)
+	{
+		/* Backend copy out of date, return failure */
+		return F_MSG_STORAGE_FAILED_ROS;
+	}
+	/* Backend write successful */
+	else
+	{
+		/* Region stored, return success */
+		return SUCCESS_ROS;
+	}
+}
+/***************************************************************************************************
+* End of _StoreMessageData_ROS
+***************************************************************************************************/
+
+void _EraseMsgEntry_ROS
+		(
+			uint8_t message_index
+		)
+{
+	gMsgTOC_ROS[message_index][MSG_ID_ROS] = NULL_ID_ROS;
+	gMsgTOC_ROS[message_index][MSG_SIZE_ROS] = NULL_SIZE_ROS;
+	gMsgTOC_ROS[message_index][MSG_LOC_ROS] = NULL_LOC_ROS;
+	gMsgTOC_ROS[message_index][MSG_TTL_ROS] = NULL_TTL_ROS;
+	gMsgTOC_ROS[message_index][MSG_TARG_ROS] = NULL_TARG_ROS;
+	gMsgTOC_ROS[message_index][MSG_INBOX_NEXT_ROS] = NULL_MSG_ROS;
+	gMsgTOC_ROS[message_index][MSG_INBOX_PREV_ROS] = NULL_MSG_ROS;
+#if (ENABLE_MSG_CHAINS_ROS)
+	gMsgTOC_ROS[message_index][MSG_CHAIN_ROS] = NULL_MSG_ROS;
+#endif
+}
+
+void _EraseDelMsgEntry_ROS
+		(
+			uint8_t message_index
+		)
+{
+	gMsgDTOC_ROS[message_index][MSG_ID_ROS] = NULL_ID_ROS;
+	gMsgDTOC_ROS[message_index][MSG_SIZE_ROS] = NULL_SIZE_ROS;
+	gMsgDTOC_ROS[message_index][MSG_LOC_ROS] = NULL_LOC_ROS;
+	gMsgDTOC_ROS[message_index][MSG_TTL_ROS] = NULL_TTL_ROS;
+	gMsgDTOC_ROS[message_index][MSG_TARG_ROS] = NULL_TARG_ROS;
+
+}
+
+/***************************************************************************************************
+* Name			: _MsgSizeClass_ROS
+* Type			: Internal function, message system
+* Description	: Returns the size class of a message or hole size, which is the index of its highest
+*				  set bit (class n holds sizes 2^n to 2^(n+1)-1).
+* Notes			: Size must not be zero.
+***************************************************************************************************/
+uint8_t _MsgSizeClass_ROS
+		(
+			/* Size in bytes to classify */
+			MsgSize_ROS size
+		)
+{
+#if defined(__GNUC__)
+	/* Highest set bit is 31 minus the leading zero count */
+	return (uint8_t)(31u - __builtin_clz(size));
+#else
+	/* Declare class container variable */
+	uint8_t size_class = 0u;
+
+	/* Halve the search window until the highest set bit is found */
+#if (MSG_STORE_WIDTH_ROS == 32)
+	if(size & 0xFFFF0000ul) { size >>= 16; size_class += 16u; }
+#endif
+#if (MSG_STORE_WIDTH_ROS >= 16)
+	if(size & 0xFF00u) { size >>= 8; size_class += 8u; }
+#endif
+	if(size & 0xF0u) { size >>= 4; size_class += 4u; }
+	if(size & 0x0Cu) { size >>= 2; size_class += 2u; }
+	if(size & 0x02u) { size_class += 1u; }
+
+	/* Return size class */
+	return size_class;
+#endif
+}
+/***************************************************************************************************
+* End of _MsgSizeClass_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _FileMsgHole_ROS
+* Type			: Internal function, message system
+* Description	: Pushes a deleted message entry (hole) onto the front of its size class list.
+* Notes			: The entry's size must be set, and the entry must not already be filed.
+***************************************************************************************************/
+void _FileMsgHole_ROS
+		(
+			/* Deleted message table index of the hole */
+			uint8_t del_index
+		)
+{
+	/* Look up the hole's size class */
+	uint8_t size_class = _MsgSizeClass_ROS(gMsgDTOC_ROS[del_index][MSG_SIZE_ROS]);
+
+	/* Hole becomes the class head, so it has no previous entry */
+	gMsgDTOC_ROS[del_index][DEL_MSG_PREV_ROS] = NULL_HOLE_ROS;
+
+	/* Check if the class already holds holes */
+	if(gMsgHoleClassBitmap_ROS & (1u << size_class))
+	{
+		/* Link in front of the old head */
+		gMsgDTOC_ROS[del_index][DEL_MSG_NEXT_ROS] = gMsgHoleClassHead_ROS[size_class];
+		gMsgDTOC_ROS[gMsgHoleClassHead_ROS[size_class]][DEL_MSG_PREV_ROS] = del_index;
+	}
+	/* Class is empty */
+	else
+	{
+		/* Hole is the only entry, and the class is now non-empty */
+		gMsgDTOC_ROS[del_index][DEL_MSG_NEXT_ROS] = NULL_HOLE_ROS;
+		gMsgHoleClassBitmap_ROS |= (MsgLoc_ROS)(1ul << size_class);
+	}
+
+	/* Hole is the new class head */
+	gMsgHoleClassHead_ROS[size_class] = del_index;
+}
+/***************************************************************************************************
+* End of _FileMsgHole_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _UnfileMsgHole_ROS
+* Type			: Internal function, message system
+* Description	: Removes a deleted message entry (hole) from its size class list.
+* Notes			: Must be called before the entry's size is changed, as the size selects the list.
+***************************************************************************************************/
+void _UnfileMsgHole_ROS
+		(
+			/* Deleted message table index of the hole */
+			uint8_t del_index
+		)
+{
+	/* Look up the hole's size class and neighbours */
+	uint8_t size_class = _MsgSizeClass_ROS(gMsgDTOC_ROS[del_index][MSG_SIZE_ROS]);
+	uint8_t prev = gMsgDTOC_ROS[del_index][DEL_MSG_PREV_ROS];
+	uint8_t next = gMsgDTOC_ROS[del_index][DEL_MSG_NEXT_ROS];
+
+	/* Check if the hole is the class head */
+	if(prev == NULL_HOLE_ROS)
+	{
+		/* Check if the hole is the only entry in the class */
+		if(next == NULL_HOLE_ROS)
+		{
+			/* Class is now empty */
+			gMsgHoleClassBitmap_ROS &= (MsgLoc_ROS)~(1ul << size_class);
+		}
+		/* Class holds further holes */
+		else
+		{
+			/* Next hole becomes the head */
+			gMsgHoleClassHead_ROS[size_class] = next;
+		}
+	}
+	/* Hole is not the head */
+	else
+	{
+		/* Bridge the previous hole over this one */
+		gMsgDTOC_ROS[prev][DEL_MSG_NEXT_ROS] = next;
+	}
+
+	/* Back link the next hole, if any */
+	if(next != NULL_HOLE_ROS)
+	{
+		gMsgDTOC_ROS[next][DEL_MSG_PREV_ROS] = prev;
+	}
+}
+/***************************************************************************************************
+* End of _UnfileMsgHole_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _TakeMsgHoleSpace_ROS
+* Type			: Internal function, message system
+* Description	: Allocates a message's bytes from the front of a hole. An exact fit frees the
+*				  deleted message entry; otherwise the hole shrinks and is refiled under its new
+*				  size class, so no bytes are lost.
+* Notes			: Hole must be at least message_size bytes.
+***************************************************************************************************/
+void _TakeMsgHoleSpace_ROS
+		(
+			/* Deleted message table index of the hole */
+			uint8_t del_index, \
+			/* Number of bytes to allocate */
+			MsgSize_ROS message_size
+		)
+{
+	/* Remove the hole from its current size class list */
+	_UnfileMsgHole_ROS(del_index);
+
+	/* Decrease the number of deleted bytes by the size of the message now created */
+	gNumDelBytes_ROS -= message_size;
+
+	/* Check if the message fills the hole exactly */
+	if(gMsgDTOC_ROS[del_index][MSG_SIZE_ROS] == message_size)
+	{
+		/* Decrement the total number of deleted messages by one */
+		gNumDelMsg_ROS--;
+
+		/* Hole consumed, erase its deleted message entry */
+		_EraseDelMsgEntry_ROS(del_index);
+	}
+	/* Bytes remain after the message */
+	else
+	{
+		/* Shrink the hole to the remaining bytes, and refile it */
+		gMsgDTOC_ROS[del_index][MSG_LOC_ROS] += message_size;
+		gMsgDTOC_ROS[del_index][MSG_SIZE_ROS] -= message_size;
+		_FileMsgHole_ROS(del_index);
+	}
+}
+/***************************************************************************************************
+* End of _TakeMsgHoleSpace_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _LowerMsgStoreTop_ROS
+* Type			: Internal function, message system
+* Description	: Lowers the next free location (the top of the store) to a new location, if it is
+*				  still at the location expected. Returns true if it was lowered, otherwise false
+*				  (nothing is changed).
+* Notes			: With ENABLE_LOCK_FREE_MSGS_ROS set the top is swapped atomically, as creators may
+*				  raise it at any time.
+***************************************************************************************************/
+uint8_t _LowerMsgStoreTop_ROS
+		(
+			/* Location the top is expected to be at */
+			MsgLoc_ROS expected_location, \
+			/* Location to lower the top to */
+			MsgLoc_ROS new_location
+		)
+{
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Swap the top if it is unchanged, and return the result */
+	return __atomic_compare_exchange_n(&gNextFreeMsgLoc_ROS, &expected_location, new_location, \
+									   false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ? \
+		   TRUE_ROS : FALSE_ROS;
+#else
+	/* Check if the top is where expected */
+	if(gNextFreeMsgLoc_ROS == expected_location)
+	{
+		/* Lower the top, and return true */
+		gNextFreeMsgLoc_ROS = new_location;
+		return TRUE_ROS;
+	}
+	/* Top has moved */
+	else
+	{
+		/* Nothing changed, return false */
+		return FALSE_ROS;
+	}
+#endif
+}
+/***************************************************************************************************
+* End of _LowerMsgStoreTop_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _ReleaseMsgSpace_ROS
+* Type			: Internal function, message system
+* Description	: Returns a deleted message's bytes to the free space. Bytes on top of the last
+*				  message lower the next free location; otherwise they are merged into an adjacent
+*				  hole (joining holes either side), or stored in a free deleted message entry.
+*				  Returns success, or a failure code if a new entry is needed and none is free.
+* Notes			: Nothing is changed if the function fails.
+***************************************************************************************************/
+uint8_t _ReleaseMsgSpace_ROS
+		(
+			/* Location of the bytes to release */
+			MsgLoc_ROS location, \
+			/* Number of bytes to release */
+			MsgSize_ROS size
+		)
+{
+	/* Declare loop counter, and neighbouring hole index variables */
+	uint8_t i, left = NULL_HOLE_ROS, right = NULL_HOLE_ROS;
+
+	/* Calculate the location just after the released bytes */
+	MsgLoc_ROS end = location + size;
+
+	/* Search the deleted message table for holes touching either end of the released bytes */
+	for(i = 0u; i < MAX_DEL_MSGS_ROS; i++)
+	{
+		/* Check if the entry is in use */
+		if(gMsgDTOC_ROS[i][MSG_ID_ROS] != NULL_ID_ROS)
+		{
+			/* Check if the hole ends where the released bytes start */
+			if((gMsgDTOC_ROS[i][MSG_LOC_ROS] + gMsgDTOC_ROS[i][MSG_SIZE_ROS]) == location)
+			{
+				left = i;
+			}
+			/* Check if the hole starts where the released bytes end */
+			else if(gMsgDTOC_ROS[i][MSG_LOC_ROS] == end)
+			{
+				right = i;
+			}
+		}
+	}
+
+	/* Check if the released bytes are on top of the last message, and lower the next free
+	   location to their start */
+	if(_LowerMsgStoreTop_ROS(end, location) == TRUE_ROS)
+	{
+		/* Check if a hole now sits on top of the last message, and lower the next free location
+		   over the hole too */
+		if((left != NULL_HOLE_ROS) && \
+		   (_LowerMsgStoreTop_ROS(location, gMsgDTOC_ROS[left][MSG_LOC_ROS]) == TRUE_ROS))
+		{
+			/* Discard the hole */
+			gNumDelBytes_ROS -= gMsgDTOC_ROS[left][MSG_SIZE_ROS];
+			gNumDelMsg_ROS--;
+			_UnfileMsgHole_ROS(left);
+			_EraseDelMsgEntry_ROS(left);
+		}
+	}
+	/* Check if a hole ends where the released bytes start */
+	else if(left != NULL_HOLE_ROS)
+	{
+		/* Grow the left hole over the released bytes */
+		_UnfileMsgHole_ROS(left);
+		gMsgDTOC_ROS[left][MSG_SIZE_ROS] += size;
+		gNumDelBytes_ROS += size;
+
+		/* Check if a hole also starts where the released bytes end */
+		if(right != NULL_HOLE_ROS)
+		{
+			/* Join the right hole onto the left, and discard it */
+			_UnfileMsgHole_ROS(right);
+			gMsgDTOC_ROS[left][MSG_SIZE_ROS] += gMsgDTOC_ROS[right][MSG_SIZE_ROS];
+			gNumDelMsg_ROS--;
+			_EraseDelMsgEntry_ROS(right);
+		}
+
+		/* Refile the grown hole */
+		_FileMsgHole_ROS(left);
+	}
+	/* Check if a hole starts where the released bytes end */
+	else if(right != NULL_HOLE_ROS)
+	{
+		/* Grow the right hole down over the released bytes, and refile it */
+		_UnfileMsgHole_ROS(right);
+		gMsgDTOC_ROS[right][MSG_LOC_ROS] = location;
+		gMsgDTOC_ROS[right][MSG_SIZE_ROS] += size;
+		gNumDelBytes_ROS += size;
+		_FileMsgHole_ROS(right);
+	}
+	/* Released bytes are isolated, a new hole entry is needed */
+	else
+	{
+		/* Search for a free deleted message entry */
+		for(i = 0u; i < MAX_DEL_MSGS_ROS; i++)
+		{
+			/* Check if deleted message ID is null value (deleted slot is free) */
+			if(gMsgDTOC_ROS[i][MSG_ID_ROS] == NULL_ID_ROS)
+			{
+				/* Free slot found, break from the for loop prematurely */
+				break;
+			}
+		}
+
+		/* Check if no free slot was found */
+		if(i == MAX_DEL_MSGS_ROS)
+		{
+			/* Need to defrag, no deleted table space left */
+			return F_MAX_DEL_MSGS_REACHED_ROS;
+		}
+
+		/* Store the new hole, and file it under its size class */
+		gMsgDTOC_ROS[i][MSG_ID_ROS] = DEL_MSG_IN_USE_ROS;
+		gMsgDTOC_ROS[i][MSG_LOC_ROS] = location;
+		gMsgDTOC_ROS[i][MSG_SIZE_ROS] = size;
+		gNumDelMsg_ROS++;
+		gNumDelBytes_ROS += size;
+		_FileMsgHole_ROS(i);
+	}
+
+	/* Space released, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _ReleaseMsgSpace_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _DefragStep_ROS
+* Type			: Internal function, message system
+* Description	: Runs one defragmentation step on the lowest hole in the store. If the hole is
+*				  followed by the top of the store or by another hole, it is merged into it; if it
+*				  is followed by a live message, the message is moved down to the start of the hole
+*				  and the hole moves up above it. Holes below a pinned message are skipped, and the
+*				  next hole up is tried. Returns true if a step was run, or false if there are no
+*				  holes that can be worked on.
+* Notes			: Worst case cost is one scan of each table per hole, and a MAX_MSG_BYTES_ROS byte
+*				  move.
+***************************************************************************************************/
+uint8_t _DefragStep_ROS
+		(
+			void
+		)
+{
+	/* Declare loop counter, and lowest hole index variables */
+	uint8_t i, hole;
+
+	/* Declare lowest location a candidate hole may start at */
+	uint32_t search_location = 0u;
+
+	/* Try holes in ascending location order, until one can be worked on */
+	while(true)
+	{
+		/* Search the deleted message table for the lowest hole at or above the search location */
+		hole = NULL_HOLE_ROS;
+		for(i = 0u; i < MAX_DEL_MSGS_ROS; i++)
+		{
+			/* Check if the entry is in use, in range, and lower than the lowest found so far */
+			if((gMsgDTOC_ROS[i][MSG_ID_ROS] != NULL_ID_ROS) && \
+			   (gMsgDTOC_ROS[i][MSG_LOC_ROS] >= search_location) && ((hole == NULL_HOLE_ROS) || \
+			   (gMsgDTOC_ROS[i][MSG_LOC_ROS] < gMsgDTOC_ROS[hole][MSG_LOC_ROS])))
+			{
+				hole = i;
+			}
+		}
+
+		/* Check if there are no (more) holes */
+		if(hole == NULL_HOLE_ROS)
+		{
+			/* Nothing can be defragmented, return false */
+			return FALSE_ROS;
+		}
+		/* Hole found, work on the bytes above it */
+		else
+		{
+			/* Store the hole's location and size in container variables */
+			MsgLoc_ROS hole_location = gMsgDTOC_ROS[hole][MSG_LOC_ROS];
+			MsgSize_ROS hole_size = gMsgDTOC_ROS[hole][MSG_SIZE_ROS];
+			MsgLoc_ROS hole_end = hole_location + hole_size;
+
+			/* Check if the hole is on top of the last message, and lower the next free location
+			   over it */
+			if(_LowerMsgStoreTop_ROS(hole_end, hole_location) == TRUE_ROS)
+			{
+				/* Discard the hole */
+				gNumDelBytes_ROS -= hole_size;
+				gNumDelMsg_ROS--;
+				_UnfileMsgHole_ROS(hole);
+				_EraseDelMsgEntry_ROS(hole);
+
+				/* Step complete, return true */
+				return TRUE_ROS;
+			}
+
+			/* Search the deleted message table for a hole starting where this one ends */
+			for(i = 0u; i < MAX_DEL_MSGS_ROS; i++)
+			{
+				/* Check if the entry is in use, and starts at the end of the hole */
+				if((gMsgDTOC_ROS[i][MSG_ID_ROS] != NULL_ID_ROS) && \
+				   (gMsgDTOC_ROS[i][MSG_LOC_ROS] == hole_end))
+				{
+					/* Join the next hole onto this one, and discard it */
+					_UnfileMsgHole_ROS(hole);
+					_UnfileMsgHole_ROS(i);
+					gMsgDTOC_ROS[hole][MSG_SIZE_ROS] += gMsgDTOC_ROS[i][MSG_SIZE_ROS];
+					gNumDelMsg_ROS--;
+					_EraseDelMsgEntry_ROS(i);
+					_FileMsgHole_ROS(hole);
+
+					/* Step complete, return true */
+					return TRUE_ROS;
+				}
+			}
+
+			/* Search the message table for the live message starting where the hole ends */
+			for(i = 0u; i < MAX_MSGS_ROS; i++)
+			{
+				/* Check if the entry is in use, and starts at the end of the hole */
+				if((gMsgTOC_ROS[i][MSG_SIZE_ROS] != NULL_SIZE_ROS) && \
+				   (gMsgTOC_ROS[i][MSG_LOC_ROS] == hole_end))
+				{
+					/* Found, break from the for loop prematurely */
+					break;
+				}
+			}
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+			/* Check if the message was found, and hold it (only if committed and not pinned) so
+			   it cannot be pinned, deleted or read while it moves */
+			if((i != MAX_MSGS_ROS) && \
+			   (_HoldMsgSlot_ROS(i, (__atomic_load_n(&gMsgSlotArray_ROS[i], __ATOMIC_ACQUIRE) & \
+									MSG_SLOT_VERSION_MASK_ROS) | MSG_SLOT_LIVE_ROS) == TRUE_ROS))
+#else
+			/* Check if the message was found and is not pinned */
+			if((i != MAX_MSGS_ROS) && (_MsgPinCount_ROS(i) == 0u))
+#endif
+			{
+				/* Slide the message data down to the start of the hole (writing it through to the
+				   storage backend) */
+				_WriteMessageData_ROS(gMsgFileSysPtr_ROS + hole_end, \
+									  gMsgFileSysPtr_ROS + hole_location, \
+									  gMsgTOC_ROS[i][MSG_SIZE_ROS]);
+
+				/* Patch the message's location, in the table and on the medium */
+				gMsgTOC_ROS[i][MSG_LOC_ROS] = hole_location;
+				_StoreMsgRecord_ROS(i);
+
+				/* Move the hole up above the message, its size (and class) is unchanged */
+				gMsgDTOC_ROS[hole][MSG_LOC_ROS] = hole_location + gMsgTOC_ROS[i][MSG_SIZE_ROS];
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+				/* Let go of the message */
+				_UnholdMsgSlot_ROS(i);
+#endif
+
+				/* Step complete, return true */
+				return TRUE_ROS;
+			}
+
+			/* Message above the hole is pinned (or missing), try the next hole up. The number of
+			   holes bounds this loop */
+			search_location = (uint32_t)hole_location + 1u;
+		}
+	}
+}
+/***************************************************************************************************
+* End of _DefragStep_ROS
+***************************************************************************************************/
+
+#if (ENABLE_MSG_EXPIRY_ROS)
+/***************************************************************************************************
+* Name			: _PushMsgExpiry_ROS
+* Type			: Internal function, message expiry.
+* Description	: Adds a message to the expiry heap, to expire at the specified tick.
+* Notes			: The message must not already be in the heap.
+***************************************************************************************************/
+void _PushMsgExpiry_ROS
+		(
+			/* Message table index to add */
+			uint8_t message_index, \
+			/* Tick the message expires at */
+			uint32_t expiry_tick
+		)
+{
+	/* Place the message in the first free element at the bottom of the heap */
+	gNumExpiryMsg_ROS++;
+	gMsgExpiryTickArray_ROS[message_index] = expiry_tick;
+	gMsgExpiryHeap_ROS[gNumExpiryMsg_ROS] = message_index;
+	gMsgExpiryHeapPosArray_ROS[message_index] = gNumExpiryMsg_ROS;
+
+	/* Move it up to its place */
+	_SiftMsgExpiry_ROS(gNumExpiryMsg_ROS);
+}
+/***************************************************************************************************
+* End of _PushMsgExpiry_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _RemoveMsgExpiry_ROS
+* Type			: Internal function, message expiry.
+* Description	: Removes a message from the expiry heap, by moving the last element into its place.
+* Notes			: The message must be in the heap.
+***************************************************************************************************/
+void _RemoveMsgExpiry_ROS
+		(
+			/* Message table index to remove */
+			uint8_t message_index
+		)
+{
+	/* Look up the message's heap element, and the last element's message */
+	uint8_t position = gMsgExpiryHeapPosArray_ROS[message_index];
+	uint8_t last_index = gMsgExpiryHeap_ROS[gNumExpiryMsg_ROS];
+
+	/* Take the message out of the heap */
+	gMsgExpiryHeapPosArray_ROS[message_index] = NULL_HEAP_POS_ROS;
+	gNumExpiryMsg_ROS--;
+
+	/* Check if the removed element was not the last */
+	if(last_index != message_index)
+	{
+		/* Fill the gap with the last element, and move it to its place */
+		gMsgExpiryHeap_ROS[position] = last_index;
+		gMsgExpiryHeapPosArray_ROS[last_index] = position;
+		_SiftMsgExpiry_ROS(position);
+	}
+}
+/***************************************************************************************************
+* End of _RemoveMsgExpiry_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _SiftMsgExpiry_ROS
+* Type			: Internal function, message expiry.
+* Description	: Restores heap order around an element whose expiry tick has changed, moving it up
+*				  towards the root if it expires before its parent, or otherwise down below any
+*				  child that expires before it.
+* Notes			: None.
+***************************************************************************************************/
+void _SiftMsgExpiry_ROS
+		(
+			/* Heap element to move */
+			uint8_t position
+		)
+{
+	/* Look up the element's message and expiry tick */
+	uint8_t message_index = gMsgExpiryHeap_ROS[position];
+	uint32_t expiry_tick = gMsgExpiryTickArray_ROS[message_index];
+
+	/* Move parents down while they expire after the message */
+	while((position > 1u) && \
+		  ((int32_t)(gMsgExpiryTickArray_ROS[gMsgExpiryHeap_ROS[position / 2u]] - \
+					 expiry_tick) > 0))
+	{
+		gMsgExpiryHeap_ROS[position] = gMsgExpiryHeap_ROS[position / 2u];
+		gMsgExpiryHeapPosArray_ROS[gMsgExpiryHeap_ROS[position]] = position;
+		position /= 2u;
+	}
+
+	/* Move the earlier expiring child up while it expires before the message */
+	while((2u * position) <= gNumExpiryMsg_ROS)
+	{
+		/* Start with the left child, and take the right child if it expires first */
+		uint8_t child = 2u * position;
+		if((child < gNumExpiryMsg_ROS) && \
+		   ((int32_t)(gMsgExpiryTickArray_ROS[gMsgExpiryHeap_ROS[child + 1u]] - \
+					  gMsgExpiryTickArray_ROS[gMsgExpiryHeap_ROS[child]]) < 0))
+		{
+			child++;
+		}
+
+		/* Check if the message expires no later than the child, and is in place */
+		if((int32_t)(gMsgExpiryTickArray_ROS[gMsgExpiryHeap_ROS[child]] - expiry_tick) >= 0)
+		{
+			break;
+		}
+
+		gMsgExpiryHeap_ROS[position] = gMsgExpiryHeap_ROS[child];
+		gMsgExpiryHeapPosArray_ROS[gMsgExpiryHeap_ROS[position]] = position;
+		position = child;
+	}
+
+	/* Store the message in its final element */
+	gMsgExpiryHeap_ROS[position] = message_index;
+	gMsgExpiryHeapPosArray_ROS[message_index] = position;
+}
+/***************************************************************************************************
+* End of _SiftMsgExpiry_ROS
+***************************************************************************************************/
+#endif
+	
+/***************************************************************************************************
+* Name			: _IsMessageIDValid_ROS
+* Type			: Internal function, input validation.
+* Description	: Checks passed message ID is within maximum and minimum ranges, as defined by
+*				  MAX_MSG_ID_ROS and MIN_MESSAGE_ID_ROS (declaration in messages.h). Returns 
+*				  too high or too low error code if not in range, otherwise returns true.
+* Notes			: None.
+***************************************************************************************************/					
+uint8_t _IsMessageIDValid_ROS
+		(
+			/* Message ID to validate */
+			MsgID_ROS message_id
+		)
+{
+	/* Check if message ID is greater than maximum defined value */
+	if(message_id > MAX_MSG_ID_ROS)
+	{
+		/* Message ID too high, return failure */
+		return F_MSG_ID_TOO_HIGH_ROS;
+	}
+	/* Check if message ID is lower than minimum defined value */
+	else if(message_id < MIN_MSG_ID_ROS)
+	{
+		/* Message ID too low, return failure */
+		return F_MSG_ID_TOO_LOW_ROS;
+	}
+	/* No fail conditions met, message ID is within range */
+	else
+	{
+		/* Input validation passed, return true */
+		return TRUE_ROS;
+	}
+}
+/***************************************************************************************************
+* End of _IsMessageIDValid_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _IsMessageIDEmpty_ROS
+* Type			: Internal function, input validation.
+* Description	: Checks if passed message ID contains a valid message. If the message ID is
+*				  invalid, it returns an error code; otherwise it returns true if the ID is empty or
+*				  false if its occupied.
+* Notes			: This function uses _IsMessageIDValid_ROS to check if passed message ID is valid.
+***************************************************************************************************/
+uint8_t _IsMessageIDEmpty_ROS
+		(
+			/* Message ID to check */
+			MsgID_ROS message_id
+		)
+{
+	/* Check if passed message ID is valid, and store result in temporary container variable */
+	uint8_t message_id_valid = _IsMessageIDValid_ROS(message_id);
+	
+	/* Check ID validation check did not return true */
+	if(message_id_valid != TRUE_ROS)
+	{
+		/* Message ID invalid, return error code from validation check function */
+		return message_id_valid;
+	}
+	/* Message ID is valid */
+	else
+	{
+		/* Look up message ID's index number, and store in temporary container variable */
+		uint8_t message_index = _LookupMsgIndex_ROS(message_id);
+		
+		/* Check if the message ID's index number is a null value (defined in messages.h) */
+		if(message_index == NULL_ID_ROS)
+		{
+			/* Message index is null, therefore ID is empty - return true */
+			return TRUE_ROS;
+		}
+		/* Message index is not a null value */
+		else
+		{
+			/* Message index is not null, there ID is occupied - return false */
+			return FALSE_ROS;
+		}
+	}
+}
+/***************************************************************************************************
+* End of _IsMessageIDEmpty_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _IsMessageSizeValid_ROS
+* Type			: Internal function, input validation.
+* Description	: Checks if passed message size is within the range defined by MAX_MESSAGE_BYTES_ROS
+*				  and MIN_MESSAGE_BYTES_ROS; and returns an error code if outside this range and 
+*				  true if within the range. The max/min values are defined in messages.h.
+* Notes			: 
+***************************************************************************************************/
+uint8_t _IsMessageSizeValid_ROS
+		(
+			/* Message size to validate */
+			MsgSize_ROS message_size
+		)
+{
+	/* Check if message size is above maximum */
+	if(message_size > MAX_MSG_BYTES_ROS)
+	{
+		/* Message size greater than maximum, return failure */
+		return F_MSG_SIZE_TOO_LARGE_ROS;
+	}
+	/* Check if message size is below minimum */
+	else if(message_size < MIN_MSG_BYTES_ROS)
+	{
+		/* Message size lower than minimum, return failure */
+		return F_MSG_SIZE_TOO_LOW_ROS;
+	}
+	/* Message size is within range */
+	else
+	{
+		/* Message size is within range, return true */	
+		return TRUE_ROS;
+	}
+}
+/***************************************************************************************************
+* End of _IsMessageSizeValid_ROS
+***************************************************************************************************/
+
+#if (ENABLE_MSG_ID_HASH_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+/***************************************************************************************************
+* Name			: _HashMsgID_ROS
+* Type			: Internal function, message ID index.
+* Description	: Returns the home slot of a message ID in the hash index, using Fibonacci
+*				  (multiplicative) hashing so sequential IDs spread across the table.
+* Notes			: None.
+***************************************************************************************************/
+uint8_t _HashMsgID_ROS
+		(
+			/* Message ID to hash */
+			MsgID_ROS message_id
+		)
+{
+	/* Multiply by 2^32 / golden ratio, and keep the top MSG_ID_HASH_BITS_ROS bits */
+	return (uint8_t)((uint32_t)((uint32_t)message_id * (uint32_t)2654435769ul) >> \
+					 (32u - MSG_ID_HASH_BITS_ROS));
+}
+/***************************************************************************************************
+* End of _HashMsgID_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _LookupMsgIndex_ROS
+* Type			: Internal function, message ID index.
+* Description	: Returns the message table index stored for a message ID, or NULL_ID_ROS if the ID
+*				  is not in the index.
+* Notes			: Probes at most MAX_MSG_ID_PROBES_ROS slots.
+***************************************************************************************************/
+uint8_t _LookupMsgIndex_ROS
+		(
+			/* Message ID to look up */
+			MsgID_ROS message_id
+		)
+{
+	/* Declare probe counter, and start at the ID's home slot */
+	uint8_t probe, slot = _HashMsgID_ROS(message_id);
+
+	/* Probe linearly from the home slot */
+	for(probe = 0u; probe < MAX_MSG_ID_PROBES_ROS; probe++)
+	{
+		/* Check if the slot is empty (the ID cannot be further along) */
+		if(gMsgIDHashIndexArray_ROS[slot] == NULL_ID_ROS)
+		{
+			break;
+		}
+		/* Check if the slot holds the ID */
+		else if(gMsgIDHashKeyArray_ROS[slot] == message_id)
+		{
+			/* ID found, return its message index */
+			return gMsgIDHashIndexArray_ROS[slot];
+		}
+
+		/* Move to the next slot, wrapping at the end of the table */
+		slot = (slot + 1u) & (MSG_ID_HASH_SLOTS_ROS - 1u);
+	}
+
+	/* ID not in the index, return null */
+	return NULL_ID_ROS;
+}
+/***************************************************************************************************
+* End of _LookupMsgIndex_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _InsertMsgIndex_ROS
+* Type			: Internal function, message ID index.
+* Description	: Stores a message table index for a message ID that is not already in the index.
+*				  Returns success, or F_MSG_ID_TABLE_FULL_ROS if no empty slot is found within
+*				  MAX_MSG_ID_PROBES_ROS probes (nothing is changed).
+* Notes			: None.
+***************************************************************************************************/
+uint8_t _InsertMsgIndex_ROS
+		(
+			/* Message ID to insert */
+			MsgID_ROS message_id, \
+			/* Message table index to store */
+			uint8_t message_index
+		)
+{
+	/* Declare probe counter, and start at the ID's home slot */
+	uint8_t probe, slot = _HashMsgID_ROS(message_id);
+
+	/* Probe linearly from the home slot for an empty slot */
+	for(probe = 0u; probe < MAX_MSG_ID_PROBES_ROS; probe++)
+	{
+		/* Check if the slot is empty */
+		if(gMsgIDHashIndexArray_ROS[slot] == NULL_ID_ROS)
+		{
+			/* Store the ID and its index */
+			gMsgIDHashKeyArray_ROS[slot] = message_id;
+			gMsgIDHashIndexArray_ROS[slot] = message_index;
+
+			/* Insert complete, return success */
+			return SUCCESS_ROS;
+		}
+
+		/* Move to the next slot, wrapping at the end of the table */
+		slot = (slot + 1u) & (MSG_ID_HASH_SLOTS_ROS - 1u);
+	}
+
+	/* Probe limit reached, return failure */
+	return F_MSG_ID_TABLE_FULL_ROS;
+}
+/***************************************************************************************************
+* End of _InsertMsgIndex_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _RemoveMsgIndex_ROS
+* Type			: Internal function, message ID index.
+* Description	: Removes a message ID from the index. Entries further along the probe sequence are
+*				  shifted back into the gap (backward shift deletion), so no tombstones are needed
+*				  and probe sequences never grow.
+* Notes			: The ID must be in the index.
+***************************************************************************************************/
+void _RemoveMsgIndex_ROS
+		(
+			/* Message ID to remove */
+			MsgID_ROS message_id
+		)
+{
+	/* Declare slot variables, starting at the ID's home slot */
+	uint8_t gap = _HashMsgID_ROS(message_id), slot;
+
+	/* Find the slot holding the ID */
+	while((gMsgIDHashIndexArray_ROS[gap] == NULL_ID_ROS) || \
+		  (gMsgIDHashKeyArray_ROS[gap] != message_id))
+	{
+		gap = (gap + 1u) & (MSG_ID_HASH_SLOTS_ROS - 1u);
+	}
+
+	/* Walk the entries after the gap until an empty slot ends the cluster */
+	slot = (gap + 1u) & (MSG_ID_HASH_SLOTS_ROS - 1u);
+	while(gMsgIDHashIndexArray_ROS[slot] != NULL_ID_ROS)
+	{
+		/* Calculate how far the entry is from its home slot, and how far the gap is */
+		uint8_t home = _HashMsgID_ROS(gMsgIDHashKeyArray_ROS[slot]);
+		uint8_t slot_distance = (slot - home) & (MSG_ID_HASH_SLOTS_ROS - 1u);
+		uint8_t gap_distance = (gap - home) & (MSG_ID_HASH_SLOTS_ROS - 1u);
+
+		/* Check if the gap lies on the entry's probe sequence */
+		if(gap_distance < slot_distance)
+		{
+			/* Move the entry back into the gap, leaving a new gap behind it */
+			gMsgIDHashKeyArray_ROS[gap] = gMsgIDHashKeyArray_ROS[slot];
+			gMsgIDHashIndexArray_ROS[gap] = gMsgIDHashIndexArray_ROS[slot];
+			gap = slot;
+		}
+
+		/* Move to the next slot */
+		slot = (slot + 1u) & (MSG_ID_HASH_SLOTS_ROS - 1u);
+	}
+
+	/* Empty the final gap */
+	gMsgIDHashIndexArray_ROS[gap] = NULL_ID_ROS;
+}
+/***************************************************************************************************
+* End of _RemoveMsgIndex_ROS
+***************************************************************************************************/
+#endif
+
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+#if (ENABLE_MSG_ID_HASH_ROS)
+/***************************************************************************************************
+* Name			: _LookupMsgIndex_ROS
+* Type			: Internal function, message ID index.
+* Description	: Returns the message table index holding a message ID (claimed, live or held), or
+*				  NULL_ID_ROS if no slot holds it.
+* Notes			: Lock-free store version of the hashed index lookup. The hash index cannot be
+*				  updated with one compare and swap (a removal shifts entries back), so the table's
+*				  full width IDs are scanned instead, at a cost of one pass of the table.
+***************************************************************************************************/
+uint8_t _LookupMsgIndex_ROS
+		(
+			/* Message ID to look up */
+			MsgID_ROS message_id
+		)
+{
+	/* Declare loop counter and slot state container variables */
+	uint8_t i;
+	uint32_t state;
+
+	/* Search the table for a slot in use holding the ID (index 0 is the null message) */
+	for(i = 1u; i < MAX_MSGS_ROS; i++)
+	{
+		state = _MsgSlotState_ROS(__atomic_load_n(&gMsgSlotArray_ROS[i], __ATOMIC_ACQUIRE));
+		if(((state == MSG_SLOT_CLAIMED_ROS) || (state == MSG_SLOT_LIVE_ROS) || \
+			(state == MSG_SLOT_HELD_ROS)) && \
+		   (__atomic_load_n(&gMsgIDArray_ROS[i], __ATOMIC_ACQUIRE) == message_id))
+		{
+			/* ID found, return its message index */
+			return i;
+		}
+	}
+
+	/* ID not in the table, return null */
+	return NULL_ID_ROS;
+}
+/***************************************************************************************************
+* End of _LookupMsgIndex_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _InsertMsgIndex_ROS
+* Type			: Internal function, message ID index.
+* Description	: Claims a message ID for a claimed message table index, by storing the ID against
+*				  the index and then scanning the table for another slot holding it. Returns
+*				  success; F_MSG_ID_OCCUPIED_ROS if a committed or held message has the ID; or
+*				  F_MSG_BUSY_ROS if another creator is claiming it at the same time. The ID is
+*				  cleared again on failure.
+* Notes			: Lock-free store version of the hashed index insert. Both creators of one ID store
+*				  it before they scan, so at least one of them sees the other, and at most one
+*				  succeeds (both may fail, as each sees the other claiming it).
+***************************************************************************************************/
+uint8_t _InsertMsgIndex_ROS
+		(
+			/* Message ID to claim */
+			MsgID_ROS message_id, \
+			/* Claimed message table index */
+			uint8_t message_index
+		)
+{
+	/* Declare loop counter and slot state container variables */
+	uint8_t i;
+	uint32_t state;
+
+	/* Store the ID against the index before scanning */
+	__atomic_store_n(&gMsgIDArray_ROS[message_index], message_id, __ATOMIC_SEQ_CST);
+
+	/* Search the rest of the table for a slot in use holding the ID */
+	for(i = 1u; i < MAX_MSGS_ROS; i++)
+	{
+		state = _MsgSlotState_ROS(__atomic_load_n(&gMsgSlotArray_ROS[i], __ATOMIC_SEQ_CST));
+		if((i != message_index) && (state != MSG_SLOT_FREE_ROS) && \
+		   (state != MSG_SLOT_DELETED_ROS) && \
+		   (__atomic_load_n(&gMsgIDArray_ROS[i], __ATOMIC_SEQ_CST) == message_id))
+		{
+			/* ID taken, clear it from the index and return failure */
+			__atomic_store_n(&gMsgIDArray_ROS[message_index], NULL_ID_ROS, __ATOMIC_SEQ_CST);
+			return (state == MSG_SLOT_CLAIMED_ROS) ? F_MSG_BUSY_ROS : F_MSG_ID_OCCUPIED_ROS;
+		}
+	}
+
+	/* ID claimed, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _InsertMsgIndex_ROS
+***************************************************************************************************/
+#else
+/***************************************************************************************************
+* Name			: _InsertMsgIndex_ROS
+* Type			: Internal function, message ID index.
+* Description	: Claims a message ID for a message table index, with a compare and swap from null.
+*				  Returns success, or F_MSG_ID_OCCUPIED_ROS if the ID is already claimed (nothing is
+*				  changed).
+* Notes			: Lock-free store version of the dense index insert.
+***************************************************************************************************/
+uint8_t _InsertMsgIndex_ROS
+		(
+			/* Message ID to claim */
+			MsgID_ROS message_id, \
+			/* Message table index to store */
+			uint8_t message_index
+		)
+{
+	/* Declare expected index variable, the ID must be empty */
+	uint8_t expected_index = NULL_ID_ROS;
+
+	/* Swap the index in if the ID is empty, and return the result */
+	return __atomic_compare_exchange_n(&gMsgIndexArray_ROS[message_id], &expected_index, \
+									   message_index, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ? \
+		   SUCCESS_ROS : F_MSG_ID_OCCUPIED_ROS;
+}
+/***************************************************************************************************
+* End of _InsertMsgIndex_ROS
+***************************************************************************************************/
+#endif
+
+/***************************************************************************************************
+* Name			: _ClaimMsgSlot_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Claims a free message table slot for a new message, giving it a new version and
+*				  one pin (held by its writer until it is published). Returns true and outputs the
+*				  slot's index, or false if every slot is in use.
+* Notes			: A slot lost to another claimer is skipped, so the cost is one pass of the table.
+***************************************************************************************************/
+uint8_t _ClaimMsgSlot_ROS
+		(
+			/* Pointer to variable that will store the claimed index */
+			uint8_t * message_index
+		)
+{
+	/* Declare loop counter and slot word container variables */
+	uint8_t i;
+	uint32_t slot;
+
+	/* Search the table for a free slot (index 0 is the null message) */
+	for(i = 1u; i < MAX_MSGS_ROS; i++)
+	{
+		slot = __atomic_load_n(&gMsgSlotArray_ROS[i], __ATOMIC_RELAXED);
+
+		/* Check if the slot is free, and claim it with the next version */
+		if((_MsgSlotState_ROS(slot) == MSG_SLOT_FREE_ROS) && \
+		   __atomic_compare_exchange_n(&gMsgSlotArray_ROS[i], &slot, \
+									   ((slot + MSG_SLOT_VERSION_ROS) & MSG_SLOT_VERSION_MASK_ROS) | \
+									   MSG_SLOT_PIN_ROS | MSG_SLOT_CLAIMED_ROS, \
+									   false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+		{
+			/* Slot claimed, output it and return true */
+			*message_index = i;
+			return TRUE_ROS;
+		}
+	}
+
+	/* No free slot, return false */
+	return FALSE_ROS;
+}
+/***************************************************************************************************
+* End of _ClaimMsgSlot_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _ReleaseMsgSlot_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Frees a claimed slot whose message was never entered (its ID was taken, or the
+*				  store was full).
+* Notes			: Nothing else can change a claimed slot, so it is stored, not swapped.
+***************************************************************************************************/
+void _ReleaseMsgSlot_ROS
+		(
+			/* Claimed message table index */
+			uint8_t message_index
+		)
+{
+	/* Free the slot, keeping its version */
+#if (ENABLE_MSG_ID_HASH_ROS)
+	__atomic_store_n(&gMsgIDArray_ROS[message_index], NULL_ID_ROS, __ATOMIC_RELAXED);
+#endif
+	__atomic_store_n(&gMsgSlotArray_ROS[message_index], \
+					 __atomic_load_n(&gMsgSlotArray_ROS[message_index], __ATOMIC_RELAXED) & \
+					 MSG_SLOT_VERSION_MASK_ROS, __ATOMIC_RELEASE);
+}
+/***************************************************************************************************
+* End of _ReleaseMsgSlot_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _BumpMsgStoreTop_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Takes bytes from the top of the store, raising the next free location with a
+*				  compare and swap. Returns success and outputs the location taken, or
+*				  F_INSUFF_FREE_MEM_ROS if the bytes do not fit below the end of the store.
+* Notes			: A fetch and add cannot be undone once it overshoots, and could wrap a narrow
+*				  location past the end of the store, so the room is checked before each swap. A
+*				  swap only fails if another creator took bytes first.
+***************************************************************************************************/
+uint8_t _BumpMsgStoreTop_ROS
+		(
+			/* Number of bytes to take */
+			MsgSize_ROS message_size, \
+			/* Pointer to variable that will store the location taken */
+			MsgLoc_ROS * message_location
+		)
+{
+	/* Load the top of the store */
+	MsgLoc_ROS top = __atomic_load_n(&gNextFreeMsgLoc_ROS, __ATOMIC_ACQUIRE);
+
+	/* Retry until the top is raised, or found without room */
+	do
+	{
+		/* Check if the bytes do not fit on top */
+		if(((uint32_t)top + message_size) >= MAX_MSG_STOR_BYTES_ROS)
+		{
+			/* Top of the store is full, return failure */
+			return F_INSUFF_FREE_MEM_ROS;
+		}
+	}
+	while(!__atomic_compare_exchange_n(&gNextFreeMsgLoc_ROS, &top, (MsgLoc_ROS)(top + message_size), \
+									   false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+	/* Bytes taken, output their location and return success */
+	*message_location = top;
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _BumpMsgStoreTop_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _LoadMsgSlot_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Looks up a message ID, and outputs its message table index and slot word. Returns
+*				  success if the slot holds the ID's message, committed or not; an error code if the
+*				  ID is invalid; F_MSG_ID_EMPTY_ROS if it holds no message (or one that is deleted);
+*				  or F_MSG_BUSY_ROS if the message is held.
+* Notes			: The slot word is the value to compare and swap against. Its version changes each
+*				  time the slot is reused, so a swap fails if the message was replaced since the
+*				  lookup.
+***************************************************************************************************/
+uint8_t _LoadMsgSlot_ROS
+		(
+			/* Message ID to look up */
+			MsgID_ROS message_id, \
+			/* Pointer to variable that will store the message table index */
+			uint8_t * message_index, \
+			/* Pointer to variable that will store the slot word */
+			uint32_t * slot
+		)
+{
+	/* Check if passed message ID is valid, and store result in container variable */
+	uint8_t message_id_valid = _IsMessageIDValid_ROS(message_id);
+
+	/* Check ID validation check did not return true */
+	if(message_id_valid != TRUE_ROS)
+	{
+		/* Message ID invalid, return error code */
+		return message_id_valid;
+	}
+
+	/* Look up the ID's index, and check it is empty */
+	*message_index = _LookupMsgIndex_ROS(message_id);
+	if(*message_index == NULL_ID_ROS)
+	{
+		return F_MSG_ID_EMPTY_ROS;
+	}
+
+	/* Load the slot word */
+	*slot = __atomic_load_n(&gMsgSlotArray_ROS[*message_index], __ATOMIC_ACQUIRE);
+
+	/* Check if a maintenance function holds the message */
+	if(_MsgSlotState_ROS(*slot) == MSG_SLOT_HELD_ROS)
+	{
+		return F_MSG_BUSY_ROS;
+	}
+	/* Check if the slot holds no message, or a different one (the index was reused since the
+	   lookup) */
+	else if(((_MsgSlotState_ROS(*slot) != MSG_SLOT_LIVE_ROS) && \
+			 (_MsgSlotState_ROS(*slot) != MSG_SLOT_CLAIMED_ROS)) || \
+			(_MsgIDOfIndex_ROS(*message_index) != message_id))
+	{
+		return F_MSG_ID_EMPTY_ROS;
+	}
+	/* Slot holds the message */
+	else
+	{
+		return SUCCESS_ROS;
+	}
+}
+/***************************************************************************************************
+* End of _LoadMsgSlot_ROS
+***************************************************************************************************/
 
-					/* Set the space found flag to true */
-					space_found = true;
+/***************************************************************************************************
+* Name			: _PinMsgID_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Pins a committed message by ID, so it cannot be deleted, moved or reused until it
+*				  is unpinned. Returns success and outputs the message table index, or the error
+*				  code of _LoadMsgSlot_ROS, F_MSG_NOT_COMMITTED_ROS if the message is still being
+*				  written, or F_MSG_PINNED_ROS if it already has MAX_MSG_PINS_ROS pins.
+* Notes			: Retried only when the slot word changes between load and swap.
+***************************************************************************************************/
+uint8_t _PinMsgID_ROS
+		(
+			/* Message ID to pin */
+			MsgID_ROS message_id, \
+			/* Pointer to variable that will store the message table index */
+			uint8_t * message_index
+		)
+{
+	/* Declare slot word and result container variables */
+	uint32_t slot;
+	uint8_t result;
 
-					/* Suitable deleted message space found, break from for loop prematurely */
-					break;
-				} 
-			}
+	/* Retry until the pin is swapped in, or the message is found unable to be pinned */
+	while(true)
+	{
+		/* Load the message's slot word, and check the message exists */
+		result = _LoadMsgSlot_ROS(message_id, message_index, &slot);
+		if(result != SUCCESS_ROS)
+		{
+			return result;
 		}
-	
-		if(!space_found)
+		/* Check if the message is still being written */
+		else if(_MsgSlotState_ROS(slot) != MSG_SLOT_LIVE_ROS)
 		{
-			if((gNextFreeMsgLoc_ROS + message_size) < MAX_MSG_STOR_BYTES_ROS)
-			{
-				*output_location = gNextFreeMsgLoc_ROS;
-			
-				*message_index = gNextFreeMsgIndex_ROS;
-				
-				*is_deleted_location = false;
-				
-				return SUCCESS_ROS;
-			}
-			else
-			{
-				return F_INSUFF_FREE_MEM_ROS;
-			}
+			return F_MSG_NOT_COMMITTED_ROS;
 		}
-		else
+		/* Check if the pin count is saturated */
+		else if(_MsgSlotPins_ROS(slot) == MAX_MSG_PINS_ROS)
+		{
+			return F_MSG_PINNED_ROS;
+		}
+		/* Check if the slot word is unchanged, and add the pin */
+		else if(__atomic_compare_exchange_n(&gMsgSlotArray_ROS[*message_index], &slot, \
+											slot + MSG_SLOT_PIN_ROS, false, __ATOMIC_ACQ_REL, \
+											__ATOMIC_ACQUIRE))
 		{
 			return SUCCESS_ROS;
 		}
 	}
-	return 0;
 }
-				
-uint8_t _WriteMessageData_ROS
+/***************************************************************************************************
+* End of _PinMsgID_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _HoldMsgSlot_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Holds a committed, unpinned message for a maintenance function, so it cannot be
+*				  pinned or deleted by any other context (which then get F_MSG_BUSY_ROS). Returns
+*				  true if the slot word was still the one expected, otherwise false (nothing is
+*				  changed).
+* Notes			: The expected word must be live with no pins. Let go with _UnholdMsgSlot_ROS, or
+*				  delete the message with _DeleteMsgIndex_ROS.
+***************************************************************************************************/
+uint8_t _HoldMsgSlot_ROS
 		(
-			uint8_t * pointer_to_data, \
-			uint8_t * pointer_to_destination, \
-			uint8_t number_bytes
+			/* Message table index to hold */
+			uint8_t message_index, \
+			/* Slot word expected */
+			uint32_t slot
 		)
 {
-	if(0)
+	/* Swap the slot to held if it is unchanged, and return the result */
+	return __atomic_compare_exchange_n(&gMsgSlotArray_ROS[message_index], &slot, \
+									   (slot & MSG_SLOT_VERSION_MASK_ROS) | MSG_SLOT_HELD_ROS, \
+									   false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) ? \
+		   TRUE_ROS : FALSE_ROS;
+}
+/***************************************************************************************************
+* End of _HoldMsgSlot_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _RetireMsgSlot_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Marks a message deleted, if its slot word is still the one expected: removes its
+*				  ID from the index, and queues it for SettleMessageStore_ROS, which releases its
+*				  space and frees the slot. Returns true if deleted, otherwise false (nothing is
+*				  changed).
+* Notes			: The caller checks the message may be deleted. The table entry is left intact
+*				  until settled. A settle retrying deleted messages (see _SettleMsgStore_ROS) can
+*				  free the slot before it is queued here, and the slot can then be claimed again,
+*				  so the ID is read before the swap, and only removed while it maps to this index.
+***************************************************************************************************/
+uint8_t _RetireMsgSlot_ROS
+		(
+			/* Message table index to delete */
+			uint8_t message_index, \
+			/* Slot word expected */
+			uint32_t slot
+		)
+{
+	/* Declare message ID container variable, read while the slot word is the one expected */
+	MsgID_ROS message_id = _MsgIDOfIndex_ROS(message_index);
+
+	/* Check if the slot word is unchanged, and mark the message deleted */
+	if(__atomic_compare_exchange_n(&gMsgSlotArray_ROS[message_index], &slot, \
+								   (slot & MSG_SLOT_VERSION_MASK_ROS) | MSG_SLOT_DELETED_ROS, \
+								   false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
 	{
-		/* Input validation */
+#if (ENABLE_MSG_ID_HASH_ROS)
+		/* Nothing to remove, a freed slot drops its ID */
+		_RemoveMsgIndex_ROS(message_id);
+#else
+		/* Free the ID if it still maps to this index. No other creator can claim the ID until
+		   it is freed, so a slot claimed again never maps it */
+		uint8_t expected_index = message_index;
+		(void)__atomic_compare_exchange_n(&gMsgIndexArray_ROS[message_id], &expected_index, \
+										  NULL_ID_ROS, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#endif
+
+		/* Decrease the total number of messages by one */
+		__atomic_fetch_sub(&gNumMsg_ROS, 1u, __ATOMIC_RELAXED);
+
+		/* Leave the rest to the next settle, and return true */
+		_PushMsgSettle_ROS(message_index);
+		return TRUE_ROS;
 	}
+	/* Slot word changed */
 	else
 	{
-		
-
-		memmove(pointer_to_destination, pointer_to_data, number_bytes);	
-			
-		/**
-		* DEV: [OK] Add different write options here, for writing to EEPROM/SDRAM etc? 
-		*       Perhaps an extension, or user defined function elsewhere. Will only use
-		*		 internal flash memory for first release.
-		**/
-		 
-		return SUCCESS_ROS;
+		/* Nothing deleted, return false */
+		return FALSE_ROS;
 	}
-	
-	return 0;	
 }
+/***************************************************************************************************
+* End of _RetireMsgSlot_ROS
+***************************************************************************************************/
 
-void _EraseMsgEntry_ROS
+/***************************************************************************************************
+* Name			: _PublishMsgSlot_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Makes a claimed message readable once its table entry and data are written,
+*				  dropping its writer's pin, and queues it for SettleMessageStore_ROS to deliver.
+* Notes			: The release store orders the entry and data before the slot, so a reader that
+*				  sees the message live sees them too.
+***************************************************************************************************/
+void _PublishMsgSlot_ROS
 		(
+			/* Claimed message table index */
 			uint8_t message_index
 		)
 {
-	gMsgTOC_ROS[message_index][MSG_ID_ROS] = NULL_ID_ROS;
-	gMsgTOC_ROS[message_index][MSG_SIZE_ROS] = NULL_SIZE_ROS;
-	gMsgTOC_ROS[message_index][MSG_LOC_ROS] = NULL_LOC_ROS;
-	gMsgTOC_ROS[message_index][MSG_TTL_ROS] = NULL_TTL_ROS;
-	gMsgTOC_ROS[message_index][MSG_TARG_ROS] = NULL_TARG_ROS;
+	/* Mark the slot live with no pins, keeping its version */
+	__atomic_store_n(&gMsgSlotArray_ROS[message_index], \
+					 (__atomic_load_n(&gMsgSlotArray_ROS[message_index], __ATOMIC_RELAXED) & \
+					  MSG_SLOT_VERSION_MASK_ROS) | MSG_SLOT_LIVE_ROS, __ATOMIC_RELEASE);
+
+	/* Queue the message for delivery */
+	_PushMsgSettle_ROS(message_index);
 }
+/***************************************************************************************************
+* End of _PublishMsgSlot_ROS
+***************************************************************************************************/
 
-void _EraseDelMsgEntry_ROS
+/***************************************************************************************************
+* Name			: _PushMsgSettle_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Queues a message index for SettleMessageStore_ROS, unless it is already queued (it
+*				  is settled in whatever state it is in when its turn comes).
+* Notes			: The stack is only pushed to with compare and swap, and taken whole by exchange,
+*				  so a stale head can never be swapped back in.
+***************************************************************************************************/
+void _PushMsgSettle_ROS
 		(
+			/* Message table index to queue */
 			uint8_t message_index
 		)
 {
-	gMsgDTOC_ROS[message_index][MSG_ID_ROS] = NULL_ID_ROS;
-	gMsgDTOC_ROS[message_index][MSG_SIZE_ROS] = NULL_SIZE_ROS;
-	gMsgDTOC_ROS[message_index][MSG_LOC_ROS] = NULL_LOC_ROS;
-	gMsgDTOC_ROS[message_index][MSG_TTL_ROS] = NULL_TTL_ROS;
-	gMsgDTOC_ROS[message_index][MSG_TARG_ROS] = NULL_TARG_ROS;
+	/* Declare stack head container variable */
+	uint8_t head;
+
+	/* Check if the index is already queued, and mark it queued */
+	if(__atomic_exchange_n(&gMsgSettlePendingArray_ROS[message_index], true, __ATOMIC_SEQ_CST))
+	{
+		return;
+	}
 
+	/* Link the index above the current head, retrying until it is swapped in */
+	head = __atomic_load_n(&gMsgSettleHead_ROS, __ATOMIC_RELAXED);
+	do
+	{
+		gMsgSettleNextArray_ROS[message_index] = head;
+	}
+	while(!__atomic_compare_exchange_n(&gMsgSettleHead_ROS, &head, message_index, false, \
+									   __ATOMIC_SEQ_CST, __ATOMIC_RELAXED));
 }
-	
 /***************************************************************************************************
-* Name			: _IsMessageIDValid_ROS
-* Type			: Internal function, input validation.
-* Description	: Checks passed message ID is within maximum and minimum ranges, as defined by
-*				  MAX_MSG_ID_ROS and MIN_MESSAGE_ID_ROS (declaration in messages.h). Returns 
-*				  too high or too low error code if not in range, otherwise returns true.
-* Notes			: None.
-***************************************************************************************************/					
-uint8_t _IsMessageIDValid_ROS
+* End of _PushMsgSettle_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _SettleWaitedMsg_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Runs SettleMessageStore_ROS straight after a message is published, if a task is
+*				  waiting for it (for its target's inbox, or for its ID), so the task is queued now
+*				  rather than by the next settle. Otherwise the message is left queued.
+* Notes			: The fence orders the message's push before the wait checks. An owner arming a
+*				  wait orders it before its last check of the settle stack (see
+*				  _ReleaseMsgStore_ROS), so either the wait is seen here or the message there.
+***************************************************************************************************/
+void _SettleWaitedMsg_ROS
 		(
-			/* Message ID to validate */
-			uint8_t message_id
+			/* Target task vector of the message */
+			uint8_t target_vector, \
+			/* ID of the message */
+			MsgID_ROS message_id
 		)
 {
-	/* Check if message ID is greater than maximum defined value */
-	if(message_id > MAX_MSG_ID_ROS)
+	/* Order the push before the wait checks */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	/* Check if the target task waits for its inbox, or any task waits for an ID in the
+	   message's wait list */
+	if(((target_vector != MSG_TARG_GLOBAL_ROS) && \
+		__atomic_load_n(&gMsgInboxWaitArray_ROS[target_vector], __ATOMIC_RELAXED)) || \
+	   (__atomic_load_n(&gMsgWaitHeadArray_ROS[message_id & (NUM_MSG_WAIT_BUCKETS_ROS - 1u)], \
+						__ATOMIC_RELAXED) != NULL_TARG_ROS))
 	{
-		/* Message ID too high, return failure */
-		return F_MSG_ID_TOO_HIGH_ROS;
+		/* Deliver the message now */
+		(void)SettleMessageStore_ROS();
 	}
-	/* Check if message ID is lower than minimum defined value */
-	else if(message_id < MIN_MSG_ID_ROS)
+}
+/***************************************************************************************************
+* End of _SettleWaitedMsg_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _OwnMsgStore_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Takes ownership of the store on entry to a function that walks the inboxes, wait
+*				  lists, holes, topics or expiry heap, and settles it, so the function sees every
+*				  message created or deleted before it. Returns 0 to initialise the function's
+*				  owner guard.
+* Notes			: Used through OWN_MSG_STORE_ROS. In SMP mode the kernel lock is taken first, so
+*				  owners on different cores are serialised by it; only a settle from an interrupt
+*				  handler can own the store meanwhile, and it does not wait for anything.
+***************************************************************************************************/
+uint8_t _OwnMsgStore_ROS
+		(
+			void
+		)
+{
+#if (ENABLE_SMP_ROS)
+	/* Take the kernel lock */
+	_LockKernel_ROS();
+#endif
+
+	/* Take the store, waiting for a settle on another context to finish */
+	while(__atomic_exchange_n(&gMsgStoreOwned_ROS, true, __ATOMIC_ACQUIRE))
 	{
-		/* Message ID too low, return failure */
-		return F_MSG_ID_TOO_LOW_ROS;
 	}
-	/* No fail conditions met, message ID is within range */
-	else
+
+	/* Settle the store */
+	_SettleMsgStore_ROS();
+	return 0u;
+}
+/***************************************************************************************************
+* End of _OwnMsgStore_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _DisownMsgStore_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Settles the store and gives up ownership of it when the owning function returns,
+*				  as the cleanup of its owner guard.
+* Notes			: Used through OWN_MSG_STORE_ROS.
+***************************************************************************************************/
+void _DisownMsgStore_ROS
+		(
+			/* Pointer to the owner guard (unused) */
+			uint8_t * store_owner
+		)
+{
+	/* Give the store up */
+	(void)store_owner;
+	_ReleaseMsgStore_ROS();
+
+#if (ENABLE_SMP_ROS)
+	/* Release the kernel lock */
+	(void)_UnlockKernel_ROS(SUCCESS_ROS);
+#endif
+}
+/***************************************************************************************************
+* End of _DisownMsgStore_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _ReleaseMsgStore_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Settles the store and gives up ownership of it. A message queued by another
+*				  context that found the store owned (so left it to the owner) is found after the
+*				  store is given up, and the store is taken back to settle it.
+* Notes			: The store must be owned by the caller.
+***************************************************************************************************/
+void _ReleaseMsgStore_ROS
+		(
+			void
+		)
+{
+	/* Settle and give the store up, until nothing is left queued or another context takes the
+	   store (and the work with it) */
+	do
 	{
-		/* Input validation passed, return true */
-		return TRUE_ROS;
+		_SettleMsgStore_ROS();
+		__atomic_store_n(&gMsgStoreOwned_ROS, false, __ATOMIC_SEQ_CST);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
 	}
+	while((__atomic_load_n(&gMsgSettleHead_ROS, __ATOMIC_RELAXED) != NULL_MSG_ROS) && \
+		  !__atomic_exchange_n(&gMsgStoreOwned_ROS, true, __ATOMIC_ACQUIRE));
 }
 /***************************************************************************************************
-* End of _IsMessageIDValid_ROS
+* End of _ReleaseMsgStore_ROS
 ***************************************************************************************************/
 
 /***************************************************************************************************
-* Name			: _IsMessageIDEmpty_ROS
-* Type			: Internal function, input validation.
-* Description	: Checks if passed message ID contains a valid message. If the message ID is
-*				  invalid, it returns an error code; otherwise it returns true if the ID is empty or
-*				  false if its occupied.
-* Notes			: This function uses _IsMessageIDValid_ROS to check if passed message ID is valid.
+* Name			: _SettleMsgStore_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Settles every message index queued, oldest first, until none is left (settling a
+*				  topic message can queue its deletion). Deleted messages whose space could not be
+*				  released before are retried first.
+* Notes			: The store must be owned by the caller. Backend failures are recorded in
+*				  gMsgSettleResult_ROS.
 ***************************************************************************************************/
-uint8_t _IsMessageIDEmpty_ROS
+void _SettleMsgStore_ROS
 		(
-			/* Message ID to check */
-			uint8_t message_id
+			void
 		)
 {
-	/* Check if passed message ID is valid, and store result in temporary container variable */
-	uint8_t message_id_valid = _IsMessageIDValid_ROS(message_id);
-	
-	/* Check ID validation check did not return true */
-	if(message_id_valid != TRUE_ROS)
+	/* Declare list of indexes to settle, its length, and loop variables */
+	uint8_t settle_list[MAX_MSGS_ROS];
+	uint8_t num_settle, i, message_index;
+
+	/* Check if deleted messages are waiting for their space, and retry them. A deleted message
+	   that is not queued is one whose release failed */
+	if(gMsgSettleRetry_ROS)
 	{
-		/* Message ID invalid, return error code from validation check function */
-		return message_id_valid;
+		gMsgSettleRetry_ROS = false;
+		for(i = 1u; i < MAX_MSGS_ROS; i++)
+		{
+			if((_MsgSlotState_ROS(__atomic_load_n(&gMsgSlotArray_ROS[i], __ATOMIC_ACQUIRE)) == \
+				MSG_SLOT_DELETED_ROS) && \
+			   !__atomic_load_n(&gMsgSettlePendingArray_ROS[i], __ATOMIC_ACQUIRE))
+			{
+				_SettleMsgIndex_ROS(i);
+			}
+		}
 	}
-	/* Message ID is valid */
-	else
+
+	/* Settle until nothing is queued */
+	while(__atomic_load_n(&gMsgSettleHead_ROS, __ATOMIC_ACQUIRE) != NULL_MSG_ROS)
 	{
-		/* Look up message ID's index number, and store in temporary container variable */
-		uint8_t message_index = gMsgIndexArray_ROS[message_id];
-		
-		/* Check if the message ID's index number is a null value (defined in messages.h) */
-		if(message_index == NULL_ID_ROS)
+		/* Take the whole stack, and copy it out before any index is cleared for pushing again (a
+		   push reuses the index's link). Each index is on it at most once, so this is bounded */
+		num_settle = 0u;
+		message_index = __atomic_exchange_n(&gMsgSettleHead_ROS, NULL_MSG_ROS, __ATOMIC_ACQUIRE);
+		while(message_index != NULL_MSG_ROS)
 		{
-			/* Message index is null, therefore ID is empty - return true */
-			return TRUE_ROS;
+			settle_list[num_settle] = message_index;
+			num_settle++;
+			message_index = gMsgSettleNextArray_ROS[message_index];
 		}
-		/* Message index is not a null value */
-		else
+
+		/* Settle the indexes in the order they were pushed (the stack holds the newest first) */
+		for(i = num_settle; i != 0u; i--)
 		{
-			/* Message index is not null, there ID is occupied - return false */
-			return FALSE_ROS;
+			_SettleMsgIndex_ROS(settle_list[i - 1u]);
 		}
 	}
 }
 /***************************************************************************************************
-* End of _IsMessageIDEmpty_ROS
+* End of _SettleMsgStore_ROS
 ***************************************************************************************************/
 
 /***************************************************************************************************
-* Name			: _IsMessageSizeValid_ROS
-* Type			: Internal function, input validation.
-* Description	: Checks if passed message size is within the range defined by MAX_MESSAGE_BYTES_ROS
-*				  and MIN_MESSAGE_BYTES_ROS; and returns an error code if outside this range and 
-*				  true if within the range. The max/min values are defined in messages.h.
-* Notes			: 
+* Name			: _SettleMsgIndex_ROS
+* Type			: Internal function, lock-free store.
+* Description	: Settles one message index in whatever state it is in now (see
+*				  SettleMessageStore_ROS). A live, settled topic message is deleted if no subscriber
+*				  or taker still needs it.
+* Notes			: The store must be owned by the caller.
 ***************************************************************************************************/
-uint8_t _IsMessageSizeValid_ROS
+void _SettleMsgIndex_ROS
 		(
-			/* Message size to validate */
-			uint8_t message_size
+			/* Message table index to settle */
+			uint8_t message_index
 		)
 {
-	/* Check if message size is above maximum */
-	if(message_size > MAX_MSG_BYTES_ROS)
+	/* Declare slot word and space released result container variables */
+	uint32_t slot;
+	uint8_t is_space_released;
+
+	/* Clear the pending status before the state is read, so a change made from here on pushes
+	   the index again */
+	__atomic_store_n(&gMsgSettlePendingArray_ROS[message_index], false, __ATOMIC_SEQ_CST);
+	slot = __atomic_load_n(&gMsgSlotArray_ROS[message_index], __ATOMIC_SEQ_CST);
+
+	/* Check if the message is live, and not yet settled */
+	if((_MsgSlotState_ROS(slot) == MSG_SLOT_LIVE_ROS) && !gMsgSettledArray_ROS[message_index])
 	{
-		/* Message size greater than maximum, return failure */
-		return F_MSG_SIZE_TOO_LARGE_ROS;
+#if (ENABLE_MSG_EXPIRY_ROS)
+		/* Check if the message has a time to live, and schedule its expiry at the tick recorded
+		   when it was created */
+		if(gMsgTOC_ROS[message_index][MSG_TTL_ROS] != NULL_TTL_ROS)
+		{
+			_PushMsgExpiry_ROS(message_index, gMsgExpiryTickArray_ROS[message_index]);
+		}
+#endif
+
+		/* Deliver the message to its target's inbox */
+		_LinkMsgInbox_ROS(message_index);
+		gMsgSettledArray_ROS[message_index] = true;
+
+		/* Write the data and the on-media record through to the backend, and check for failure */
+		if((_StoreMessageData_ROS(gMsgTOC_ROS[message_index][MSG_LOC_ROS], \
+								  gMsgTOC_ROS[message_index][MSG_SIZE_ROS]) != SUCCESS_ROS) || \
+		   (_StoreMsgRecord_ROS(message_index) != SUCCESS_ROS))
+		{
+			gMsgSettleResult_ROS = F_MSG_STORAGE_FAILED_ROS;
+		}
 	}
-	/* Check if message size is below minimum */
-	else if(message_size < MIN_MSG_BYTES_ROS)
+#if (ENABLE_MSG_TOPICS_ROS)
+	/* Check if the message is live and settled (a published message released by a taker) */
+	else if(_MsgSlotState_ROS(slot) == MSG_SLOT_LIVE_ROS)
 	{
-		/* Message size lower than minimum, return failure */
-		return F_MSG_SIZE_TOO_LOW_ROS;
+		/* Delete it if this was its last reference */
+		_ReclaimTopicMessage_ROS(message_index);
 	}
-	/* Message size is within range */
-	else
+#endif
+	/* Check if the message is deleted */
+	else if(_MsgSlotState_ROS(slot) == MSG_SLOT_DELETED_ROS)
 	{
-		/* Message size is within range, return true */	
-		return TRUE_ROS;
+		/* Return the message's bytes to the free space, and store the result in a container
+		   variable */
+		is_space_released = _ReleaseMsgSpace_ROS
+							(
+								gMsgTOC_ROS[message_index][MSG_LOC_ROS], \
+								gMsgTOC_ROS[message_index][MSG_SIZE_ROS]
+							);
+
+		/* Check if the deleted message table is full */
+		if(is_space_released == F_MAX_DEL_MSGS_REACHED_ROS)
+		{
+			/* Defragment until a deleted message entry is freed, and retry the release */
+			while((gNumDelMsg_ROS >= MAX_DEL_MSGS_ROS) && (_DefragStep_ROS() == TRUE_ROS))
+			{
+			}
+			is_space_released = _ReleaseMsgSpace_ROS
+								(
+									gMsgTOC_ROS[message_index][MSG_LOC_ROS], \
+									gMsgTOC_ROS[message_index][MSG_SIZE_ROS]
+								);
+		}
+
+		/* Check if the space could not be released */
+		if(is_space_released != SUCCESS_ROS)
+		{
+			/* Leave the message deleted, and retry on the next settle */
+			gMsgSettleRetry_ROS = true;
+			return;
+		}
+
+		/* Check if the message was delivered */
+		if(gMsgSettledArray_ROS[message_index])
+		{
+			/* Remove the message from its target's inbox */
+			_UnlinkMsgInbox_ROS(message_index);
+		}
+#if (ENABLE_MSG_TOPICS_ROS)
+		/* Check if the message was published to a topic, and remove it from the topic list */
+		if(gMsgTopicArray_ROS[message_index] != NULL_TOPIC_ROS)
+		{
+			_UnlinkMsgTopic_ROS(message_index);
+		}
+#endif
+#if (ENABLE_MSG_EXPIRY_ROS)
+		/* Check if the message is waiting to expire, and cancel its expiry */
+		if(gMsgExpiryHeapPosArray_ROS[message_index] != NULL_HEAP_POS_ROS)
+		{
+			_RemoveMsgExpiry_ROS(message_index);
+		}
+#endif
+
+		/* Erase the message's table entry, and invalidate its on-media record */
+		_EraseMsgEntry_ROS(message_index);
+		if(_StoreMsgRecord_ROS(message_index) != SUCCESS_ROS)
+		{
+			gMsgSettleResult_ROS = F_MSG_STORAGE_FAILED_ROS;
+		}
+
+		/* Free the slot for reuse, keeping its version */
+#if (ENABLE_MSG_ID_HASH_ROS)
+		__atomic_store_n(&gMsgIDArray_ROS[message_index], NULL_ID_ROS, __ATOMIC_RELAXED);
+#endif
+		gMsgSettledArray_ROS[message_index] = false;
+		gMsgReservedArray_ROS[message_index] = false;
+		__atomic_store_n(&gMsgSlotArray_ROS[message_index], \
+						 (slot & MSG_SLOT_VERSION_MASK_ROS) | MSG_SLOT_FREE_ROS, __ATOMIC_RELEASE);
 	}
 }
 /***************************************************************************************************
-* End of _IsMessageSizeValid_ROS
+* End of _SettleMsgIndex_ROS
+***************************************************************************************************/
+#endif
+
+#if (ENABLE_SMP_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+/***************************************************************************************************
+* Name			: _LockMsgAPI_ROS
+* Type			: Internal function, message system
+* Description	: Takes the kernel lock on entry to a message API function, and returns 0 to
+*				  initialise the function's lock guard.
+* Notes			: Used through LOCK_MSG_API_ROS.
+***************************************************************************************************/
+uint8_t _LockMsgAPI_ROS
+		(
+			void
+		)
+{
+	/* Take the lock */
+	_LockKernel_ROS();
+	return 0u;
+}
+/***************************************************************************************************
+* End of _LockMsgAPI_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _UnlockMsgAPI_ROS
+* Type			: Internal function, message system
+* Description	: Releases the kernel lock when a message API function returns, as the cleanup of
+*				  its lock guard.
+* Notes			: Used through LOCK_MSG_API_ROS.
+***************************************************************************************************/
+void _UnlockMsgAPI_ROS
+		(
+			/* Pointer to the lock guard (unused) */
+			uint8_t * lock_guard
+		)
+{
+	/* Release the lock */
+	(void)lock_guard;
+	(void)_UnlockKernel_ROS(SUCCESS_ROS);
+}
+/***************************************************************************************************
+* End of _UnlockMsgAPI_ROS
 ***************************************************************************************************/
+#endif
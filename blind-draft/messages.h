@@ -6,29 +6,182 @@
 
 /* System Parameters */
 
+/* The switches and sizes wrapped in #ifndef below can be overridden from the build (-D), as the
+   Makefile does for the test and benchmark configurations */
+
+#ifndef MAX_MSGS_ROS
 #define MAX_MSGS_ROS						32u
+#endif
+
+/* Message store field width in bits (8, 16 or 32). Sets the type of message sizes, store locations
+   and message table fields, so 8 bit parts keep single byte tables. With 8 bit fields the store is
+   limited to 256 bytes and messages to 255 bytes; widen to raise MAX_MSG_STOR_BYTES_ROS and
+   MAX_MSG_BYTES_ROS beyond that */
+#ifndef MSG_STORE_WIDTH_ROS
+#define MSG_STORE_WIDTH_ROS					8
+#endif
 
+#ifndef MAX_MSG_STOR_BYTES_ROS
 #define MAX_MSG_STOR_BYTES_ROS				256u
+#endif
 #define MIN_MSG_BYTES_ROS					1u
 
+#ifndef MAX_MSG_BYTES_ROS
 #define MAX_MSG_BYTES_ROS					32u
+#endif
 
 #define MAX_DEL_MSGS_ROS					8u
+
+/* Chained messages, set to 1 to let a message that fits no single free space be split over up to
+   MAX_MSG_SEGMENTS_ROS free spaces. It is read back as one message, or borrowed as a scatter /
+   gather list. Deleting a chain needs a free deleted message entry per segment, so it is limited
+   to MAX_DEL_MSGS_ROS segments */
+#ifndef ENABLE_MSG_CHAINS_ROS
+#define ENABLE_MSG_CHAINS_ROS				1
+#endif
+#define MAX_MSG_SEGMENTS_ROS				4u
+
+#if (MAX_MSG_SEGMENTS_ROS > MAX_DEL_MSGS_ROS)
+#error "MAX_MSG_SEGMENTS_ROS larger than MAX_DEL_MSGS_ROS"
+#endif
+
 #define	MIN_MSG_ID_ROS						0x02
+
+/* Message ID index mode, set to 1 for an open addressing hash index sized to MAX_MSGS_ROS (allowing
+   wide IDs), or 0 for a dense lookup array with an entry for every ID */
+#ifndef ENABLE_MSG_ID_HASH_ROS
+#define ENABLE_MSG_ID_HASH_ROS				0
+#endif
+
+/* Message ID width in bits when the hash index is enabled (16 or 32) */
+#ifndef MSG_ID_WIDTH_ROS
+#define MSG_ID_WIDTH_ROS					16
+#endif
+
+#if (ENABLE_MSG_ID_HASH_ROS) && (MSG_ID_WIDTH_ROS == 32)
+typedef uint32_t MsgID_ROS;
+#define MAX_MSG_ID_ROS						0xFFFFFFF0ul
+#elif (ENABLE_MSG_ID_HASH_ROS)
+typedef uint16_t MsgID_ROS;
+#define MAX_MSG_ID_ROS						0xFFF0u
+#else
+typedef uint8_t MsgID_ROS;
 #define MAX_MSG_ID_ROS						0xF0
+#endif
+
+/* Hash index slots (a power of two, at least twice MAX_MSGS_ROS), and the longest probe sequence
+   allowed before an insert fails */
+#ifndef MSG_ID_HASH_BITS_ROS
+#define MSG_ID_HASH_BITS_ROS				6u
+#endif
+#define MSG_ID_HASH_SLOTS_ROS				(1u << MSG_ID_HASH_BITS_ROS)
+#define MAX_MSG_ID_PROBES_ROS				8u
+
+#if (MSG_STORE_WIDTH_ROS == 32)
+typedef uint32_t MsgLoc_ROS;
+#define MAX_MSG_LOC_ROS						0xFFFFFFFFul
+#elif (MSG_STORE_WIDTH_ROS == 16)
+typedef uint16_t MsgLoc_ROS;
+#define MAX_MSG_LOC_ROS						0xFFFFu
+#else
+typedef uint8_t MsgLoc_ROS;
+#define MAX_MSG_LOC_ROS						0xFFu
+#endif
+/* Message sizes, and the fields of the message tables, have the same width as store locations */
+typedef MsgLoc_ROS MsgSize_ROS;
+typedef MsgLoc_ROS MsgField_ROS;
 
-#define MAX_MSG_ATTR_ROS					5u
-#define MAX_DEL_MSG_ATTR_ROS 				6u
+#if ((MAX_MSG_STOR_BYTES_ROS - 1u) > MAX_MSG_LOC_ROS) || (MAX_MSG_BYTES_ROS > MAX_MSG_LOC_ROS)
+#error "MAX_MSG_STOR_BYTES_ROS or MAX_MSG_BYTES_ROS too large for MSG_STORE_WIDTH_ROS"
+#endif
+
+#if (ENABLE_MSG_CHAINS_ROS)
+#define MAX_MSG_ATTR_ROS					8u
+#else
+#define MAX_MSG_ATTR_ROS					7u
+#endif
+#define MAX_MSG_PINS_ROS					0xFF
+#define MAX_DEL_MSG_ATTR_ROS 				7u
+
+/* One hole size class per bit of a message size */
+#define NUM_MSG_SIZE_CLASSES_ROS			MSG_STORE_WIDTH_ROS
+
+/* Number of task inboxes, one per target vector below it (messages addressed to, and topic
+   subscriptions of, higher vectors fail with F_MSG_TARGET_INVALID_ROS). Each inbox takes about 8
+   bytes of static memory (its links, and its task's wait state), so set it to the highest task
+   vector that sends or receives messages plus one, at most 256 */
+#ifndef NUM_MSG_INBOXES_ROS
+#define NUM_MSG_INBOXES_ROS					64u
+#endif
+
+#if (NUM_MSG_INBOXES_ROS > 256u)
+#error "NUM_MSG_INBOXES_ROS larger than the 8 bit target vector range"
+#endif
+
+/* Check if a target vector has an inbox (every 8 bit vector has one at 256 inboxes) */
+#if (NUM_MSG_INBOXES_ROS == 256u)
+#define IS_MSG_INBOX_ROS(target_vector)		(1)
+#else
+#define IS_MSG_INBOX_ROS(target_vector)		((uint32_t)(target_vector) < NUM_MSG_INBOXES_ROS)
+#endif
+
+/* Message ID wait lists (a power of two). A new message finds its ID's waiters by passing one
+   waiter per other waited for ID sharing the list, however many tasks wait for each */
+#define NUM_MSG_WAIT_BUCKETS_ROS			16u
+
+/* Publish / subscribe topics, set to 1 to enable. Topics are numbered from 1, and each has up to
+   MAX_TOPIC_SUBSCRIBERS_ROS subscriber task vectors (at most 8, one bit each in a message's unread
+   mask) */
+#ifndef ENABLE_MSG_TOPICS_ROS
+#define ENABLE_MSG_TOPICS_ROS				1
+#endif
+#define NUM_MSG_TOPICS_ROS					8u
+#define MAX_TOPIC_SUBSCRIBERS_ROS			8u
+
+/* Message expiry, set to 1 to delete messages automatically when their time to live (in calls to
+   TickMessageExpiry_ROS) runs out, or 0 to store the time to live without acting on it */
+#ifndef ENABLE_MSG_EXPIRY_ROS
+#define ENABLE_MSG_EXPIRY_ROS				1
+#endif
+
+/* Lock-free store, set to 1 to let CreateMessage_ROS, CreateMessages_ROS, ReadMessage_ROS,
+   ReadMessages_ROS, DeleteMessage_ROS, DeleteMessages_ROS, ReserveMessage_ROS, CommitMessage_ROS,
+   BorrowMessage_ROS and ReleaseMessage_ROS be called at once from tasks and several cores without
+   a lock. Message table slots are claimed with compare and swap and carry a version that changes
+   each time they are reused, IDs are claimed with compare and swap (with the hashed index, by
+   scanning the table for the ID instead), and new messages take space from the top of the store
+   with a compare and swap bump.
+   - Holes are never reused: a message deleted below the top leaves its space unusable until
+     OptimizeMessageStorage_ROS compacts it, so a store with deleted messages under live ones
+     fails creates with F_INSUFF_FREE_MEM_ROS long before it is full. Call
+     OptimizeMessageStorage_ROS from the idle task.
+   - Messages are never chained (ENABLE_MSG_CHAINS_ROS only affects stores mounted from media,
+     whose chained records are dropped).
+   - Inbox delivery, expiry scheduling, backend writes and the release of deleted space are left
+     to SettleMessageStore_ROS. The other message functions (inbox, wait, topic, expiry,
+     defragmentation and flush) own the store while they run, settling first and last, and one
+     owner runs at a time; in SMP mode they take the kernel lock themselves.
+   - A create that a task is waiting for (by inbox or ID) settles straight away, queueing the
+     waiter, so an interrupt handler may only create messages where it may queue tasks (in
+     preemptive mode, between _EnterKernelFromISR_ROS and _ExitKernelFromISR_ROS); otherwise post
+     an ISR task to create them */
+#ifndef ENABLE_LOCK_FREE_MSGS_ROS
+#define ENABLE_LOCK_FREE_MSGS_ROS			0
+#endif
+
+/* Bytes between the words tested by a sampled mount test */
+#define MSG_MOUNT_SAMPLE_STRIDE_ROS			64u
 
 
 /* Imported */
-#define MAX_TASKS_ROS						32u
 #define SUCCESS_ROS							0x01
 
 #define TRUE_ROS							0x02
 
 #define FALSE_ROS							0x03
 
+#define NULL_TASK_ROS						0u
+
 
 /* Misc */
 
@@ -38,19 +191,83 @@
 #define NULL_SIZE_ROS						0u
 #define NULL_TTL_ROS						0u
 #define NULL_TARG_ROS						0u
+#define NULL_HOLE_ROS						0xFF
+#define NULL_HEAP_POS_ROS					0u
+#define NULL_TOPIC_ROS						0u
+#define DEL_MSG_IN_USE_ROS					0x01
+
+/* Message table slot word (lock-free store): state in bits 0-7, pin count in bits 8-15, and
+   version in bits 16-31. A held slot is worked on by one maintenance function (moved, received or
+   batch deleted), and cannot be pinned or deleted meanwhile */
+#define MSG_SLOT_FREE_ROS					0x00u
+#define MSG_SLOT_CLAIMED_ROS				0x01u
+#define MSG_SLOT_LIVE_ROS					0x02u
+#define MSG_SLOT_DELETED_ROS				0x03u
+#define MSG_SLOT_HELD_ROS					0x04u
+#define MSG_SLOT_STATE_MASK_ROS				0x000000FFul
+#define MSG_SLOT_PIN_ROS					0x00000100ul
+#define MSG_SLOT_PIN_SHIFT_ROS				8u
+#define MSG_SLOT_VERSION_ROS				0x00010000ul
+#define MSG_SLOT_VERSION_MASK_ROS			0xFFFF0000ul
+
+/* Message wait states (WaitForMessage_ROS). An armed wait is listed for the message, and holds the
+   priority it lent its server. A woken wait has been given both up, and ends when it is resumed */
+#define MSG_WAIT_IDLE_ROS					0x00u
+#define MSG_WAIT_ARMED_ROS					0x01u
+#define MSG_WAIT_WOKEN_ROS					0x02u
 
 #define MSG_ID_ROS							0u
 #define MSG_SIZE_ROS						1u
 #define MSG_LOC_ROS							2u
 #define MSG_TARG_ROS						3u
 #define MSG_TTL_ROS							4u
-#define MSG_OLDINDEX_ROS					5u
+#define MSG_INBOX_NEXT_ROS					5u
+#define MSG_INBOX_PREV_ROS					6u
+/* Published messages are global, so never in an inbox. Their inbox links thread the topic list */
+#define MSG_TOPIC_NEXT_ROS					MSG_INBOX_NEXT_ROS
+#define MSG_TOPIC_PREV_ROS					MSG_INBOX_PREV_ROS
+/* Next segment of a chained message (NULL_MSG_ROS = last segment) */
+#define MSG_CHAIN_ROS						7u
+#define DEL_MSG_NEXT_ROS					5u
+#define DEL_MSG_PREV_ROS					6u
+
+/* On-media header, stored in the mounted block just above the message data. It starts with a magic
+   word (the last byte is the field width, so a store is never restored with the wrong layout),
+   followed by one record per message table index: message ID (4 bytes), size and location (field
+   width each), target vector, time to live and next segment index, multi byte fields little
+   endian. Records of empty, reserved and published messages are left invalid, so they are not
+   restored. Segments after the first of a chained message have a null ID, and are only restored
+   through the chain of a valid record */
+#define MSG_FS_HEADER_LOC_ROS				MAX_MSG_STOR_BYTES_ROS
+#define MSG_FS_MAGIC_ROS					(0x00534F52ul | ((uint32_t)MSG_STORE_WIDTH_ROS << 24))
+#define MSG_FS_MAGIC_BYTES_ROS				4u
+#define MSG_FS_REC_SIZE_ROS					4u
+#define MSG_FS_REC_LOC_ROS					(MSG_FS_REC_SIZE_ROS + (MSG_STORE_WIDTH_ROS / 8u))
+#define MSG_FS_REC_TARG_ROS					(MSG_FS_REC_LOC_ROS + (MSG_STORE_WIDTH_ROS / 8u))
+#define MSG_FS_REC_TTL_ROS					(MSG_FS_REC_TARG_ROS + 1u)
+#define MSG_FS_REC_CHAIN_ROS				(MSG_FS_REC_TTL_ROS + 1u)
+#define MSG_FS_RECORD_BYTES_ROS				(MSG_FS_REC_CHAIN_ROS + 1u)
+#define MSG_FS_HEADER_BYTES_ROS				(MSG_FS_MAGIC_BYTES_ROS + \
+											 (MAX_MSGS_ROS * MSG_FS_RECORD_BYTES_ROS))
+/* Smallest block MountMessageFileSystem_ROS accepts */
+#define MSG_FS_BLOCK_BYTES_ROS				(MSG_FS_HEADER_LOC_ROS + MSG_FS_HEADER_BYTES_ROS)
 
 
 /* API Control Parameters */
 
 #define MSG_TARG_GLOBAL_ROS					0x00
 
+/* Message ID passed to WaitForMessage_ROS to wait for any message in the task's inbox */
+#define MSG_WAIT_INBOX_ROS					NULL_ID_ROS
+
+/* Mount modes. The test modes check the block with a word wide march test (every word, or one word
+   every MSG_MOUNT_SAMPLE_STRIDE_ROS bytes), the trusted mode skips the test, and all three wipe the
+   store. The persistent mode keeps the store, and rebuilds the message tables from its header */
+#define MSG_MOUNT_FULL_TEST_ROS				0x01
+#define MSG_MOUNT_SAMPLED_TEST_ROS			0x02
+#define MSG_MOUNT_TRUSTED_ROS				0x03
+#define MSG_MOUNT_PERSISTENT_ROS			0x04
+
 
 /* Error Return Codes */
 
@@ -73,15 +290,101 @@
 #define F_MSG_FS_NOT_MOUNTED_ROS			0x37
 #define F_MSG_FS_MOUNT_TEST_FAIL_ROS		0x38
 #define F_READ_GREATER_MSG_SIZE_ROS			0x39
+#define F_MSG_DEFRAG_PENDING_ROS			0x3A
+#define F_MSG_PINNED_ROS					0x3B
+#define F_MSG_NOT_COMMITTED_ROS				0x3C
+#define F_MSG_NOT_RESERVED_ROS				0x3D
+#define F_MSG_NOT_BORROWED_ROS				0x3E
+#define F_MSG_ID_TABLE_FULL_ROS				0x3F
+#define F_MSG_INBOX_EMPTY_ROS				0x40
+#define F_MSG_NO_RUNNING_TASK_ROS			0x41
+#define F_MSG_TOPIC_INVALID_ROS				0x42
+#define F_MSG_NO_SUBSCRIBERS_ROS			0x43
+#define F_MSG_TOPIC_FULL_ROS				0x44
+#define F_MSG_STORAGE_FAILED_ROS			0x53
+#define F_MSG_FS_BLOCK_TOO_SMALL_ROS		0x56
+#define F_MSG_FS_NOT_FORMATTED_ROS			0x57
+#define F_MSG_FS_MODE_INVALID_ROS			0x58
+#define F_MSG_CHAINED_ROS					0x59
+#define F_MSG_BUSY_ROS						0x5F
+#define F_MSG_WAIT_TIMEOUT_ROS				0x61
+#define F_MSG_NOT_WAITING_ROS				0x62
+#define F_MSG_ALREADY_WAITING_ROS			0x63
+#define F_MSG_TARGET_INVALID_ROS			0x65
+
+/* Batch message descriptor, one per message passed to CreateMessages_ROS or ReadMessages_ROS */
+typedef struct
+{
+	/* Message ID */
+	MsgID_ROS message_id;
+	/* Target task vector (create only) */
+	uint8_t target_vector;
+	/* Maximum time to live (create only) */
+	uint8_t time_to_live;
+	/* Message size in bytes (read: number of bytes to read, 0 = whole message) */
+	MsgSize_ROS message_size;
+	/* Pointer to the message data (read: pointer to the destination) */
+	uint8_t * pointer_to_message;
+} MsgDescriptor_ROS;
+
+/* Message storage backend. The mounted block is the working image of the store, which messages are
+   read and borrowed from in place. Every change to the image is written through to the backend, at
+   the same offset from the start of the block, so that a non-volatile backend holds a copy of the
+   store. Each function returns SUCCESS_ROS or an error code */
+typedef struct
+{
+	/* Read bytes from the backend (context, offset, destination, number of bytes) */
+	uint8_t (*read)(void *, uint32_t, uint8_t *, uint32_t);
+	/* Write bytes to the backend (context, offset, source, number of bytes) */
+	uint8_t (*write)(void *, uint32_t, const uint8_t *, uint32_t);
+	/* Erase bytes on the backend to 0xFF (context, offset, number of bytes) */
+	uint8_t (*erase)(void *, uint32_t, uint32_t);
+	/* Commit any buffered writes to the medium (context) */
+	uint8_t (*flush)(void *);
+	/* Backend state, passed to each function */
+	void * context;
+} MsgStorageBackend_ROS;
 
-uint8_t CreateMessage_ROS (uint8_t, uint8_t, uint8_t, uint8_t, uint8_t *);
-uint8_t DeleteMessage_ROS (uint8_t);
-uint8_t MountMessageFileSystem_ROS(uint8_t *, uint32_t, uint32_t, uint32_t, uint32_t *);
-uint8_t ReadMessage_ROS(uint8_t, uint8_t, uint8_t *);
+/* Scatter / gather list element, one per segment of a message borrowed with
+   BorrowMessageSegments_ROS */
+typedef struct
+{
+	/* Pointer to the segment's data */
+	uint8_t * pointer_to_data;
+	/* Segment size in bytes */
+	MsgSize_ROS segment_size;
+} MsgSegment_ROS;
 
+uint8_t CreateMessage_ROS (MsgID_ROS, uint8_t, uint8_t, MsgSize_ROS, uint8_t *);
+uint8_t CreateMessages_ROS(MsgDescriptor_ROS *, uint8_t, uint8_t *);
+uint8_t DeleteMessages_ROS(MsgID_ROS *, uint8_t, uint8_t *);
+uint8_t ReadMessages_ROS(MsgDescriptor_ROS *, uint8_t, uint8_t *);
+uint8_t DeleteMessage_ROS (MsgID_ROS);
+uint8_t MountMessageFileSystem_ROS(uint8_t *, uint32_t, uint32_t, uint32_t, uint32_t *, MsgStorageBackend_ROS *,
+								   uint8_t);
+uint8_t FlushMessageStorage_ROS(void);
+uint8_t ReadMessage_ROS(MsgID_ROS, MsgSize_ROS, uint8_t *);
+uint8_t OptimizeMessageStorage_ROS(uint8_t);
+uint8_t ReserveMessage_ROS(MsgID_ROS, uint8_t, uint8_t, MsgSize_ROS, uint8_t **);
+uint8_t CommitMessage_ROS(MsgID_ROS);
+uint8_t BorrowMessage_ROS(MsgID_ROS, uint8_t **, MsgSize_ROS *);
+uint8_t BorrowMessageSegments_ROS(MsgID_ROS, MsgSegment_ROS *, uint8_t, uint8_t *);
+uint8_t ReleaseMessage_ROS(MsgID_ROS);
+uint8_t TickMessageExpiry_ROS(void);
+uint8_t AdvanceMessageExpiry_ROS(uint32_t);
+uint32_t NextMessageExpiry_ROS(void);
+uint8_t PeekMessage_ROS(MsgID_ROS *, MsgSize_ROS *);
+uint8_t ReceiveMessage_ROS(MsgSize_ROS, uint8_t *, MsgID_ROS *, MsgSize_ROS *);
+uint8_t WaitForInbox_ROS(void);
+uint8_t WaitForMessage_ROS(MsgID_ROS, uint8_t, uint32_t);
+uint8_t ResumeMessageWait_ROS(void);
+uint8_t SubscribeTopic_ROS(uint8_t, uint8_t);
+uint8_t UnsubscribeTopic_ROS(uint8_t, uint8_t);
+uint8_t PublishMessage_ROS(uint8_t, MsgID_ROS, uint8_t, MsgSize_ROS, uint8_t *);
+uint8_t TakeTopicMessage_ROS(uint8_t, MsgID_ROS *, uint8_t **, MsgSize_ROS *);
+uint8_t SettleMessageStore_ROS(void);
 
-extern uint8_t gMsgTable_ROS[MAX_MSGS_ROS][MAX_MSG_ATTR_ROS];
-extern uint8_t gDelMsgTable_ROS[MAX_DEL_MSGS_ROS][MAX_DEL_MSG_ATTR_ROS];
-extern uint8_t gMessageIDLookupArray_ROS[MAX_MSG_ID_ROS];
-extern uint8_t gNumDelBytes_ROS;
+extern MsgField_ROS gMsgTable_ROS[MAX_MSGS_ROS][MAX_MSG_ATTR_ROS];
+extern MsgField_ROS gDelMsgTable_ROS[MAX_DEL_MSGS_ROS][MAX_DEL_MSG_ATTR_ROS];
+extern MsgLoc_ROS gNumDelBytes_ROS;
 #endif
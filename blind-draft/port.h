@@ -0,0 +1,46 @@
+#include <stdint.h>
+
+#ifndef PORT_H
+#define PORT_H
+
+
+/* Architecture port layer, needed by the preemptive kernel, SMP and tickless idle modes. Each port
+   provides the functions below for its processor (port_posix.c provides them for the host) */
+
+/* Task context handle, owned by the port (a saved stack pointer, or a pointer to a saved context
+   record) */
+typedef void * TaskContext_ROS;
+
+/* Point the handle at the context of the caller (the kernel), so it can be switched away from */
+void _InitKernelContext_ROS(TaskContext_ROS *);
+
+/* Build a fresh context in the stack area (stack, size in bytes) that starts running the entry
+   function when switched to. The entry function must never return */
+void _InitTaskContext_ROS(TaskContext_ROS *, uint8_t *, uint32_t, void (*)(void));
+
+/* Save the running context into the first handle, and resume the context of the second. Returns
+   when the saved context is next switched to */
+void _SwitchTaskContext_ROS(TaskContext_ROS *, TaskContext_ROS *);
+
+/* Spin lock shared between cores (0 = free) */
+typedef volatile uint8_t SpinLock_ROS;
+
+/* Return the ID of the calling core, from 0 */
+uint8_t _CurrentCore_ROS(void);
+
+/* Take a spin lock, waiting while another core holds it */
+void _AcquireSpinLock_ROS(SpinLock_ROS *);
+
+/* Take a spin lock if it is free. Returns TRUE_ROS if taken, or FALSE_ROS without waiting */
+uint8_t _TryAcquireSpinLock_ROS(SpinLock_ROS *);
+
+/* Release a held spin lock */
+void _ReleaseSpinLock_ROS(SpinLock_ROS *);
+
+/* Stop the periodic tick, and sleep until the number of ticks passed has gone by, or an interrupt
+   wakes the processor first. With interrupts masked, and before sleeping, the port must call
+   _ConfirmIdle_ROS (tasks.h), and return 0 at once if it is not true or a tick is pending. Returns
+   the number of whole ticks that went by, with the periodic tick restarted in phase with the old
+   one, so the part tick left over is not lost */
+uint32_t _SuppressTicksAndSleep_ROS(uint32_t);
+#endif
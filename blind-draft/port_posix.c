@@ -0,0 +1,992 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: port_posix.c
+* Description   	: Host (POSIX) port. Provides a simulated tick source,
+*					  cycle / nanosecond timers, a file backed simulated
+*					  flash device, a ucontext based task context switch and
+*					  pthread based simulated cores, so the kernel can be run
+*					  and measured on a development machine.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+#include "storage.h"
+#include "tasks.h"
+#include "port_posix.h"
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+#include <ucontext.h>
+#endif
+#if (ENABLE_SMP_ROS)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/* System Parameters */
+
+/* Port selection, set to 1 to build the host port, or 0 when building for
+   target hardware */
+#define ENABLE_POSIX_PORT_ROS		1
+
+#if (ENABLE_POSIX_PORT_ROS)
+
+/* Import scheduler tick function */
+extern void TickScheduler_ROS(void);
+
+/* Free running count of simulated tick interrupts raised, written only by the
+   timer signal handler */
+volatile sig_atomic_t gRaisedTicks_ROS = 0;
+
+/* Free running count of ticks passed to the scheduler, written only by
+   ServiceSimulatedTick_ROS (never by two callers at once, as the preemptive
+   tick handler only calls it while a task is interrupted) */
+sig_atomic_t gServicedTicks_ROS = 0;
+
+/* Simulated tick timer running status */
+bool gSimulatedTickRunning_ROS = false;
+
+/* Monotonic clock reading when the last simulated tick was raised, in
+   nanoseconds */
+volatile uint64_t gTickRaisedNs_ROS = 0u;
+
+/* Simulated tick period, in microseconds */
+uint32_t gTickPeriodUs_ROS = 0u;
+
+#if (ENABLE_TICKLESS_IDLE_ROS)
+/* Tickless sleep status. While set, the timer signal only wakes the sleep,
+   and the ticks that went by are counted from the monotonic clock */
+volatile sig_atomic_t gTicklessSleep_ROS = 0;
+#endif
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+/* Import kernel entry and exit for interrupt handlers */
+extern uint8_t _EnterKernelFromISR_ROS(void);
+extern void _ExitKernelFromISR_ROS(void);
+
+/* Saved context of the kernel */
+ucontext_t gKernelContextRecord_ROS;
+#endif
+
+#if (ENABLE_SMP_ROS)
+/* Simulated core ID of the calling thread */
+__thread uint8_t gThisCoreID_ROS = 0u;
+
+/* Thread of each simulated core, and the number started */
+pthread_t gCoreThreadArray_ROS[NUM_CORES_ROS];
+uint8_t gNumSimulatedCores_ROS = 0u;
+
+/* Loop run by each simulated core */
+void (*gCoreLoop_ROS)(void);
+#endif
+
+/* Local function prototypes */
+uint64_t ReadNanoseconds_ROS(void);
+void _SimulatedTickHandler_ROS(int);
+uint8_t _FileReadPage_ROS(void *, uint16_t, uint8_t *);
+uint8_t _FileProgramPage_ROS(void *, uint16_t, const uint8_t *);
+uint8_t _FileErasePage_ROS(void *, uint16_t);
+uint32_t ServiceSimulatedTick_ROS(void);
+#if (ENABLE_SMP_ROS)
+void JoinSimulatedCores_ROS(void);
+void * _SimulatedCoreThread_ROS(void *);
+#endif
+
+/*******************************************************************************
+* Name			: StartSimulatedTick_ROS
+* Description	: Starts a wall clock timer that raises a simulated tick
+*				  interrupt every tick_period_us microseconds. Ticks are
+*				  counted by the signal handler, and passed to the scheduler
+*				  by ServiceSimulatedTick_ROS.
+* Notes			: Uses SIGALRM, which must not be used elsewhere by the host
+*				  program.
+*******************************************************************************/
+uint8_t StartSimulatedTick_ROS
+		(
+			/* Tick period, in microseconds */
+			uint32_t tick_period_us
+		)
+{
+	/* Declare signal action and timer configuration variables */
+	struct sigaction action;
+	struct itimerval timer;
+
+	/* Check if tick period is zero */
+	if(tick_period_us == 0u)
+	{
+		/* Period invalid, return failure */
+		return F_TICK_PERIOD_INVALID_ROS;
+	}
+
+	/* Install the tick handler, restarting interrupted system calls */
+	action.sa_handler = _SimulatedTickHandler_ROS;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART;
+
+	/* Load the period into both the first expiry and the reload value */
+	timer.it_value.tv_sec = tick_period_us / 1000000u;
+	timer.it_value.tv_usec = tick_period_us % 1000000u;
+	timer.it_interval = timer.it_value;
+
+	/* Check if the handler or timer could not be installed */
+	if((sigaction(SIGALRM, &action, 0) != 0) || \
+	   (setitimer(ITIMER_REAL, &timer, 0) != 0))
+	{
+		/* Host refused the timer, return failure */
+		return F_TICK_TIMER_FAILED_ROS;
+	}
+
+	/* Timer running, record its period and return success */
+	gTickPeriodUs_ROS = tick_period_us;
+	gTickRaisedNs_ROS = ReadNanoseconds_ROS();
+	gSimulatedTickRunning_ROS = true;
+	return SUCCESS_ROS;
+}
+/*******************************************************************************
+* End of StartSimulatedTick_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: StopSimulatedTick_ROS
+* Description	: Stops the simulated tick timer. Ticks already raised remain
+*				  pending until serviced.
+* Notes			: None
+*******************************************************************************/
+uint8_t StopSimulatedTick_ROS
+		(
+			void
+		)
+{
+	/* Declare zeroed timer configuration */
+	struct itimerval timer = {{0, 0}, {0, 0}};
+
+	/* Check if the timer is not running */
+	if(!gSimulatedTickRunning_ROS)
+	{
+		/* Nothing to stop, return failure */
+		return F_TICK_NOT_RUNNING_ROS;
+	}
+
+	/* Disarm the timer */
+	setitimer(ITIMER_REAL, &timer, 0);
+	gSimulatedTickRunning_ROS = false;
+
+	/* Timer stopped, return success */
+	return SUCCESS_ROS;
+}
+/*******************************************************************************
+* End of StopSimulatedTick_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: ServiceSimulatedTick_ROS
+* Description	: Passes every pending simulated tick to the scheduler. Returns
+*				  the number of ticks serviced.
+* Notes			: Call from the host main loop, between dispatches. The
+*				  scheduler is never entered from the signal handler, so the
+*				  kernel tables need no signal masking. In SMP mode, call from
+*				  one core only.
+*******************************************************************************/
+uint32_t ServiceSimulatedTick_ROS
+		(
+			void
+		)
+{
+	/* Declare serviced tick counter */
+	uint32_t serviced = 0u;
+
+	/* Catch up with the raised count, which is re-read each pass so a tick
+	   raised during the loop is not lost. Each counter has a single writer,
+	   so no signal masking is needed */
+	while(gServicedTicks_ROS != gRaisedTicks_ROS)
+	{
+		gServicedTicks_ROS++;
+		TickScheduler_ROS();
+		serviced++;
+	}
+
+	/* Return number of ticks serviced */
+	return serviced;
+}
+/*******************************************************************************
+* End of ServiceSimulatedTick_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: AdvanceSimulatedTick_ROS
+* Description	: Passes the specified number of ticks straight to the
+*				  scheduler, independent of wall clock time.
+* Notes			: For deterministic runs, use instead of the tick timer.
+*******************************************************************************/
+void AdvanceSimulatedTick_ROS
+		(
+			/* Number of ticks to advance */
+			uint32_t ticks
+		)
+{
+	/* Tick the scheduler the requested number of times */
+	while(ticks-- > 0u)
+	{
+		TickScheduler_ROS();
+	}
+}
+/*******************************************************************************
+* End of AdvanceSimulatedTick_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: ReadCycleCounter_ROS
+* Description	: Returns the host CPU cycle (time stamp) counter.
+* Notes			: On hosts without a readable cycle counter, returns the
+*				  monotonic clock in nanoseconds instead.
+*******************************************************************************/
+uint64_t ReadCycleCounter_ROS
+		(
+			void
+		)
+{
+#if defined(__i386__) || defined(__x86_64__)
+	/* Read the time stamp counter */
+	return __rdtsc();
+#elif defined(__aarch64__)
+	/* Read the virtual counter */
+	uint64_t cycles;
+	__asm__ volatile("mrs %0, cntvct_el0" : "=r"(cycles));
+	return cycles;
+#else
+	/* No cycle counter, fall back to nanoseconds */
+	return ReadNanoseconds_ROS();
+#endif
+}
+/*******************************************************************************
+* End of ReadCycleCounter_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: ReadNanoseconds_ROS
+* Description	: Returns the host monotonic clock, in nanoseconds.
+* Notes			: None
+*******************************************************************************/
+uint64_t ReadNanoseconds_ROS
+		(
+			void
+		)
+{
+	/* Declare clock reading variable */
+	struct timespec now;
+
+	/* Read the monotonic clock */
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	/* Return reading in nanoseconds */
+	return ((uint64_t)now.tv_sec * 1000000000u) + (uint64_t)now.tv_nsec;
+}
+/*******************************************************************************
+* End of ReadNanoseconds_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: MeasureOperation_ROS
+* Description	: Runs an operation the specified number of times, and outputs
+*				  the mean cost per call in cycles and nanoseconds.
+* Notes			: The operation must restore any kernel state it changes, or
+*				  successive calls will measure different paths.
+*******************************************************************************/
+void MeasureOperation_ROS
+		(
+			/* Pointer to the operation to measure */
+			void (*operation)(void), \
+			/* Number of calls to time */
+			uint32_t count, \
+			/* Pointer to variable that will store mean cycles per call */
+			uint64_t * cycles_per_call, \
+			/* Pointer to variable that will store mean nanoseconds per call */
+			uint64_t * ns_per_call
+		)
+{
+	/* Declare loop counter and start readings */
+	uint32_t i;
+	uint64_t start_ns, start_cycles;
+
+	/* Check if there is nothing to measure */
+	if(count == 0u)
+	{
+		*cycles_per_call = 0u;
+		*ns_per_call = 0u;
+		return;
+	}
+
+	/* Take start readings */
+	start_ns = ReadNanoseconds_ROS();
+	start_cycles = ReadCycleCounter_ROS();
+
+	/* Run the operation */
+	for(i = 0u; i < count; i++)
+	{
+		operation();
+	}
+
+	/* Output the mean cost per call */
+	*cycles_per_call = (ReadCycleCounter_ROS() - start_cycles) / count;
+	*ns_per_call = (ReadNanoseconds_ROS() - start_ns) / count;
+}
+/*******************************************************************************
+* End of MeasureOperation_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: ReadTickLatency_ROS
+* Description	: Returns the time since the last simulated tick was raised, in
+*				  nanoseconds. Called first thing by a task released by the
+*				  tick, it measures the tick to task response time (including
+*				  any preemption).
+* Notes			: None
+*******************************************************************************/
+uint64_t ReadTickLatency_ROS
+		(
+			void
+		)
+{
+	/* Return time elapsed since the tick */
+	return ReadNanoseconds_ROS() - gTickRaisedNs_ROS;
+}
+/*******************************************************************************
+* End of ReadTickLatency_ROS
+*******************************************************************************/
+
+#if (ENABLE_TICKLESS_IDLE_ROS)
+/*******************************************************************************
+* Name			: _SuppressTicksAndSleep_ROS
+* Description	: Tickless idle sleep (port.h). Replaces the periodic simulated
+*				  tick with a one-shot timer due expected_ticks after the last
+*				  tick, and waits for it or any other signal. Returns the whole
+*				  ticks that went by, counted as raised and serviced, and
+*				  restarts the periodic tick in phase with the last tick.
+* Notes			: Returns 0 without sleeping if the simulated tick is not
+*				  running, a tick is pending, or the kernel is no longer idle.
+*******************************************************************************/
+uint32_t _SuppressTicksAndSleep_ROS
+		(
+			/* Number of ticks to sleep for */
+			uint32_t expected_ticks
+		)
+{
+	/* Declare signal masks, timer configuration and time variables */
+	sigset_t tick_mask, old_mask;
+	struct itimerval timer;
+	uint64_t period_ns = (uint64_t)gTickPeriodUs_ROS * 1000u;
+	uint64_t since_tick, wake_ns;
+	uint32_t elapsed;
+
+	/* Check if there is no tick to suppress */
+	if(!gSimulatedTickRunning_ROS || (expected_ticks == 0u))
+	{
+		return 0u;
+	}
+
+	/* Mask the tick signal, so no tick is raised while the timer is changed */
+	sigemptyset(&tick_mask);
+	sigaddset(&tick_mask, SIGALRM);
+	sigprocmask(SIG_BLOCK, &tick_mask, &old_mask);
+
+	/* Check if a tick is pending, or a task became ready since the kernel
+	   checked */
+	if((gServicedTicks_ROS != gRaisedTicks_ROS) || \
+	   (_ConfirmIdle_ROS() != TRUE_ROS))
+	{
+		/* Leave the tick running, and return without sleeping */
+		sigprocmask(SIG_SETMASK, &old_mask, 0);
+		return 0u;
+	}
+
+	/* Arm a one-shot timer for the expected tick, measured from the last
+	   tick raised */
+	since_tick = ReadNanoseconds_ROS() - gTickRaisedNs_ROS;
+	wake_ns = ((uint64_t)expected_ticks * period_ns > since_tick) ? \
+			  ((uint64_t)expected_ticks * period_ns) - since_tick : 1000u;
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = 0;
+	timer.it_value.tv_sec = (time_t)(wake_ns / 1000000000u);
+	timer.it_value.tv_usec = (suseconds_t)(((wake_ns % 1000000000u) + 999u) / 1000u);
+	gTicklessSleep_ROS = 1;
+	setitimer(ITIMER_REAL, &timer, 0);
+
+	/* Wait for the timer, or any other signal, with the tick signal let in */
+	sigsuspend(&old_mask);
+	gTicklessSleep_ROS = 0;
+
+	/* Count the whole ticks that went by, and move the last tick forward */
+	since_tick = ReadNanoseconds_ROS() - gTickRaisedNs_ROS;
+	elapsed = (uint32_t)(since_tick / period_ns);
+	gTickRaisedNs_ROS += (uint64_t)elapsed * period_ns;
+	gRaisedTicks_ROS += elapsed;
+	gServicedTicks_ROS += elapsed;
+
+	/* Restart the periodic tick at the next whole tick, keeping the part
+	   tick already gone by */
+	wake_ns = period_ns - (since_tick - ((uint64_t)elapsed * period_ns));
+	timer.it_interval.tv_sec = gTickPeriodUs_ROS / 1000000u;
+	timer.it_interval.tv_usec = gTickPeriodUs_ROS % 1000000u;
+	timer.it_value.tv_sec = (time_t)(wake_ns / 1000000000u);
+	timer.it_value.tv_usec = (suseconds_t)(((wake_ns % 1000000000u) + 999u) / 1000u);
+	setitimer(ITIMER_REAL, &timer, 0);
+	sigprocmask(SIG_SETMASK, &old_mask, 0);
+
+	/* Return the ticks slept, for the kernel to catch up with */
+	return elapsed;
+}
+/*******************************************************************************
+* End of _SuppressTicksAndSleep_ROS
+*******************************************************************************/
+#endif
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+/*******************************************************************************
+* Name			: _InitKernelContext_ROS
+* Description	: Points the kernel context handle at the kernel's context
+*				  record.
+* Notes			: None
+*******************************************************************************/
+void _InitKernelContext_ROS
+		(
+			/* Pointer to the kernel context handle */
+			TaskContext_ROS * context
+		)
+{
+	/* The record is filled in by the first switch away from the kernel */
+	*context = &gKernelContextRecord_ROS;
+}
+/*******************************************************************************
+* End of _InitKernelContext_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _InitTaskContext_ROS
+* Description	: Builds a fresh task context in the specified stack area. The
+*				  context record is placed at the base of the area, and the
+*				  rest is used as the task's stack.
+* Notes			: The area must hold the record (about 1 KB) plus the deepest
+*				  task call chain and a signal frame, as the tick handler runs
+*				  on the interrupted task's stack.
+*******************************************************************************/
+void _InitTaskContext_ROS
+		(
+			/* Pointer to the task's context handle */
+			TaskContext_ROS * context, \
+			/* Pointer to the task's stack area */
+			uint8_t * stack, \
+			/* Size of the stack area, in bytes */
+			uint32_t stack_bytes, \
+			/* Function the context starts in */
+			void (*entry)(void)
+		)
+{
+	/* Align the context record at the base of the stack area */
+	uintptr_t base = ((uintptr_t)stack + 15u) & ~(uintptr_t)15u;
+	ucontext_t * record = (ucontext_t *)base;
+	uint32_t record_bytes = (uint32_t)(((sizeof(ucontext_t) + 15u) & \
+							~(size_t)15u) + (base - (uintptr_t)stack));
+
+	/* Start from the caller's context (signal mask included), then move
+	   it onto the stack above the record */
+	getcontext(record);
+	record->uc_stack.ss_sp = stack + record_bytes;
+	record->uc_stack.ss_size = stack_bytes - record_bytes;
+	record->uc_link = 0;
+	makecontext(record, entry, 0);
+
+	/* Output handle */
+	*context = record;
+}
+/*******************************************************************************
+* End of _InitTaskContext_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _SwitchTaskContext_ROS
+* Description	: Saves the running context into the first record, and resumes
+*				  the second.
+* Notes			: Also used from the tick signal handler to preempt a task.
+*				  swapcontext is not async signal safe by the letter of POSIX,
+*				  but is safe here, as the handler only switches while the
+*				  interrupted task is outside the kernel.
+*******************************************************************************/
+void _SwitchTaskContext_ROS
+		(
+			/* Pointer to the handle of the context to save */
+			TaskContext_ROS * save_context, \
+			/* Pointer to the handle of the context to resume */
+			TaskContext_ROS * load_context
+		)
+{
+	/* Swap contexts */
+	swapcontext((ucontext_t *)*save_context, (ucontext_t *)*load_context);
+}
+/*******************************************************************************
+* End of _SwitchTaskContext_ROS
+*******************************************************************************/
+#endif
+
+#if (ENABLE_SMP_ROS)
+/*******************************************************************************
+* Name			: StartSimulatedCores_ROS
+* Description	: Starts the specified number of host threads, one per simulated
+*				  core, each running the specified core loop (typically a
+*				  DispatchTask_ROS loop) with its own core ID.
+* Notes			: Only one core should call ServiceSimulatedTick_ROS. Cores are
+*				  threads, so they run truly in parallel on a multi-core host,
+*				  and the scheduler's scaling can be measured.
+*******************************************************************************/
+uint8_t StartSimulatedCores_ROS
+		(
+			/* Number of cores to start */
+			uint8_t num_cores, \
+			/* Loop run by each core */
+			void (*core_loop)(void)
+		)
+{
+	/* Check if core count is out of range */
+	if((num_cores == 0u) || (num_cores > NUM_CORES_ROS))
+	{
+		/* Core count invalid, return failure */
+		return F_CORE_COUNT_INVALID_ROS;
+	}
+	/* Input validation successful, start the cores */
+	else
+	{
+		/* Declare core walk variable */
+		uint8_t core;
+
+		/* Record the loop, and start one thread per core */
+		gCoreLoop_ROS = core_loop;
+		for(core = 0u; core < num_cores; core++)
+		{
+			/* Check if the thread failed to start */
+			if(pthread_create(&gCoreThreadArray_ROS[core], 0, \
+							  _SimulatedCoreThread_ROS, \
+							  (void *)(uintptr_t)core) != 0)
+			{
+				/* Wait for the cores already started, and return failure */
+				gNumSimulatedCores_ROS = core;
+				JoinSimulatedCores_ROS();
+				return F_CORE_START_FAILED_ROS;
+			}
+		}
+		gNumSimulatedCores_ROS = num_cores;
+
+		/* Cores started, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of StartSimulatedCores_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: JoinSimulatedCores_ROS
+* Description	: Waits for every simulated core started by
+*				  StartSimulatedCores_ROS to return from its core loop.
+* Notes			: None
+*******************************************************************************/
+void JoinSimulatedCores_ROS
+		(
+			void
+		)
+{
+	/* Wait for each core thread in turn */
+	while(gNumSimulatedCores_ROS > 0u)
+	{
+		gNumSimulatedCores_ROS--;
+		pthread_join(gCoreThreadArray_ROS[gNumSimulatedCores_ROS], 0);
+	}
+}
+/*******************************************************************************
+* End of JoinSimulatedCores_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _CurrentCore_ROS
+* Description	: Returns the ID of the calling simulated core.
+* Notes			: Threads not started as cores (such as main) are core 0.
+*******************************************************************************/
+uint8_t _CurrentCore_ROS
+		(
+			void
+		)
+{
+	/* Read the thread's core ID */
+	return gThisCoreID_ROS;
+}
+/*******************************************************************************
+* End of _CurrentCore_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _AcquireSpinLock_ROS
+* Description	: Takes a spin lock, waiting while another core holds it.
+* Notes			: Waits on a plain read, so the lock's cache line is not
+*				  written while held. Yields the host processor while waiting,
+*				  as a core thread holding the lock may be descheduled.
+*******************************************************************************/
+void _AcquireSpinLock_ROS
+		(
+			/* Pointer to the lock */
+			SpinLock_ROS * lock
+		)
+{
+	/* Try to take the lock until it is free */
+	while(__atomic_exchange_n(lock, 1u, __ATOMIC_ACQUIRE) != 0u)
+	{
+		/* Wait for the holder to release it */
+		while(__atomic_load_n(lock, __ATOMIC_RELAXED) != 0u)
+		{
+			sched_yield();
+		}
+	}
+}
+/*******************************************************************************
+* End of _AcquireSpinLock_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _TryAcquireSpinLock_ROS
+* Description	: Takes a spin lock if it is free. Returns TRUE_ROS if taken,
+*				  or FALSE_ROS straight away if another core holds it.
+* Notes			: None
+*******************************************************************************/
+uint8_t _TryAcquireSpinLock_ROS
+		(
+			/* Pointer to the lock */
+			SpinLock_ROS * lock
+		)
+{
+	/* Check if the lock is free, and take it */
+	if((__atomic_load_n(lock, __ATOMIC_RELAXED) == 0u) && \
+	   (__atomic_exchange_n(lock, 1u, __ATOMIC_ACQUIRE) == 0u))
+	{
+		/* Lock taken, return true */
+		return TRUE_ROS;
+	}
+	/* Lock held elsewhere */
+	else
+	{
+		/* Lock not taken, return false */
+		return FALSE_ROS;
+	}
+}
+/*******************************************************************************
+* End of _TryAcquireSpinLock_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _ReleaseSpinLock_ROS
+* Description	: Releases a held spin lock.
+* Notes			: None
+*******************************************************************************/
+void _ReleaseSpinLock_ROS
+		(
+			/* Pointer to the lock */
+			SpinLock_ROS * lock
+		)
+{
+	/* Free the lock, publishing the writes made while it was held */
+	__atomic_store_n(lock, 0u, __ATOMIC_RELEASE);
+}
+/*******************************************************************************
+* End of _ReleaseSpinLock_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _SimulatedCoreThread_ROS
+* Description	: Entry point of each simulated core's thread. Sets the thread's
+*				  core ID, then runs the core loop.
+* Notes			: None
+*******************************************************************************/
+void * _SimulatedCoreThread_ROS
+		(
+			/* Core ID, passed as a pointer */
+			void * core
+		)
+{
+	/* Set core ID, and run the core loop */
+	gThisCoreID_ROS = (uint8_t)(uintptr_t)core;
+	gCoreLoop_ROS();
+
+	/* Core loop returned, end the thread */
+	return 0;
+}
+/*******************************************************************************
+* End of _SimulatedCoreThread_ROS
+*******************************************************************************/
+#endif
+
+/*******************************************************************************
+* Name			: OpenFileFlashDevice_ROS
+* Description	: Opens (or creates) a file as a simulated flash device of
+*				  num_pages pages, and sets up its driver for use with
+*				  InitFlashBackend_ROS. Pages missing from the end of the file
+*				  are added in the erased state, so an existing file keeps its
+*				  contents across runs, like flash across a power cycle.
+* Notes			: None
+*******************************************************************************/
+uint8_t OpenFileFlashDevice_ROS
+		(
+			/* Path of the backing file */
+			const char * path, \
+			/* Page size in bytes */
+			uint32_t page_bytes, \
+			/* Number of pages */
+			uint16_t num_pages, \
+			/* Pointer to the device to set up */
+			FileFlashDevice_ROS * file_device
+		)
+{
+	/* Declare file status, erased page and page counter */
+	struct stat status;
+	uint8_t erased[MAX_FLASH_PAGE_BYTES_ROS];
+	uint16_t page;
+
+	/* Check if the page size exceeds the erased page buffer */
+	if((page_bytes == 0u) || (page_bytes > MAX_FLASH_PAGE_BYTES_ROS))
+	{
+		/* Page size invalid, return failure */
+		return F_FLASH_GEOMETRY_INVALID_ROS;
+	}
+
+	/* Check if the file could not be opened */
+	file_device->file = open(path, O_RDWR | O_CREAT, 0644);
+	if((file_device->file < 0) || (fstat(file_device->file, &status) != 0))
+	{
+		/* Host refused the file, return failure */
+		return F_FLASH_DEVICE_FAILED_ROS;
+	}
+
+	/* Add erased pages from the first one the file does not fully hold */
+	memset(erased, 0xFF, page_bytes);
+	for(page = (uint16_t)(status.st_size / page_bytes); page < num_pages; page++)
+	{
+		if(pwrite(file_device->file, erased, page_bytes, (off_t)page * page_bytes) != \
+		   (ssize_t)page_bytes)
+		{
+			close(file_device->file);
+			return F_FLASH_DEVICE_FAILED_ROS;
+		}
+	}
+
+	/* Set up the driver */
+	file_device->driver.read_page = _FileReadPage_ROS;
+	file_device->driver.program_page = _FileProgramPage_ROS;
+	file_device->driver.erase_page = _FileErasePage_ROS;
+	file_device->driver.device = file_device;
+	file_device->driver.page_bytes = page_bytes;
+	file_device->driver.num_pages = num_pages;
+
+	/* Device open, return success */
+	return SUCCESS_ROS;
+}
+/*******************************************************************************
+* End of OpenFileFlashDevice_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: CloseFileFlashDevice_ROS
+* Description	: Closes a simulated flash device's backing file.
+* Notes			: Flush the message store first, or buffered writes are lost
+*				  (as they would be at power down).
+*******************************************************************************/
+uint8_t CloseFileFlashDevice_ROS
+		(
+			/* Pointer to the device to close */
+			FileFlashDevice_ROS * file_device
+		)
+{
+	/* Check if the file could not be closed */
+	if(close(file_device->file) != 0)
+	{
+		return F_FLASH_DEVICE_FAILED_ROS;
+	}
+
+	/* Device closed, return success */
+	return SUCCESS_ROS;
+}
+/*******************************************************************************
+* End of CloseFileFlashDevice_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _FileReadPage_ROS
+* Description	: Simulated flash driver read function. Reads a whole page.
+* Notes			: None
+*******************************************************************************/
+uint8_t _FileReadPage_ROS
+		(
+			/* Pointer to the device */
+			void * device, \
+			/* Page to read */
+			uint16_t page, \
+			/* Pointer to the destination */
+			uint8_t * buffer
+		)
+{
+	/* Declare device */
+	FileFlashDevice_ROS * file_device = (FileFlashDevice_ROS *)device;
+	uint32_t page_bytes = file_device->driver.page_bytes;
+
+	/* Check if the page could not be read in full */
+	if(pread(file_device->file, buffer, page_bytes, (off_t)page * page_bytes) != \
+	   (ssize_t)page_bytes)
+	{
+		return F_FLASH_DEVICE_FAILED_ROS;
+	}
+
+	/* Page read, return success */
+	return SUCCESS_ROS;
+}
+/*******************************************************************************
+* End of _FileReadPage_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _FileProgramPage_ROS
+* Description	: Simulated flash driver program function. Programming can only
+*				  clear bits, so the source is ANDed into the page, and a page
+*				  programmed without erasing reads back corrupted, as on real
+*				  flash.
+* Notes			: None
+*******************************************************************************/
+uint8_t _FileProgramPage_ROS
+		(
+			/* Pointer to the device */
+			void * device, \
+			/* Page to program */
+			uint16_t page, \
+			/* Pointer to the source */
+			const uint8_t * buffer
+		)
+{
+	/* Declare device, current page contents and loop counter */
+	FileFlashDevice_ROS * file_device = (FileFlashDevice_ROS *)device;
+	uint32_t page_bytes = file_device->driver.page_bytes;
+	uint8_t cells[MAX_FLASH_PAGE_BYTES_ROS];
+	uint32_t i;
+
+	/* Check if the page could not be read */
+	if(_FileReadPage_ROS(device, page, cells) != SUCCESS_ROS)
+	{
+		return F_FLASH_DEVICE_FAILED_ROS;
+	}
+
+	/* Clear the programmed bits */
+	for(i = 0u; i < page_bytes; i++)
+	{
+		cells[i] &= buffer[i];
+	}
+
+	/* Check if the page could not be written back in full */
+	if(pwrite(file_device->file, cells, page_bytes, (off_t)page * page_bytes) != \
+	   (ssize_t)page_bytes)
+	{
+		return F_FLASH_DEVICE_FAILED_ROS;
+	}
+
+	/* Page programmed, return success */
+	return SUCCESS_ROS;
+}
+/*******************************************************************************
+* End of _FileProgramPage_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _FileErasePage_ROS
+* Description	: Simulated flash driver erase function. Sets a whole page to
+*				  0xFF.
+* Notes			: None
+*******************************************************************************/
+uint8_t _FileErasePage_ROS
+		(
+			/* Pointer to the device */
+			void * device, \
+			/* Page to erase */
+			uint16_t page
+		)
+{
+	/* Declare device and erased page */
+	FileFlashDevice_ROS * file_device = (FileFlashDevice_ROS *)device;
+	uint32_t page_bytes = file_device->driver.page_bytes;
+	uint8_t erased[MAX_FLASH_PAGE_BYTES_ROS];
+
+	/* Check if the page could not be written in full */
+	memset(erased, 0xFF, page_bytes);
+	if(pwrite(file_device->file, erased, page_bytes, (off_t)page * page_bytes) != \
+	   (ssize_t)page_bytes)
+	{
+		return F_FLASH_DEVICE_FAILED_ROS;
+	}
+
+	/* Page erased, return success */
+	return SUCCESS_ROS;
+}
+/*******************************************************************************
+* End of _FileErasePage_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _SimulatedTickHandler_ROS
+* Description	: Simulated tick interrupt handler. Counts one pending tick. In
+*				  preemptive mode, if a task was interrupted outside the kernel,
+*				  the tick is serviced at once and the task preempted if a
+*				  higher priority task was released.
+* Notes			: Runs in signal context. Outside preemptive mode, or while
+*				  the kernel is running, it only touches gRaisedTicks_ROS.
+*				  During a tickless sleep it does nothing but wake the sleep.
+*******************************************************************************/
+void _SimulatedTickHandler_ROS
+		(
+			/* Signal number (unused) */
+			int signal_number
+		)
+{
+	(void)signal_number;
+
+#if (ENABLE_TICKLESS_IDLE_ROS)
+	/* Check if the signal ends a tickless sleep, which counts its own ticks */
+	if(gTicklessSleep_ROS)
+	{
+		return;
+	}
+#endif
+
+	/* Time stamp and count the tick */
+	gTickRaisedNs_ROS = ReadNanoseconds_ROS();
+	gRaisedTicks_ROS++;
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+	/* Check if the interrupted task is outside the kernel */
+	if(_EnterKernelFromISR_ROS() == TRUE_ROS)
+	{
+		/* Service the tick now, and preempt the task if needed */
+		ServiceSimulatedTick_ROS();
+		_ExitKernelFromISR_ROS();
+	}
+#endif
+}
+/*******************************************************************************
+* End of _SimulatedTickHandler_ROS
+*******************************************************************************/
+
+#endif
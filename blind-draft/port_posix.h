@@ -0,0 +1,29 @@
+#include <stdint.h>
+#include "port.h"
+
+#ifndef PORT_POSIX_H
+#define PORT_POSIX_H
+
+
+/* Host (POSIX) port functions beyond the port layer, used by host programs such as the tests and
+   benchmarks (port_posix.c) */
+
+/* Error Return Codes */
+
+#define F_TICK_PERIOD_INVALID_ROS			0x50
+#define F_TICK_TIMER_FAILED_ROS				0x51
+#define F_TICK_NOT_RUNNING_ROS				0x52
+#define F_CORE_COUNT_INVALID_ROS			0x5D
+#define F_CORE_START_FAILED_ROS				0x5E
+
+uint8_t StartSimulatedTick_ROS(uint32_t);
+uint8_t StopSimulatedTick_ROS(void);
+uint32_t ServiceSimulatedTick_ROS(void);
+void AdvanceSimulatedTick_ROS(uint32_t);
+uint64_t ReadCycleCounter_ROS(void);
+uint64_t ReadNanoseconds_ROS(void);
+void MeasureOperation_ROS(void (*)(void), uint32_t, uint64_t *, uint64_t *);
+uint64_t ReadTickLatency_ROS(void);
+uint8_t StartSimulatedCores_ROS(uint8_t, void (*)(void));
+void JoinSimulatedCores_ROS(void);
+#endif
@@ -9,23 +9,3354 @@
 * Project Location	: http://rataos.sourceforge.net/
 *******************************************************************************/
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "tasks.h"
+#include "port.h"
+
 /* System Parameters */
-#define MAX_TASK_QUEUE_ROS			32u
 #define PRIORITY_DEADLINE_SCALER	3u
 
+/* Ready list granularity, 1 (default) for one ready list level per task
+   priority (256 levels, found through a two tier bitmap), or 0 for 32 levels of
+   8 consecutive priorities each (priority >> 3, one bitmap word, and smaller
+   tables). With 32 levels, tasks whose priorities differ only in the low 3 bits
+   share a level, and run first in first out: neither is dispatched, nor
+   preempts, ahead of the other, and an inherited priority within the holder's
+   level has no effect */
+#ifndef ENABLE_FINE_PRIORITY_LEVELS_ROS
+#define ENABLE_FINE_PRIORITY_LEVELS_ROS	1
+#endif
+
+#if (ENABLE_FINE_PRIORITY_LEVELS_ROS)
+#define NUM_PRIORITY_LEVELS_ROS		256u
+#define PRIORITY_LEVEL_SHIFT_ROS	0u
+#else
+#define NUM_PRIORITY_LEVELS_ROS		32u
+#define PRIORITY_LEVEL_SHIFT_ROS	3u
+#endif
+
+/* Returned by _HighestReadyLevel_ROS when no level is ready */
+#define NO_READY_LEVEL_ROS			0xFFFFu
+
+/* Timer wheel geometry: two levels of 64 slots, covering 4096 ticks */
+#define TIMER_WHEEL_BITS_ROS		6u
+#define TIMER_WHEEL_SLOTS_ROS		64u
+#define TIMER_WHEEL_MASK_ROS		0x3F
+#define MIN_TASK_PERIOD_ROS			1u
+#define MAX_TASK_PERIOD_ROS			4000u
+
+/* ISR post ring size, must be a power of two no greater than 128 */
+#define ISR_RING_SIZE_ROS			16u
+#define ISR_RING_MASK_ROS			(ISR_RING_SIZE_ROS - 1u)
+
+/* Scheduling mode, set to 1 for earliest deadline first (EDF) selection, or 0
+   for fixed priority selection */
+#ifndef ENABLE_EDF_SCHEDULER_ROS
+#define ENABLE_EDF_SCHEDULER_ROS	0
+#endif
+
+#if (ENABLE_EDF_SCHEDULER_ROS) && (ENABLE_PREEMPTIVE_KERNEL_ROS)
+#error "Preemptive kernel mode needs fixed priority selection"
+#endif
+
+/* Sets a task's EDF deadline to its timeout from now, when it is queued for a
+   new run. Relinking a queued task (on a priority change) keeps its deadline */
+#if (ENABLE_EDF_SCHEDULER_ROS)
+#define SET_TASK_DEADLINE_ROS(task_id) \
+		(gTaskDeadlineArray_ROS[(task_id)] = gSystemTick_ROS + \
+											 TASK_TIMEOUT_ROS(task_id))
+#else
+#define SET_TASK_DEADLINE_ROS(task_id)
+#endif
+
+#if (ENABLE_SMP_ROS) && (ENABLE_PREEMPTIVE_KERNEL_ROS)
+#error "SMP mode runs tasks to completion, disable the preemptive kernel mode"
+#endif
+
+#if (ENABLE_SMP_ROS) && (ENABLE_TICKLESS_IDLE_ROS)
+#error "Tickless idle mode stops the tick of a single core, disable the SMP mode"
+#endif
+
 /* API Control Parameters */
 
 
+/* Imported */
+#define NULL_TASK_ROS				0u
+#define SUCCESS_ROS					0x01
+#define TRUE_ROS					0x02
+#define FALSE_ROS					0x03
+#define F_TASK_VECTOR_EMPTY_ROS		0x06
+
+#if (ENABLE_TICKLESS_IDLE_ROS)
+/* Message expiry clock functions (messages.c) */
+uint32_t NextMessageExpiry_ROS(void);
+uint8_t AdvanceMessageExpiry_ROS(uint32_t);
+#endif
+
 /* Error Return Codes */
- 
+#define F_TASK_ALREADY_QUEUED_ROS	0x45
+#define F_TASK_NOT_QUEUED_ROS		0x46
+#define F_TASK_QUEUE_EMPTY_ROS		0x47
+#define F_TASK_PERIOD_TOO_LOW_ROS	0x48
+#define F_TASK_PERIOD_TOO_HIGH_ROS	0x49
+#define F_TASK_NOT_PERIODIC_ROS		0x4A
+#define F_TASK_ALREADY_PERIODIC_ROS	0x4B
+#define F_TASK_NOT_ISR_ROS			0x4C
+#define F_TASK_ALREADY_ISR_ROS		0x4D
+#define F_ISR_RING_FULL_ROS			0x4E
+#define F_TASK_ALREADY_COROUTINE_ROS	0x5A
+#define F_TASK_NOT_RUNNING_ROS		0x5B
+#define F_TASK_AFFINITY_INVALID_ROS	0x5C
+#define F_TASK_NOT_INHERITED_ROS	0x60
+
+/* Misc */
+#if (ENABLE_SMP_ROS)
+/* Lock and release of a spin lock, compiled out on one core */
+#define ACQUIRE_LOCK_ROS(lock)		_AcquireSpinLock_ROS(&(lock))
+#define RELEASE_LOCK_ROS(lock)		_ReleaseSpinLock_ROS(&(lock))
+
+/* Marks a task as queued, evaluating to its previous queued status. Atomic, so
+   only one of several cores queuing a task at once links it */
+#define CLAIM_TASK_QUEUED_ROS(task_id) \
+		__atomic_exchange_n(&gTaskQueuedArray_ROS[(task_id)], true, \
+							__ATOMIC_ACQ_REL)
+
+/* Clears a task's queued status, once its links are cleared */
+#define CLEAR_TASK_QUEUED_ROS(task_id) \
+		__atomic_store_n(&gTaskQueuedArray_ROS[(task_id)], false, \
+						 __ATOMIC_RELEASE)
+
+/* Loads and stores of the ISR ring indices. The interrupt posting may run on
+   another core, so a store publishes the entries (or free space) before it,
+   and a load sees them */
+#define LOAD_RING_INDEX_ROS(index)	__atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define STORE_RING_INDEX_ROS(index, value) \
+		__atomic_store_n(&(index), (value), __ATOMIC_RELEASE)
+
+/* Mask with a bit set for every core */
+#define ALL_CORES_MASK_ROS			((uint8_t)((1u << NUM_CORES_ROS) - 1u))
+
+/* Checks if the calling core may run a queued task now: the task is not still
+   running on another core, and its affinity mask allows the calling core */
+#define CAN_CORE_RUN_TASK_ROS(task_id) \
+		(!__atomic_load_n(&gTaskRunningArray_ROS[(task_id)], __ATOMIC_ACQUIRE) && \
+		 ((TASK_AFFINITY_ROS(task_id) == 0u) || \
+		  ((TASK_AFFINITY_ROS(task_id) & (1u << CURRENT_CORE_ROS())) != 0u)))
+#else
+#define ACQUIRE_LOCK_ROS(lock)
+#define RELEASE_LOCK_ROS(lock)
+#define CLAIM_TASK_QUEUED_ROS(task_id) \
+		(gTaskQueuedArray_ROS[(task_id)] || \
+		 !(gTaskQueuedArray_ROS[(task_id)] = true))
+#define CLEAR_TASK_QUEUED_ROS(task_id) \
+		(gTaskQueuedArray_ROS[(task_id)] = false)
+#define LOAD_RING_INDEX_ROS(index)	(index)
+#define STORE_RING_INDEX_ROS(index, value) \
+		((index) = (value))
+#endif
+
+/* Bitmap of priority levels holding at least one ready task, per core (bit n =
+   level n, higher level runs first). With fine priority levels, bit n is set
+   while any of levels 8n to 8n + 7 is ready, and gReadyLevelBitmap_ROS holds
+   the ready bits of those levels */
+uint32_t gReadyPriorityBitmap_ROS[NUM_CORES_ROS];
+
+#if (ENABLE_FINE_PRIORITY_LEVELS_ROS)
+/* Ready bits of each group of 8 priority levels, per core (bit n of group g =
+   level 8g + n) */
+uint8_t gReadyLevelBitmap_ROS[NUM_CORES_ROS][NUM_PRIORITY_LEVELS_ROS >> 3];
+
+/* Mark a level of a core as ready, or as empty */
+#define SET_LEVEL_READY_ROS(core, level) \
+		do { gReadyLevelBitmap_ROS[(core)][(level) >> 3] |= (uint8_t)(1u << ((level) & 7u)); \
+			 gReadyPriorityBitmap_ROS[(core)] |= (1ul << ((level) >> 3)); } while(0)
+#define CLEAR_LEVEL_READY_ROS(core, level) \
+		do { if((gReadyLevelBitmap_ROS[(core)][(level) >> 3] &= \
+				 (uint8_t)~(1u << ((level) & 7u))) == 0u) \
+			 { gReadyPriorityBitmap_ROS[(core)] &= ~(1ul << ((level) >> 3)); } } while(0)
+#else
+/* Mark a level of a core as ready, or as empty */
+#define SET_LEVEL_READY_ROS(core, level) \
+		(gReadyPriorityBitmap_ROS[(core)] |= (1ul << (level)))
+#define CLEAR_LEVEL_READY_ROS(core, level) \
+		(gReadyPriorityBitmap_ROS[(core)] &= ~(1ul << (level)))
+#endif
+
+/* First (oldest) task ID queued at each priority level, per core */
+TaskID_ROS gReadyHeadArray_ROS[NUM_CORES_ROS][NUM_PRIORITY_LEVELS_ROS];
+
+/* Last (newest) task ID queued at each priority level, per core */
+TaskID_ROS gReadyTailArray_ROS[NUM_CORES_ROS][NUM_PRIORITY_LEVELS_ROS];
+
+/* The tables indexed by task ID below are carved from the task table memory
+   block by _MountSchedulerTables_ROS, sized for the mounted task capacity */
+
+/* Next task ID in the same priority level, indexed by task ID */
+TaskID_ROS * gReadyNextArray_ROS;
+
+/* Previous task ID in the same priority level, indexed by task ID */
+TaskID_ROS * gReadyPrevArray_ROS;
+
+/* Priority level each queued task was inserted at, indexed by task ID */
+uint8_t * gReadyLevelArray_ROS;
+
+/* Queued status of each task, indexed by task ID */
+bool * gTaskQueuedArray_ROS;
+
+#if (ENABLE_SMP_ROS)
+/* Core whose ready lists hold each task, plus one (0 = not linked), indexed by
+   task ID */
+uint8_t * gTaskQueuedCoreArray_ROS;
+
+/* Running status of each task, on any core, indexed by task ID */
+bool * gTaskRunningArray_ROS;
+
+/* Lock of each core's ready lists */
+SpinLock_ROS gReadyLockArray_ROS[NUM_CORES_ROS];
+
+/* Lock of the timer wheel and the periodic / sleep tables */
+SpinLock_ROS gTimerLock_ROS = 0u;
+
+/* Lock held by the core draining the ISR ring */
+SpinLock_ROS gISRDrainLock_ROS = 0u;
+
+/* Kernel lock taken by KERNEL_CALL_ROS, its owner core plus one (0 = free) and
+   the owner's nesting depth. Left to the preemptive kernel's own lock in a
+   build that also enables it, so only the #error above is reported */
+#if !(ENABLE_PREEMPTIVE_KERNEL_ROS)
+SpinLock_ROS gKernelLock_ROS = 0u;
+volatile uint8_t gKernelLockOwner_ROS = 0u;
+uint8_t gKernelLockDepth_ROS = 0u;
+#endif
+#endif
+
+/* ID of the task being run by DispatchTask_ROS on each core, or NULL_TASK_ROS
+   outside any task */
+TaskID_ROS gRunningTaskIDArray_ROS[NUM_CORES_ROS];
+
+/* Scheduler tick counter */
+uint32_t gSystemTick_ROS = 0u;
+
+/* Operating system status, OS_STOPPED_ROS until the application starts
+   dispatching tasks */
+uint8_t gOperatingSystemStatus_ROS = OS_STOPPED_ROS;
+
+/* First task ID in each timer wheel slot. Slots 0-63 are level 0 (one tick
+   each), slots 64-127 are level 1 (64 ticks each) */
+TaskID_ROS gTimerWheelHeadArray_ROS[2u * TIMER_WHEEL_SLOTS_ROS];
+
+/* Next / previous task ID in the same wheel slot, indexed by task ID */
+TaskID_ROS * gTimerNextArray_ROS;
+TaskID_ROS * gTimerPrevArray_ROS;
+
+/* Wheel slot each armed task is linked into, indexed by task ID */
+uint8_t * gTimerSlotArray_ROS;
+
+/* Periodic task release period in ticks (0 = not periodic) */
+uint16_t * gTaskPeriodArray_ROS;
+
+/* Tick of each periodic task's next (or pending) release */
+uint32_t * gTaskReleaseTickArray_ROS;
+
+/* Armed (release timer running) status of each periodic task */
+bool * gTaskPeriodArmedArray_ROS;
+
+/* Queued periodic release status of each task, so only the dispatch of a
+   release (not of a plain QueueTask_ROS wake up) is measured as jitter */
+bool * gTaskReleasePendingArray_ROS;
+
+/* Worst release-to-dispatch delay seen for each periodic task, in ticks
+   (saturating at 0xFFFF) */
+uint16_t * gTaskMaxJitterArray_ROS;
+
+/* Number of releases that found the previous release still queued */
+uint16_t * gTaskOverrunArray_ROS;
+
+/* Tick each sleeping task is woken at (its timer may be armed earlier, if the
+   tick is beyond the timer wheel range) */
+uint32_t * gTaskWakeTickArray_ROS;
+
+/* Own (base) priority of each task holding an inherited priority */
+uint8_t * gTaskBasePriorityArray_ROS;
+
+/* Number of inherited priorities each task holds (0 = runs at its own) */
+uint8_t * gTaskInheritCountArray_ROS;
+
+#if (ENABLE_COROUTINE_TASKS_ROS)
+/* Coroutine function of each coroutine task, run by _RunCoroutineTask_ROS */
+TaskCoroutine_ROS * gTaskCoroutineArray_ROS;
+
+/* Saved resume point of each coroutine task (0 = start of the body) */
+uint16_t * gTaskResumeArray_ROS;
+#endif
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+/* Nesting depth of the kernel lock. While it is held the running task is not
+   preempted, and a preemption asked for by an interrupt is left pending */
+volatile uint8_t gKernelLockDepth_ROS = 0u;
+
+/* Preemption asked for while the kernel lock was held */
+volatile bool gPreemptPending_ROS = false;
+
+/* Ready list level the running task was dispatched from */
+uint8_t gRunningLevel_ROS = 0u;
+
+/* Preempted tasks, most recent last, and the level each was running at. A task
+   is only preempted for a higher level, so levels rise towards the top and at
+   most one task per level is held */
+TaskID_ROS gPreemptedTaskArray_ROS[NUM_PRIORITY_LEVELS_ROS];
+uint8_t gPreemptedLevelArray_ROS[NUM_PRIORITY_LEVELS_ROS];
+uint8_t gNumPreemptedTasks_ROS = 0u;
+
+/* Saved context of the kernel (the caller of DispatchTask_ROS) */
+TaskContext_ROS gKernelContext_ROS;
+
+/* Saved context of each task, indexed by task ID */
+TaskContext_ROS * gTaskContextArray_ROS;
+
+/* Stack area of each task, TASK_STACK_BYTES_ROS per task ID */
+uint8_t * gTaskStackArray_ROS;
+#endif
+
+/* ISR to scheduler ring of posted task IDs. Written only by interrupt
+   handlers (producer), read only by the scheduler (consumer) */
+volatile TaskID_ROS gISRRing_ROS[ISR_RING_SIZE_ROS];
+
+/* Free running ring indices, only the producer writes head and only the
+   consumer writes tail */
+volatile uint8_t gISRRingHead_ROS = 0u;
+volatile uint8_t gISRRingTail_ROS = 0u;
+
+/* Number of posts dropped because the ring was full */
+volatile uint16_t gISRRingOverflow_ROS = 0u;
+
+/* ISR task registration status, indexed by task ID */
+bool * gTaskISRArray_ROS;
+
+/* ISR task enable status (posts to disabled tasks are discarded) */
+bool * gTaskISREnabledArray_ROS;
 
-uint8_t gOSTaskQueue_ROS[MAX_TASK_QUEUE_ROS];
+#if (ENABLE_EDF_SCHEDULER_ROS)
+/* Absolute tick each queued task must run by, indexed by task ID */
+uint32_t * gTaskDeadlineArray_ROS;
 
+/* Ready tasks of each core in EDF mode, as a binary min heap with the most
+   urgent task at index 0 (see _IsMoreUrgent_ROS), and the number of tasks in
+   each heap */
+TaskID_ROS * gDeadlineHeapArray_ROS[NUM_CORES_ROS];
+TaskID_ROS gDeadlineHeapSizeArray_ROS[NUM_CORES_ROS];
 
+/* Heap index of each queued task, and the order tasks were queued in (which
+   breaks ties between equally urgent tasks), indexed by task ID */
+TaskID_ROS * gDeadlineHeapIndexArray_ROS;
+uint32_t * gTaskQueueOrderArray_ROS;
+
+/* Count of tasks queued in EDF mode, numbering gTaskQueueOrderArray_ROS */
+uint32_t gTaskQueueCount_ROS = 0u;
+
+/* Number of times each task was dispatched after its deadline */
+uint16_t * gTaskDeadlineMissArray_ROS;
+#endif
+
+/* Local function prototypes */
+uint8_t _IsTaskQueued_ROS(TaskID_ROS);
+uint8_t _HighestSetBit_ROS(uint32_t);
+uint16_t _HighestReadyLevel_ROS(uint8_t, uint16_t);
+void _LinkReadyTask_ROS(TaskID_ROS);
+TaskID_ROS _PopReadyTask_ROS(uint8_t);
+void _ArmTimer_ROS(TaskID_ROS);
+void _DisarmTimer_ROS(TaskID_ROS);
+void _ReleasePeriodicTask_ROS(TaskID_ROS);
+void _DrainISRRing_ROS(void);
+void _UnlinkReadyTask_ROS(TaskID_ROS);
+uint8_t _ArmSleepTimer_ROS(void);
+void _ChangeTaskPriority_ROS(TaskID_ROS, uint8_t);
+void _AdvanceTimerWheel_ROS(void);
+#if (ENABLE_TICKLESS_IDLE_ROS)
+uint32_t _NextTimerEvent_ROS(void);
+uint32_t _EarliestSlotRelease_ROS(uint8_t);
+#endif
+#if (ENABLE_SMP_ROS)
+uint8_t _SelectTaskCore_ROS(TaskID_ROS);
+TaskID_ROS _StealReadyTask_ROS(uint8_t);
+uint8_t _UnqueueLinkedTask_ROS(TaskID_ROS);
+#endif
+#if (ENABLE_COROUTINE_TASKS_ROS)
+void _RunCoroutineTask_ROS(void);
+#endif
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+uint8_t _EnterKernelFromISR_ROS(void);
+void _ExitKernelFromISR_ROS(void);
+void _RunTaskContext_ROS(TaskID_ROS);
+void _SwitchToKernel_ROS(void);
+void _RunPreemptiveTask_ROS(void);
+uint8_t _DropPreemptedTask_ROS(TaskID_ROS);
+#endif
+#if (ENABLE_EDF_SCHEDULER_ROS)
+bool _IsMoreUrgent_ROS(TaskID_ROS, TaskID_ROS);
+void _InsertDeadlineTask_ROS(uint8_t, TaskID_ROS);
+void _RemoveDeadlineTask_ROS(uint8_t, TaskID_ROS);
+void _SiftDeadlineTask_ROS(uint8_t, uint32_t);
+#endif
+
+/*******************************************************************************
+* Name			: QueueTask_ROS
+* Description	: Adds the task at the specified vector to the back of its
+*				  priority level's ready list. Returns success, or an error code
+*				  if the vector is empty/invalid or the task is already queued.
+* Notes			: Task ID 0 is never allocated (NULL_TASK_ROS), so it is used
+*				  to terminate the ready lists. Runs in constant time.
+*******************************************************************************/
 uint8_t QueueTask_ROS
 	    (
-	    	uint8_t task_vector, \
-	    	uint8_t 
+	    	/* Vector of task to queue */
+	    	TaskID_ROS task_vector
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* Nothing to queue, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Mark task as queued, and check if it already was */
+	else if(CLAIM_TASK_QUEUED_ROS(gTaskVectorLookupArray_ROS[task_vector]))
+	{
+		/* Task already queued, return failure */
+		return F_TASK_ALREADY_QUEUED_ROS;
+	}
+	/* Input validation successful, append task to its ready list */
+	else
+	{
+		/* Set the task's deadline, and link it into its ready list */
+		SET_TASK_DEADLINE_ROS(gTaskVectorLookupArray_ROS[task_vector]);
+		_LinkReadyTask_ROS(gTaskVectorLookupArray_ROS[task_vector]);
+
+		/* Task queued, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of QueueTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: UnqueueTask_ROS
+* Description	: Removes the task at the specified vector from its ready list,
+*				  wherever it sits in the list. Returns success, or an error
+*				  code if the task is invalid or not queued.
+* Notes			: Runs in constant time.
+*******************************************************************************/
+uint8_t UnqueueTask_ROS
+		(
+			/* Vector of task to remove from the ready lists */
+			TaskID_ROS task_vector
+		)
+{
+	/* Check if task is queued, and store result in container variable */
+	uint8_t is_task_queued = _IsTaskQueued_ROS(task_vector);
+
+	/* Check if task is not queued */
+	if(is_task_queued == FALSE_ROS)
+	{
+		/* Task not in a ready list, return failure */
+		return F_TASK_NOT_QUEUED_ROS;
+	}
+	/* Check if task vector is empty or invalid */
+	else if(is_task_queued != TRUE_ROS)
+	{
+		/* Return error code */
+		return is_task_queued;
+	}
+	/* Input validation successful, unlink task */
+	else
+	{
+		/* Look up task id */
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
+
+		/* Drop any queued periodic release with the entry */
+		gTaskReleasePendingArray_ROS[task_id] = false;
+
+#if (ENABLE_SMP_ROS)
+		/* Remove task from the ready list of whichever core holds it */
+		return _UnqueueLinkedTask_ROS(task_id);
+#else
+		/* Remove task from its ready list */
+		_UnlinkReadyTask_ROS(task_id);
+
+		/* Task removed, return success */
+		return SUCCESS_ROS;
+#endif
+	}
+}
+/*******************************************************************************
+* End of UnqueueTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: DispatchTask_ROS
+* Description	: Removes the oldest task from the highest non-empty priority
+*				  level of the calling core and runs it to completion. Returns
+*				  success, or a failure code if no task is ready.
+* Notes			: Tasks posted from interrupts are drained into the ready lists
+*				  first. Selection is a single count-leading-zeros on the bitmap,
+*				  so dispatch cost does not grow with the number of tasks. In
+*				  EDF mode the ready list is kept sorted, and the head is taken.
+*				  In preemptive mode the task runs on its own stack, and a
+*				  preempted task is resumed unless a higher level is ready (a
+*				  preempted task queued again is resumed, not restarted). In
+*				  SMP mode a core with nothing ready steals from the others. A
+*				  task without a task function is discarded, never called.
+*******************************************************************************/
+uint8_t DispatchTask_ROS
+		(
+			void
+		)
+{
+	/* Look up the calling core, and declare the dispatched task id */
+	uint8_t core = CURRENT_CORE_ROS();
+	TaskID_ROS task_id;
+
+	/* Move tasks posted by interrupt handlers into the ready lists */
+	_DrainISRRing_ROS();
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+	/* Pending preemptions are served by this dispatch */
+	gPreemptPending_ROS = false;
+
+	/* Check if the last preempted task is at least as urgent as every ready
+	   task */
+	if((gNumPreemptedTasks_ROS > 0u) && \
+	   ((gReadyPriorityBitmap_ROS[core] == 0u) || \
+		(gPreemptedLevelArray_ROS[gNumPreemptedTasks_ROS - 1u] >= \
+		 _HighestReadyLevel_ROS(core, NUM_PRIORITY_LEVELS_ROS))))
+	{
+		/* Pop the preempted task, and resume it where it was suspended */
+		gNumPreemptedTasks_ROS--;
+		gRunningLevel_ROS = gPreemptedLevelArray_ROS[gNumPreemptedTasks_ROS];
+		_RunTaskContext_ROS(gPreemptedTaskArray_ROS[gNumPreemptedTasks_ROS]);
+
+		/* Task ran, return success */
+		return SUCCESS_ROS;
+	}
+#endif
+
+	/* Pop the highest priority task, passing over any task left without a
+	   task function */
+	while(true)
+	{
+		/* Pop the highest priority task from the core's ready lists */
+		ACQUIRE_LOCK_ROS(gReadyLockArray_ROS[core]);
+		task_id = _PopReadyTask_ROS(core);
+		RELEASE_LOCK_ROS(gReadyLockArray_ROS[core]);
+
+#if (ENABLE_SMP_ROS)
+		/* Check if the core has nothing ready */
+		if(task_id == NULL_TASK_ROS)
+		{
+			/* Steal a ready task from another core */
+			task_id = _StealReadyTask_ROS(core);
+		}
+#endif
+
+		/* Check if nothing is ready, or the task can be run */
+		if((task_id == NULL_TASK_ROS) || \
+		   (TASK_POINTER_ROS(task_id) != NULL))
+		{
+			break;
+		}
+
+#if (ENABLE_SMP_ROS)
+		/* Discard the task, which may be dispatched again once it has a
+		   task function */
+		__atomic_store_n(&gTaskRunningArray_ROS[task_id], false, \
+						 __ATOMIC_RELEASE);
+#endif
+	}
+
+	/* Check if no task is ready */
+	if(task_id == NULL_TASK_ROS)
+	{
+		/* Nothing ready, return failure */
+		return F_TASK_QUEUE_EMPTY_ROS;
+	}
+	/* A task was popped */
+	else
+	{
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+		/* Record the level the task is dispatched from */
+		gRunningLevel_ROS = gReadyLevelArray_ROS[task_id];
+
+		/* Check if the task was queued again while preempted, so its context
+		   still holds the unfinished run */
+		if(_DropPreemptedTask_ROS(task_id) == TRUE_ROS)
+		{
+			/* Queue the new run behind the unfinished one (a periodic release
+			   stays pending until then), and resume the unfinished run at
+			   the level the task was queued at */
+			(void)CLAIM_TASK_QUEUED_ROS(task_id);
+			_LinkReadyTask_ROS(task_id);
+			_RunTaskContext_ROS(task_id);
+
+			/* Task ran, return success */
+			return SUCCESS_ROS;
+		}
+#endif
+
+#if (ENABLE_EDF_SCHEDULER_ROS)
+		/* Check if the task's deadline has already passed */
+		if((int32_t)(gSystemTick_ROS - gTaskDeadlineArray_ROS[task_id]) > 0)
+		{
+			/* Record deadline miss */
+			gTaskDeadlineMissArray_ROS[task_id]++;
+		}
+#endif
+
+		/* Check if a periodic release is being dispatched */
+		if(gTaskReleasePendingArray_ROS[task_id])
+		{
+			/* Measure delay from the scheduled release to now (the release
+			   tick has already been advanced to the next period) */
+			uint32_t jitter = gSystemTick_ROS - \
+							  (gTaskReleaseTickArray_ROS[task_id] - \
+							   gTaskPeriodArray_ROS[task_id]);
+
+			/* Release served */
+			gTaskReleasePendingArray_ROS[task_id] = false;
+
+			/* Keep the worst case, saturating at the counter's range */
+			if(jitter > UINT16_MAX)
+			{
+				gTaskMaxJitterArray_ROS[task_id] = UINT16_MAX;
+			}
+			else if(jitter > gTaskMaxJitterArray_ROS[task_id])
+			{
+				gTaskMaxJitterArray_ROS[task_id] = (uint16_t)jitter;
+			}
+		}
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+		/* Check if the task has no context yet (first dispatch, or its last
+		   run was abandoned). A completed run leaves the context waiting to
+		   start the task function again, so it is built only once */
+		if(gTaskContextArray_ROS[task_id] == 0)
+		{
+			/* Build the context on the task's own stack */
+			_InitTaskContext_ROS(&gTaskContextArray_ROS[task_id], \
+								 gTaskStackArray_ROS + ((uint32_t)task_id * \
+								 TASK_STACK_BYTES_ROS), TASK_STACK_BYTES_ROS, \
+								 _RunPreemptiveTask_ROS);
+		}
+
+		/* Start the task function in its context */
+		_RunTaskContext_ROS(task_id);
+#else
+		/* Run the task function, recording it as the core's running task */
+		gRunningTaskIDArray_ROS[core] = task_id;
+		TASK_POINTER_ROS(task_id)();
+		gRunningTaskIDArray_ROS[core] = NULL_TASK_ROS;
+#endif
+
+#if (ENABLE_SMP_ROS)
+		/* Task may now be dispatched again, on any core */
+		__atomic_store_n(&gTaskRunningArray_ROS[task_id], false, \
+						 __ATOMIC_RELEASE);
+#endif
+
+		/* Task ran, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of DispatchTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: CreatePeriodicTask_ROS
+* Description	: Makes the task at the specified vector periodic. The task is
+*				  queued every period ticks, starting first_delay ticks from
+*				  now. Returns success, or an error code if the task is invalid,
+*				  already periodic, or either time is out of range.
+* Notes			: Periods are limited to MAX_TASK_PERIOD_ROS by the two level
+*				  timer wheel.
+*******************************************************************************/
+uint8_t CreatePeriodicTask_ROS
+		(
+			/* Vector of task to make periodic */
+			TaskID_ROS task_vector, \
+			/* Release period, in clock ticks */
+			uint16_t period, \
+			/* Delay before the first release, in clock ticks */
+			uint16_t first_delay
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* Task vector is empty, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Check if period or first delay is too short */
+	else if((period < MIN_TASK_PERIOD_ROS) || (first_delay < MIN_TASK_PERIOD_ROS))
+	{
+		/* Time too short, return failure */
+		return F_TASK_PERIOD_TOO_LOW_ROS;
+	}
+	/* Check if period or first delay is beyond the timer wheel range */
+	else if((period > MAX_TASK_PERIOD_ROS) || (first_delay > MAX_TASK_PERIOD_ROS))
+	{
+		/* Time too long, return failure */
+		return F_TASK_PERIOD_TOO_HIGH_ROS;
+	}
+	/* Check if task is already periodic */
+	else if(gTaskPeriodArray_ROS[gTaskVectorLookupArray_ROS[task_vector]] != 0u)
+	{
+		/* Task already periodic, return failure */
+		return F_TASK_ALREADY_PERIODIC_ROS;
+	}
+	/* Input validation successful, arm the release timer */
+	else
+	{
+		/* Look up task id */
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
+
+		/* Lock the timer wheel against the tick */
+		ACQUIRE_LOCK_ROS(gTimerLock_ROS);
+
+		/* Cancel any sleep in progress, the timer is reused for releases */
+		if(gTaskPeriodArmedArray_ROS[task_id])
+		{
+			_DisarmTimer_ROS(task_id);
+		}
+
+		/* Store period and first release tick */
+		gTaskPeriodArray_ROS[task_id] = period;
+		gTaskReleaseTickArray_ROS[task_id] = gSystemTick_ROS + first_delay;
+
+		/* Clear release statistics */
+		gTaskMaxJitterArray_ROS[task_id] = 0u;
+		gTaskOverrunArray_ROS[task_id] = 0u;
+
+		/* Link task into the timer wheel */
+		_ArmTimer_ROS(task_id);
+		RELEASE_LOCK_ROS(gTimerLock_ROS);
+
+		/* Periodic task created, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of CreatePeriodicTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: ControlPeriodicTask_ROS
+* Description	: Pauses or resumes the release timer of a periodic task. A
+*				  resumed task is next released one period from now.
+* Notes			: Pausing does not remove an already queued release.
+*******************************************************************************/
+uint8_t ControlPeriodicTask_ROS
+		(
+			/* Vector of periodic task to control */
+			TaskID_ROS task_vector, \
+			/* Control release timer (true = run) */
+			bool enable_release
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* Task vector is empty, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Check if task is periodic */
+	else if(gTaskPeriodArray_ROS[gTaskVectorLookupArray_ROS[task_vector]] == 0u)
+	{
+		/* Task not periodic, return failure */
+		return F_TASK_NOT_PERIODIC_ROS;
+	}
+	/* Input validation successful, update release timer */
+	else
+	{
+		/* Look up task id */
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
+
+		/* Lock the timer wheel against the tick */
+		ACQUIRE_LOCK_ROS(gTimerLock_ROS);
+
+		/* Check if resume requested on a paused timer */
+		if(enable_release && !gTaskPeriodArmedArray_ROS[task_id])
+		{
+			/* Next release is one period from now */
+			gTaskReleaseTickArray_ROS[task_id] = gSystemTick_ROS + \
+												 gTaskPeriodArray_ROS[task_id];
+			_ArmTimer_ROS(task_id);
+		}
+		/* Check if pause requested on a running timer */
+		else if(!enable_release && gTaskPeriodArmedArray_ROS[task_id])
+		{
+			/* Remove timer from the wheel */
+			_DisarmTimer_ROS(task_id);
+		}
+		RELEASE_LOCK_ROS(gTimerLock_ROS);
+
+		/* Periodic control complete, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of ControlPeriodicTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: DestroyPeriodicTask_ROS
+* Description	: Stops a periodic task's release timer and returns the task to
+*				  normal (manually queued) operation.
+* Notes			: The task entry itself is not destroyed.
+*******************************************************************************/
+uint8_t DestroyPeriodicTask_ROS
+		(
+			/* Vector of periodic task to destroy */
+			TaskID_ROS task_vector
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* Task vector is empty, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Check if task is periodic */
+	else if(gTaskPeriodArray_ROS[gTaskVectorLookupArray_ROS[task_vector]] == 0u)
+	{
+		/* Task not periodic, return failure */
+		return F_TASK_NOT_PERIODIC_ROS;
+	}
+	/* Input validation successful, remove periodic entry */
+	else
+	{
+		/* Look up task id */
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
+
+		/* Remove timer from the wheel if it is running */
+		ACQUIRE_LOCK_ROS(gTimerLock_ROS);
+		if(gTaskPeriodArmedArray_ROS[task_id])
+		{
+			_DisarmTimer_ROS(task_id);
+		}
+
+		/* Clear period, marking the task as not periodic */
+		gTaskPeriodArray_ROS[task_id] = 0u;
+		RELEASE_LOCK_ROS(gTimerLock_ROS);
+
+		/* Periodic task destroyed, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of DestroyPeriodicTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: SleepUntilTick_ROS
+* Description	: Puts the running task to sleep until the scheduler tick
+*				  reaches wake_tick. Returns true if the tick has already been
+*				  reached (nothing is armed). Otherwise returns false, and the
+*				  task is queued at the wake tick. Returns an error code outside
+*				  any task, or for periodic tasks (their timer is in use).
+* Notes			: Tasks run to completion, so the caller must return after a
+*				  false result, and call ResumeSleep_ROS when next dispatched.
+*******************************************************************************/
+uint8_t SleepUntilTick_ROS
+		(
+			/* Tick to wake at */
+			uint32_t wake_tick
+		)
+{
+	/* Check if no task is running */
+	if(RUNNING_TASK_ID_ROS == NULL_TASK_ROS)
+	{
+		/* No task to put to sleep, return failure */
+		return F_TASK_NOT_RUNNING_ROS;
+	}
+	/* Check if the running task is periodic */
+	else if(gTaskPeriodArray_ROS[RUNNING_TASK_ID_ROS] != 0u)
+	{
+		/* Timer in use, return failure */
+		return F_TASK_ALREADY_PERIODIC_ROS;
+	}
+	/* Input validation successful, store the wake tick and arm the timer */
+	else
+	{
+		/* Declare result container variable */
+		uint8_t is_asleep;
+
+		gTaskWakeTickArray_ROS[RUNNING_TASK_ID_ROS] = wake_tick;
+		ACQUIRE_LOCK_ROS(gTimerLock_ROS);
+		is_asleep = _ArmSleepTimer_ROS();
+		RELEASE_LOCK_ROS(gTimerLock_ROS);
+		return is_asleep;
+	}
+}
+/*******************************************************************************
+* End of SleepUntilTick_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: ResumeSleep_ROS
+* Description	: Checks whether the running task's sleep is over, once it is
+*				  dispatched again. Returns true if the wake tick has been
+*				  reached. Otherwise returns false (the task was queued early,
+*				  or the wake tick was beyond the timer wheel), and the timer is
+*				  re-armed. Returns an error code as SleepUntilTick_ROS.
+* Notes			: None.
+*******************************************************************************/
+uint8_t ResumeSleep_ROS
+		(
+			void
+		)
+{
+	/* Check if no task is running */
+	if(RUNNING_TASK_ID_ROS == NULL_TASK_ROS)
+	{
+		/* No task to resume, return failure */
+		return F_TASK_NOT_RUNNING_ROS;
+	}
+	/* Check if the running task is periodic */
+	else if(gTaskPeriodArray_ROS[RUNNING_TASK_ID_ROS] != 0u)
+	{
+		/* Timer in use, return failure */
+		return F_TASK_ALREADY_PERIODIC_ROS;
+	}
+	/* Input validation successful, check the stored wake tick */
+	else
+	{
+		/* Declare result container variable */
+		uint8_t is_asleep;
+
+		ACQUIRE_LOCK_ROS(gTimerLock_ROS);
+		is_asleep = _ArmSleepTimer_ROS();
+		RELEASE_LOCK_ROS(gTimerLock_ROS);
+		return is_asleep;
+	}
+}
+/*******************************************************************************
+* End of ResumeSleep_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: CancelSleep_ROS
+* Description	: Cancels the running task's sleep timer, so a task woken early
+*				  (by a message it waited for) is not queued again when its wake
+*				  tick arrives. Returns success, or an error code as
+*				  SleepUntilTick_ROS.
+* Notes			: Does nothing if no timer is armed.
+*******************************************************************************/
+uint8_t CancelSleep_ROS
+		(
+			void
+		)
+{
+	/* Check if no task is running */
+	if(RUNNING_TASK_ID_ROS == NULL_TASK_ROS)
+	{
+		/* No task to wake, return failure */
+		return F_TASK_NOT_RUNNING_ROS;
+	}
+	/* Check if the running task is periodic */
+	else if(gTaskPeriodArray_ROS[RUNNING_TASK_ID_ROS] != 0u)
+	{
+		/* Timer in use, return failure */
+		return F_TASK_ALREADY_PERIODIC_ROS;
+	}
+	/* Input validation successful, disarm the timer if it is armed */
+	else
+	{
+		ACQUIRE_LOCK_ROS(gTimerLock_ROS);
+		if(gTaskPeriodArmedArray_ROS[RUNNING_TASK_ID_ROS])
+		{
+			_DisarmTimer_ROS(RUNNING_TASK_ID_ROS);
+		}
+		RELEASE_LOCK_ROS(gTimerLock_ROS);
+
+		/* Sleep cancelled, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of CancelSleep_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: InheritTaskPriority_ROS
+* Description	: Lends the task at the specified vector a priority, for as long
+*				  as a higher priority task is blocked waiting on it. The task
+*				  runs at the higher of its current and the lent priority, and
+*				  is moved to that level if it is queued. Every call must be
+*				  matched by a call to RestoreTaskPriority_ROS. Returns success,
+*				  or an error code if the vector is empty or invalid.
+* Notes			: The task keeps the highest priority lent until every lender
+*				  has been matched, then returns to its own priority. Not
+*				  transitive: a lender's own wait is not followed. In
+*				  preemptive mode a preempted task keeps its level until it is
+*				  resumed.
+*******************************************************************************/
+uint8_t InheritTaskPriority_ROS
+		(
+			/* Vector of task to lend a priority to */
+			TaskID_ROS task_vector, \
+			/* Priority lent */
+			uint8_t priority
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* No task to lend to, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Input validation successful, lend the priority */
+	else
+	{
+		/* Look up task id */
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
+
+		/* Check if this is the first priority lent, and keep the task's own */
+		if(gTaskInheritCountArray_ROS[task_id]++ == 0u)
+		{
+			gTaskBasePriorityArray_ROS[task_id] = TASK_PRIORITY_ROS(task_id);
+		}
+
+		/* Check if the lent priority is higher than the one the task runs at */
+		if(priority > TASK_PRIORITY_ROS(task_id))
+		{
+			/* Raise the task */
+			_ChangeTaskPriority_ROS(task_id, priority);
+		}
+
+		/* Priority lent, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of InheritTaskPriority_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: RestoreTaskPriority_ROS
+* Description	: Matches a call to InheritTaskPriority_ROS, once the lender is
+*				  no longer blocked on the task at the specified vector. The
+*				  last match returns the task to its own priority (and level,
+*				  if it is queued). Returns success, or an error code if the
+*				  vector is empty or invalid, or holds no lent priority.
+* Notes			: None.
+*******************************************************************************/
+uint8_t RestoreTaskPriority_ROS
+		(
+			/* Vector of task to take a lent priority back from */
+			TaskID_ROS task_vector
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* No task to restore, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Check if the task holds no lent priority */
+	else if(gTaskInheritCountArray_ROS[gTaskVectorLookupArray_ROS \
+									   [task_vector]] == 0u)
+	{
+		/* Nothing to restore, return failure */
+		return F_TASK_NOT_INHERITED_ROS;
+	}
+	/* Input validation successful, take the priority back */
+	else
+	{
+		/* Look up task id */
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
+
+		/* Check if this was the last priority lent, and the task was raised */
+		if((--gTaskInheritCountArray_ROS[task_id] == 0u) && \
+		   (TASK_PRIORITY_ROS(task_id) != gTaskBasePriorityArray_ROS[task_id]))
+		{
+			/* Return the task to its own priority */
+			_ChangeTaskPriority_ROS(task_id, \
+									gTaskBasePriorityArray_ROS[task_id]);
+		}
+
+		/* Priority restored, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of RestoreTaskPriority_ROS
+*******************************************************************************/
+
+#if (ENABLE_COROUTINE_TASKS_ROS)
+/*******************************************************************************
+* Name			: CreateCoroutineTask_ROS
+* Description	: Makes the task at the specified vector a coroutine task, run
+*				  by calling the coroutine function with its saved resume point.
+*				  The coroutine starts from the beginning of its body. Returns
+*				  success, or an error code if the task is invalid or already a
+*				  coroutine task.
+* Notes			: The task keeps its vector, priority and other registrations,
+*				  only its task function is replaced.
+*******************************************************************************/
+uint8_t CreateCoroutineTask_ROS
+		(
+			/* Vector of task to make a coroutine task */
+			TaskID_ROS task_vector, \
+			/* Coroutine function */
+			TaskCoroutine_ROS coroutine
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* Task vector is empty, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Check if task is already a coroutine task */
+	else if(TASK_POINTER_ROS(gTaskVectorLookupArray_ROS[task_vector]) == \
+			_RunCoroutineTask_ROS)
+	{
+		/* Task already a coroutine task, return failure */
+		return F_TASK_ALREADY_COROUTINE_ROS;
+	}
+	/* Input validation successful, install the coroutine */
+	else
+	{
+		/* Look up task id */
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
+
+		/* Store coroutine and start from the beginning of its body */
+		gTaskCoroutineArray_ROS[task_id] = coroutine;
+		gTaskResumeArray_ROS[task_id] = 0u;
+
+		/* Dispatch the task through the coroutine trampoline */
+		TASK_POINTER_ROS(task_id) = _RunCoroutineTask_ROS;
+
+		/* Coroutine task created, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of CreateCoroutineTask_ROS
+*******************************************************************************/
+#endif
+
+#if (ENABLE_SMP_ROS)
+/*******************************************************************************
+* Name			: SetTaskAffinity_ROS
+* Description	: Sets the cores allowed to run the task at the specified
+*				  vector (bit n set = core n). A mask of 0 lets any core run it.
+* Notes			: Takes effect the next time the task is queued. A task already
+*				  queued is only dispatched by a core its new mask allows.
+*******************************************************************************/
+uint8_t SetTaskAffinity_ROS
+		(
+			/* Vector of task to bind */
+			TaskID_ROS task_vector, \
+			/* Mask of cores allowed to run the task */
+			uint8_t core_mask
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* Task vector is empty, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Check if the mask names a core that does not exist */
+	else if(core_mask & (uint8_t)~ALL_CORES_MASK_ROS)
+	{
+		/* Mask invalid, return failure */
+		return F_TASK_AFFINITY_INVALID_ROS;
+	}
+	/* Input validation successful, store the mask */
+	else
+	{
+		TASK_AFFINITY_ROS(gTaskVectorLookupArray_ROS[task_vector]) = core_mask;
+
+		/* Affinity set, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of SetTaskAffinity_ROS
+*******************************************************************************/
+#endif
+
+/*******************************************************************************
+* Name			: CreateISRTask_ROS
+* Description	: Registers the task at the specified vector as an ISR task, so
+*				  interrupt handlers can queue it with PostISRTask_ROS. Outputs
+*				  the handle to pass to PostISRTask_ROS. The task starts enabled.
+* Notes			: The handle is the task ID, so posting needs no lookups.
+*******************************************************************************/
+uint8_t CreateISRTask_ROS
+		(
+			/* Vector of task to register */
+			TaskID_ROS task_vector, \
+			/* Pointer to variable that will store the ISR post handle */
+			TaskID_ROS * isr_handle
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* Task vector is empty, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Check if task is already an ISR task */
+	else if(gTaskISRArray_ROS[gTaskVectorLookupArray_ROS[task_vector]])
+	{
+		/* Task already registered, return failure */
+		return F_TASK_ALREADY_ISR_ROS;
+	}
+	/* Input validation successful, register ISR task */
+	else
+	{
+		/* Look up task id */
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
+
+		/* Mark task as a registered and enabled ISR task */
+		gTaskISRArray_ROS[task_id] = true;
+		gTaskISREnabledArray_ROS[task_id] = true;
+
+		/* Output task id as the post handle */
+		*isr_handle = task_id;
+
+		/* ISR task created, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of CreateISRTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: ControlISRTask_ROS
+* Description	: Enables or disables an ISR task. Posts made while the task is
+*				  disabled are discarded when the ring is drained.
+* Notes			: None.
+*******************************************************************************/
+uint8_t ControlISRTask_ROS
+		(
+			/* Vector of ISR task to control */
+			TaskID_ROS task_vector, \
+			/* Control ISR task (true = enable) */
+			bool enable_task
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* Task vector is empty, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Check if task is an ISR task */
+	else if(!gTaskISRArray_ROS[gTaskVectorLookupArray_ROS[task_vector]])
+	{
+		/* Task not registered, return failure */
+		return F_TASK_NOT_ISR_ROS;
+	}
+	/* Input validation successful, update enable status */
+	else
+	{
+		/* Store enable status for this task */
+		gTaskISREnabledArray_ROS[gTaskVectorLookupArray_ROS[task_vector]] = \
+																enable_task;
+
+		/* ISR control complete, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of ControlISRTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: DestroyISRTask_ROS
+* Description	: Unregisters an ISR task. Posts still in the ring for this task
+*				  are discarded when the ring is drained.
+* Notes			: The task entry itself is not destroyed.
+*******************************************************************************/
+uint8_t DestroyISRTask_ROS
+		(
+			/* Vector of ISR task to destroy */
+			TaskID_ROS task_vector
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* Task vector is empty, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector invalid, return error code */
+		return is_task_empty;
+	}
+	/* Check if task is an ISR task */
+	else if(!gTaskISRArray_ROS[gTaskVectorLookupArray_ROS[task_vector]])
+	{
+		/* Task not registered, return failure */
+		return F_TASK_NOT_ISR_ROS;
+	}
+	/* Input validation successful, unregister task */
+	else
+	{
+		/* Look up task id */
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
+
+		/* Clear registration and enable status */
+		gTaskISRArray_ROS[task_id] = false;
+		gTaskISREnabledArray_ROS[task_id] = false;
+
+		/* ISR task destroyed, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of DestroyISRTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: PostISRTask_ROS
+* Description	: Called from an interrupt handler to request that an ISR task
+*				  is queued. Returns success, or a failure code if the ring is
+*				  full (the post is dropped and counted).
+* Notes			: Single producer: interrupt handlers that post must not nest
+*				  with each other. The handle is not validated here; disabled or
+*				  destroyed tasks are filtered when the ring is drained.
+*******************************************************************************/
+uint8_t PostISRTask_ROS
+		(
+			/* Handle output by CreateISRTask_ROS */
+			TaskID_ROS isr_handle
 		)
 {
-	if(task_vector
+	/* Take a local copy of the producer index */
+	uint8_t head = gISRRingHead_ROS;
+
+	/* Check if the ring is full (seeing every entry the consumer has freed) */
+	if((uint8_t)(head - LOAD_RING_INDEX_ROS(gISRRingTail_ROS)) >= ISR_RING_SIZE_ROS)
+	{
+		/* Drop the post, and record it */
+		gISRRingOverflow_ROS++;
+
+		/* Ring full, return failure */
+		return F_ISR_RING_FULL_ROS;
+	}
+	/* Space available */
+	else
+	{
+		/* Store the handle, then publish it by advancing the head (a release
+		   store in SMP mode, so the handle is seen first on every core) */
+		gISRRing_ROS[head & ISR_RING_MASK_ROS] = isr_handle;
+		STORE_RING_INDEX_ROS(gISRRingHead_ROS, (uint8_t)(head + 1u));
+
+		/* Post complete, return success */
+		return SUCCESS_ROS;
+	}
+}
+/*******************************************************************************
+* End of PostISRTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: TickScheduler_ROS
+* Description	: Advances the scheduler tick counter, and releases periodic
+*				  tasks that are due. Call once per system tick, typically from
+*				  the tick timer interrupt.
+* Notes			: Only the current wheel slot is visited, so the cost does not
+*				  depend on the number of armed periodic tasks. Every 64 ticks
+*				  one level 1 slot is cascaded into level 0.
+*******************************************************************************/
+void TickScheduler_ROS
+		(
+			void
+		)
+{
+	/* Lock the timer wheel, advance it by one tick, and unlock it */
+	ACQUIRE_LOCK_ROS(gTimerLock_ROS);
+	_AdvanceTimerWheel_ROS();
+	RELEASE_LOCK_ROS(gTimerLock_ROS);
+}
+/*******************************************************************************
+* End of TickScheduler_ROS
+*******************************************************************************/
+
+#if (ENABLE_TICKLESS_IDLE_ROS)
+/*******************************************************************************
+* Name			: NextSchedulerEvent_ROS
+* Description	: Returns the number of ticks from now to the next due event:
+*				  the next armed timer (periodic release, sleep wake up or
+*				  message wait timeout) or message expiry, at most
+*				  MAX_IDLE_TICKS_ROS. Returns 0 if a task is ready or posted.
+* Notes			: Task timeouts (TASK_TIMEOUT_ROS) only set EDF deadlines,
+*				  which are checked at dispatch, so they need no wake up.
+*******************************************************************************/
+uint32_t NextSchedulerEvent_ROS
+		(
+			void
+		)
+{
+	/* Declare event container variables */
+	uint32_t next_event, next_expiry;
+
+	/* Check if there is work to do now */
+	if(_ConfirmIdle_ROS() != TRUE_ROS)
+	{
+		/* Not idle, return 0 */
+		return 0u;
+	}
+
+	/* Find the next armed timer, and the next message expiry */
+	ACQUIRE_LOCK_ROS(gTimerLock_ROS);
+	next_event = _NextTimerEvent_ROS();
+	RELEASE_LOCK_ROS(gTimerLock_ROS);
+	next_expiry = NextMessageExpiry_ROS();
+
+	/* Keep the earliest of the two, and the sleep limit */
+	if(next_expiry < next_event)
+	{
+		next_event = next_expiry;
+	}
+	if(next_event > MAX_IDLE_TICKS_ROS)
+	{
+		next_event = MAX_IDLE_TICKS_ROS;
+	}
+
+	/* Return ticks to the next event */
+	return next_event;
+}
+/*******************************************************************************
+* End of NextSchedulerEvent_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: StepScheduler_ROS
+* Description	: Catches the scheduler up with ticks that went by while the
+*				  tick was stopped. The timer wheel is stepped from one timer
+*				  event to the next, and each event's tick, and each level 0
+*				  wrap on the way, is passed through it as TickScheduler_ROS
+*				  would, so releases, cascades, overrun counts and release
+*				  ticks come out as in a ticked run. The message expiry clock
+*				  is advanced by the same number of ticks.
+* Notes			: The cost grows with the number of timer events and level 0
+*				  wraps in the ticks, not with the ticks themselves. While the
+*				  tick runs, the tick handler advances the message expiry
+*				  clock itself, with TickMessageExpiry_ROS.
+*******************************************************************************/
+void StepScheduler_ROS
+		(
+			/* Number of ticks that went by */
+			uint32_t ticks
+		)
+{
+	/* Declare remaining ticks, step and ticks to wrap variables */
+	uint32_t remaining = ticks;
+	uint32_t step, wrap;
+
+	/* Lock the timer wheel, and step it until the ticks are used up */
+	ACQUIRE_LOCK_ROS(gTimerLock_ROS);
+	while(remaining > 0u)
+	{
+		/* Step to the next timer event, or as far as the ticks go */
+		step = _NextTimerEvent_ROS();
+		if(step > remaining)
+		{
+			step = remaining;
+		}
+		remaining -= step;
+
+		/* Pass each level 0 wrap before the step's last tick through the
+		   wheel, so level 1 slots are cascaded on time */
+		while((wrap = TIMER_WHEEL_SLOTS_ROS - (gSystemTick_ROS & \
+				TIMER_WHEEL_MASK_ROS)) < step)
+		{
+			gSystemTick_ROS += wrap - 1u;
+			_AdvanceTimerWheel_ROS();
+			step -= wrap;
+		}
+
+		/* Skip the empty ticks, and pass the step's last tick through the
+		   wheel */
+		gSystemTick_ROS += step - 1u;
+		_AdvanceTimerWheel_ROS();
+	}
+	RELEASE_LOCK_ROS(gTimerLock_ROS);
+
+	/* Expire messages whose time to live ran out meanwhile */
+	(void)AdvanceMessageExpiry_ROS(ticks);
+}
+/*******************************************************************************
+* End of StepScheduler_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: IdleScheduler_ROS
+* Description	: Sleeps the processor until the next due event, with the
+*				  periodic tick stopped, then catches the scheduler up. Call
+*				  when DispatchTask_ROS finds nothing ready. Returns the number
+*				  of ticks slept, or 0 if a task became ready first.
+* Notes			: An interrupt ends the sleep early; the ticks that went by up
+*				  to then are caught up, and the next call sleeps again.
+*******************************************************************************/
+uint32_t IdleScheduler_ROS
+		(
+			void
+		)
+{
+	/* Look up ticks to the next event, and declare the slept tick count */
+	uint32_t next_event = NextSchedulerEvent_ROS();
+	uint32_t elapsed;
+
+	/* Check if there is work to do now */
+	if(next_event == 0u)
+	{
+		/* Not idle, return 0 */
+		return 0u;
+	}
+
+	/* Sleep until the event (or an interrupt), and catch up with the ticks
+	   that went by */
+	elapsed = _SuppressTicksAndSleep_ROS(next_event);
+	StepScheduler_ROS(elapsed);
+
+	/* Return number of ticks slept */
+	return elapsed;
+}
+/*******************************************************************************
+* End of IdleScheduler_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _ConfirmIdle_ROS
+* Description	: Checks that no task is ready on any core, posted by an
+*				  interrupt handler or preempted. Returns true if idle, or
+*				  false.
+* Notes			: Called by the port with interrupts masked, just before it
+*				  sleeps, so a task posted after NextSchedulerEvent_ROS still
+*				  cancels the sleep. Tickless idle mode excludes SMP mode, so
+*				  there is one core today, but every core's bitmap is checked
+*				  rather than relying on it.
+*******************************************************************************/
+uint8_t _ConfirmIdle_ROS
+		(
+			void
+		)
+{
+	/* Declare core loop variable */
+	uint8_t core;
+
+	/* Check if a task is ready on any core */
+	for(core = 0u; core < NUM_CORES_ROS; core++)
+	{
+		if(gReadyPriorityBitmap_ROS[core] != 0u)
+		{
+			/* Work to do, return false */
+			return FALSE_ROS;
+		}
+	}
+
+	/* Check if a task is posted and not yet drained */
+	if(gISRRingHead_ROS != gISRRingTail_ROS)
+	{
+		/* Work to do, return false */
+		return FALSE_ROS;
+	}
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+	/* Check if a preempted task is waiting to be resumed */
+	else if(gNumPreemptedTasks_ROS != 0u)
+	{
+		/* Work to do, return false */
+		return FALSE_ROS;
+	}
+#endif
+	/* Nothing to run */
+	else
+	{
+		/* Idle, return true */
+		return TRUE_ROS;
+	}
+}
+/*******************************************************************************
+* End of _ConfirmIdle_ROS
+*******************************************************************************/
+#endif
+
+/*******************************************************************************
+* Name			: _IsTaskQueued_ROS
+* Description	: Checks whether the task at the specified vector is in a ready
+*				  list. Returns true if queued, false if not, and an error code
+*				  if the task vector is empty or invalid.
+* Notes			: None.
+*******************************************************************************/
+uint8_t _IsTaskQueued_ROS
+		(
+			/* Task vector to check */
+			TaskID_ROS task_vector
+		)
+{
+	/* Check if task vector is empty, and store result in container variable */
+	uint8_t is_task_empty = _IsTaskVectorEmpty_ROS(task_vector);
+
+	/* Check if task vector is empty */
+	if(is_task_empty == TRUE_ROS)
+	{
+		/* Task vector is empty, return failure */
+		return F_TASK_VECTOR_EMPTY_ROS;
+	}
+	/* Check if task vector is invalid */
+	else if(is_task_empty != FALSE_ROS)
+	{
+		/* Task vector is invalid, return failure */
+		return is_task_empty;
+	}
+	/* Check queued status of the task */
+	else if(gTaskQueuedArray_ROS[gTaskVectorLookupArray_ROS[task_vector]])
+	{
+		/* Task is queued, return true */
+		return TRUE_ROS;
+	}
+	/* Task is not queued */
+	else
+	{
+		/* Task is not queued, return false */
+		return FALSE_ROS;
+	}
+}
+/*******************************************************************************
+* End of _IsTaskQueued_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _HighestSetBit_ROS
+* Description	: Returns the number of the highest bit set in a ready bitmap.
+* Notes			: Ready bitmap must be non-zero. Uses the compiler's count
+*				  leading zeros builtin where available (a single instruction on
+*				  most cores), otherwise a five step binary search.
+*******************************************************************************/
+uint8_t _HighestSetBit_ROS
+		(
+			/* Ready bitmap to search */
+			uint32_t bitmap
+		)
+{
+#if defined(__GNUC__)
+	/* Highest set bit is 31 minus the leading zero count */
+	return (uint8_t)(31u - __builtin_clz(bitmap));
+#else
+	/* Declare result */
+	uint8_t level = 0u;
+
+	/* Halve the search window until the highest set bit is found */
+	if(bitmap & 0xFFFF0000ul) { bitmap >>= 16; level += 16u; }
+	if(bitmap & 0x0000FF00ul) { bitmap >>= 8;  level += 8u;  }
+	if(bitmap & 0x000000F0ul) { bitmap >>= 4;  level += 4u;  }
+	if(bitmap & 0x0000000Cul) { bitmap >>= 2;  level += 2u;  }
+	if(bitmap & 0x00000002ul) { level += 1u; }
+
+	/* Return highest set bit */
+	return level;
+#endif
+}
+/*******************************************************************************
+* End of _HighestSetBit_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _HighestReadyLevel_ROS
+* Description	: Returns the highest ready priority level of a core below a
+*				  limit (NUM_PRIORITY_LEVELS_ROS for the highest of all), or
+*				  NO_READY_LEVEL_ROS if no level below the limit is ready.
+* Notes			: With fine priority levels, the group bitmap finds the highest
+*				  ready group, and the group's level bitmap the level in it.
+*******************************************************************************/
+uint16_t _HighestReadyLevel_ROS
+		(
+			/* Core whose ready lists to search */
+			uint8_t core, \
+			/* Levels at or above this one are ignored */
+			uint16_t limit
+		)
+{
+	/* Take a search copy of the core's ready bitmap */
+	uint32_t bitmap = gReadyPriorityBitmap_ROS[core];
+
+#if (ENABLE_FINE_PRIORITY_LEVELS_ROS)
+	/* Declare group number and group level bitmap */
+	uint8_t group;
+	uint32_t levels;
+
+	/* Check if the limit falls inside a group */
+	if(limit < NUM_PRIORITY_LEVELS_ROS)
+	{
+		/* Search the limit's own group, below the limit */
+		group = (uint8_t)(limit >> 3);
+		levels = gReadyLevelBitmap_ROS[core][group] & ((1u << (limit & 7u)) - 1u);
+
+		/* Check if a level below the limit is ready in that group */
+		if(levels != 0u)
+		{
+			/* Return the highest of them */
+			return (uint16_t)((group << 3) + _HighestSetBit_ROS(levels));
+		}
+
+		/* Search only the groups below */
+		bitmap &= (1ul << group) - 1u;
+	}
+
+	/* Check if no group is ready */
+	if(bitmap == 0u)
+	{
+		return NO_READY_LEVEL_ROS;
+	}
+
+	/* Return the highest ready level of the highest ready group */
+	group = _HighestSetBit_ROS(bitmap);
+	return (uint16_t)((group << 3) + \
+					  _HighestSetBit_ROS(gReadyLevelBitmap_ROS[core][group]));
+#else
+	/* Check if the limit masks any levels */
+	if(limit < NUM_PRIORITY_LEVELS_ROS)
+	{
+		/* Search only the levels below the limit */
+		bitmap &= (1ul << limit) - 1u;
+	}
+
+	/* Check if no level is ready */
+	if(bitmap == 0u)
+	{
+		return NO_READY_LEVEL_ROS;
+	}
+
+	/* Return highest ready level */
+	return _HighestSetBit_ROS(bitmap);
+#endif
+}
+/*******************************************************************************
+* End of _HighestReadyLevel_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _LinkReadyTask_ROS
+* Description	: Links a task ID into its ready list (the back of its priority
+*				  level, or its core's deadline heap in EDF mode). In SMP mode
+*				  the ready lists of the core picked by _SelectTaskCore_ROS are
+*				  used, and locked while the task is linked.
+* Notes			: Task must be valid, and already marked as queued by
+*				  CLAIM_TASK_QUEUED_ROS. In EDF mode the task keeps the deadline
+*				  last set by SET_TASK_DEADLINE_ROS.
+*******************************************************************************/
+void _LinkReadyTask_ROS
+		(
+			/* Task id to link */
+			TaskID_ROS task_id
+		)
+{
+#if (ENABLE_SMP_ROS)
+	/* Pick the core to queue the task on, and lock its ready lists */
+	uint8_t core = _SelectTaskCore_ROS(task_id);
+	ACQUIRE_LOCK_ROS(gReadyLockArray_ROS[core]);
+#else
+	/* Only one core */
+	uint8_t core = 0u;
+#endif
+
+#if (ENABLE_EDF_SCHEDULER_ROS)
+	/* All tasks share level 0, held in the core's deadline heap */
+	gReadyLevelArray_ROS[task_id] = 0u;
+	_InsertDeadlineTask_ROS(core, task_id);
+#else
+	/* Map task priority onto a ready list level */
+	uint8_t level = TASK_PRIORITY_ROS(task_id) >> \
+					PRIORITY_LEVEL_SHIFT_ROS;
+	TaskID_ROS tail = gReadyTailArray_ROS[core][level];
+
+	/* Link task behind the current tail */
+	gReadyPrevArray_ROS[task_id] = tail;
+	gReadyNextArray_ROS[task_id] = NULL_TASK_ROS;
+
+	/* Check if the level was empty */
+	if(tail == NULL_TASK_ROS)
+	{
+		/* Task becomes the head, and the level is now ready */
+		gReadyHeadArray_ROS[core][level] = task_id;
+		SET_LEVEL_READY_ROS(core, level);
+	}
+	/* Level already holds tasks */
+	else
+	{
+		/* Point old tail at the new task */
+		gReadyNextArray_ROS[tail] = task_id;
+	}
+
+	/* Task is the new tail of its level */
+	gReadyTailArray_ROS[core][level] = task_id;
+
+	/* Remember level, so removal does not depend on current priority */
+	gReadyLevelArray_ROS[task_id] = level;
+#endif
+
+#if (ENABLE_SMP_ROS)
+	/* Record the core holding the task, and unlock its ready lists */
+	__atomic_store_n(&gTaskQueuedCoreArray_ROS[task_id], core + 1u, \
+					 __ATOMIC_RELEASE);
+	RELEASE_LOCK_ROS(gReadyLockArray_ROS[core]);
+#endif
+}
+/*******************************************************************************
+* End of _LinkReadyTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _PopReadyTask_ROS
+* Description	: Removes and returns the oldest task ID in the highest ready
+*				  priority level of the specified core (the root of its
+*				  deadline heap in EDF mode), or NULL_TASK_ROS if the core has
+*				  nothing ready. In SMP mode tasks still running on
+*				  another core, or not allowed on the calling core, are passed
+*				  over, and the popped task is marked as running.
+* Notes			: The core's ready lists must be locked.
+*******************************************************************************/
+TaskID_ROS _PopReadyTask_ROS
+		(
+			/* Core whose ready lists to pop from */
+			uint8_t core
+		)
+{
+#if (ENABLE_EDF_SCHEDULER_ROS)
+	/* Take the root of the core's deadline heap */
+	TaskID_ROS task_id = NULL_TASK_ROS;
+	if(gDeadlineHeapSizeArray_ROS[core] != 0u)
+	{
+		task_id = gDeadlineHeapArray_ROS[core][0];
+	}
+
+#if (ENABLE_SMP_ROS)
+	/* Check if the calling core cannot run the root yet */
+	if((task_id != NULL_TASK_ROS) && !CAN_CORE_RUN_TASK_ROS(task_id))
+	{
+		/* Search the heap for the most urgent task the core can run */
+		uint32_t position;
+		TaskID_ROS candidate;
+		task_id = NULL_TASK_ROS;
+		for(position = 1u; position < gDeadlineHeapSizeArray_ROS[core]; \
+			position++)
+		{
+			candidate = gDeadlineHeapArray_ROS[core][position];
+			if(CAN_CORE_RUN_TASK_ROS(candidate) && \
+			   ((task_id == NULL_TASK_ROS) || \
+				_IsMoreUrgent_ROS(candidate, task_id)))
+			{
+				task_id = candidate;
+			}
+		}
+	}
+#endif
+#else
+	/* Start the search at the highest ready level */
+	uint16_t level = _HighestReadyLevel_ROS(core, NUM_PRIORITY_LEVELS_ROS);
+	TaskID_ROS task_id = NULL_TASK_ROS;
+
+	/* Search the ready levels from the highest down */
+	while(level != NO_READY_LEVEL_ROS)
+	{
+		/* Look up the head of the level */
+		task_id = gReadyHeadArray_ROS[core][level];
+
+#if (ENABLE_SMP_ROS)
+		/* Pass over tasks the calling core cannot run yet */
+		while((task_id != NULL_TASK_ROS) && !CAN_CORE_RUN_TASK_ROS(task_id))
+		{
+			task_id = gReadyNextArray_ROS[task_id];
+		}
+#endif
+
+		/* Check if a task was found */
+		if(task_id != NULL_TASK_ROS)
+		{
+			break;
+		}
+
+		/* Nothing runnable at this level, try the next one down */
+		level = _HighestReadyLevel_ROS(core, level);
+	}
+#endif
+
+	/* Check if a task was found */
+	if(task_id != NULL_TASK_ROS)
+	{
+#if (ENABLE_SMP_ROS)
+		/* Mark it as running before its queued status clears, so a core
+		   queuing it again meanwhile cannot dispatch it as well */
+		__atomic_store_n(&gTaskRunningArray_ROS[task_id], true, \
+						 __ATOMIC_RELEASE);
+#endif
+
+		/* Unlink it from its level */
+		_UnlinkReadyTask_ROS(task_id);
+	}
+
+	/* Return popped task id */
+	return task_id;
+}
+/*******************************************************************************
+* End of _PopReadyTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _UnlinkReadyTask_ROS
+* Description	: Unlinks a queued task ID from its ready list (or its core's
+*				  deadline heap in EDF mode), and clears the level's bitmap bit
+*				  if the list becomes empty.
+* Notes			: Task must be queued. In SMP mode, the ready lists of the core
+*				  holding the task must be locked.
+*******************************************************************************/
+void _UnlinkReadyTask_ROS
+		(
+			/* Task id to unlink */
+			TaskID_ROS task_id
+		)
+{
+#if (ENABLE_SMP_ROS)
+	/* Look up the core holding the task */
+	uint8_t core = gTaskQueuedCoreArray_ROS[task_id] - 1u;
+#else
+	/* Only one core */
+	uint8_t core = 0u;
+#endif
+
+#if (ENABLE_EDF_SCHEDULER_ROS)
+	/* Remove the task from the core's deadline heap */
+	_RemoveDeadlineTask_ROS(core, task_id);
+#else
+	/* Look up level and neighbours of the task */
+	uint8_t level = gReadyLevelArray_ROS[task_id];
+	TaskID_ROS prev = gReadyPrevArray_ROS[task_id];
+	TaskID_ROS next = gReadyNextArray_ROS[task_id];
+
+	/* Bridge the previous entry (or head) over the task */
+	if(prev == NULL_TASK_ROS)
+	{
+		gReadyHeadArray_ROS[core][level] = next;
+	}
+	else
+	{
+		gReadyNextArray_ROS[prev] = next;
+	}
+
+	/* Bridge the next entry (or tail) over the task */
+	if(next == NULL_TASK_ROS)
+	{
+		gReadyTailArray_ROS[core][level] = prev;
+	}
+	else
+	{
+		gReadyPrevArray_ROS[next] = prev;
+	}
+
+	/* Check if the level is now empty */
+	if(gReadyHeadArray_ROS[core][level] == NULL_TASK_ROS)
+	{
+		/* Clear level's ready bit */
+		CLEAR_LEVEL_READY_ROS(core, level);
+	}
+#endif
+
+	/* Clear task's links and queued status */
+	gReadyPrevArray_ROS[task_id] = NULL_TASK_ROS;
+	gReadyNextArray_ROS[task_id] = NULL_TASK_ROS;
+#if (ENABLE_SMP_ROS)
+	__atomic_store_n(&gTaskQueuedCoreArray_ROS[task_id], 0u, __ATOMIC_RELAXED);
+#endif
+	CLEAR_TASK_QUEUED_ROS(task_id);
+}
+/*******************************************************************************
+* End of _UnlinkReadyTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _ArmTimer_ROS
+* Description	: Links a task's release timer into the wheel slot for its
+*				  release tick: level 0 if due within 64 ticks, else level 1.
+* Notes			: Release tick must be in the future and within 4096 ticks.
+*******************************************************************************/
+void _ArmTimer_ROS
+		(
+			/* Task id to arm */
+			TaskID_ROS task_id
+		)
+{
+	/* Look up release tick */
+	uint32_t release = gTaskReleaseTickArray_ROS[task_id];
+
+	/* Declare slot container variable */
+	uint8_t slot;
+
+	/* Check if release falls within the level 0 window */
+	if((release - gSystemTick_ROS) < TIMER_WHEEL_SLOTS_ROS)
+	{
+		/* Level 0 slot is the low bits of the release tick */
+		slot = release & TIMER_WHEEL_MASK_ROS;
+	}
+	/* Release is further away */
+	else
+	{
+		/* Level 1 slot is the next six bits of the release tick */
+		slot = TIMER_WHEEL_SLOTS_ROS + ((release >> TIMER_WHEEL_BITS_ROS) & \
+										TIMER_WHEEL_MASK_ROS);
+	}
+
+	/* Push task onto the front of the slot */
+	gTimerPrevArray_ROS[task_id] = NULL_TASK_ROS;
+	gTimerNextArray_ROS[task_id] = gTimerWheelHeadArray_ROS[slot];
+
+	/* Back link the old head, if any */
+	if(gTimerWheelHeadArray_ROS[slot] != NULL_TASK_ROS)
+	{
+		gTimerPrevArray_ROS[gTimerWheelHeadArray_ROS[slot]] = task_id;
+	}
+
+	/* Task is the new head */
+	gTimerWheelHeadArray_ROS[slot] = task_id;
+
+	/* Record slot and armed status */
+	gTimerSlotArray_ROS[task_id] = slot;
+	gTaskPeriodArmedArray_ROS[task_id] = true;
+}
+/*******************************************************************************
+* End of _ArmTimer_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _DisarmTimer_ROS
+* Description	: Unlinks a task's release timer from its wheel slot.
+* Notes			: Timer must be armed.
+*******************************************************************************/
+void _DisarmTimer_ROS
+		(
+			/* Task id to disarm */
+			TaskID_ROS task_id
+		)
+{
+	/* Look up neighbours of the task */
+	TaskID_ROS prev = gTimerPrevArray_ROS[task_id];
+	TaskID_ROS next = gTimerNextArray_ROS[task_id];
+
+	/* Bridge the previous entry (or slot head) over the task */
+	if(prev == NULL_TASK_ROS)
+	{
+		gTimerWheelHeadArray_ROS[gTimerSlotArray_ROS[task_id]] = next;
+	}
+	else
+	{
+		gTimerNextArray_ROS[prev] = next;
+	}
+
+	/* Back link the next entry, if any */
+	if(next != NULL_TASK_ROS)
+	{
+		gTimerPrevArray_ROS[next] = prev;
+	}
+
+	/* Clear armed status */
+	gTaskPeriodArmedArray_ROS[task_id] = false;
+}
+/*******************************************************************************
+* End of _DisarmTimer_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _ReleasePeriodicTask_ROS
+* Description	: Queues a periodic task whose release tick has arrived, and
+*				  re-arms its timer for the next period. A release that finds
+*				  the previous one still queued is counted as an overrun. A
+*				  sleeping task is queued once, and its timer left disarmed.
+* Notes			: Timer must be armed in the current level 0 slot.
+*******************************************************************************/
+void _ReleasePeriodicTask_ROS
+		(
+			/* Task id to release */
+			TaskID_ROS task_id
+		)
+{
+	/* Remove timer from the current slot */
+	_DisarmTimer_ROS(task_id);
+
+	/* Check if the timer was a sleep wake up, which is not repeated */
+	if(gTaskPeriodArray_ROS[task_id] == 0u)
+	{
+		/* Queue the task, unless something else already has */
+		if(!CLAIM_TASK_QUEUED_ROS(task_id))
+		{
+			SET_TASK_DEADLINE_ROS(task_id);
+			_LinkReadyTask_ROS(task_id);
+		}
+	}
+	/* Check if the previous release has not run yet */
+	else if(CLAIM_TASK_QUEUED_ROS(task_id))
+	{
+		/* Record overrun, the queued entry is reused for this release */
+		gTaskOverrunArray_ROS[task_id]++;
+		gTaskReleasePendingArray_ROS[task_id] = true;
+
+		/* Schedule the next release */
+		gTaskReleaseTickArray_ROS[task_id] += gTaskPeriodArray_ROS[task_id];
+		_ArmTimer_ROS(task_id);
+	}
+	/* Previous release has completed */
+	else
+	{
+		/* Queue this release */
+		gTaskReleasePendingArray_ROS[task_id] = true;
+		SET_TASK_DEADLINE_ROS(task_id);
+		_LinkReadyTask_ROS(task_id);
+
+		/* Schedule the next release from the ideal release tick, so that
+		   dispatch delays do not accumulate as drift */
+		gTaskReleaseTickArray_ROS[task_id] += gTaskPeriodArray_ROS[task_id];
+		_ArmTimer_ROS(task_id);
+	}
+}
+/*******************************************************************************
+* End of _ReleasePeriodicTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _ArmSleepTimer_ROS
+* Description	: Arms the running task's timer for its stored wake tick. Returns
+*				  true if the wake tick has already been reached (nothing is
+*				  armed), or false once armed.
+* Notes			: Wake ticks beyond the timer wheel range are armed at the edge
+*				  of the range, and re-armed by ResumeSleep_ROS.
+*******************************************************************************/
+uint8_t _ArmSleepTimer_ROS
+		(
+			void
+		)
+{
+	/* Look up the running task, and its remaining sleep */
+	TaskID_ROS task_id = RUNNING_TASK_ID_ROS;
+	int32_t remaining = (int32_t)(gTaskWakeTickArray_ROS[task_id] - \
+								  gSystemTick_ROS);
+
+	/* Cancel any timer left armed by an early wake */
+	if(gTaskPeriodArmedArray_ROS[task_id])
+	{
+		_DisarmTimer_ROS(task_id);
+	}
+
+	/* Check if the wake tick has been reached */
+	if(remaining <= 0)
+	{
+		/* Sleep over, return true */
+		return TRUE_ROS;
+	}
+	/* Check if the wake tick is beyond the timer wheel range */
+	else if(remaining > (int32_t)MAX_TASK_PERIOD_ROS)
+	{
+		/* Wake at the edge of the range, and sleep again from there */
+		gTaskReleaseTickArray_ROS[task_id] = gSystemTick_ROS + MAX_TASK_PERIOD_ROS;
+	}
+	/* Wake tick is within range */
+	else
+	{
+		gTaskReleaseTickArray_ROS[task_id] = gTaskWakeTickArray_ROS[task_id];
+	}
+
+	/* Link task into the timer wheel, and return false */
+	_ArmTimer_ROS(task_id);
+	return FALSE_ROS;
+}
+/*******************************************************************************
+* End of _ArmSleepTimer_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _ChangeTaskPriority_ROS
+* Description	: Sets a task's priority, and moves it to the back of its new
+*				  priority level if it is queued.
+* Notes			: In EDF mode a queued task keeps its deadline, and moves to its
+*				  new place in the deadline heap.
+*******************************************************************************/
+void _ChangeTaskPriority_ROS
+		(
+			/* Task id to change */
+			TaskID_ROS task_id, \
+			/* New priority */
+			uint8_t priority
+		)
+{
+	/* Declare queued status container variable */
+	bool is_queued;
+
+#if (ENABLE_SMP_ROS)
+	/* Remove task from the ready list of whichever core holds it */
+	is_queued = (_UnqueueLinkedTask_ROS(task_id) == SUCCESS_ROS);
+#else
+	/* Check if the task is queued, and remove it from its ready list */
+	is_queued = gTaskQueuedArray_ROS[task_id];
+	if(is_queued)
+	{
+		_UnlinkReadyTask_ROS(task_id);
+	}
+#endif
+
+	/* Store the new priority */
+	TASK_PRIORITY_ROS(task_id) = priority;
+
+	/* Queue task again at its new level, unless something else already has */
+	if(is_queued && !CLAIM_TASK_QUEUED_ROS(task_id))
+	{
+		_LinkReadyTask_ROS(task_id);
+	}
+}
+/*******************************************************************************
+* End of _ChangeTaskPriority_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _AdvanceTimerWheel_ROS
+* Description	: Advances the scheduler tick counter by one, cascading a level
+*				  1 slot into level 0 when level 0 wraps, and releases every
+*				  timer in the new tick's level 0 slot.
+* Notes			: The timer wheel must be locked.
+*******************************************************************************/
+void _AdvanceTimerWheel_ROS
+		(
+			void
+		)
+{
+	/* Declare slot walk variable */
+	TaskID_ROS task_id;
+
+	/* Advance the tick counter */
+	gSystemTick_ROS++;
+
+	/* Check if level 0 has wrapped, and a level 1 slot is now due */
+	if((gSystemTick_ROS & TIMER_WHEEL_MASK_ROS) == 0u)
+	{
+		/* Look up the level 1 slot covering the next 64 ticks */
+		uint8_t slot = TIMER_WHEEL_SLOTS_ROS + ((gSystemTick_ROS >> \
+					   TIMER_WHEEL_BITS_ROS) & TIMER_WHEEL_MASK_ROS);
+
+		/* Cascade each timer down into its level 0 slot */
+		while((task_id = gTimerWheelHeadArray_ROS[slot]) != NULL_TASK_ROS)
+		{
+			_DisarmTimer_ROS(task_id);
+			_ArmTimer_ROS(task_id);
+		}
+	}
+
+	/* Release every timer in the current level 0 slot, all of which are due
+	   this tick */
+	while((task_id = gTimerWheelHeadArray_ROS[gSystemTick_ROS & \
+					 TIMER_WHEEL_MASK_ROS]) != NULL_TASK_ROS)
+	{
+		_ReleasePeriodicTask_ROS(task_id);
+	}
+}
+/*******************************************************************************
+* End of _AdvanceTimerWheel_ROS
+*******************************************************************************/
+
+#if (ENABLE_TICKLESS_IDLE_ROS)
+/*******************************************************************************
+* Name			: _NextTimerEvent_ROS
+* Description	: Returns the number of ticks from now to the earliest armed
+*				  timer's release tick, or 0xFFFFFFFF if no timer is armed.
+* Notes			: The timer wheel must be locked. Level 0 slots are visited in
+*				  tick order from the next tick, and hold timers due within 64
+*				  ticks. The level 1 slot cascaded at the level 0 wrap they
+*				  cross holds timers due from the wrap on, so it is searched
+*				  there too. Otherwise the first level 1 slot holding timers
+*				  (in cascade order) is searched for its earliest release. At
+*				  most 127 slots are visited, whatever the number of timers.
+*******************************************************************************/
+uint32_t _NextTimerEvent_ROS
+		(
+			void
+		)
+{
+	/* Declare ticks ahead and slot variables */
+	uint32_t ahead;
+	uint8_t slot;
+	uint32_t next_event = 0xFFFFFFFFul;
+
+	/* Visit the level 0 slots of the next 63 ticks in tick order, up to the
+	   earliest release found in a level 1 slot */
+	for(ahead = 1u; (ahead < TIMER_WHEEL_SLOTS_ROS) && (ahead < next_event); \
+		ahead++)
+	{
+		/* Check if level 0 wraps that tick, and search the level 1 slot
+		   cascaded then */
+		if(((gSystemTick_ROS + ahead) & TIMER_WHEEL_MASK_ROS) == 0u)
+		{
+			next_event = _EarliestSlotRelease_ROS(TIMER_WHEEL_SLOTS_ROS + \
+							(((gSystemTick_ROS + ahead) >> TIMER_WHEEL_BITS_ROS) & \
+							 TIMER_WHEEL_MASK_ROS));
+		}
+
+		/* Check if a timer is due that tick */
+		if(gTimerWheelHeadArray_ROS[(gSystemTick_ROS + ahead) & \
+									TIMER_WHEEL_MASK_ROS] != NULL_TASK_ROS)
+		{
+			/* Earliest timer found, return ticks to it */
+			return ahead;
+		}
+	}
+
+	/* Check if the level 1 slot of the wrap crossed holds the earliest timer */
+	if(next_event != 0xFFFFFFFFul)
+	{
+		/* Return ticks to it */
+		return next_event;
+	}
+
+	/* Visit the level 1 slots in the order they are cascaded, from the next
+	   level 0 wrap */
+	for(ahead = 1u; ahead <= TIMER_WHEEL_SLOTS_ROS; ahead++)
+	{
+		slot = TIMER_WHEEL_SLOTS_ROS + (((gSystemTick_ROS >> \
+				TIMER_WHEEL_BITS_ROS) + ahead) & TIMER_WHEEL_MASK_ROS);
+
+		/* Check if the slot holds timers */
+		if(gTimerWheelHeadArray_ROS[slot] != NULL_TASK_ROS)
+		{
+			/* Return ticks to the earliest release in the slot (every
+			   release in a later slot is later still) */
+			return _EarliestSlotRelease_ROS(slot);
+		}
+	}
+
+	/* No timer armed */
+	return next_event;
+}
+/*******************************************************************************
+* End of _NextTimerEvent_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _EarliestSlotRelease_ROS
+* Description	: Returns the number of ticks from now to the earliest release
+*				  tick of the timers in a timer wheel slot, or 0xFFFFFFFF if
+*				  the slot is empty.
+* Notes			: The timer wheel must be locked.
+*******************************************************************************/
+uint32_t _EarliestSlotRelease_ROS
+		(
+			/* Timer wheel slot to search */
+			uint8_t slot
+		)
+{
+	/* Declare slot walk and earliest release variables */
+	TaskID_ROS task_id;
+	uint32_t earliest = 0xFFFFFFFFul;
+
+	/* Keep the nearest release of each timer in the slot */
+	for(task_id = gTimerWheelHeadArray_ROS[slot]; task_id != NULL_TASK_ROS; \
+		task_id = gTimerNextArray_ROS[task_id])
+	{
+		if((gTaskReleaseTickArray_ROS[task_id] - gSystemTick_ROS) < earliest)
+		{
+			earliest = gTaskReleaseTickArray_ROS[task_id] - gSystemTick_ROS;
+		}
+	}
+
+	/* Return ticks to the earliest release */
+	return earliest;
+}
+/*******************************************************************************
+* End of _EarliestSlotRelease_ROS
+*******************************************************************************/
+#endif
+
+#if (ENABLE_COROUTINE_TASKS_ROS)
+/*******************************************************************************
+* Name			: _RunCoroutineTask_ROS
+* Description	: Task function of every coroutine task. Runs the running task's
+*				  coroutine from its saved resume point, and queues it again if
+*				  it yielded.
+* Notes			: A waiting coroutine is queued by whatever it waits on.
+*******************************************************************************/
+void _RunCoroutineTask_ROS
+		(
+			void
+		)
+{
+	/* Look up the running task */
+	TaskID_ROS task_id = RUNNING_TASK_ID_ROS;
+
+	/* Run the coroutine, and check if it yielded */
+	if(gTaskCoroutineArray_ROS[task_id](&gTaskResumeArray_ROS[task_id]) == \
+	   COROUTINE_YIELDED_ROS)
+	{
+		/* Queue behind the other ready tasks of its priority level, unless
+		   it is already queued */
+		(void)KERNEL_CALL_ROS(QueueTask_ROS(TASK_VECTOR_ROS(task_id)));
+	}
+}
+/*******************************************************************************
+* End of _RunCoroutineTask_ROS
+*******************************************************************************/
+#endif
+
+/*******************************************************************************
+* Name			: _DrainISRRing_ROS
+* Description	: Moves every task ID posted by interrupt handlers into the
+*				  ready lists. Posts for disabled or unregistered ISR tasks, and
+*				  for tasks already queued, are discarded.
+* Notes			: Single consumer: only the scheduler may call this function.
+*				  In SMP mode the core draining the ring holds a lock, and any
+*				  other core skips the drain.
+*******************************************************************************/
+void _DrainISRRing_ROS
+		(
+			void
+		)
+{
+	/* Declare local copies of the ring indices */
+	uint8_t tail, head;
+
+#if (ENABLE_SMP_ROS)
+	/* Check if another core is already draining the ring */
+	if(_TryAcquireSpinLock_ROS(&gISRDrainLock_ROS) != TRUE_ROS)
+	{
+		/* Leave the posts to that core */
+		return;
+	}
+#endif
+
+	/* Take local copies of the ring indices, seeing every entry published
+	   up to the head */
+	tail = gISRRingTail_ROS;
+	head = LOAD_RING_INDEX_ROS(gISRRingHead_ROS);
+
+	/* Consume each posted entry */
+	while(tail != head)
+	{
+		/* Read the posted task id */
+		TaskID_ROS task_id = gISRRing_ROS[tail & ISR_RING_MASK_ROS];
+
+		/* Advance past the entry */
+		tail++;
+
+		/* Queue the task if it is an enabled ISR task not already queued */
+		if((task_id < gTaskTableSize_ROS) && gTaskISREnabledArray_ROS[task_id] && \
+		   !CLAIM_TASK_QUEUED_ROS(task_id))
+		{
+			SET_TASK_DEADLINE_ROS(task_id);
+			_LinkReadyTask_ROS(task_id);
+		}
+	}
+
+	/* Release the consumed entries back to the producer, once they are
+	   read */
+	STORE_RING_INDEX_ROS(gISRRingTail_ROS, tail);
+
+#if (ENABLE_SMP_ROS)
+	/* Let other cores drain */
+	RELEASE_LOCK_ROS(gISRDrainLock_ROS);
+#endif
+}
+/*******************************************************************************
+* End of _DrainISRRing_ROS
+*******************************************************************************/
+
+#if (ENABLE_EDF_SCHEDULER_ROS)
+/*******************************************************************************
+* Name			: _IsMoreUrgent_ROS
+* Description	: Checks if a queued task is more urgent than another in EDF
+*				  mode. A task's urgency is its static priority, less its
+*				  deadline scaled by PRIORITY_DEADLINE_SCALER, so that a task
+*				  nearer its deadline gains priority. Equally urgent tasks run
+*				  in the order they were queued.
+* Notes			: Both tasks must be queued. Elapsed time changes no task's
+*				  urgency relative to another, so the deadline heaps stay valid
+*				  as time passes, and overdue tasks keep their deadline order.
+*******************************************************************************/
+bool _IsMoreUrgent_ROS
+		(
+			/* Task id to check */
+			TaskID_ROS task_id, \
+			/* Task id to compare against */
+			TaskID_ROS other_id
+		)
+{
+	/* Calculate the difference in urgency, where a scaled tick of deadline
+	   is worth PRIORITY_DEADLINE_SCALER levels of priority */
+	int32_t difference = (int32_t)(PRIORITY_DEADLINE_SCALER * \
+								   (gTaskDeadlineArray_ROS[other_id] - \
+									gTaskDeadlineArray_ROS[task_id])) + \
+						 (int32_t)TASK_PRIORITY_ROS(task_id) - \
+						 (int32_t)TASK_PRIORITY_ROS(other_id);
+
+	/* Check if the urgency differs */
+	if(difference != 0)
+	{
+		return (difference > 0);
+	}
+	/* Equally urgent, the task queued first wins */
+	else
+	{
+		return ((int32_t)(gTaskQueueOrderArray_ROS[other_id] - \
+						  gTaskQueueOrderArray_ROS[task_id]) > 0);
+	}
+}
+/*******************************************************************************
+* End of _IsMoreUrgent_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _SiftDeadlineTask_ROS
+* Description	: Restores a core's deadline heap around a position, moving the
+*				  task there towards the root while it is more urgent than its
+*				  parent, else towards the leaves while a child is more urgent.
+* Notes			: Position must be within the heap.
+*******************************************************************************/
+void _SiftDeadlineTask_ROS
+		(
+			/* Core whose deadline heap to restore */
+			uint8_t core, \
+			/* Heap position of the task to move */
+			uint32_t position
+		)
+{
+	/* Declare heap variables */
+	TaskID_ROS * heap = gDeadlineHeapArray_ROS[core];
+	uint32_t size = gDeadlineHeapSizeArray_ROS[core];
+	TaskID_ROS task_id = heap[position];
+	uint32_t parent, child;
+
+	/* Move parents down while the task is more urgent */
+	while(position > 0u)
+	{
+		parent = (position - 1u) >> 1;
+		if(!_IsMoreUrgent_ROS(task_id, heap[parent]))
+		{
+			break;
+		}
+		heap[position] = heap[parent];
+		gDeadlineHeapIndexArray_ROS[heap[position]] = (TaskID_ROS)position;
+		position = parent;
+	}
+
+	/* Move children up while one is more urgent */
+	while((child = (position << 1) + 1u) < size)
+	{
+		/* Pick the more urgent child */
+		if(((child + 1u) < size) && \
+		   _IsMoreUrgent_ROS(heap[child + 1u], heap[child]))
+		{
+			child++;
+		}
+		if(!_IsMoreUrgent_ROS(heap[child], task_id))
+		{
+			break;
+		}
+		heap[position] = heap[child];
+		gDeadlineHeapIndexArray_ROS[heap[position]] = (TaskID_ROS)position;
+		position = child;
+	}
+
+	/* Settle the task at its position */
+	heap[position] = task_id;
+	gDeadlineHeapIndexArray_ROS[task_id] = (TaskID_ROS)position;
+}
+/*******************************************************************************
+* End of _SiftDeadlineTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _InsertDeadlineTask_ROS
+* Description	: Inserts a task ID into a core's deadline heap, and marks the
+*				  core's level 0 as ready.
+* Notes			: Insertion and removal take O(log n) comparisons, and dispatch
+*				  takes the heap root.
+*******************************************************************************/
+void _InsertDeadlineTask_ROS
+		(
+			/* Core whose deadline heap to insert into */
+			uint8_t core, \
+			/* Task id to insert */
+			TaskID_ROS task_id
+		)
+{
+	/* Stamp the queue order, for ties */
+	gTaskQueueOrderArray_ROS[task_id] = gTaskQueueCount_ROS++;
+
+	/* Append the task as a leaf, and move it up to its place */
+	gDeadlineHeapArray_ROS[core][gDeadlineHeapSizeArray_ROS[core]] = task_id;
+	_SiftDeadlineTask_ROS(core, gDeadlineHeapSizeArray_ROS[core]++);
+
+	/* Level 0 is now ready */
+	SET_LEVEL_READY_ROS(core, 0u);
+}
+/*******************************************************************************
+* End of _InsertDeadlineTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _RemoveDeadlineTask_ROS
+* Description	: Removes a task ID from a core's deadline heap, and clears the
+*				  core's level 0 ready bit if the heap becomes empty.
+* Notes			: Task must be in the core's deadline heap.
+*******************************************************************************/
+void _RemoveDeadlineTask_ROS
+		(
+			/* Core whose deadline heap to remove from */
+			uint8_t core, \
+			/* Task id to remove */
+			TaskID_ROS task_id
+		)
+{
+	/* Look up the task's position, and shrink the heap */
+	uint32_t position = gDeadlineHeapIndexArray_ROS[task_id];
+	uint32_t last = --gDeadlineHeapSizeArray_ROS[core];
+
+	/* Check if the task was not the last leaf */
+	if(position != last)
+	{
+		/* Move the last leaf into the gap, and restore the heap around it */
+		gDeadlineHeapArray_ROS[core][position] = \
+			gDeadlineHeapArray_ROS[core][last];
+		_SiftDeadlineTask_ROS(core, position);
+	}
+	/* Check if the heap is now empty */
+	else if(last == 0u)
+	{
+		/* Clear level 0's ready bit */
+		CLEAR_LEVEL_READY_ROS(core, 0u);
+	}
+}
+/*******************************************************************************
+* End of _RemoveDeadlineTask_ROS
+*******************************************************************************/
+#endif
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+/*******************************************************************************
+* Name			: _LockKernel_ROS
+* Description	: Takes the kernel lock, so the running task is not preempted
+*				  until the matching _UnlockKernel_ROS.
+* Notes			: Nestable. Used through KERNEL_CALL_ROS.
+*******************************************************************************/
+void _LockKernel_ROS
+		(
+			void
+		)
+{
+	/* Deepen the lock */
+	gKernelLockDepth_ROS++;
+}
+/*******************************************************************************
+* End of _LockKernel_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _UnlockKernel_ROS
+* Description	: Releases the kernel lock, and passes the specified result
+*				  through. On the outermost release in a task, the task is
+*				  preempted first if a higher level is ready, or a preemption
+*				  was left pending while the lock was held.
+* Notes			: Used through KERNEL_CALL_ROS.
+*******************************************************************************/
+uint8_t _UnlockKernel_ROS
+		(
+			/* Result of the locked kernel call */
+			uint8_t result
+		)
+{
+	/* Give way while a task is releasing the outermost lock, and a pending or
+	   higher level task needs the processor */
+	while((gKernelLockDepth_ROS == 1u) && \
+		  (RUNNING_TASK_ID_ROS != NULL_TASK_ROS) && \
+		  (gPreemptPending_ROS || ((gReadyPriorityBitmap_ROS[0] != 0u) && \
+		   (_HighestReadyLevel_ROS(0u, NUM_PRIORITY_LEVELS_ROS) > \
+			gRunningLevel_ROS))))
+	{
+		/* Suspend the task until the kernel resumes it, with the lock held */
+		gPreemptPending_ROS = false;
+		_SwitchToKernel_ROS();
+	}
+
+	/* Release the lock, and pass the result through */
+	gKernelLockDepth_ROS--;
+	return result;
+}
+/*******************************************************************************
+* End of _UnlockKernel_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _EnterKernelFromISR_ROS
+* Description	: Called by the port's interrupt handlers (such as the tick)
+*				  before they update the kernel tables. Returns true, with the
+*				  kernel lock taken, if the interrupted task was outside the
+*				  kernel. Otherwise returns false, and the preemption is left
+*				  pending for the kernel to serve.
+* Notes			: On true, the handler must finish with _ExitKernelFromISR_ROS.
+*******************************************************************************/
+uint8_t _EnterKernelFromISR_ROS
+		(
+			void
+		)
+{
+	/* Check if a task was interrupted outside the kernel */
+	if((RUNNING_TASK_ID_ROS != NULL_TASK_ROS) && (gKernelLockDepth_ROS == 0u))
+	{
+		/* Take the lock, and return true */
+		gKernelLockDepth_ROS = 1u;
+		return TRUE_ROS;
+	}
+	/* Kernel was interrupted */
+	else
+	{
+		/* Leave the preemption pending, and return false */
+		gPreemptPending_ROS = true;
+		return FALSE_ROS;
+	}
+}
+/*******************************************************************************
+* End of _EnterKernelFromISR_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _ExitKernelFromISR_ROS
+* Description	: Called by the port's interrupt handlers after updating the
+*				  kernel tables. Drains the ISR ring, and preempts the
+*				  interrupted task if a higher level task is now ready.
+* Notes			: Returns once the interrupted task is resumed.
+*******************************************************************************/
+void _ExitKernelFromISR_ROS
+		(
+			void
+		)
+{
+	/* Move tasks posted by interrupt handlers into the ready lists */
+	_DrainISRRing_ROS();
+
+	/* Release the lock, preempting the task if needed */
+	(void)_UnlockKernel_ROS(SUCCESS_ROS);
+}
+/*******************************************************************************
+* End of _ExitKernelFromISR_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _RunTaskContext_ROS
+* Description	: Switches from the kernel to the specified task's context, and
+*				  returns once the task completes or is preempted.
+* Notes			: The task is entered with the kernel lock held, which it
+*				  releases on entry or resume.
+*******************************************************************************/
+void _RunTaskContext_ROS
+		(
+			/* Task id to run */
+			TaskID_ROS task_id
+		)
+{
+	/* Hold the lock, so interrupts do not treat the kernel as the task */
+	gKernelLockDepth_ROS = 1u;
+	RUNNING_TASK_ID_ROS = task_id;
+
+	/* Run the task until it completes or is preempted */
+	_SwitchTaskContext_ROS(&gKernelContext_ROS, &gTaskContextArray_ROS[task_id]);
+
+	/* Back in the kernel */
+	RUNNING_TASK_ID_ROS = NULL_TASK_ROS;
+	gKernelLockDepth_ROS = 0u;
+}
+/*******************************************************************************
+* End of _RunTaskContext_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _SwitchToKernel_ROS
+* Description	: Preempts the running task. The task is recorded as preempted,
+*				  and the kernel resumed. Returns once the kernel resumes the
+*				  task.
+* Notes			: Kernel lock must be held.
+*******************************************************************************/
+void _SwitchToKernel_ROS
+		(
+			void
+		)
+{
+	/* Look up the running task */
+	TaskID_ROS task_id = RUNNING_TASK_ID_ROS;
+
+	/* Record the task as the most recently preempted */
+	gPreemptedTaskArray_ROS[gNumPreemptedTasks_ROS] = task_id;
+	gPreemptedLevelArray_ROS[gNumPreemptedTasks_ROS] = gRunningLevel_ROS;
+	gNumPreemptedTasks_ROS++;
+
+	/* Suspend the task until the kernel resumes it */
+	_SwitchTaskContext_ROS(&gTaskContextArray_ROS[task_id], &gKernelContext_ROS);
+}
+/*******************************************************************************
+* End of _SwitchToKernel_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _RunPreemptiveTask_ROS
+* Description	: Entry function of every task context. Runs the running task's
+*				  function and returns to the kernel, once per dispatch.
+* Notes			: Never returns. Each completed run waits in the kernel switch
+*				  below, so the next dispatch of the task resumes it there and
+*				  does not need to rebuild the context.
+*******************************************************************************/
+void _RunPreemptiveTask_ROS
+		(
+			void
+		)
+{
+	/* Run the task once per dispatch */
+	while(true)
+	{
+		/* Release the lock held by the kernel, giving way to any task made
+		   ready by a pending interrupt */
+		(void)_UnlockKernel_ROS(SUCCESS_ROS);
+
+		/* Run the task function */
+		TASK_POINTER_ROS(RUNNING_TASK_ID_ROS)();
+
+		/* Task completed, return to the kernel until the next dispatch */
+		_LockKernel_ROS();
+		_SwitchTaskContext_ROS(&gTaskContextArray_ROS[RUNNING_TASK_ID_ROS], \
+							   &gKernelContext_ROS);
+	}
+}
+/*******************************************************************************
+* End of _RunPreemptiveTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _DropPreemptedTask_ROS
+* Description	: Removes a task from the preempted tasks, keeping the order of
+*				  the others. Returns true if the task was preempted, otherwise
+*				  false. Its saved context is left as it is.
+* Notes			: Used by DispatchTask_ROS, to resume a preempted task that was
+*				  queued again, and when a task is destroyed.
+*******************************************************************************/
+uint8_t _DropPreemptedTask_ROS
+		(
+			/* Task id to drop */
+			TaskID_ROS task_id
+		)
+{
+	/* Declare preempted task walk variable */
+	uint8_t i;
+
+	/* Search the preempted tasks for the task */
+	for(i = 0u; i < gNumPreemptedTasks_ROS; i++)
+	{
+		/* Check if this entry holds the task */
+		if(gPreemptedTaskArray_ROS[i] == task_id)
+		{
+			/* Close the gap, and return true */
+			gNumPreemptedTasks_ROS--;
+			memmove(&gPreemptedTaskArray_ROS[i], &gPreemptedTaskArray_ROS[i + 1u], \
+					(gNumPreemptedTasks_ROS - i) * sizeof(TaskID_ROS));
+			memmove(&gPreemptedLevelArray_ROS[i], &gPreemptedLevelArray_ROS[i + 1u], \
+					gNumPreemptedTasks_ROS - i);
+			return TRUE_ROS;
+		}
+	}
+
+	/* Task is not preempted, return false */
+	return FALSE_ROS;
+}
+/*******************************************************************************
+* End of _DropPreemptedTask_ROS
+*******************************************************************************/
+#endif
+
+#if (ENABLE_SMP_ROS)
+/*******************************************************************************
+* Name			: _SelectTaskCore_ROS
+* Description	: Returns the core whose ready lists a task is queued on. The
+*				  calling core is used if the task's affinity mask allows it,
+*				  otherwise the lowest core the mask allows.
+* Notes			: Keeps a task on the core queuing it where possible, so idle
+*				  cores pick up the rest by stealing.
+*******************************************************************************/
+uint8_t _SelectTaskCore_ROS
+		(
+			/* Task id to place */
+			TaskID_ROS task_id
+		)
+{
+	/* Look up the calling core and the task's affinity mask */
+	uint8_t core = CURRENT_CORE_ROS();
+	uint8_t affinity = TASK_AFFINITY_ROS(task_id);
+
+	/* Check if the task may run on the calling core */
+	if((affinity == 0u) || (affinity & (1u << core)))
+	{
+		/* Queue task on the calling core */
+		return core;
+	}
+	/* Task is bound to other cores */
+	else
+	{
+		/* Find the lowest allowed core */
+		for(core = 0u; (affinity & (1u << core)) == 0u; core++)
+		{
+		}
+
+		/* Queue task on that core */
+		return core;
+	}
+}
+/*******************************************************************************
+* End of _SelectTaskCore_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _StealReadyTask_ROS
+* Description	: Pops a ready task from another core's ready lists for the
+*				  specified (idle) core to run, or returns NULL_TASK_ROS if no
+*				  other core has a task it may run.
+* Notes			: Victims are visited in order from the next core up, and a
+*				  victim whose ready lists are locked is passed over instead of
+*				  waited on, so stealing never blocks a busy core.
+*******************************************************************************/
+TaskID_ROS _StealReadyTask_ROS
+		(
+			/* Core looking for work */
+			uint8_t core
+		)
+{
+	/* Declare victim walk variables */
+	uint8_t offset;
+	uint8_t victim;
+	TaskID_ROS task_id = NULL_TASK_ROS;
+
+	/* Visit every other core */
+	for(offset = 1u; (offset < NUM_CORES_ROS) && \
+					 (task_id == NULL_TASK_ROS); offset++)
+	{
+		victim = (uint8_t)((core + offset) % NUM_CORES_ROS);
+
+		/* Check if the victim has ready tasks (an unlocked peek), and its
+		   lists are free */
+		if((__atomic_load_n(&gReadyPriorityBitmap_ROS[victim], \
+							__ATOMIC_RELAXED) != 0u) && \
+		   (_TryAcquireSpinLock_ROS(&gReadyLockArray_ROS[victim]) == TRUE_ROS))
+		{
+			/* Take the best task the calling core may run */
+			task_id = _PopReadyTask_ROS(victim);
+			RELEASE_LOCK_ROS(gReadyLockArray_ROS[victim]);
+		}
+	}
+
+	/* Return stolen task id */
+	return task_id;
+}
+/*******************************************************************************
+* End of _StealReadyTask_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _UnqueueLinkedTask_ROS
+* Description	: Unlinks a queued task ID from the ready lists of whichever core
+*				  holds it. Returns success, or F_TASK_NOT_QUEUED_ROS if the
+*				  task was dispatched or unqueued meanwhile.
+* Notes			: Retries if the task is still being linked, or moves between
+*				  the lookup of its core and the locking of that core.
+*******************************************************************************/
+uint8_t _UnqueueLinkedTask_ROS
+		(
+			/* Task id to unlink */
+			TaskID_ROS task_id
+		)
+{
+	/* Declare core lookup variable (core plus one, 0 = not linked) */
+	uint8_t queued_core;
+
+	/* Retry until the task is unlinked, or found not queued */
+	while(true)
+	{
+		queued_core = __atomic_load_n(&gTaskQueuedCoreArray_ROS[task_id], \
+									  __ATOMIC_ACQUIRE);
+
+		/* Check if the task is not linked */
+		if(queued_core == 0u)
+		{
+			/* Check if the task has left the ready lists */
+			if(!__atomic_load_n(&gTaskQueuedArray_ROS[task_id], \
+								__ATOMIC_ACQUIRE))
+			{
+				/* Task not queued, return failure */
+				return F_TASK_NOT_QUEUED_ROS;
+			}
+		}
+		/* Task linked, lock its core's ready lists */
+		else
+		{
+			ACQUIRE_LOCK_ROS(gReadyLockArray_ROS[queued_core - 1u]);
+
+			/* Check if the task is still linked on that core */
+			if(gTaskQueuedCoreArray_ROS[task_id] == queued_core)
+			{
+				/* Remove task from its ready list */
+				_UnlinkReadyTask_ROS(task_id);
+				RELEASE_LOCK_ROS(gReadyLockArray_ROS[queued_core - 1u]);
+
+				/* Task removed, return success */
+				return SUCCESS_ROS;
+			}
+
+			/* Task moved, unlock and retry */
+			RELEASE_LOCK_ROS(gReadyLockArray_ROS[queued_core - 1u]);
+		}
+	}
+}
+/*******************************************************************************
+* End of _UnqueueLinkedTask_ROS
+*******************************************************************************/
+
+#if !(ENABLE_PREEMPTIVE_KERNEL_ROS)
+/*******************************************************************************
+* Name			: _LockKernel_ROS
+* Description	: Takes the kernel lock, waiting while another core holds it, so
+*				  kernel calls from different cores do not interleave.
+* Notes			: Nestable on the owning core. Used through KERNEL_CALL_ROS.
+*******************************************************************************/
+void _LockKernel_ROS
+		(
+			void
+		)
+{
+	/* Look up the calling core, as an owner ID */
+	uint8_t owner = CURRENT_CORE_ROS() + 1u;
+
+	/* Check if the calling core does not hold the lock yet */
+	if(__atomic_load_n(&gKernelLockOwner_ROS, __ATOMIC_ACQUIRE) != owner)
+	{
+		/* Wait for the lock, and take ownership */
+		ACQUIRE_LOCK_ROS(gKernelLock_ROS);
+		__atomic_store_n(&gKernelLockOwner_ROS, owner, __ATOMIC_RELAXED);
+	}
+
+	/* Deepen the lock */
+	gKernelLockDepth_ROS++;
+}
+/*******************************************************************************
+* End of _LockKernel_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _UnlockKernel_ROS
+* Description	: Releases the kernel lock, and passes the specified result
+*				  through. The outermost release frees the lock for other
+*				  cores.
+* Notes			: Used through KERNEL_CALL_ROS.
+*******************************************************************************/
+uint8_t _UnlockKernel_ROS
+		(
+			/* Result of the locked kernel call */
+			uint8_t result
+		)
+{
+	/* Check if this is the outermost release */
+	if(--gKernelLockDepth_ROS == 0u)
+	{
+		/* Give up ownership, and free the lock */
+		__atomic_store_n(&gKernelLockOwner_ROS, 0u, __ATOMIC_RELAXED);
+		RELEASE_LOCK_ROS(gKernelLock_ROS);
+	}
+
+	/* Pass the result through */
+	return result;
+}
+/*******************************************************************************
+* End of _UnlockKernel_ROS
+*******************************************************************************/
+#endif
+#endif
+
+/*******************************************************************************
+* Name			: _MountSchedulerTables_ROS
+* Description	: Carves the scheduler's tables indexed by task ID from the task
+*				  table memory block, and empties the ready lists, timer wheel
+*				  and ISR ring (and the preempted tasks, in preemptive mode).
+* Notes			: Called by MountTaskTables_ROS, which clears the carved tables.
+*******************************************************************************/
+void _MountSchedulerTables_ROS
+		(
+			/* Number of entries per table, including the null task */
+			TaskID_ROS table_size
+		)
+{
+#if (ENABLE_EDF_SCHEDULER_ROS)
+	/* Declare core loop variable */
+	uint8_t core;
+#endif
+
+	/* Carve the ready list tables */
+	gReadyNextArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(TaskID_ROS));
+	gReadyPrevArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(TaskID_ROS));
+	gReadyLevelArray_ROS = _CarveTaskMemory_ROS(table_size);
+	gTaskQueuedArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(bool));
+#if (ENABLE_SMP_ROS)
+	gTaskQueuedCoreArray_ROS = _CarveTaskMemory_ROS(table_size);
+	gTaskRunningArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(bool));
+#endif
+
+	/* Carve the timer wheel and periodic task tables */
+	gTimerNextArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(TaskID_ROS));
+	gTimerPrevArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(TaskID_ROS));
+	gTimerSlotArray_ROS = _CarveTaskMemory_ROS(table_size);
+	gTaskPeriodArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(uint16_t));
+	gTaskReleaseTickArray_ROS = _CarveTaskMemory_ROS
+								(table_size * sizeof(uint32_t));
+	gTaskPeriodArmedArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(bool));
+	gTaskReleasePendingArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(bool));
+	gTaskMaxJitterArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(uint16_t));
+	gTaskOverrunArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(uint16_t));
+	gTaskWakeTickArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(uint32_t));
+
+	/* Carve the priority inheritance tables */
+	gTaskBasePriorityArray_ROS = _CarveTaskMemory_ROS(table_size);
+	gTaskInheritCountArray_ROS = _CarveTaskMemory_ROS(table_size);
+
+#if (ENABLE_COROUTINE_TASKS_ROS)
+	/* Carve the coroutine task tables */
+	gTaskCoroutineArray_ROS = _CarveTaskMemory_ROS
+							  (table_size * sizeof(TaskCoroutine_ROS));
+	gTaskResumeArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(uint16_t));
+#endif
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+	/* Carve the task contexts and stacks */
+	gTaskContextArray_ROS = _CarveTaskMemory_ROS
+							(table_size * sizeof(TaskContext_ROS));
+	gTaskStackArray_ROS = _CarveTaskMemory_ROS
+						  ((uint32_t)table_size * TASK_STACK_BYTES_ROS);
+#endif
+
+	/* Carve the ISR task tables */
+	gTaskISRArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(bool));
+	gTaskISREnabledArray_ROS = _CarveTaskMemory_ROS(table_size * sizeof(bool));
+
+#if (ENABLE_EDF_SCHEDULER_ROS)
+	/* Carve the deadline tables */
+	gTaskDeadlineArray_ROS = _CarveTaskMemory_ROS
+							 (table_size * sizeof(uint32_t));
+	gTaskDeadlineMissArray_ROS = _CarveTaskMemory_ROS
+								 (table_size * sizeof(uint16_t));
+
+	/* Carve the deadline heaps, and empty them */
+	for(core = 0u; core < NUM_CORES_ROS; core++)
+	{
+		gDeadlineHeapArray_ROS[core] = _CarveTaskMemory_ROS
+									   (table_size * sizeof(TaskID_ROS));
+		gDeadlineHeapSizeArray_ROS[core] = 0u;
+	}
+	gDeadlineHeapIndexArray_ROS = _CarveTaskMemory_ROS
+								  (table_size * sizeof(TaskID_ROS));
+	gTaskQueueOrderArray_ROS = _CarveTaskMemory_ROS
+							   (table_size * sizeof(uint32_t));
+#endif
+
+	/* Empty the ready lists and timer wheel */
+	memset(gReadyPriorityBitmap_ROS, 0x00, sizeof(gReadyPriorityBitmap_ROS));
+#if (ENABLE_FINE_PRIORITY_LEVELS_ROS)
+	memset(gReadyLevelBitmap_ROS, 0x00, sizeof(gReadyLevelBitmap_ROS));
+#endif
+	memset(gReadyHeadArray_ROS, NULL_TASK_ROS, sizeof(gReadyHeadArray_ROS));
+	memset(gReadyTailArray_ROS, NULL_TASK_ROS, sizeof(gReadyTailArray_ROS));
+	memset(gTimerWheelHeadArray_ROS, NULL_TASK_ROS, \
+		   sizeof(gTimerWheelHeadArray_ROS));
+
+	/* Discard any posts left in the ISR ring */
+	gISRRingTail_ROS = gISRRingHead_ROS;
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+	/* Forget preempted tasks, and record the kernel context */
+	gNumPreemptedTasks_ROS = 0u;
+	gPreemptPending_ROS = false;
+	_InitKernelContext_ROS(&gKernelContext_ROS);
+#endif
+}
+/*******************************************************************************
+* End of _MountSchedulerTables_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _DestroySchedulerTask_ROS
+* Description	: Removes a task being destroyed from the scheduler: unlinks it
+*				  from the ready lists, drops it from the preempted tasks in
+*				  preemptive mode, disarms its release or sleep timer, and
+*				  clears its per task scheduler tables, so the ID starts clean
+*				  when it is reused.
+* Notes			: Called by DestroyTask_ROS. Posts for the task still in the
+*				  ISR ring are discarded when the ring is drained.
+*******************************************************************************/
+void _DestroySchedulerTask_ROS
+		(
+			/* Task id being destroyed */
+			TaskID_ROS task_id
+		)
+{
+#if (ENABLE_SMP_ROS)
+	/* Remove task from the ready list of whichever core holds it */
+	(void)_UnqueueLinkedTask_ROS(task_id);
+#else
+	/* Remove task from its ready list, if it is queued */
+	if(gTaskQueuedArray_ROS[task_id])
+	{
+		_UnlinkReadyTask_ROS(task_id);
+	}
+#endif
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS)
+	/* Drop the task from the preempted tasks, abandoning its unfinished run,
+	   so the context is rebuilt when the ID is next dispatched */
+	if(_DropPreemptedTask_ROS(task_id) == TRUE_ROS)
+	{
+		gTaskContextArray_ROS[task_id] = 0;
+	}
+#endif
+
+	/* Stop any periodic release or sleep timer, and clear the period */
+	ACQUIRE_LOCK_ROS(gTimerLock_ROS);
+	if(gTaskPeriodArmedArray_ROS[task_id])
+	{
+		_DisarmTimer_ROS(task_id);
+	}
+	gTaskPeriodArray_ROS[task_id] = 0u;
+	gTaskReleasePendingArray_ROS[task_id] = false;
+	gTaskWakeTickArray_ROS[task_id] = 0u;
+	RELEASE_LOCK_ROS(gTimerLock_ROS);
+
+	/* Clear the task's ISR registration, so posts still in the ring are
+	   discarded */
+	gTaskISRArray_ROS[task_id] = false;
+	gTaskISREnabledArray_ROS[task_id] = false;
+
+	/* Clear release statistics and lent priorities */
+	gTaskMaxJitterArray_ROS[task_id] = 0u;
+	gTaskOverrunArray_ROS[task_id] = 0u;
+	gTaskInheritCountArray_ROS[task_id] = 0u;
+
+#if (ENABLE_COROUTINE_TASKS_ROS)
+	/* Forget any coroutine, and its resume point */
+	gTaskCoroutineArray_ROS[task_id] = 0;
+	gTaskResumeArray_ROS[task_id] = 0u;
+#endif
+
+#if (ENABLE_EDF_SCHEDULER_ROS)
+	/* Clear deadline statistics */
+	gTaskDeadlineMissArray_ROS[task_id] = 0u;
+#endif
+}
+/*******************************************************************************
+* End of _DestroySchedulerTask_ROS
+*******************************************************************************/
@@ -0,0 +1,586 @@
+/***************************************************************************************************
+* RataOS Task Scheduler
+* File 				: storage.c
+* Description   	: Message storage backends. Provides a page buffered flash / EEPROM backend, which
+*					  coalesces small writes into whole page programs and spreads erases across the
+*					  device's pages.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Authors			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Header Includes
+***************************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "storage.h"
+
+/***************************************************************************************************
+* Local Function Prototypes
+***************************************************************************************************/
+/* Backend functions, entered through MsgStorageBackend_ROS */
+uint8_t _FlashRead_ROS(void *, uint32_t, uint8_t *, uint32_t);
+uint8_t _FlashWrite_ROS(void *, uint32_t, const uint8_t *, uint32_t);
+uint8_t _FlashErase_ROS(void *, uint32_t, uint32_t);
+uint8_t _FlashFlush_ROS(void *);
+/* Write or erase a range of store bytes in the page buffers function */
+uint8_t _UpdateFlashPages_ROS(FlashBackend_ROS *, uint32_t, const uint8_t *, uint32_t);
+/* Load a logical page into a page buffer function */
+uint8_t _LoadFlashPage_ROS(FlashBackend_ROS *, uint16_t, uint8_t *);
+/* Program a page buffer into the least worn free page function */
+uint8_t _ProgramFlashPage_ROS(FlashBackend_ROS *, uint8_t);
+/* Little endian page header field access functions */
+uint32_t _GetFlashWord_ROS(const uint8_t *);
+void _PutFlashWord_ROS(uint8_t *, uint32_t);
+
+/***************************************************************************************************
+* Name			: InitFlashBackend_ROS
+* Type			: API function, storage system
+* Description	: This function sets up a page buffered backend on a flash / EEPROM device, and
+*				  outputs the backend functions to pass to MountMessageFileSystem_ROS. The device is
+*				  scanned to find the newest copy of each logical page, and each page's erase count.
+*				  Fails if the device page size or page count is out of range, or the device has too
+*				  few pages to hold store_bytes bytes with one page spare.
+* Notes			: The spare page is needed because a page is always rewritten to a different
+*				  physical page, so the old copy survives until the new one is programmed.
+***************************************************************************************************/
+uint8_t InitFlashBackend_ROS
+		(
+			/* Pointer to the backend state to set up */
+			FlashBackend_ROS * flash, \
+			/* Pointer to the device driver */
+			FlashDevice_ROS * device, \
+			/* Size of the message store held on the device, in bytes */
+			uint32_t store_bytes, \
+			/* Pointer to the backend functions to output */
+			MsgStorageBackend_ROS * backend
+		)
+{
+	/* Declare loop counters, and the sequence number of each logical page's newest copy */
+	uint16_t page;
+	uint8_t buffer;
+	uint32_t mapped_sequence[MAX_FLASH_PAGES_ROS];
+
+	/* Check if the page size leaves no room for data, or exceeds the page buffer */
+	if((device->page_bytes <= FLASH_PAGE_HEADER_BYTES_ROS) || \
+	   (device->page_bytes > MAX_FLASH_PAGE_BYTES_ROS) || \
+	   (device->num_pages > MAX_FLASH_PAGES_ROS))
+	{
+		/* Device geometry out of range, return failure */
+		return F_FLASH_GEOMETRY_INVALID_ROS;
+	}
+
+	/* Split the store into logical pages */
+	flash->device = device;
+	flash->payload_bytes = device->page_bytes - FLASH_PAGE_HEADER_BYTES_ROS;
+	flash->num_logical_pages = (uint16_t)((store_bytes + flash->payload_bytes - 1u) / \
+										  flash->payload_bytes);
+
+	/* Check if the store is empty, or there is no spare page */
+	if((flash->num_logical_pages == 0u) || (flash->num_logical_pages >= device->num_pages))
+	{
+		/* Device too small, return failure */
+		return F_FLASH_GEOMETRY_INVALID_ROS;
+	}
+
+	/* Start with nothing mapped and nothing buffered */
+	for(page = 0u; page < MAX_FLASH_PAGES_ROS; page++)
+	{
+		flash->page_map[page] = NULL_FLASH_PAGE_ROS;
+		flash->erase_counts[page] = 0u;
+		flash->page_in_use[page] = false;
+	}
+	flash->next_sequence = 0u;
+	for(buffer = 0u; buffer < NUM_FLASH_PAGE_BUFFERS_ROS; buffer++)
+	{
+		flash->buffered_pages[buffer] = NULL_FLASH_PAGE_ROS;
+		flash->buffer_dirty[buffer] = false;
+		flash->buffer_last_use[buffer] = 0u;
+	}
+	flash->buffer_uses = 0u;
+
+	/* Scan every physical page's header, read into the first page buffer */
+	for(page = 0u; page < device->num_pages; page++)
+	{
+		/* Declare header fields */
+		uint32_t sequence;
+		uint16_t logical_page;
+		uint8_t * header = flash->page_buffers[0];
+
+		/* Check if the page could not be read */
+		if(device->read_page(device->device, page, header) != SUCCESS_ROS)
+		{
+			/* Device failed, return failure */
+			return F_FLASH_DEVICE_FAILED_ROS;
+		}
+
+		/* Unpack the header */
+		sequence = _GetFlashWord_ROS(header);
+		logical_page = (uint16_t)(header[8] | (header[9] << 8));
+
+		/* Check if the page is erased, so holds nothing */
+		if(sequence == ERASED_FLASH_SEQUENCE_ROS)
+		{
+			continue;
+		}
+
+		/* The erase count survives in stale copies, so take it from every programmed page */
+		flash->erase_counts[page] = _GetFlashWord_ROS(header + 4u);
+
+		/* Keep the sequence number ahead of every page seen */
+		if(sequence >= flash->next_sequence)
+		{
+			flash->next_sequence = sequence + 1u;
+		}
+
+		/* Check if the page belongs to the store, and is the newest copy seen of its logical
+		   page */
+		if((logical_page < flash->num_logical_pages) && \
+		   ((flash->page_map[logical_page] == NULL_FLASH_PAGE_ROS) || \
+			(sequence > mapped_sequence[logical_page])))
+		{
+			/* Free the older copy, and map this one */
+			if(flash->page_map[logical_page] != NULL_FLASH_PAGE_ROS)
+			{
+				flash->page_in_use[flash->page_map[logical_page]] = false;
+			}
+			flash->page_map[logical_page] = page;
+			flash->page_in_use[page] = true;
+			mapped_sequence[logical_page] = sequence;
+		}
+	}
+
+	/* Output the backend functions */
+	backend->read = _FlashRead_ROS;
+	backend->write = _FlashWrite_ROS;
+	backend->erase = _FlashErase_ROS;
+	backend->flush = _FlashFlush_ROS;
+	backend->context = flash;
+
+	/* Backend ready, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of InitFlashBackend_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _FlashRead_ROS
+* Type			: Internal function, storage system
+* Description	: Backend read function. Copies store bytes out, through the page buffers. Bytes in
+*				  logical pages never written read as 0xFF.
+* Notes			: Loading a page may program the modified page it replaces first.
+***************************************************************************************************/
+uint8_t _FlashRead_ROS
+		(
+			/* Pointer to the backend state */
+			void * context, \
+			/* Store offset to read from */
+			uint32_t offset, \
+			/* Pointer to the destination */
+			uint8_t * data, \
+			/* Number of bytes to read */
+			uint32_t number_bytes
+		)
+{
+	/* Declare backend state, page buffer and page load result */
+	FlashBackend_ROS * flash = (FlashBackend_ROS *)context;
+	uint8_t buffer, result;
+
+	/* Check if the range runs past the end of the store */
+	if((offset + number_bytes) > ((uint32_t)flash->num_logical_pages * flash->payload_bytes))
+	{
+		/* Range invalid, return failure */
+		return F_FLASH_GEOMETRY_INVALID_ROS;
+	}
+
+	/* Copy out a page at a time */
+	while(number_bytes != 0u)
+	{
+		/* Find the page, and the part of the range inside it */
+		uint32_t within = offset % flash->payload_bytes;
+		uint32_t chunk = flash->payload_bytes - within;
+		chunk = (chunk < number_bytes) ? chunk : number_bytes;
+
+		/* Load the page, and check for failure */
+		result = _LoadFlashPage_ROS(flash, (uint16_t)(offset / flash->payload_bytes), &buffer);
+		if(result != SUCCESS_ROS)
+		{
+			return result;
+		}
+
+		/* Copy the bytes out, and move on */
+		memcpy(data, flash->page_buffers[buffer] + FLASH_PAGE_HEADER_BYTES_ROS + within, chunk);
+		data += chunk;
+		offset += chunk;
+		number_bytes -= chunk;
+	}
+
+	/* Range read, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _FlashRead_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _FlashWrite_ROS
+* Type			: Internal function, storage system
+* Description	: Backend write function. Writes store bytes into the page buffers, where writes to
+*				  the same page coalesce until its buffer is reused for another page or flushed.
+* Notes			: None
+***************************************************************************************************/
+uint8_t _FlashWrite_ROS
+		(
+			/* Pointer to the backend state */
+			void * context, \
+			/* Store offset to write to */
+			uint32_t offset, \
+			/* Pointer to the source */
+			const uint8_t * data, \
+			/* Number of bytes to write */
+			uint32_t number_bytes
+		)
+{
+	/* Write the range, and return the result */
+	return _UpdateFlashPages_ROS((FlashBackend_ROS *)context, offset, data, number_bytes);
+}
+/***************************************************************************************************
+* End of _FlashWrite_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _FlashErase_ROS
+* Type			: Internal function, storage system
+* Description	: Backend erase function. Sets store bytes to 0xFF in the page buffers, like a write.
+* Notes			: Physical pages are only erased when reused, by _ProgramFlashPage_ROS.
+***************************************************************************************************/
+uint8_t _FlashErase_ROS
+		(
+			/* Pointer to the backend state */
+			void * context, \
+			/* Store offset to erase from */
+			uint32_t offset, \
+			/* Number of bytes to erase */
+			uint32_t number_bytes
+		)
+{
+	/* Erase the range, and return the result */
+	return _UpdateFlashPages_ROS((FlashBackend_ROS *)context, offset, 0, number_bytes);
+}
+/***************************************************************************************************
+* End of _FlashErase_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _FlashFlush_ROS
+* Type			: Internal function, storage system
+* Description	: Backend flush function. Programs every page buffer holding unwritten changes.
+* Notes			: Stops at the first page that fails, leaving it and the rest buffered.
+***************************************************************************************************/
+uint8_t _FlashFlush_ROS
+		(
+			/* Pointer to the backend state */
+			void * context
+		)
+{
+	/* Declare backend state, and buffer loop counter */
+	FlashBackend_ROS * flash = (FlashBackend_ROS *)context;
+	uint8_t buffer;
+
+	/* Program each modified buffered page */
+	for(buffer = 0u; buffer < NUM_FLASH_PAGE_BUFFERS_ROS; buffer++)
+	{
+		/* Check if the page is modified, and could not be programmed */
+		if(flash->buffer_dirty[buffer] && (_ProgramFlashPage_ROS(flash, buffer) != SUCCESS_ROS))
+		{
+			/* Device failed, return failure */
+			return F_FLASH_DEVICE_FAILED_ROS;
+		}
+	}
+
+	/* Buffers match the device, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _FlashFlush_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _UpdateFlashPages_ROS
+* Type			: Internal function, storage system
+* Description	: This function copies a range of store bytes into the page buffers, or sets them to
+*				  0xFF if data is null. A buffer is only marked modified if a byte changes, so
+*				  rewriting unchanged data (as the defragmenter and mount erase often do) costs no
+*				  page program.
+* Notes			: None
+***************************************************************************************************/
+uint8_t _UpdateFlashPages_ROS
+		(
+			/* Pointer to the backend state */
+			FlashBackend_ROS * flash, \
+			/* Store offset to update from */
+			uint32_t offset, \
+			/* Pointer to the source (null = erase) */
+			const uint8_t * data, \
+			/* Number of bytes to update */
+			uint32_t number_bytes
+		)
+{
+	/* Declare page buffer and page load result */
+	uint8_t buffer, result;
+
+	/* Check if the range runs past the end of the store */
+	if((offset + number_bytes) > ((uint32_t)flash->num_logical_pages * flash->payload_bytes))
+	{
+		/* Range invalid, return failure */
+		return F_FLASH_GEOMETRY_INVALID_ROS;
+	}
+
+	/* Update a page at a time */
+	while(number_bytes != 0u)
+	{
+		/* Find the page, and the part of the range inside it */
+		uint32_t within = offset % flash->payload_bytes;
+		uint32_t chunk = flash->payload_bytes - within;
+		uint8_t * target;
+		uint32_t i;
+		chunk = (chunk < number_bytes) ? chunk : number_bytes;
+
+		/* Load the page, and check for failure */
+		result = _LoadFlashPage_ROS(flash, (uint16_t)(offset / flash->payload_bytes), &buffer);
+		if(result != SUCCESS_ROS)
+		{
+			return result;
+		}
+
+		/* Update the bytes that change */
+		target = flash->page_buffers[buffer] + FLASH_PAGE_HEADER_BYTES_ROS + within;
+		for(i = 0u; i < chunk; i++)
+		{
+			/* Find the byte's new value */
+			uint8_t value = (data != 0) ? data[i] : 0xFF;
+
+			/* Check if the byte changes */
+			if(target[i] != value)
+			{
+				target[i] = value;
+				flash->buffer_dirty[buffer] = true;
+			}
+		}
+
+		/* Move on */
+		if(data != 0)
+		{
+			data += chunk;
+		}
+		offset += chunk;
+		number_bytes -= chunk;
+	}
+
+	/* Range updated, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _UpdateFlashPages_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _LoadFlashPage_ROS
+* Type			: Internal function, storage system
+* Description	: This function brings a logical page into a page buffer, and outputs the buffer. A
+*				  page already buffered is used in place, otherwise the least recently used buffer
+*				  is reused, programming the page it holds first if it has been modified.
+* Notes			: Keeping several pages buffered lets writes that alternate between pages (such as
+*				  message data and its header record) coalesce.
+***************************************************************************************************/
+uint8_t _LoadFlashPage_ROS
+		(
+			/* Pointer to the backend state */
+			FlashBackend_ROS * flash, \
+			/* Logical page to load */
+			uint16_t logical_page, \
+			/* Pointer to variable that will store the page buffer holding the page */
+			uint8_t * buffer
+		)
+{
+	/* Declare buffer loop counter, and the buffer to reuse */
+	uint8_t i, oldest = 0u;
+
+	/* Search the buffers for the page, noting the least recently used */
+	for(i = 0u; i < NUM_FLASH_PAGE_BUFFERS_ROS; i++)
+	{
+		/* Check if the page is already buffered */
+		if(flash->buffered_pages[i] == logical_page)
+		{
+			/* Nothing to load, return success */
+			flash->buffer_last_use[i] = ++flash->buffer_uses;
+			*buffer = i;
+			return SUCCESS_ROS;
+		}
+		/* Check if the buffer was used less recently */
+		else if(flash->buffer_last_use[i] < flash->buffer_last_use[oldest])
+		{
+			oldest = i;
+		}
+	}
+
+	/* Check if the reused buffer's page is modified, and could not be programmed */
+	if(flash->buffer_dirty[oldest] && (_ProgramFlashPage_ROS(flash, oldest) != SUCCESS_ROS))
+	{
+		/* Device failed, return failure (the buffer is kept for a later flush) */
+		return F_FLASH_DEVICE_FAILED_ROS;
+	}
+
+	/* Check if the logical page has never been written */
+	if(flash->page_map[logical_page] == NULL_FLASH_PAGE_ROS)
+	{
+		/* Start from an erased page */
+		memset(flash->page_buffers[oldest], 0xFF, flash->device->page_bytes);
+	}
+	/* Check if the page could not be read */
+	else if(flash->device->read_page(flash->device->device, flash->page_map[logical_page], \
+									 flash->page_buffers[oldest]) != SUCCESS_ROS)
+	{
+		/* Buffer contents unknown, return failure */
+		flash->buffered_pages[oldest] = NULL_FLASH_PAGE_ROS;
+		return F_FLASH_DEVICE_FAILED_ROS;
+	}
+
+	/* Page loaded, return success */
+	flash->buffered_pages[oldest] = logical_page;
+	flash->buffer_last_use[oldest] = ++flash->buffer_uses;
+	*buffer = oldest;
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _LoadFlashPage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _ProgramFlashPage_ROS
+* Type			: Internal function, storage system
+* Description	: This function programs a page buffer into the free physical page with the
+*				  lowest erase count, then remaps the logical page to it and frees its old copy.
+*				  Spreading rewrites over every free page this way keeps erase counts level.
+* Notes			: The old copy is not erased, so a power failure part way through leaves it
+*				  readable. The header's sequence number tells the copies apart at the next scan.
+***************************************************************************************************/
+uint8_t _ProgramFlashPage_ROS
+		(
+			/* Pointer to the backend state */
+			FlashBackend_ROS * flash, \
+			/* Page buffer to program */
+			uint8_t buffer
+		)
+{
+	/* Declare loop counter, the chosen physical page, and the buffer's page and contents */
+	uint16_t page;
+	uint16_t target = NULL_FLASH_PAGE_ROS;
+	FlashDevice_ROS * device = flash->device;
+	uint16_t logical_page = flash->buffered_pages[buffer];
+	uint8_t * contents = flash->page_buffers[buffer];
+
+	/* Find the least worn free page */
+	for(page = 0u; page < device->num_pages; page++)
+	{
+		if(!flash->page_in_use[page] && \
+		   ((target == NULL_FLASH_PAGE_ROS) || \
+			(flash->erase_counts[page] < flash->erase_counts[target])))
+		{
+			target = page;
+		}
+	}
+
+	/* Stamp the header with the next sequence number, the target's erase count after erasing and
+	   the logical page */
+	_PutFlashWord_ROS(contents, flash->next_sequence);
+	_PutFlashWord_ROS(contents + 4u, flash->erase_counts[target] + 1u);
+	contents[8] = (uint8_t)logical_page;
+	contents[9] = (uint8_t)(logical_page >> 8);
+	contents[10] = 0xFF;
+	contents[11] = 0xFF;
+
+	/* Check if the target could not be erased */
+	if(device->erase_page(device->device, target) != SUCCESS_ROS)
+	{
+		return F_FLASH_DEVICE_FAILED_ROS;
+	}
+	flash->erase_counts[target]++;
+
+	/* Check if the target could not be programmed */
+	if(device->program_page(device->device, target, contents) != SUCCESS_ROS)
+	{
+		return F_FLASH_DEVICE_FAILED_ROS;
+	}
+
+	/* Free the old copy, and map the new one */
+	if(flash->page_map[logical_page] != NULL_FLASH_PAGE_ROS)
+	{
+		flash->page_in_use[flash->page_map[logical_page]] = false;
+	}
+	flash->page_map[logical_page] = target;
+	flash->page_in_use[target] = true;
+	flash->buffer_dirty[buffer] = false;
+
+	/* Advance the sequence number, skipping the value an erased header reads as */
+	flash->next_sequence++;
+	if(flash->next_sequence == ERASED_FLASH_SEQUENCE_ROS)
+	{
+		flash->next_sequence = 0u;
+	}
+
+	/* Page programmed, return success */
+	return SUCCESS_ROS;
+}
+/***************************************************************************************************
+* End of _ProgramFlashPage_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _GetFlashWord_ROS
+* Type			: Internal function, storage system
+* Description	: Returns the little endian 32 bit word at the specified header location.
+* Notes			: None
+***************************************************************************************************/
+uint32_t _GetFlashWord_ROS
+		(
+			/* Pointer to the word */
+			const uint8_t * location
+		)
+{
+	/* Assemble the word */
+	return (uint32_t)location[0] | ((uint32_t)location[1] << 8) | \
+		   ((uint32_t)location[2] << 16) | ((uint32_t)location[3] << 24);
+}
+/***************************************************************************************************
+* End of _GetFlashWord_ROS
+***************************************************************************************************/
+
+/***************************************************************************************************
+* Name			: _PutFlashWord_ROS
+* Type			: Internal function, storage system
+* Description	: Stores a 32 bit word, little endian, at the specified header location.
+* Notes			: None
+***************************************************************************************************/
+void _PutFlashWord_ROS
+		(
+			/* Pointer to the word */
+			uint8_t * location, \
+			/* Value to store */
+			uint32_t value
+		)
+{
+	/* Split the word into bytes */
+	location[0] = (uint8_t)value;
+	location[1] = (uint8_t)(value >> 8);
+	location[2] = (uint8_t)(value >> 16);
+	location[3] = (uint8_t)(value >> 24);
+}
+/***************************************************************************************************
+* End of _PutFlashWord_ROS
+***************************************************************************************************/
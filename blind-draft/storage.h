@@ -0,0 +1,96 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "messages.h"
+
+#ifndef STORAGE_H
+#define STORAGE_H
+
+
+/* System Parameters */
+
+/* Largest flash / EEPROM device the page buffered backend can manage, in pages, and its largest
+   page size in bytes (the size of the backend's page buffer) */
+#define MAX_FLASH_PAGES_ROS					64u
+#define MAX_FLASH_PAGE_BYTES_ROS			256u
+
+/* Number of page buffers. A message create writes its data and then its header record, which is
+   on another page and may straddle two, so three buffers let a run of creates coalesce */
+#ifndef NUM_FLASH_PAGE_BUFFERS_ROS
+#define NUM_FLASH_PAGE_BUFFERS_ROS			3u
+#endif
+
+
+/* Misc */
+
+/* Each programmed page starts with a header: sequence number (4 bytes), erase count (4 bytes) and
+   logical page number (2 bytes), little endian, then 2 bytes of padding */
+#define FLASH_PAGE_HEADER_BYTES_ROS			12u
+#define NULL_FLASH_PAGE_ROS					0xFFFFu
+#define ERASED_FLASH_SEQUENCE_ROS			0xFFFFFFFFul
+
+
+/* Error Return Codes */
+
+#define F_FLASH_GEOMETRY_INVALID_ROS		0x54
+#define F_FLASH_DEVICE_FAILED_ROS			0x55
+
+/* Flash / EEPROM device driver, page granular. Each function returns SUCCESS_ROS or an error code */
+typedef struct
+{
+	/* Read a whole page (device, page, destination) */
+	uint8_t (*read_page)(void *, uint16_t, uint8_t *);
+	/* Program a whole erased page (device, page, source) */
+	uint8_t (*program_page)(void *, uint16_t, const uint8_t *);
+	/* Erase a page to 0xFF (device, page) */
+	uint8_t (*erase_page)(void *, uint16_t);
+	/* Driver state, passed to each function */
+	void * device;
+	/* Page size in bytes, including the page header */
+	uint32_t page_bytes;
+	/* Number of pages */
+	uint16_t num_pages;
+} FlashDevice_ROS;
+
+/* Page buffered flash / EEPROM backend state. Store offsets are split into logical pages, each held
+   in whichever physical page was programmed with it last, so rewriting a page moves it to a fresh
+   (least worn) physical page instead of erasing it in place */
+typedef struct
+{
+	/* Device driver */
+	FlashDevice_ROS * device;
+	/* Number of logical pages, and the store bytes held by each */
+	uint16_t num_logical_pages;
+	uint32_t payload_bytes;
+	/* Physical page holding each logical page (NULL_FLASH_PAGE_ROS = never written) */
+	uint16_t page_map[MAX_FLASH_PAGES_ROS];
+	/* Number of times each physical page has been erased */
+	uint32_t erase_counts[MAX_FLASH_PAGES_ROS];
+	/* Status of each physical page holding a mapped logical page */
+	bool page_in_use[MAX_FLASH_PAGES_ROS];
+	/* Sequence number for the next page programmed */
+	uint32_t next_sequence;
+	/* Logical page held in each page buffer (NULL_FLASH_PAGE_ROS = none), its modified status, and
+	   when it was last used */
+	uint16_t buffered_pages[NUM_FLASH_PAGE_BUFFERS_ROS];
+	bool buffer_dirty[NUM_FLASH_PAGE_BUFFERS_ROS];
+	uint32_t buffer_last_use[NUM_FLASH_PAGE_BUFFERS_ROS];
+	/* Use count, advanced each time a page buffer is used */
+	uint32_t buffer_uses;
+	/* Page buffers, each laid out as a physical page (header then payload) */
+	uint8_t page_buffers[NUM_FLASH_PAGE_BUFFERS_ROS][MAX_FLASH_PAGE_BYTES_ROS];
+} FlashBackend_ROS;
+
+/* File backed simulated flash device (host port). Pages are stored back to back in the file, and
+   programming only clears bits, as on NOR flash */
+typedef struct
+{
+	/* Device driver, whose device state points back to this structure */
+	FlashDevice_ROS driver;
+	/* File descriptor of the backing file */
+	int file;
+} FileFlashDevice_ROS;
+
+uint8_t InitFlashBackend_ROS(FlashBackend_ROS *, FlashDevice_ROS *, uint32_t, MsgStorageBackend_ROS *);
+uint8_t OpenFileFlashDevice_ROS(const char *, uint32_t, uint16_t, FileFlashDevice_ROS *);
+uint8_t CloseFileFlashDevice_ROS(FileFlashDevice_ROS *);
+#endif
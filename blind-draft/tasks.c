@@ -10,16 +10,13 @@
 *******************************************************************************/
 
 #include <string.h>
-#include <type.h>
+#include <ctype.h>
+#include "tasks.h"
 
 /* System Parameters */
-#define MAX_TASKS_ROS					16u
-#define MAX_TASK_VECTOR_ROS				250u
 #define MIN_TASK_VECTOR_ROS				5u
-#define MAX_TASK_INFO_ROS				10u
 #define MIN_TASK_INFO_ROS				3u
 #define MIN_TASK_TIMEOUT_ROS			5u
-#define MAX_TASK_TIMEOUT_ROS			200u
 #define INTIAL_NUMBER_TASKS_ROS			0u
 
 /* API Control Parameters */
@@ -43,6 +40,10 @@
 #define F_TASK_PROTECTED_ROS			0x0A
 #define F_TASK_VECTOR_TOO_HIGH			0x0B
 #define F_TASK_VECTOR_TOO_LOW			0x0C
+#define F_TASK_MEM_TOO_SMALL_ROS		0x0D
+#define F_TASK_CAPACITY_INVALID_ROS		0x0E
+#define F_MAX_TASKS_REACHED_ROS			0x0F
+#define F_OS_RUNNING_ROS				0x64
 
 /* Import global operating system status */
 extern uint8_t gOperatingSystemStatus_ROS;
@@ -50,29 +51,210 @@ extern uint8_t gOperatingSystemStatus_ROS;
 /* Global variable to contain current number of tasks */
 uint8_t gNumberGlobalTasks = INTIAL_NUMBER_TASKS_ROS;
 
-/* Array to hold task vector ID lookup table */
-uint8_t gTaskVectorLookupArray_ROS[MAX_TASK_VECTOR_ROS];
+/* Number of entries in each task table (maximum tasks plus the null task), zero
+   until the task tables are mounted */
+TaskID_ROS gTaskTableSize_ROS = 0u;
 
-/* Array to hold pointers to task functions and their task vector */
-void *gTaskPointerArray_RS[MAX_TASKS_ROS];
+/* Number of entries in the task vector lookup table */
+TaskID_ROS gTaskVectorTableSize_ROS = 0u;
 
-/* Array to hold task vector priorities */
-uint8_t gTaskPriorityArray_ROS[MAX_TASKS_ROS];
+/* Next unused byte of the task table memory block */
+uint8_t * gTaskMemCursor_ROS;
 
-/* Array to hold task timeout durations */
-uint32_t gTaskTimeoutArray_ROS[MAX_TASKS_ROS];
+/* Number of bytes of the task table memory block carved so far */
+uint32_t gTaskMemUsed_ROS = 0u;
 
-/* Array to hold task descriptions */
-uint8_t gTaskInfoArray_ROS[MAX_TASKS_ROS][MAX_TASK_INFO_ROS];
+/* Task vector ID lookup table, carved from the task table memory block */
+TaskID_ROS * gTaskVectorLookupArray_ROS;
 
-/* Array to hold task sleep status */
-uint8_t gTaskSleepStatusArray_ROS[MAX_TASKS_ROS];
+#if (ENABLE_PACKED_TCB_ROS)
+/* Hot task control blocks (fields read on every dispatch) */
+TaskHotTCB_ROS * gTaskHotArray_ROS;
 
-/* Array to hold task protected status */
-bool gTaskProtectionArray_ROS[MAX_TASKS_ROS];
+/* Cold task control blocks (descriptions and protection) */
+TaskColdTCB_ROS * gTaskColdArray_ROS;
+#else
+/* Pointers to task functions */
+void (**gTaskPointerArray_ROS)(void);
 
-/* Next free task ID location */
-uint8_t gTaskIDStack_ROS;
+/* Task priorities */
+uint8_t * gTaskPriorityArray_ROS;
+
+#if (ENABLE_SMP_ROS)
+/* Task affinity masks */
+uint8_t * gTaskAffinityArray_ROS;
+#endif
+
+/* Task timeout durations */
+uint32_t * gTaskTimeoutArray_ROS;
+
+/* Task descriptions */
+uint8_t (*gTaskInfoArray_ROS)[MAX_TASK_INFO_ROS];
+
+/* Task sleep status */
+uint8_t * gTaskSleepStatusArray_ROS;
+
+/* Task vector of each task (reverse of the vector lookup table) */
+TaskID_ROS * gTaskVectorArray_ROS;
+
+/* Task protected status */
+uint8_t * gTaskProtectionArray_ROS;
+#endif
+
+/* Next free task ID location (ID 0 is reserved as the null task) */
+TaskID_ROS gTaskIDStack_ROS = 1u;
+
+/* IDs of destroyed tasks, free for reuse (a stack, most recently freed last),
+   carved from the task table memory block */
+TaskID_ROS * gTaskFreeIDArray_ROS;
+
+/* Number of IDs on the free ID stack */
+TaskID_ROS gNumFreeTaskIDs_ROS = 0u;
+
+/* Local function prototypes */
+uint8_t _IsTaskVectorValid_ROS(TaskID_ROS);
+uint8_t _IsTaskTimeoutValid_ROS(uint32_t);
+uint8_t _IsTaskUnprotected_ROS(TaskID_ROS);
+
+/*******************************************************************************
+* Name			: MountTaskTables_ROS
+* Description	: Carves the task tables for max_tasks tasks and max_task_vectors
+*				  task vectors (including the scheduler's per task tables) from
+*				  the memory block passed, and clears them. Must be called at
+*				  boot, before any task is created. If the block is too small,
+*				  the number of bytes needed is output and nothing is mounted.
+* Notes			: The block should be aligned to a pointer boundary.
+*******************************************************************************/
+uint8_t MountTaskTables_ROS
+		(
+			/* Pointer to the start of the task table memory block */
+			uint8_t * start_pointer, \
+			/* Size of the memory block, in bytes */
+			uint32_t block_size, \
+			/* Maximum number of tasks */
+			TaskID_ROS max_tasks, \
+			/* Number of task vectors (highest vector plus one) */
+			TaskID_ROS max_task_vectors, \
+			/* Pointer to variable that will store the number of bytes used */
+			uint32_t * required_size
+		)
+{
+	/* Check if the requested capacities can be addressed by a task ID (the
+	   null task takes one ID) */
+	if((max_tasks == 0u) || (max_tasks >= MAX_TASK_ID_ROS) || \
+	   (max_task_vectors <= MIN_TASK_VECTOR_ROS))
+	{
+		/* Capacity out of range, return failure */
+		return F_TASK_CAPACITY_INVALID_ROS;
+	}
+	/* Capacity is valid, carve the tables */
+	else
+	{
+		/* Declare table entry count, including the null task */
+		TaskID_ROS table_size = max_tasks + 1u;
+
+		/* Unmount any previous tables while carving */
+		gTaskTableSize_ROS = 0u;
+		gTaskVectorTableSize_ROS = 0u;
+
+		/* Start carving at the beginning of the block */
+		gTaskMemCursor_ROS = start_pointer;
+		gTaskMemUsed_ROS = 0u;
+
+		/* Carve the task vector lookup table */
+		gTaskVectorLookupArray_ROS = _CarveTaskMemory_ROS
+									 (max_task_vectors * sizeof(TaskID_ROS));
+
+#if (ENABLE_PACKED_TCB_ROS)
+		/* Carve the hot and cold task control blocks */
+		gTaskHotArray_ROS = _CarveTaskMemory_ROS
+							(table_size * sizeof(TaskHotTCB_ROS));
+		gTaskColdArray_ROS = _CarveTaskMemory_ROS
+							 (table_size * sizeof(TaskColdTCB_ROS));
+#else
+		/* Carve one table per task field */
+		gTaskPointerArray_ROS = _CarveTaskMemory_ROS
+								(table_size * sizeof(void (*)(void)));
+		gTaskPriorityArray_ROS = _CarveTaskMemory_ROS(table_size);
+#if (ENABLE_SMP_ROS)
+		gTaskAffinityArray_ROS = _CarveTaskMemory_ROS(table_size);
+#endif
+		gTaskTimeoutArray_ROS = _CarveTaskMemory_ROS
+								(table_size * sizeof(uint32_t));
+		gTaskInfoArray_ROS = _CarveTaskMemory_ROS
+							 (table_size * MAX_TASK_INFO_ROS);
+		gTaskSleepStatusArray_ROS = _CarveTaskMemory_ROS(table_size);
+		gTaskVectorArray_ROS = _CarveTaskMemory_ROS
+							   (table_size * sizeof(TaskID_ROS));
+		gTaskProtectionArray_ROS = _CarveTaskMemory_ROS(table_size);
+#endif
+
+		/* Carve the free task ID stack */
+		gTaskFreeIDArray_ROS = _CarveTaskMemory_ROS
+							   (table_size * sizeof(TaskID_ROS));
+
+		/* Carve the scheduler's per task tables */
+		_MountSchedulerTables_ROS(table_size);
+
+		/* Output the number of bytes the tables need */
+		*required_size = gTaskMemUsed_ROS;
+
+		/* Check if the tables overran the block */
+		if(gTaskMemUsed_ROS > block_size)
+		{
+			/* Block too small, tables stay unmounted. Return failure */
+			return F_TASK_MEM_TOO_SMALL_ROS;
+		}
+		/* Tables fit in the block */
+		else
+		{
+			/* Clear the tables (null task IDs, empty lists) */
+			memset(start_pointer, 0x00, gTaskMemUsed_ROS);
+
+			/* Reset the task ID allocator, and publish the table sizes */
+			gTaskIDStack_ROS = 1u;
+			gNumFreeTaskIDs_ROS = 0u;
+			gTaskTableSize_ROS = table_size;
+			gTaskVectorTableSize_ROS = max_task_vectors;
+
+			/* Task tables mounted, return success */
+			return SUCCESS_ROS;
+		}
+	}
+}
+/*******************************************************************************
+* End of MountTaskTables_ROS
+*******************************************************************************/
+
+/*******************************************************************************
+* Name			: _CarveTaskMemory_ROS
+* Description	: Returns the next size bytes of the task table memory block,
+*				  rounded up to a pointer boundary, and advances the cursor.
+* Notes			: Does not check the block size or touch the memory, so that
+*				  MountTaskTables_ROS can measure the total before clearing.
+*******************************************************************************/
+void * _CarveTaskMemory_ROS
+		(
+			/* Number of bytes to carve */
+			uint32_t size
+		)
+{
+	/* Take the current cursor as the carved table */
+	void * table = gTaskMemCursor_ROS;
+
+	/* Round the size up to a pointer boundary, so every table is aligned */
+	size = (size + (sizeof(void *) - 1u)) & ~(uint32_t)(sizeof(void *) - 1u);
+
+	/* Advance the cursor and used byte count */
+	gTaskMemCursor_ROS += size;
+	gTaskMemUsed_ROS += size;
+
+	/* Return carved table */
+	return table;
+}
+/*******************************************************************************
+* End of _CarveTaskMemory_ROS
+*******************************************************************************/
 
 /*******************************************************************************
 * Name			: CreateTask_ROS
@@ -83,13 +265,13 @@ uint8_t gTaskIDStack_ROS;
 uint8_t CreateTask_ROS
 	 	( 
 	 		/* Vector to create task entry in */
-	 		uint8_t task_vector, \
+	 		TaskID_ROS task_vector, \
 	 		/* Created task priority level */
 	 		uint8_t task_priority, \
 	 		/* Created task timeout duration, in clock ticks */
 	 		uint32_t task_timeout, \
 	 		/* Created task sleep status */
-	 		bool task_sleep_enable \
+	 		bool task_sleep_enable, \
 			/* Pointer to created task description string */
 	 		uint8_t * task_description, \
 	 		/* Pointer to task function */
@@ -105,8 +287,14 @@ uint8_t CreateTask_ROS
 	/* Check if timeout value is valid */
 	is_timeout_valid = _IsTaskTimeoutValid_ROS(task_timeout);
 	
+	/* Check if every task ID is in use, with none freed for reuse */
+	if((gNumFreeTaskIDs_ROS == 0u) && (gTaskIDStack_ROS >= gTaskTableSize_ROS))
+	{
+		/* Task tables full (or not mounted), return failure */
+		return F_MAX_TASKS_REACHED_ROS;
+	}
 	/* Check if task empty check returned false */
-	if(is_task_empty == FALSE_ROS)
+	else if(is_task_empty == FALSE_ROS)
 	{
 		/* Task occupied, return task vector occupied failure */
 		return F_TASK_VECTOR_OCCUPIED_ROS;	
@@ -128,17 +316,15 @@ uint8_t CreateTask_ROS
 	{
 		/* Define task description length container variable, loop variable and
 		   task id variable */
-		uint8_t description_length = 0x00, i, task_id = gTaskIDStack_ROS;
-
-		/* Store task id in vector lookup table */
-		gTaskVectorLookupArray_ROS[task_vector] = task_id;
+		uint8_t description_length = 0x00, i;
+		TaskID_ROS task_id;
 
 		/* Loop through all characters in task description, to calculate actual
 		   length of description */
 		for(i = 0x00; i != MAX_TASK_INFO_ROS; i++)
 		{
 			/* Check if location is a printable character */
-			if(!iscntrl(task_description[i])
+			if(!iscntrl(task_description[i]))
 			{	
 				/* Location is a printable character, increment description
 				   length counter */
@@ -161,25 +347,44 @@ uint8_t CreateTask_ROS
 		/* Task description meets requirements */
 		else
 		{
+			/* Check if a destroyed task's ID is free for reuse */
+			if(gNumFreeTaskIDs_ROS > 0u)
+			{
+				/* Take the most recently freed ID */
+				task_id = gTaskFreeIDArray_ROS[--gNumFreeTaskIDs_ROS];
+			}
+			/* No ID freed */
+			else
+			{
+				/* Take the next never used ID */
+				task_id = gTaskIDStack_ROS++;
+			}
+
+			/* Store task id in vector lookup table */
+			gTaskVectorLookupArray_ROS[task_vector] = task_id;
+
 			/* Store task pointer in task array */
-			gTaskPointerArray_ROS[task_id] = task_pointer;
+			TASK_POINTER_ROS(task_id) = task_pointer;
+
+			/* Store task vector, so a running task can find its vector */
+			TASK_VECTOR_ROS(task_id) = task_vector;
 
 			/* Store task priority in task priority array */
-			gTaskPriorityArray_ROS[task_id] = task_priority;
+			TASK_PRIORITY_ROS(task_id) = task_priority;
 
 			/* Store task timeout length (in tick cycles) */
-			gTaskTimeoutArray_ROS[task_id] = task_timeout;
+			TASK_TIMEOUT_ROS(task_id) = task_timeout;
 			
 			/* Store task description in task info array */
-			strncpy(gTaskInfoArray_ROS[task_id], task_description, \
+			strncpy((char *)TASK_INFO_ROS(task_id), (char *)task_description, \
 			                           description_length);
 
 			/* Store task sleep enable status in sleep status array */
-			gTaskSleepStatusArray_ROS[task_id] = task_sleep_enable;
+			TASK_SLEEP_ROS(task_id) = task_sleep_enable;
 
 			/* Set task protection to disabled (default behaviour) */
-			gTaskProtectionArray_ROS[task_id] = TASK_PROTECTION_DISABLE_ROS;
-			
+			TASK_PROTECTION_ROS(task_id) = TASK_PROTECTION_DISABLE_ROS;
+
 			/* Task creation complete, return success */
 			return SUCCESS_ROS;
 		}
@@ -193,12 +398,14 @@ uint8_t CreateTask_ROS
 * Name			: DestroyTask_ROS
 * Description	: Destroys the task entry at the specified task vector. If the
 *				  task vector was already empty, the function returns false.
-* Notes			: Task entry is destroyed, but function definition remains.
+* Notes			: Task entry is destroyed, but function definition remains. A
+*				  queued task is removed from its ready list, and its ID is
+*				  freed for reuse by the next task created.
 *******************************************************************************/
 uint8_t DestroyTask_ROS
 		(
 			/* Vector of task to destroy */
-			uint8_t task_vector
+			TaskID_ROS task_vector
 		)
 {
 	/* Declare local variables to store validation results */
@@ -208,13 +415,13 @@ uint8_t DestroyTask_ROS
 	is_task_unprotected = _IsTaskUnprotected_ROS(task_vector);
 	
 	/* Check if task is protected */
-	if(is_task_unprotected == TRUE_ROS)
+	if(is_task_unprotected == FALSE_ROS)
 	{
 		/* Task is protected, return failure */
 		return F_TASK_PROTECTED_ROS;
 	}
-	/* Proceed to destroy task */
-	else if (is_task_unprotected != FALSE_ROS)
+	/* Check if task vector is empty or invalid */
+	else if (is_task_unprotected != TRUE_ROS)
 	{
 		/* Task empty or task vector invalid, return failure */
 		return is_task_unprotected;
@@ -223,29 +430,40 @@ uint8_t DestroyTask_ROS
 	else
 	{
 		/* Declare loop counter and task id variables */
-		uint8_t i, task_id = gTaskVectorLookupArray_ROS(task_vector);
+		uint8_t i;
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
+
+		/* Remove task from the scheduler (ready lists and per task tables),
+		   so it is never dispatched once destroyed */
+		_DestroySchedulerTask_ROS(task_id);
 		
 		/* Delete task vector lookup table ID entry */
-		gTaskVectorLookupArray_ROS(task_vector) = NULL_TASK_ROS;
+		gTaskVectorLookupArray_ROS[task_vector] = NULL_TASK_ROS;
 		
 		/* Delete task pointer */
-		gTaskPointerArray_ROS[task_id];
+		TASK_POINTER_ROS(task_id) = NULL_POINTER_ROS;
+
+		/* Delete task vector */
+		TASK_VECTOR_ROS(task_id) = 0u;
 		
 		/* Delete task priority */
-		gTaskPriority_ROS[task_id];
+		TASK_PRIORITY_ROS(task_id) = 0u;
 
 		/* Delete task timeout length */
-		gTaskTimeoutArray_ROS[task_id];
+		TASK_TIMEOUT_ROS(task_id) = 0u;
 
 		/* Delete task sleep status */
-		gTaskSleepStatusArray_ROS[task_id] = 
+		TASK_SLEEP_ROS(task_id) = false;
 		
 		/* Delete task description */
 		for(i = 0u; i != MAX_TASK_INFO_ROS; i++)
 		{
 			/* Replace task description character with null */
-			gTaskInfoArray_ROS[task_id][i] = NULL_CHARACTER_ROS;
+			TASK_INFO_ROS(task_id)[i] = NULL_CHARACTER_ROS;
 		}
+
+		/* Push task ID onto the free ID stack, for reuse by CreateTask_ROS */
+		gTaskFreeIDArray_ROS[gNumFreeTaskIDs_ROS++] = task_id;
 
 		/* Task destruction complete, return success */
 		return SUCCESS_ROS;
@@ -265,7 +483,7 @@ uint8_t DestroyTask_ROS
 uint8_t ProtectTask_ROS
 		(
 			/* Vector of task to protect */
-			uint8_t task_vector, \
+			TaskID_ROS task_vector, \
 			/* Enable or disable task protection (true = enable) */
 			bool enable_protection
 		)
@@ -295,7 +513,8 @@ uint8_t ProtectTask_ROS
 	else if(enable_protection)
 	{
 		/* Enable task protection for this task vector */
-		gTaskProtectionArray_ROS = TASK_PROTECTION_ENABLE_ROS;
+		TASK_PROTECTION_ROS(gTaskVectorLookupArray_ROS[task_vector]) = \
+												TASK_PROTECTION_ENABLE_ROS;
 		
 		/* Task protection configuration complete, return success */
 		return SUCCESS_ROS;
@@ -304,7 +523,8 @@ uint8_t ProtectTask_ROS
 	else
 	{
 		/* Disable task protection for this task vector */
-		gTaskProtectionArray_ROS = TASK_PROTECTION_DISABLE_ROS;
+		TASK_PROTECTION_ROS(gTaskVectorLookupArray_ROS[task_vector]) = \
+												TASK_PROTECTION_DISABLE_ROS;
 		
 		/* Task protection configuration complete, return success */
 		return SUCCESS_ROS;
@@ -324,22 +544,22 @@ uint8_t ProtectTask_ROS
 uint8_t ControlSleepTask_ROS
 		(
 			/* Vector of task to control sleep status */
-			uint8_t task_vector, \
+			TaskID_ROS task_vector, \
 			/* Control task sleep status (true = enable) */
-			bool task_sleep_enable,		
+			bool task_sleep_enable
 		)
 {
 	/* Check if task is protected, and store result in container variable */
 	uint8_t is_task_unprotected = _IsTaskUnprotected_ROS(task_vector);
 	
 	/* Check if task is protected */
-	if(is_task_unprotected = FALSE_ROS)
+	if(is_task_unprotected == FALSE_ROS)
 	{
 		/* Task is protected, return failure */
 		return F_TASK_PROTECTED_ROS;
 	}
 	/* Check if task vector is valid */
-	if(is_task_unprotected != TRUE_ROS)
+	else if(is_task_unprotected != TRUE_ROS)
 	{
 		/* Task vector invalid, return failure */
 		return is_task_unprotected;
@@ -348,7 +568,7 @@ uint8_t ControlSleepTask_ROS
 	else if(task_sleep_enable)
 	{
 		/* Enable task sleep for this task vector */
-		gTaskSleepStatusArray_ROS[task_vector] = TASK_SLEEP_ENABLE_ROS;
+		TASK_SLEEP_ROS(gTaskVectorLookupArray_ROS[task_vector]) = true;
 		
 		/* Sleep control complete, return success */
 		return SUCCESS_ROS;
@@ -357,7 +577,7 @@ uint8_t ControlSleepTask_ROS
 	else
 	{
 		/* Disable task sleep for this task vector */
-		gTaskSleepStqatusArray_ROS[task_vector] = TASK_SLEEP_DISABLE_ROS;
+		TASK_SLEEP_ROS(gTaskVectorLookupArray_ROS[task_vector]) = false;
 		
 		/* Sleep control complete, return success */
 		return SUCCESS_ROS;
@@ -376,11 +596,12 @@ uint8_t ControlSleepTask_ROS
 uint8_t _IsTaskVectorValid_ROS
 	 	(
 	 		/* Task vector to check */
-	 		uint8_t task_vector
+	 		TaskID_ROS task_vector
 		)
 {
-	/* Check if requested task vector exceeds maximum */
-	if(task_vector > MAX_TASKS_ROS)
+	/* Check if requested task vector exceeds the mounted vector table (nothing
+	   is valid before the task tables are mounted) */
+	if(task_vector >= gTaskVectorTableSize_ROS)
 	{
 		/* Task vector exceeds maximum, return vector too high */
 		return F_TASK_VECTOR_TOO_HIGH;
@@ -413,7 +634,7 @@ uint8_t _IsTaskVectorValid_ROS
 uint8_t _IsTaskVectorEmpty_ROS
 		(
 			/* Task vector to check */
-			uint8_t task_vector
+			TaskID_ROS task_vector
 		)
 {
 	/* Check if task vector is valid, and store result in local variable */
@@ -455,14 +676,14 @@ uint8_t _IsTaskVectorEmpty_ROS
 uint8_t _IsTaskTimeoutValid_ROS
 		(
 			/* Timeout value to check */
-			uint8_t timeout
+			uint32_t timeout
 		)
 {
 	/* Check if timeout value is greater than the system maximum */	
 	if(timeout > MAX_TASK_TIMEOUT_ROS)
 	{
 		/* Timeout value too high, return failure */
-		return F_TASK_TIMEOUT_TOO_HIGH_ROS
+		return F_TASK_TIMEOUT_TOO_HIGH_ROS;
 	}
 	/* Check if timeout value is lower than the system minimum */
 	else if(timeout < MIN_TASK_TIMEOUT_ROS)
@@ -492,7 +713,7 @@ uint8_t _IsTaskTimeoutValid_ROS
 uint8_t _IsTaskUnprotected_ROS
 		(
 			/* Task vector to check */
-			uint8_t task_vector
+			TaskID_ROS task_vector
 		)
 {
 	/* Check if task vector is empty, and store result in container variable */
@@ -514,10 +735,10 @@ uint8_t _IsTaskUnprotected_ROS
 	else 
 	{
 		/* Store task vector id in container variable */
-		uint8_t task_id = gTaskVectorLookupArray_ROS[task_vector];
+		TaskID_ROS task_id = gTaskVectorLookupArray_ROS[task_vector];
 		
 		/* Check if task is protected */
-		if(gTaskProtectionArray_ROS[task_id])
+		if(TASK_PROTECTION_ROS(task_id) == TASK_PROTECTION_ENABLE_ROS)
 		{
 			/* Task is protected, return false */
 			return FALSE_ROS;
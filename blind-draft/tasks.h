@@ -0,0 +1,287 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "port.h"
+
+#ifndef TASKS_H
+#define TASKS_H
+
+
+/* System Parameters */
+
+/* The switches and sizes wrapped in #ifndef below can be overridden from the build (-D), as the
+   Makefile does for the test and benchmark configurations */
+
+#define MAX_TASK_INFO_ROS					10u
+
+/* Longest task timeout, in clock ticks. CreateTask_ROS rejects longer timeouts, which also bounds
+   the deadline range the EDF scheduler compares */
+#define MAX_TASK_TIMEOUT_ROS				200u
+
+/* Task ID and task vector width, set to 1 for 16 bit IDs (up to 65534 tasks), or 0 for 8 bit IDs
+   (up to 254 tasks) */
+#ifndef ENABLE_WIDE_TASK_ID_ROS
+#define ENABLE_WIDE_TASK_ID_ROS				0
+#endif
+
+#if (ENABLE_WIDE_TASK_ID_ROS)
+typedef uint16_t TaskID_ROS;
+#define MAX_TASK_ID_ROS						0xFFFFu
+#else
+typedef uint8_t TaskID_ROS;
+#define MAX_TASK_ID_ROS						0xFFu
+#endif
+
+/* Task control block layout, set to 1 for a packed hot block per task (the fields read on every
+   dispatch) with descriptions and protection in a separate cold block, or 0 for one array per
+   field */
+#ifndef ENABLE_PACKED_TCB_ROS
+#define ENABLE_PACKED_TCB_ROS				1
+#endif
+
+/* Stackless coroutine tasks, set to 1 to enable. A coroutine task can wait (yield, wait for a
+   message or sleep until a tick) by returning to the scheduler, and carries on from the wait when
+   it is next dispatched. Only its resume point is saved, so it needs no stack of its own */
+#ifndef ENABLE_COROUTINE_TASKS_ROS
+#define ENABLE_COROUTINE_TASKS_ROS			1
+#endif
+
+/* Preemptive kernel mode, set to 1 to run each task on its own stack, so a running task can be
+   suspended (preempted) as soon as a higher priority task is ready, or 0 for run to completion
+   tasks sharing the caller's stack. Needs a port providing the context switch (port.h) */
+#ifndef ENABLE_PREEMPTIVE_KERNEL_ROS
+#define ENABLE_PREEMPTIVE_KERNEL_ROS		0
+#endif
+
+/* Stack carved for each task in preemptive mode, in bytes, including the port's context record */
+#define TASK_STACK_BYTES_ROS				16384u
+
+/* Symmetric multi-core (SMP) mode, set to 1 to give each core its own ready lists, or 0 for one
+   core. A task is queued on a core its affinity mask allows (preferring the queuing core), and a
+   core with nothing ready steals from the others. Needs a port providing the core ID and spin
+   locks (port.h) */
+#ifndef ENABLE_SMP_ROS
+#define ENABLE_SMP_ROS						0
+#endif
+
+/* Tickless idle mode, set to 1 to let IdleScheduler_ROS stop the periodic tick while no task is
+   ready, sleeping with a one-shot timer until the next due timer (periodic release, sleep or
+   message wait timeout) or message expiry, and catching the tick counters up on waking. Needs a
+   port providing _SuppressTicksAndSleep_ROS (port.h), and the message expiry clock (messages.c) */
+#ifndef ENABLE_TICKLESS_IDLE_ROS
+#define ENABLE_TICKLESS_IDLE_ROS			0
+#endif
+
+/* Longest tickless sleep, in ticks, when nothing is due (the port may wake sooner) */
+#define MAX_IDLE_TICKS_ROS					60000u
+
+#if (ENABLE_SMP_ROS)
+/* Number of cores scheduled (at most 8, one affinity mask bit each) */
+#ifndef NUM_CORES_ROS
+#define NUM_CORES_ROS						4u
+#endif
+#define CURRENT_CORE_ROS()					_CurrentCore_ROS()
+#else
+#define NUM_CORES_ROS						1u
+#define CURRENT_CORE_ROS()					0u
+#endif
+
+
+/* Imported */
+#define FALSE_ROS							0x03
+
+/* Operating system status (gOperatingSystemStatus_ROS), set to running by the application once it
+   starts dispatching tasks. Task protection can only be changed while it is stopped */
+#define OS_STOPPED_ROS						0x00
+#define OS_RUNNING_ROS						0x01
+
+
+#if (ENABLE_PACKED_TCB_ROS)
+
+/* Hot task control block, read by the scheduler on every dispatch. 12 bytes on 32 bit parts, so
+   several tasks share a cache line and a dispatch touches one line per task */
+typedef struct
+{
+	/* Pointer to task function */
+	void (*task_pointer)(void);
+	/* Task timeout duration, in clock ticks */
+	uint32_t timeout;
+	/* Task priority level */
+	uint8_t priority;
+	/* Task sleep status */
+	uint8_t sleep_status;
+	/* Task vector the task was created at (fills padding, so the block stays 12 bytes) */
+	TaskID_ROS vector;
+#if (ENABLE_SMP_ROS)
+	/* Task affinity mask, bit n set if core n may run the task (0 = any core) */
+	uint8_t affinity;
+#endif
+} TaskHotTCB_ROS;
+
+/* Cold task control block, only used by the task administration functions */
+typedef struct
+{
+	/* Task description */
+	uint8_t info[MAX_TASK_INFO_ROS];
+	/* Task protected status */
+	uint8_t protection;
+} TaskColdTCB_ROS;
+
+extern TaskHotTCB_ROS * gTaskHotArray_ROS;
+extern TaskColdTCB_ROS * gTaskColdArray_ROS;
+
+/* Task control block field accessors, indexed by task ID */
+#define TASK_POINTER_ROS(task_id)			(gTaskHotArray_ROS[(task_id)].task_pointer)
+#define TASK_TIMEOUT_ROS(task_id)			(gTaskHotArray_ROS[(task_id)].timeout)
+#define TASK_PRIORITY_ROS(task_id)			(gTaskHotArray_ROS[(task_id)].priority)
+#define TASK_SLEEP_ROS(task_id)				(gTaskHotArray_ROS[(task_id)].sleep_status)
+#define TASK_VECTOR_ROS(task_id)			(gTaskHotArray_ROS[(task_id)].vector)
+#define TASK_AFFINITY_ROS(task_id)			(gTaskHotArray_ROS[(task_id)].affinity)
+#define TASK_INFO_ROS(task_id)				(gTaskColdArray_ROS[(task_id)].info)
+#define TASK_PROTECTION_ROS(task_id)		(gTaskColdArray_ROS[(task_id)].protection)
+
+#else
+
+extern void (**gTaskPointerArray_ROS)(void);
+extern uint32_t * gTaskTimeoutArray_ROS;
+extern uint8_t * gTaskPriorityArray_ROS;
+#if (ENABLE_SMP_ROS)
+extern uint8_t * gTaskAffinityArray_ROS;
+#endif
+extern uint8_t * gTaskSleepStatusArray_ROS;
+extern TaskID_ROS * gTaskVectorArray_ROS;
+extern uint8_t (*gTaskInfoArray_ROS)[MAX_TASK_INFO_ROS];
+extern uint8_t * gTaskProtectionArray_ROS;
+
+/* Task control block field accessors, indexed by task ID */
+#define TASK_POINTER_ROS(task_id)			(gTaskPointerArray_ROS[(task_id)])
+#define TASK_TIMEOUT_ROS(task_id)			(gTaskTimeoutArray_ROS[(task_id)])
+#define TASK_PRIORITY_ROS(task_id)			(gTaskPriorityArray_ROS[(task_id)])
+#define TASK_AFFINITY_ROS(task_id)			(gTaskAffinityArray_ROS[(task_id)])
+#define TASK_SLEEP_ROS(task_id)				(gTaskSleepStatusArray_ROS[(task_id)])
+#define TASK_VECTOR_ROS(task_id)			(gTaskVectorArray_ROS[(task_id)])
+#define TASK_INFO_ROS(task_id)				(gTaskInfoArray_ROS[(task_id)])
+#define TASK_PROTECTION_ROS(task_id)		(gTaskProtectionArray_ROS[(task_id)])
+
+#endif
+
+
+#if (ENABLE_PREEMPTIVE_KERNEL_ROS) || (ENABLE_SMP_ROS)
+
+/* Kernel call from a task. In preemptive and SMP modes, every kernel function returning a status
+   that a task calls must be wrapped. In preemptive mode the task is then not preempted while it is
+   updating the kernel tables, and a higher priority task made ready by the call runs as soon as
+   the call returns. In SMP mode calls from different cores are serialised, which makes the
+   task tables safe to share between cores (the message API functions also take the lock
+   themselves) */
+#define KERNEL_CALL_ROS(call)				(_LockKernel_ROS(), _UnlockKernel_ROS(call))
+
+void _LockKernel_ROS(void);
+uint8_t _UnlockKernel_ROS(uint8_t);
+#else
+#define KERNEL_CALL_ROS(call)				(call)
+#endif
+
+
+#if (ENABLE_COROUTINE_TASKS_ROS)
+
+/* Coroutine task function, passed its saved resume point (0 = start of the body), and returning
+   one of the coroutine states below */
+typedef uint8_t (*TaskCoroutine_ROS)(uint16_t *);
+
+/* Coroutine states */
+#define COROUTINE_ENDED_ROS					0x01
+#define COROUTINE_YIELDED_ROS				0x02
+#define COROUTINE_WAITING_ROS				0x03
+
+/* Coroutine body macros. The body of a coroutine task function is written between
+   COROUTINE_BEGIN_ROS and COROUTINE_END_ROS, and may wait with the macros in between, each of
+   which saves the resume point (its source line) and returns to the scheduler. Local variables
+   are not kept across a wait (use statics), a wait cannot be used inside a switch statement, and
+   there can only be one wait per source line. The message waits need messages.h */
+#define COROUTINE_BEGIN_ROS(resume_point)	switch(*(resume_point)) { case 0u:
+#define COROUTINE_END_ROS(resume_point)		} *(resume_point) = 0u; return COROUTINE_ENDED_ROS
+
+/* Let the other ready tasks run, carrying on from the back of the task's priority level */
+#define COROUTINE_YIELD_ROS(resume_point) \
+		do { *(resume_point) = __LINE__; return COROUTINE_YIELDED_ROS; case __LINE__:; } while(0)
+
+/* Wait until the task's inbox holds a message */
+#define COROUTINE_WAIT_MESSAGE_ROS(resume_point) \
+		do { *(resume_point) = __LINE__; if(0) { case __LINE__:; } \
+			 if(KERNEL_CALL_ROS(WaitForInbox_ROS()) == FALSE_ROS) \
+				 { return COROUTINE_WAITING_ROS; } } while(0)
+
+/* Wait until the scheduler tick reaches wake_tick (evaluated once) */
+#define COROUTINE_SLEEP_UNTIL_ROS(resume_point, wake_tick) \
+		do { *(resume_point) = __LINE__; \
+			 if(KERNEL_CALL_ROS(SleepUntilTick_ROS(wake_tick)) == FALSE_ROS) \
+				 { return COROUTINE_WAITING_ROS; } \
+			 if(0) { case __LINE__: \
+			 if(KERNEL_CALL_ROS(ResumeSleep_ROS()) == FALSE_ROS) \
+				 { return COROUTINE_WAITING_ROS; } } } while(0)
+
+/* Wait for the message ID (or the inbox, with MSG_WAIT_INBOX_ROS) for up to timeout ticks (0 = no
+   timeout), lending the task's priority to server_vector meanwhile. The outcome (true,
+   F_MSG_WAIT_TIMEOUT_ROS or an error code) is stored in the variable result */
+#define COROUTINE_WAIT_MESSAGE_FOR_ROS(resume_point, message_id, server_vector, timeout, result) \
+		do { *(resume_point) = __LINE__; \
+			 (result) = KERNEL_CALL_ROS(WaitForMessage_ROS((message_id), (server_vector), (timeout))); \
+			 if(0) { case __LINE__: (result) = KERNEL_CALL_ROS(ResumeMessageWait_ROS()); } \
+			 if((result) == FALSE_ROS) \
+				 { return COROUTINE_WAITING_ROS; } } while(0)
+
+uint8_t CreateCoroutineTask_ROS(TaskID_ROS, TaskCoroutine_ROS);
+#endif
+
+
+extern TaskID_ROS * gTaskVectorLookupArray_ROS;
+extern TaskID_ROS gTaskTableSize_ROS;
+extern TaskID_ROS gTaskVectorTableSize_ROS;
+
+/* ID of the task being run by DispatchTask_ROS on each core, or NULL_TASK_ROS outside any task */
+extern TaskID_ROS gRunningTaskIDArray_ROS[NUM_CORES_ROS];
+
+/* ID of the task running on the calling core */
+#define RUNNING_TASK_ID_ROS					(gRunningTaskIDArray_ROS[CURRENT_CORE_ROS()])
+
+/* Scheduler tick counter */
+extern uint32_t gSystemTick_ROS;
+
+/* Operating system status */
+extern uint8_t gOperatingSystemStatus_ROS;
+
+uint8_t MountTaskTables_ROS(uint8_t *, uint32_t, TaskID_ROS, TaskID_ROS, uint32_t *);
+uint8_t CreateTask_ROS(TaskID_ROS, uint8_t, uint32_t, bool, uint8_t *, void (*)(void));
+uint8_t DestroyTask_ROS(TaskID_ROS);
+uint8_t ProtectTask_ROS(TaskID_ROS, bool);
+uint8_t ControlSleepTask_ROS(TaskID_ROS, bool);
+uint8_t QueueTask_ROS(TaskID_ROS);
+uint8_t UnqueueTask_ROS(TaskID_ROS);
+uint8_t DispatchTask_ROS(void);
+void TickScheduler_ROS(void);
+uint8_t CreatePeriodicTask_ROS(TaskID_ROS, uint16_t, uint16_t);
+uint8_t ControlPeriodicTask_ROS(TaskID_ROS, bool);
+uint8_t DestroyPeriodicTask_ROS(TaskID_ROS);
+uint8_t CreateISRTask_ROS(TaskID_ROS, TaskID_ROS *);
+uint8_t ControlISRTask_ROS(TaskID_ROS, bool);
+uint8_t DestroyISRTask_ROS(TaskID_ROS);
+uint8_t PostISRTask_ROS(TaskID_ROS);
+uint8_t _IsTaskVectorEmpty_ROS(TaskID_ROS);
+void * _CarveTaskMemory_ROS(uint32_t);
+void _MountSchedulerTables_ROS(TaskID_ROS);
+void _DestroySchedulerTask_ROS(TaskID_ROS);
+uint8_t SleepUntilTick_ROS(uint32_t);
+uint8_t ResumeSleep_ROS(void);
+uint8_t CancelSleep_ROS(void);
+uint8_t InheritTaskPriority_ROS(TaskID_ROS, uint8_t);
+uint8_t RestoreTaskPriority_ROS(TaskID_ROS);
+#if (ENABLE_SMP_ROS)
+uint8_t SetTaskAffinity_ROS(TaskID_ROS, uint8_t);
+#endif
+#if (ENABLE_TICKLESS_IDLE_ROS)
+uint32_t NextSchedulerEvent_ROS(void);
+void StepScheduler_ROS(uint32_t);
+uint32_t IdleScheduler_ROS(void);
+uint8_t _ConfirmIdle_ROS(void);
+#endif
+#endif
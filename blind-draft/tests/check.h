@@ -0,0 +1,20 @@
+#include <stdio.h>
+
+#ifndef CHECK_H
+#define CHECK_H
+
+
+/* Minimal test checks. Each failed check prints its location and condition, and is counted, so a
+   test program can run every check and return the count (0 = pass) from main */
+
+static unsigned gCheckFailures_ROS = 0u;
+
+#define CHECK_ROS(condition) \
+		do { if(!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+								gCheckFailures_ROS++; } } while(0)
+
+/* Print the outcome of a test program, and return its exit status */
+#define CHECK_RESULT_ROS() \
+		(printf("%s: %s (%u failed)\n", __FILE__, gCheckFailures_ROS ? "FAIL" : "pass", \
+				gCheckFailures_ROS), (gCheckFailures_ROS != 0u))
+#endif
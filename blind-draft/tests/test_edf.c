@@ -0,0 +1,189 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: test_edf.c
+* Description   	: Tests of earliest deadline first selection
+*					  (ENABLE_EDF_SCHEDULER_ROS, schedule.c).
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <string.h>
+#include "tasks.h"
+#include "check.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define F_TASK_QUEUE_EMPTY_ROS			0x47
+extern uint16_t * gTaskDeadlineMissArray_ROS;
+
+/* Task table memory block */
+static uint8_t gTestTaskMemory[16384];
+
+/* Order the tasks ran in, one letter per task */
+static char gRunOrder[32];
+static uint8_t gNumRuns;
+
+static void TaskA(void) { gRunOrder[gNumRuns++] = 'A'; }
+static void TaskB(void) { gRunOrder[gNumRuns++] = 'B'; }
+static void TaskC(void) { gRunOrder[gNumRuns++] = 'C'; }
+static void TaskD(void) { gRunOrder[gNumRuns++] = 'D'; }
+
+/* Letter of each task the heap test creates, by vector */
+static void TaskLetter(void)
+{
+	gRunOrder[gNumRuns++] = (char)('a' + (gRunningTaskIDArray_ROS[0] % 26u));
+}
+
+/* Dispatch until nothing is ready, and return the run order */
+static const char * RunAll(void)
+{
+	gNumRuns = 0u;
+	while(DispatchTask_ROS() == SUCCESS_ROS)
+	{
+	}
+	gRunOrder[gNumRuns] = '\0';
+	return gRunOrder;
+}
+
+/* Mount fresh tables with four tasks: A at priority 10 with a 100 tick
+   timeout, B at 10 with 20, C at 10 with 50, and D at 40 with 60 */
+static void SetUp(void)
+{
+	uint32_t used;
+
+	CHECK_ROS(MountTaskTables_ROS(gTestTaskMemory, sizeof(gTestTaskMemory), 8u, 32u, &used) == \
+			  SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 100u, false, (uint8_t *)"task a", TaskA) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(6u, 10u, 20u, false, (uint8_t *)"task b", TaskB) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(7u, 10u, 50u, false, (uint8_t *)"task c", TaskC) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(8u, 40u, 60u, false, (uint8_t *)"task d", TaskD) == SUCCESS_ROS);
+}
+
+/* Earlier deadlines run first. A priority 30 levels higher is worth 10 ticks
+   of deadline, and equally urgent tasks run first in first out */
+static void TestDeadlineOrder(void)
+{
+	SetUp();
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(7u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "BCA") == 0);
+	CHECK_ROS(DispatchTask_ROS() == F_TASK_QUEUE_EMPTY_ROS);
+
+	/* D's deadline is 10 ticks after C's, and its priority 30 levels higher */
+	CHECK_ROS(QueueTask_ROS(8u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(7u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "DC") == 0);
+	CHECK_ROS(QueueTask_ROS(7u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(8u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "CD") == 0);
+
+	/* Deadlines are set when queued, so a long timeout queued early can run
+	   before a short one queued later */
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	while(gSystemTick_ROS % 100u != 90u)
+	{
+		TickScheduler_ROS();
+	}
+	CHECK_ROS(QueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "AB") == 0);
+
+	/* Unqueuing a task leaves the others in order */
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(7u) == SUCCESS_ROS);
+	CHECK_ROS(UnqueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "CA") == 0);
+}
+
+/* A task lent a priority keeps its deadline, and only gains the priority */
+static void TestInheritKeepsDeadline(void)
+{
+	uint8_t i;
+
+	SetUp();
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	for(i = 0u; i < 60u; i++)
+	{
+		TickScheduler_ROS();
+	}
+
+	/* A is due in 40 ticks, B in 20 */
+	CHECK_ROS(QueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(InheritTaskPriority_ROS(5u, 80u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "AB") == 0);
+	CHECK_ROS(RestoreTaskPriority_ROS(5u) == SUCCESS_ROS);
+}
+
+/* A task dispatched after its deadline counts a miss */
+static void TestDeadlineMiss(void)
+{
+	uint8_t i;
+
+	SetUp();
+	CHECK_ROS(QueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(7u) == SUCCESS_ROS);
+	for(i = 0u; i < 30u; i++)
+	{
+		TickScheduler_ROS();
+	}
+	CHECK_ROS(strcmp(RunAll(), "BC") == 0);
+	CHECK_ROS(gTaskDeadlineMissArray_ROS[gTaskVectorLookupArray_ROS[6u]] == 1u);
+	CHECK_ROS(gTaskDeadlineMissArray_ROS[gTaskVectorLookupArray_ROS[7u]] == 0u);
+}
+
+/* Many tasks with mixed deadlines, queued and unqueued in a scrambled order,
+   run in deadline order */
+static void TestHeapOrder(void)
+{
+	uint32_t used;
+	TaskID_ROS vector;
+	char expected[32];
+	uint8_t i, num_expected = 0u;
+
+	CHECK_ROS(MountTaskTables_ROS(gTestTaskMemory, sizeof(gTestTaskMemory), 24u, 64u, &used) == \
+			  SUCCESS_ROS);
+
+	/* Task at vector 5 + i times out after 10 + (i * 7) % 24 ticks, so
+	   every timeout differs */
+	for(i = 0u; i < 24u; i++)
+	{
+		CHECK_ROS(CreateTask_ROS(5u + i, 10u, 10u + ((i * 7u) % 24u), false, \
+								 (uint8_t *)"heap task", TaskLetter) == SUCCESS_ROS);
+	}
+	for(i = 0u; i < 24u; i++)
+	{
+		CHECK_ROS(QueueTask_ROS(5u + ((i * 5u) % 24u)) == SUCCESS_ROS);
+	}
+	for(i = 0u; i < 24u; i += 3u)
+	{
+		CHECK_ROS(UnqueueTask_ROS(5u + i) == SUCCESS_ROS);
+	}
+
+	/* Expect the queued tasks by increasing timeout */
+	for(i = 0u; i < 24u; i++)
+	{
+		for(vector = 5u; vector < 29u; vector++)
+		{
+			if((((vector - 5u) % 3u) != 0u) && (((vector - 5u) * 7u) % 24u == i))
+			{
+				expected[num_expected++] = \
+					(char)('a' + (gTaskVectorLookupArray_ROS[vector] % 26u));
+			}
+		}
+	}
+	expected[num_expected] = '\0';
+	CHECK_ROS(strcmp(RunAll(), expected) == 0);
+}
+
+int main(void)
+{
+	TestDeadlineOrder();
+	TestInheritKeepsDeadline();
+	TestDeadlineMiss();
+	TestHeapOrder();
+	return CHECK_RESULT_ROS();
+}
@@ -0,0 +1,99 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: test_fine_levels.c
+* Description   	: Tests of the ready lists with one level per task priority
+*					  (ENABLE_FINE_PRIORITY_LEVELS_ROS, schedule.c, the default).
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "tasks.h"
+#include "check.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define F_TASK_QUEUE_EMPTY_ROS			0x47
+#define F_TASK_MEM_TOO_SMALL_ROS		0x0D
+
+/* Task table memory block, grown to the size the tables report they need
+   (which includes the task stacks in preemptive mode) */
+static uint8_t * gTestTaskMemory;
+static uint32_t gTestTaskMemoryBytes;
+
+/* Order the tasks ran in, one letter per task */
+static char gRunOrder[32];
+static uint8_t gNumRuns;
+
+static void TaskA(void) { gRunOrder[gNumRuns++] = 'A'; }
+static void TaskB(void) { gRunOrder[gNumRuns++] = 'B'; }
+static void TaskC(void) { gRunOrder[gNumRuns++] = 'C'; }
+static void TaskD(void) { gRunOrder[gNumRuns++] = 'D'; }
+static void TaskE(void) { gRunOrder[gNumRuns++] = 'E'; }
+
+/* Mount fresh task tables, growing the memory block first if it is too
+   small for them */
+static uint8_t MountTaskMemory(TaskID_ROS max_tasks, TaskID_ROS max_task_vectors)
+{
+	uint32_t required;
+	uint8_t result = MountTaskTables_ROS(gTestTaskMemory, gTestTaskMemoryBytes, max_tasks, \
+										 max_task_vectors, &required);
+
+	/* Check if the block was too small, and mount again in a big enough one */
+	if(result == F_TASK_MEM_TOO_SMALL_ROS)
+	{
+		free(gTestTaskMemory);
+		gTestTaskMemory = malloc(required);
+		gTestTaskMemoryBytes = (gTestTaskMemory != NULL) ? required : 0u;
+		result = MountTaskTables_ROS(gTestTaskMemory, gTestTaskMemoryBytes, max_tasks, \
+									 max_task_vectors, &required);
+	}
+	return result;
+}
+
+/* Dispatch until nothing is ready, and return the run order */
+static const char * RunAll(void)
+{
+	gNumRuns = 0u;
+	while(DispatchTask_ROS() == SUCCESS_ROS)
+	{
+	}
+	gRunOrder[gNumRuns] = '\0';
+	return gRunOrder;
+}
+
+/* Priorities within one group of 8 levels, and across groups, run highest
+   first, and equal priorities first in first out */
+static void TestPriorityOrder(void)
+{
+	CHECK_ROS(MountTaskMemory(8u, 32u) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 8u, 50u, false, (uint8_t *)"task a", TaskA) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(6u, 15u, 50u, false, (uint8_t *)"task b", TaskB) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(7u, 255u, 50u, false, (uint8_t *)"task c", TaskC) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(8u, 0u, 50u, false, (uint8_t *)"task d", TaskD) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(9u, 15u, 50u, false, (uint8_t *)"task e", TaskE) == SUCCESS_ROS);
+
+	CHECK_ROS(QueueTask_ROS(8u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(9u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(7u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "CBEAD") == 0);
+	CHECK_ROS(DispatchTask_ROS() == F_TASK_QUEUE_EMPTY_ROS);
+
+	/* Unqueuing the only task of a level leaves the rest of its group ready */
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(UnqueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "A") == 0);
+}
+
+int main(void)
+{
+	TestPriorityOrder();
+	return CHECK_RESULT_ROS();
+}
@@ -0,0 +1,176 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: test_lock_free.c
+* Description   	: Tests of the lock-free message store
+*					  (ENABLE_LOCK_FREE_MSGS_ROS, messages.c), with every
+*					  simulated core creating, reading and deleting at once.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <sched.h>
+#include <string.h>
+#include "tasks.h"
+#include "messages.h"
+#include "port_posix.h"
+#include "check.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+extern MsgLoc_ROS gNextFreeMsgLoc_ROS;
+
+/* Rounds each core makes, the IDs each core owns, and the size of every
+   message */
+#define TEST_ROUNDS						2000u
+#define TEST_OWN_IDS					4u
+#define TEST_MSG_BYTES					8u
+
+/* Tries a create makes while the store is full, before it counts a failure */
+#define TEST_CREATE_TRIES				1000u
+
+/* ID every core tries to create each round, and the first ID owned by a core */
+#define CONTESTED_ID					0x10u
+#define FIRST_OWN_ID					0x20u
+
+/* Message store */
+static uint8_t gTestMsgStore[MSG_FS_BLOCK_BYTES_ROS];
+
+/* Rounds each core won the contested ID, and failures seen on the cores */
+static volatile uint32_t gContestedWins[NUM_CORES_ROS];
+static volatile uint32_t gCoreFailures;
+
+/* Count a failure seen on a core */
+static void CoreFailure(void)
+{
+	__atomic_add_fetch(&gCoreFailures, 1u, __ATOMIC_RELAXED);
+}
+
+/* Fill a message's data from the core and round that create it and its ID */
+static void FillData(uint8_t * data, uint8_t core, uint32_t round, MsgID_ROS message_id)
+{
+	uint8_t i;
+
+	for(i = 0u; i < TEST_MSG_BYTES; i++)
+	{
+		data[i] = (uint8_t)((core << 6) ^ (round >> (i & 3u)) ^ (message_id + i));
+	}
+}
+
+/* Create a message, compacting the store and trying again while it is full.
+   A message another core is still writing on top cannot be slid down, so the
+   host thread yields between tries to let it finish. Returns the create's
+   result */
+static uint8_t CreateOrCompact(MsgID_ROS message_id, uint8_t * data)
+{
+	uint8_t result = F_INSUFF_FREE_MEM_ROS;
+	uint32_t tries;
+
+	for(tries = 0u; tries < TEST_CREATE_TRIES; tries++)
+	{
+		result = CreateMessage_ROS(message_id, MSG_TARG_GLOBAL_ROS, 0u, TEST_MSG_BYTES, data);
+		if((result != F_INSUFF_FREE_MEM_ROS) && (result != F_MAX_MSGS_REACHED_ROS))
+		{
+			break;
+		}
+		(void)OptimizeMessageStorage_ROS(0xFFu);
+		(void)sched_yield();
+	}
+	return result;
+}
+
+/* Check a message reads back as the data given, then delete it */
+static void CheckAndDelete(MsgID_ROS message_id, const uint8_t * data)
+{
+	uint8_t buffer[TEST_MSG_BYTES];
+
+	if((ReadMessage_ROS(message_id, TEST_MSG_BYTES, buffer) != SUCCESS_ROS) || \
+	   (memcmp(buffer, data, TEST_MSG_BYTES) != 0) || \
+	   (DeleteMessage_ROS(message_id) != SUCCESS_ROS))
+	{
+		CoreFailure();
+	}
+}
+
+/* Core loop: each round, create the core's own IDs and try for the contested
+   ID, then read each message won back and delete it */
+static void CoreLoop(void)
+{
+	uint8_t own_data[TEST_OWN_IDS][TEST_MSG_BYTES], contested_data[TEST_MSG_BYTES];
+	uint8_t core = CURRENT_CORE_ROS(), result, i;
+	MsgID_ROS message_id;
+	uint32_t round;
+
+	for(round = 0u; round < TEST_ROUNDS; round++)
+	{
+		for(i = 0u; i < TEST_OWN_IDS; i++)
+		{
+			message_id = FIRST_OWN_ID + (core * TEST_OWN_IDS) + i;
+			FillData(own_data[i], core, round, message_id);
+			if(CreateOrCompact(message_id, own_data[i]) != SUCCESS_ROS)
+			{
+				CoreFailure();
+			}
+		}
+
+		/* Losing the contested ID to another core (or to its delete, still
+		   being settled) is expected, any other failure is not */
+		FillData(contested_data, core, round, CONTESTED_ID);
+		result = CreateOrCompact(CONTESTED_ID, contested_data);
+		if((result != SUCCESS_ROS) && (result != F_MSG_ID_OCCUPIED_ROS) && (result != F_MSG_BUSY_ROS))
+		{
+			CoreFailure();
+		}
+
+		for(i = 0u; i < TEST_OWN_IDS; i++)
+		{
+			CheckAndDelete(FIRST_OWN_ID + (core * TEST_OWN_IDS) + i, own_data[i]);
+		}
+		if(result == SUCCESS_ROS)
+		{
+			gContestedWins[core]++;
+			CheckAndDelete(CONTESTED_ID, contested_data);
+		}
+	}
+}
+
+/* Every message created reads back as its own creator's data and deletes,
+   the contested ID is won some rounds, and once settled and compacted the
+   store is empty */
+static void TestCoresShareStore(void)
+{
+	uint32_t failed_at, wins = 0u;
+	uint8_t core, buffer[TEST_MSG_BYTES];
+	MsgID_ROS message_id;
+
+	CHECK_ROS(MountMessageFileSystem_ROS(gTestMsgStore, sizeof(gTestMsgStore), 0u, 0u, &failed_at, \
+										 NULL, MSG_MOUNT_TRUSTED_ROS) == SUCCESS_ROS);
+	gCoreFailures = 0u;
+	CHECK_ROS(StartSimulatedCores_ROS(NUM_CORES_ROS, CoreLoop) == SUCCESS_ROS);
+	JoinSimulatedCores_ROS();
+
+	CHECK_ROS(gCoreFailures == 0u);
+	for(core = 0u; core < NUM_CORES_ROS; core++)
+	{
+		wins += gContestedWins[core];
+	}
+	CHECK_ROS(wins != 0u);
+
+	CHECK_ROS(SettleMessageStore_ROS() == SUCCESS_ROS);
+	CHECK_ROS(OptimizeMessageStorage_ROS(0xFFu) == SUCCESS_ROS);
+	for(message_id = CONTESTED_ID; message_id < (FIRST_OWN_ID + (NUM_CORES_ROS * TEST_OWN_IDS)); \
+		message_id++)
+	{
+		CHECK_ROS(ReadMessage_ROS(message_id, TEST_MSG_BYTES, buffer) == F_MSG_ID_EMPTY_ROS);
+	}
+	CHECK_ROS(gNextFreeMsgLoc_ROS == 1u);
+	CHECK_ROS(gNumDelBytes_ROS == 0u);
+}
+
+int main(void)
+{
+	TestCoresShareStore();
+	return CHECK_RESULT_ROS();
+}
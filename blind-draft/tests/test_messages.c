@@ -0,0 +1,844 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: test_messages.c
+* Description   	: Tests of the message API (messages.c).
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <string.h>
+#include "tasks.h"
+#include "messages.h"
+#include "check.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+extern uint8_t gMsgInboxHeadArray_ROS[NUM_MSG_INBOXES_ROS];
+extern MsgField_ROS gMsgTOC_ROS[MAX_MSGS_ROS][MAX_MSG_ATTR_ROS];
+extern MsgField_ROS gMsgDTOC_ROS[MAX_DEL_MSGS_ROS][MAX_DEL_MSG_ATTR_ROS];
+extern uint8_t gMsgHoleClassHead_ROS[NUM_MSG_SIZE_CLASSES_ROS];
+extern MsgLoc_ROS gMsgHoleClassBitmap_ROS;
+extern MsgLoc_ROS gNextFreeMsgLoc_ROS;
+extern uint8_t gNumDelMsg_ROS;
+extern uint32_t _GetMsgFSField_ROS(const uint8_t *, uint8_t);
+extern void _PutMsgFSField_ROS(uint8_t *, uint32_t, uint8_t);
+extern void _GatherMessageData_ROS(uint8_t, uint8_t *, MsgSize_ROS);
+
+/* Message store, and a larger block for mounts that start off a word boundary */
+static uint8_t gTestMsgStore[MSG_FS_BLOCK_BYTES_ROS];
+static uint8_t gTestWideStore[MSG_FS_BLOCK_BYTES_ROS + 8u];
+
+/* Message data */
+static uint8_t gData[MAX_MSG_BYTES_ROS];
+
+/* Task table memory block, large enough for the task stacks */
+static uint8_t gTestTaskMemory[131072];
+
+/* Vectors of the waiting tasks in the order they were woken */
+static char gWakeOrder[8];
+static uint8_t gNumWakes;
+
+/* ID the timed waiter waits for (MSG_WAIT_INBOX_ROS = its inbox), its timeout, and the result
+   of its last run */
+static MsgID_ROS gWaitID;
+static uint32_t gWaitTimeout;
+static uint8_t gWaitResult;
+
+#if (ENABLE_MSG_TOPICS_ROS)
+/* Result of the last take from topic 1, and the ID taken */
+static uint8_t gTakeResult;
+static MsgID_ROS gTakenID;
+#endif
+
+/* Mount a fresh, empty message store, dropping the messages earlier tests left */
+static void MountStore(void)
+{
+	uint32_t failed_at;
+
+	CHECK_ROS(MountMessageFileSystem_ROS(gTestMsgStore, sizeof(gTestMsgStore), 0u, 0u, &failed_at, \
+										 NULL, MSG_MOUNT_TRUSTED_ROS) == SUCCESS_ROS);
+}
+
+/* Settle the deletes, inbox deliveries and record writes that ENABLE_LOCK_FREE_MSGS_ROS
+   defers */
+static void SettleStore(void)
+{
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	CHECK_ROS(SettleMessageStore_ROS() == SUCCESS_ROS);
+#endif
+}
+
+/* Location of a message in the store */
+static MsgLoc_ROS MessageLocation(MsgID_ROS message_id)
+{
+	uint8_t * data = gTestMsgStore;
+	MsgSize_ROS size;
+
+	CHECK_ROS(BorrowMessage_ROS(message_id, &data, &size) == SUCCESS_ROS);
+	CHECK_ROS(ReleaseMessage_ROS(message_id) == SUCCESS_ROS);
+	return (MsgLoc_ROS)(data - gTestMsgStore);
+}
+
+/* Check the store holds exactly one hole, filed as the only entry of its size class */
+static void CheckOneHole(MsgLoc_ROS location, MsgSize_ROS size, uint8_t size_class)
+{
+	uint8_t hole = gMsgHoleClassHead_ROS[size_class];
+
+	CHECK_ROS(gNumDelMsg_ROS == 1u);
+	CHECK_ROS(gNumDelBytes_ROS == size);
+	CHECK_ROS(gMsgHoleClassBitmap_ROS == (MsgLoc_ROS)(1u << size_class));
+	CHECK_ROS(gMsgDTOC_ROS[hole][MSG_LOC_ROS] == location);
+	CHECK_ROS(gMsgDTOC_ROS[hole][MSG_SIZE_ROS] == size);
+	CHECK_ROS(gMsgDTOC_ROS[hole][DEL_MSG_NEXT_ROS] == NULL_HOLE_ROS);
+	CHECK_ROS(gMsgDTOC_ROS[hole][DEL_MSG_PREV_ROS] == NULL_HOLE_ROS);
+}
+
+/* The hole tests do not apply with ENABLE_LOCK_FREE_MSGS_ROS set, where holes are never reused
+   and deletes only release space once settled */
+#if !(ENABLE_LOCK_FREE_MSGS_ROS)
+/* A message smaller than a hole takes its front, and the rest is refiled under its new size
+   class. A message that fits exactly uses the hole up */
+static void TestHoleSplit(void)
+{
+	MountStore();
+	CHECK_ROS(CreateMessage_ROS(0x20u, MSG_TARG_GLOBAL_ROS, 0u, 8u, gData) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x21u, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x20u) == SUCCESS_ROS);
+	CheckOneHole(1u, 8u, 3u);
+
+	/* 3 bytes from the front of the 8 byte hole leave 5 bytes, in class 2 */
+	CHECK_ROS(CreateMessage_ROS(0x22u, MSG_TARG_GLOBAL_ROS, 0u, 3u, gData) == SUCCESS_ROS);
+	CHECK_ROS(MessageLocation(0x22u) == 1u);
+	CheckOneHole(4u, 5u, 2u);
+
+	/* 5 bytes fill the rest */
+	CHECK_ROS(CreateMessage_ROS(0x23u, MSG_TARG_GLOBAL_ROS, 0u, 5u, gData) == SUCCESS_ROS);
+	CHECK_ROS(MessageLocation(0x23u) == 4u);
+	CHECK_ROS(gNumDelMsg_ROS == 0u);
+	CHECK_ROS(gNumDelBytes_ROS == 0u);
+	CHECK_ROS(gMsgHoleClassBitmap_ROS == 0u);
+	CHECK_ROS(gNextFreeMsgLoc_ROS == 13u);
+}
+
+/* Released bytes merge with a hole on their left, their right, or both, and bytes released on
+   top of the last message lower the top over any hole below them */
+static void TestHoleMerge(void)
+{
+	uint8_t i;
+
+	/* Seven 4 byte messages, 0x20 to 0x26 at locations 1 to 25 */
+	MountStore();
+	for(i = 0u; i < 7u; i++)
+	{
+		CHECK_ROS(CreateMessage_ROS(0x20u + i, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	}
+	CHECK_ROS(gNextFreeMsgLoc_ROS == 29u);
+
+	/* Left: 0x22 joins the hole 0x21 left */
+	CHECK_ROS(DeleteMessage_ROS(0x21u) == SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x22u) == SUCCESS_ROS);
+	CheckOneHole(5u, 8u, 3u);
+
+	/* Both: 0x23 joins the holes either side of it */
+	CHECK_ROS(DeleteMessage_ROS(0x24u) == SUCCESS_ROS);
+	CHECK_ROS(gNumDelMsg_ROS == 2u);
+	CHECK_ROS(DeleteMessage_ROS(0x23u) == SUCCESS_ROS);
+	CheckOneHole(5u, 16u, 4u);
+
+	/* Right: 0x20 grows the hole down */
+	CHECK_ROS(DeleteMessage_ROS(0x20u) == SUCCESS_ROS);
+	CheckOneHole(1u, 20u, 4u);
+
+	/* The top is lowered over 0x26, then over 0x25 and the hole below it */
+	CHECK_ROS(DeleteMessage_ROS(0x26u) == SUCCESS_ROS);
+	CHECK_ROS(gNextFreeMsgLoc_ROS == 25u);
+	CheckOneHole(1u, 20u, 4u);
+	CHECK_ROS(DeleteMessage_ROS(0x25u) == SUCCESS_ROS);
+	CHECK_ROS(gNextFreeMsgLoc_ROS == 1u);
+	CHECK_ROS(gNumDelMsg_ROS == 0u);
+	CHECK_ROS(gNumDelBytes_ROS == 0u);
+	CHECK_ROS(gMsgHoleClassBitmap_ROS == 0u);
+}
+
+/* A delete that needs a hole entry when the deleted message table is full, and cannot be
+   defragmented because every message above a hole is pinned, fails and changes nothing */
+static void TestHoleTableFull(void)
+{
+	uint8_t * data;
+	MsgSize_ROS size;
+	uint8_t i;
+
+	/* 4 byte messages 0x20 to 0x31, then MAX_DEL_MSGS_ROS isolated holes below borrowed
+	   messages */
+	MountStore();
+	for(i = 0u; i < ((2u * MAX_DEL_MSGS_ROS) + 2u); i++)
+	{
+		CHECK_ROS(CreateMessage_ROS(0x20u + i, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	}
+	for(i = 0u; i < MAX_DEL_MSGS_ROS; i++)
+	{
+		CHECK_ROS(BorrowMessage_ROS(0x21u + (2u * i), &data, &size) == SUCCESS_ROS);
+		CHECK_ROS(DeleteMessage_ROS(0x20u + (2u * i)) == SUCCESS_ROS);
+	}
+	CHECK_ROS(gNumDelMsg_ROS == MAX_DEL_MSGS_ROS);
+
+	/* The message between the last borrowed one and the top needs a ninth entry */
+	CHECK_ROS(DeleteMessage_ROS(0x20u + (2u * MAX_DEL_MSGS_ROS)) == F_MAX_DEL_MSGS_REACHED_ROS);
+	CHECK_ROS(gNumDelMsg_ROS == MAX_DEL_MSGS_ROS);
+	CHECK_ROS(gNumDelBytes_ROS == (4u * MAX_DEL_MSGS_ROS));
+	CHECK_ROS(ReadMessage_ROS(0x20u + (2u * MAX_DEL_MSGS_ROS), 4u, gData) == SUCCESS_ROS);
+
+	/* Once the messages are released, the delete defragments to free an entry for its bytes */
+	for(i = 0u; i < MAX_DEL_MSGS_ROS; i++)
+	{
+		CHECK_ROS(ReleaseMessage_ROS(0x21u + (2u * i)) == SUCCESS_ROS);
+	}
+	CHECK_ROS(DeleteMessage_ROS(0x20u + (2u * MAX_DEL_MSGS_ROS)) == SUCCESS_ROS);
+	CHECK_ROS(gNumDelBytes_ROS == (4u * (MAX_DEL_MSGS_ROS + 1u)));
+}
+#endif
+
+/* Check a message holds the 4 bytes of gData from an offset */
+static void CheckMessageData(MsgID_ROS message_id, uint8_t offset)
+{
+	uint8_t buffer[4];
+
+	CHECK_ROS(ReadMessage_ROS(message_id, 4u, buffer) == SUCCESS_ROS);
+	CHECK_ROS(memcmp(buffer, gData + offset, 4u) == 0);
+}
+
+/* Each defragmentation step slides the message above the lowest hole down over it, joins the
+   hole to the next hole, or lowers the top over it, and steps past holes below pinned messages */
+static void TestDefragSteps(void)
+{
+	uint8_t * data;
+	MsgSize_ROS size;
+	size_t i;
+
+	/* 4 byte messages 0x20 to 0x24 at locations 1 to 17, each with different data */
+	MountStore();
+	for(i = 0u; i < sizeof(gData); i++)
+	{
+		gData[i] = (uint8_t)(i + 1u);
+	}
+	for(i = 0u; i < 5u; i++)
+	{
+		CHECK_ROS(CreateMessage_ROS(0x20u + i, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData + i) == \
+				  SUCCESS_ROS);
+	}
+
+	/* Holes at 1 and 9, with 0x21 borrowed: the lower hole is skipped, and 0x23 slides down */
+	CHECK_ROS(DeleteMessage_ROS(0x20u) == SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x22u) == SUCCESS_ROS);
+	CHECK_ROS(BorrowMessage_ROS(0x21u, &data, &size) == SUCCESS_ROS);
+	CHECK_ROS(OptimizeMessageStorage_ROS(1u) == F_MSG_DEFRAG_PENDING_ROS);
+	CHECK_ROS(MessageLocation(0x21u) == 5u);
+	CHECK_ROS(MessageLocation(0x23u) == 9u);
+	CheckMessageData(0x23u, 3u);
+
+	/* 0x24 slides down next, and the hole is then on top, so it is dropped */
+	CHECK_ROS(OptimizeMessageStorage_ROS(1u) == F_MSG_DEFRAG_PENDING_ROS);
+	CHECK_ROS(MessageLocation(0x24u) == 13u);
+	CheckMessageData(0x24u, 4u);
+	CHECK_ROS(OptimizeMessageStorage_ROS(1u) == F_MSG_DEFRAG_PENDING_ROS);
+	CHECK_ROS(gNextFreeMsgLoc_ROS == 17u);
+	CHECK_ROS(gNumDelMsg_ROS == 1u);
+
+	/* Nothing can be done while 0x21 is borrowed */
+	CHECK_ROS(OptimizeMessageStorage_ROS(1u) == F_MSG_DEFRAG_PENDING_ROS);
+	CHECK_ROS(MessageLocation(0x21u) == 5u);
+
+	/* Once released, the rest slide down over the last hole */
+	CHECK_ROS(ReleaseMessage_ROS(0x21u) == SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x23u) == SUCCESS_ROS);
+	SettleStore();
+	CHECK_ROS(gNumDelMsg_ROS == 2u);
+	CHECK_ROS(OptimizeMessageStorage_ROS(0xFFu) == SUCCESS_ROS);
+	CHECK_ROS(gNextFreeMsgLoc_ROS == 9u);
+	CHECK_ROS(MessageLocation(0x21u) == 1u);
+	CHECK_ROS(MessageLocation(0x24u) == 5u);
+	CheckMessageData(0x21u, 1u);
+	CheckMessageData(0x24u, 4u);
+}
+
+/* A reserved message holds one pin until committed, which is not a borrow. Each borrow adds a
+   pin, and the message can only be deleted once every borrow is released */
+static void TestReserveAndBorrow(void)
+{
+	uint8_t * space;
+	uint8_t * data;
+	MsgSize_ROS size;
+
+	MountStore();
+	CHECK_ROS(ReserveMessage_ROS(0x20u, MSG_TARG_GLOBAL_ROS, 0u, 4u, &space) == SUCCESS_ROS);
+	CHECK_ROS(ReserveMessage_ROS(0x20u, MSG_TARG_GLOBAL_ROS, 0u, 4u, &space) == \
+			  F_MSG_ID_OCCUPIED_ROS);
+	memcpy(space, "abcd", 4u);
+
+	/* Until committed, the message cannot be read, borrowed, released or deleted */
+	CHECK_ROS(ReadMessage_ROS(0x20u, 4u, gData) == F_MSG_NOT_COMMITTED_ROS);
+	CHECK_ROS(BorrowMessage_ROS(0x20u, &data, &size) == F_MSG_NOT_COMMITTED_ROS);
+	CHECK_ROS(ReleaseMessage_ROS(0x20u) == F_MSG_NOT_BORROWED_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x20u) == F_MSG_PINNED_ROS);
+	CHECK_ROS(CommitMessage_ROS(0x20u) == SUCCESS_ROS);
+	CHECK_ROS(CommitMessage_ROS(0x20u) == F_MSG_NOT_RESERVED_ROS);
+	CHECK_ROS(CommitMessage_ROS(0x21u) == F_MSG_ID_EMPTY_ROS);
+
+	/* Two borrows of the data written in place, each released once */
+	CHECK_ROS(BorrowMessage_ROS(0x20u, &data, &size) == SUCCESS_ROS);
+	CHECK_ROS((data == space) && (size == 4u) && (memcmp(data, "abcd", 4u) == 0));
+	CHECK_ROS(BorrowMessage_ROS(0x20u, &data, &size) == SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x20u) == F_MSG_PINNED_ROS);
+	CHECK_ROS(ReleaseMessage_ROS(0x20u) == SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x20u) == F_MSG_PINNED_ROS);
+	CHECK_ROS(ReleaseMessage_ROS(0x20u) == SUCCESS_ROS);
+	CHECK_ROS(ReleaseMessage_ROS(0x20u) == F_MSG_NOT_BORROWED_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x20u) == SUCCESS_ROS);
+	CHECK_ROS(ReleaseMessage_ROS(0x20u) == F_MSG_ID_EMPTY_ROS);
+}
+
+#if (ENABLE_MSG_EXPIRY_ROS)
+/* Messages expire in time to live order, however they were created. A deleted message's expiry
+   is cancelled, and a pinned message's expiry is retried each tick until it is released */
+static void TestExpiryOrder(void)
+{
+	const uint8_t ttl[6] = { 5u, 2u, 9u, 2u, 0u, 7u };
+	uint8_t * data;
+	MsgSize_ROS size;
+	uint8_t i;
+
+	MountStore();
+	for(i = 0u; i < 6u; i++)
+	{
+		CHECK_ROS(CreateMessage_ROS(0x20u + i, MSG_TARG_GLOBAL_ROS, ttl[i], 4u, gData) == \
+				  SUCCESS_ROS);
+	}
+	CHECK_ROS(NextMessageExpiry_ROS() == 2u);
+
+	/* 0x21 and 0x23 expire on the second tick */
+	CHECK_ROS(TickMessageExpiry_ROS() == 0u);
+	CHECK_ROS(TickMessageExpiry_ROS() == 2u);
+	CHECK_ROS(ReadMessage_ROS(0x21u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x23u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x20u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(NextMessageExpiry_ROS() == 3u);
+
+	/* 0x25 is deleted before it is due, and 0x20 is borrowed when it is due */
+	CHECK_ROS(DeleteMessage_ROS(0x25u) == SUCCESS_ROS);
+	CHECK_ROS(BorrowMessage_ROS(0x20u, &data, &size) == SUCCESS_ROS);
+	CHECK_ROS(AdvanceMessageExpiry_ROS(3u) == 0u);
+	CHECK_ROS(NextMessageExpiry_ROS() == 1u);
+	CHECK_ROS(TickMessageExpiry_ROS() == 0u);
+	CHECK_ROS(ReleaseMessage_ROS(0x20u) == SUCCESS_ROS);
+	CHECK_ROS(TickMessageExpiry_ROS() == 1u);
+	CHECK_ROS(ReadMessage_ROS(0x20u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+
+	/* 0x22 is the last to expire, and 0x24 never does */
+	CHECK_ROS(NextMessageExpiry_ROS() == 2u);
+	CHECK_ROS(AdvanceMessageExpiry_ROS(10u) == 1u);
+	CHECK_ROS(NextMessageExpiry_ROS() == 0xFFFFFFFFul);
+	CHECK_ROS(ReadMessage_ROS(0x24u, 4u, gData) == SUCCESS_ROS);
+}
+#endif
+
+/* Run a task once */
+static void RunTask(uint8_t vector)
+{
+	CHECK_ROS(QueueTask_ROS(vector) == SUCCESS_ROS);
+	CHECK_ROS(DispatchTask_ROS() == SUCCESS_ROS);
+}
+
+#if (ENABLE_MSG_TOPICS_ROS)
+/* Taking task body: takes the oldest message on topic 1 it has not taken, and keeps it */
+static void TaskTaker(void)
+{
+	uint8_t * data;
+	MsgSize_ROS size;
+
+	gTakeResult = TakeTopicMessage_ROS(1u, &gTakenID, &data, &size);
+}
+
+/* A published message is kept while any subscriber has not taken it, or a taker has not released
+   it, and is deleted when the last reference is dropped by a release or an unsubscribe */
+static void TestTopicReferences(void)
+{
+	uint8_t * data;
+	MsgSize_ROS size;
+	MsgID_ROS id;
+	uint32_t used;
+
+	MountStore();
+	CHECK_ROS(MountTaskTables_ROS(gTestTaskMemory, sizeof(gTestTaskMemory), 4u, 32u, &used) == \
+			  SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 40u, 50u, false, (uint8_t *)"taker", TaskTaker) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(6u, 40u, 50u, false, (uint8_t *)"taker", TaskTaker) == SUCCESS_ROS);
+	CHECK_ROS(PublishMessage_ROS(1u, 0x30u, 0u, 4u, gData) == F_MSG_NO_SUBSCRIBERS_ROS);
+	CHECK_ROS(SubscribeTopic_ROS(1u, 5u) == SUCCESS_ROS);
+	CHECK_ROS(SubscribeTopic_ROS(1u, 6u) == SUCCESS_ROS);
+	CHECK_ROS(SubscribeTopic_ROS(1u, 6u) == SUCCESS_ROS);
+	CHECK_ROS(TakeTopicMessage_ROS(1u, &id, &data, &size) == F_MSG_NO_RUNNING_TASK_ROS);
+
+	/* 0x30 is taken by 5, so outlives 6 unsubscribing, until 5 releases it */
+	CHECK_ROS(PublishMessage_ROS(1u, 0x30u, 0u, 4u, gData) == SUCCESS_ROS);
+	RunTask(5u);
+	CHECK_ROS((gTakeResult == SUCCESS_ROS) && (gTakenID == 0x30u));
+	RunTask(5u);
+	CHECK_ROS(gTakeResult == F_MSG_INBOX_EMPTY_ROS);
+	CHECK_ROS(UnsubscribeTopic_ROS(1u, 6u) == SUCCESS_ROS);
+	CHECK_ROS(UnsubscribeTopic_ROS(1u, 6u) == F_MSG_ACCESS_DENIED_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x30u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x30u) == F_MSG_PINNED_ROS);
+	CHECK_ROS(ReleaseMessage_ROS(0x30u) == SUCCESS_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x30u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+
+	/* Messages are taken oldest first, and each is deleted by its own release */
+	CHECK_ROS(PublishMessage_ROS(1u, 0x31u, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(PublishMessage_ROS(1u, 0x32u, 0u, 4u, gData) == SUCCESS_ROS);
+	RunTask(5u);
+	CHECK_ROS((gTakeResult == SUCCESS_ROS) && (gTakenID == 0x31u));
+	RunTask(5u);
+	CHECK_ROS((gTakeResult == SUCCESS_ROS) && (gTakenID == 0x32u));
+	CHECK_ROS(ReleaseMessage_ROS(0x32u) == SUCCESS_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x32u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x31u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(ReleaseMessage_ROS(0x31u) == SUCCESS_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x31u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+
+	/* An untaken message goes when its last subscriber unsubscribes */
+	CHECK_ROS(PublishMessage_ROS(1u, 0x33u, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(UnsubscribeTopic_ROS(1u, 5u) == SUCCESS_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x33u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+}
+#endif
+
+/* Check a block is wiped to a formatted, empty store */
+static void CheckWiped(const uint8_t * block, uint32_t block_size)
+{
+	uint32_t i;
+
+	CHECK_ROS(_GetMsgFSField_ROS(block + MSG_FS_HEADER_LOC_ROS, MSG_FS_MAGIC_BYTES_ROS) == \
+			  MSG_FS_MAGIC_ROS);
+	for(i = 0u; i < block_size; i++)
+	{
+		if((i < MSG_FS_HEADER_LOC_ROS) || (i >= (MSG_FS_HEADER_LOC_ROS + MSG_FS_MAGIC_BYTES_ROS)))
+		{
+			CHECK_ROS(block[i] == 0xFFu);
+		}
+	}
+}
+
+/* Both test modes march test the block, on or off a word boundary, then wipe it and drop the
+   messages held. Blocks too small for the store, and unknown modes, are refused */
+static void TestMountModes(void)
+{
+	uint8_t * block = gTestWideStore + 1u;
+	uint32_t block_size = sizeof(gTestWideStore) - 3u;
+	uint32_t failed_at = 0xFFFFFFFFul;
+
+	MountStore();
+	CHECK_ROS(CreateMessage_ROS(0x20u, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	memset(gTestWideStore, 0, sizeof(gTestWideStore));
+	CHECK_ROS(MountMessageFileSystem_ROS(block, block_size, 0u, 0u, &failed_at, NULL, \
+										 MSG_MOUNT_FULL_TEST_ROS) == SUCCESS_ROS);
+	CHECK_ROS(failed_at == 0xFFFFFFFFul);
+	CheckWiped(block, block_size);
+	CHECK_ROS((gTestWideStore[0] == 0u) && (gTestWideStore[sizeof(gTestWideStore) - 1u] == 0u));
+	CHECK_ROS(ReadMessage_ROS(0x20u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+
+	CHECK_ROS(CreateMessage_ROS(0x20u, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	memset(gTestWideStore, 0, sizeof(gTestWideStore));
+	CHECK_ROS(MountMessageFileSystem_ROS(block, block_size, 0u, 0u, &failed_at, NULL, \
+										 MSG_MOUNT_SAMPLED_TEST_ROS) == SUCCESS_ROS);
+	CHECK_ROS(failed_at == 0xFFFFFFFFul);
+	CheckWiped(block, block_size);
+	CHECK_ROS(ReadMessage_ROS(0x20u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+
+	CHECK_ROS(MountMessageFileSystem_ROS(block, MSG_FS_BLOCK_BYTES_ROS - 1u, 0u, 0u, &failed_at, \
+										 NULL, MSG_MOUNT_TRUSTED_ROS) == \
+			  F_MSG_FS_BLOCK_TOO_SMALL_ROS);
+	CHECK_ROS(MountMessageFileSystem_ROS(block, block_size, 0u, 0u, &failed_at, NULL, 0x05u) == \
+			  F_MSG_FS_MODE_INVALID_ROS);
+}
+
+/* Header record of a message in the store */
+static uint8_t * MessageRecord(MsgID_ROS message_id)
+{
+	uint8_t * record;
+	uint8_t i;
+
+	for(i = 1u; i < MAX_MSGS_ROS; i++)
+	{
+		record = gTestMsgStore + MSG_FS_HEADER_LOC_ROS + MSG_FS_MAGIC_BYTES_ROS + \
+				 ((uint32_t)i * MSG_FS_RECORD_BYTES_ROS);
+		if(_GetMsgFSField_ROS(record, 4u) == message_id)
+		{
+			return record;
+		}
+	}
+	CHECK_ROS(false);
+	return gTestMsgStore + MSG_FS_HEADER_LOC_ROS;
+}
+
+/* A persistent mount rebuilds the messages, inboxes, expiries and holes from the header, skipping
+   reserved messages and records whose ID is a duplicate, and refuses a block never formatted */
+static void TestPersistentMount(void)
+{
+	uint32_t failed_at;
+	uint8_t * space;
+	size_t i;
+
+	/* 0x20 at 1, 0x21 at 5 (deleted), 0x22 at 13, 0x23 at 17 and 0x24 (reserved) at 21 */
+	MountStore();
+	for(i = 0u; i < sizeof(gData); i++)
+	{
+		gData[i] = (uint8_t)(i + 1u);
+	}
+	CHECK_ROS(CreateMessage_ROS(0x20u, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x21u, 5u, 0u, 8u, gData) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x22u, 5u, 6u, 4u, gData + 2u) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x23u, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(ReserveMessage_ROS(0x24u, MSG_TARG_GLOBAL_ROS, 0u, 4u, &space) == SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x21u) == SUCCESS_ROS);
+#if (ENABLE_MSG_EXPIRY_ROS)
+	CHECK_ROS(AdvanceMessageExpiry_ROS(4u) == 0u);
+	CHECK_ROS(NextMessageExpiry_ROS() == 2u);
+#endif
+
+	/* 0x23's record is damaged to a copy of 0x20's ID */
+	SettleStore();
+	_PutMsgFSField_ROS(MessageRecord(0x23u), 0x20u, 4u);
+	CHECK_ROS(MountMessageFileSystem_ROS(gTestMsgStore, sizeof(gTestMsgStore), 0u, 0u, &failed_at, \
+										 NULL, MSG_MOUNT_PERSISTENT_ROS) == SUCCESS_ROS);
+	CheckMessageData(0x20u, 0u);
+	CheckMessageData(0x22u, 2u);
+	CHECK_ROS(ReadMessage_ROS(0x21u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x23u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x24u, 4u, gData) == F_MSG_ID_EMPTY_ROS);
+	CHECK_ROS(gMsgInboxHeadArray_ROS[5u] != NULL_MSG_ROS);
+#if (ENABLE_MSG_EXPIRY_ROS)
+	CHECK_ROS(NextMessageExpiry_ROS() == 6u);
+#endif
+
+	/* The gap left by 0x21 is a hole, and everything from 17 up is free */
+	CheckOneHole(5u, 8u, 3u);
+	CHECK_ROS(gNextFreeMsgLoc_ROS == 17u);
+	CHECK_ROS(CreateMessage_ROS(0x25u, MSG_TARG_GLOBAL_ROS, 0u, 8u, gData) == SUCCESS_ROS);
+#if (ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Holes are never reused lock free, so it goes on top */
+	CHECK_ROS(MessageLocation(0x25u) == 17u);
+#else
+	CHECK_ROS(MessageLocation(0x25u) == 5u);
+#endif
+
+	memset(gTestMsgStore, 0, sizeof(gTestMsgStore));
+	CHECK_ROS(MountMessageFileSystem_ROS(gTestMsgStore, sizeof(gTestMsgStore), 0u, 0u, &failed_at, \
+										 NULL, MSG_MOUNT_PERSISTENT_ROS) == \
+			  F_MSG_FS_NOT_FORMATTED_ROS);
+	MountStore();
+}
+
+/* Messages can only be addressed to vectors with an inbox */
+static void TestTargetRange(void)
+{
+	MsgDescriptor_ROS batch[2] =
+	{
+		{ 0x21u, 5u, 0u, 4u, gData },
+		{ 0x22u, NUM_MSG_INBOXES_ROS, 0u, 4u, gData }
+	};
+	uint8_t failed_message;
+
+	MountStore();
+	CHECK_ROS(CreateMessage_ROS(0x20u, NUM_MSG_INBOXES_ROS - 1u, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x23u, NUM_MSG_INBOXES_ROS, 0u, 4u, gData) == \
+			  F_MSG_TARGET_INVALID_ROS);
+	CHECK_ROS(CreateMessages_ROS(batch, 2u, &failed_message) == F_MSG_TARGET_INVALID_ROS);
+	CHECK_ROS(failed_message == 1u);
+	CHECK_ROS(DeleteMessage_ROS(0x21u) == F_MSG_ID_EMPTY_ROS);
+}
+
+/* A batch that fails part way leaves the inboxes it targets as they were, and a batch message
+   that fits no single free space is chained */
+static void TestBatchRollback(void)
+{
+	MsgDescriptor_ROS batch[2] =
+	{
+		{ 0x22u, 5u, 0u, 4u, gData },
+		{ 0x23u, 5u, 0u, 32u, gData }
+	};
+	uint8_t failed_message, head;
+	size_t i;
+#if (ENABLE_MSG_CHAINS_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+	uint8_t buffer[MAX_MSG_BYTES_ROS];
+#endif
+
+	MountStore();
+	for(i = 0u; i < sizeof(gData); i++)
+	{
+		gData[i] = (uint8_t)(i + 1u);
+	}
+
+	/* Leave 27 bytes free on top of the store, too few for the second message */
+	CHECK_ROS(CreateMessage_ROS(0x21u, 5u, 0u, 4u, gData) == SUCCESS_ROS);
+	for(i = 0u; i < 7u; i++)
+	{
+		CHECK_ROS(CreateMessage_ROS(0x30u + i, MSG_TARG_GLOBAL_ROS, 0u, 32u, gData) == SUCCESS_ROS);
+	}
+	SettleStore();
+	head = gMsgInboxHeadArray_ROS[5];
+	CHECK_ROS(head != NULL_MSG_ROS);
+
+	/* The first message is placed, then rolled back before it is delivered */
+#if (ENABLE_MSG_CHAINS_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+	CHECK_ROS(CreateMessages_ROS(batch, 2u, &failed_message) == F_INSUFF_MEM_SPACE_ROS);
+#else
+	CHECK_ROS(CreateMessages_ROS(batch, 2u, &failed_message) == F_INSUFF_FREE_MEM_ROS);
+#endif
+	CHECK_ROS(failed_message == 1u);
+	CHECK_ROS(gMsgInboxHeadArray_ROS[5] == head);
+	CHECK_ROS(DeleteMessage_ROS(0x22u) == F_MSG_ID_EMPTY_ROS);
+
+#if (ENABLE_MSG_CHAINS_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+	/* Leave a 12 byte hole, so the second message only fits split with the top of the store */
+	CHECK_ROS(DeleteMessage_ROS(0x30u) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x40u, MSG_TARG_GLOBAL_ROS, 0u, 20u, gData) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessages_ROS(&batch[1], 1u, &failed_message) == SUCCESS_ROS);
+	CHECK_ROS(ReadMessage_ROS(0x23u, 32u, buffer) == SUCCESS_ROS);
+	CHECK_ROS(memcmp(buffer, gData, 32u) == 0);
+	CHECK_ROS(gMsgInboxHeadArray_ROS[5] == head);
+	CHECK_ROS(DeleteMessage_ROS(0x23u) == SUCCESS_ROS);
+#endif
+	CHECK_ROS(DeleteMessage_ROS(0x21u) == SUCCESS_ROS);
+	SettleStore();
+	CHECK_ROS(gMsgInboxHeadArray_ROS[5] == NULL_MSG_ROS);
+}
+
+#if (ENABLE_MSG_CHAINS_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+/* A message too large for any one free space is scattered over several holes, gathered back in
+   order, and every segment's space and table entry is released when it is deleted */
+static void TestChainScatterGather(void)
+{
+	uint8_t buffer[12];
+	uint8_t segments[MAX_MSG_SEGMENTS_ROS];
+	uint8_t num_segments = 0u, message_index = NULL_MSG_ROS, j;
+	MsgSize_ROS total_size = 0u;
+	size_t i;
+
+	/* 4 byte messages 0x20 to 0x24 at 1 to 17, and the rest of the store filled */
+	MountStore();
+	for(i = 0u; i < sizeof(gData); i++)
+	{
+		gData[i] = (uint8_t)(i + 1u);
+	}
+	for(i = 0u; i < 5u; i++)
+	{
+		CHECK_ROS(CreateMessage_ROS(0x20u + i, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	}
+	for(i = 0u; i < 7u; i++)
+	{
+		CHECK_ROS(CreateMessage_ROS(0x30u + i, MSG_TARG_GLOBAL_ROS, 0u, 32u, gData) == SUCCESS_ROS);
+	}
+	CHECK_ROS(CreateMessage_ROS(0x37u, MSG_TARG_GLOBAL_ROS, 0u, 10u, gData) == SUCCESS_ROS);
+	CHECK_ROS(gNextFreeMsgLoc_ROS == (MAX_MSG_STOR_BYTES_ROS - 1u));
+
+	/* 12 bytes only fit over the three 4 byte holes at 1, 9 and 17 */
+	CHECK_ROS(DeleteMessage_ROS(0x20u) == SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x22u) == SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x24u) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x40u, MSG_TARG_GLOBAL_ROS, 0u, 12u, gData) == SUCCESS_ROS);
+	CHECK_ROS((gNumDelMsg_ROS == 0u) && (gNumDelBytes_ROS == 0u));
+
+	/* Walk the chain from its first segment */
+	for(j = 1u; j < MAX_MSGS_ROS; j++)
+	{
+		if((gMsgTOC_ROS[j][MSG_ID_ROS] == 0x40u) && (gMsgTOC_ROS[j][MSG_SIZE_ROS] != NULL_SIZE_ROS))
+		{
+			message_index = j;
+		}
+	}
+	for(j = message_index; (j != NULL_MSG_ROS) && (num_segments < MAX_MSG_SEGMENTS_ROS); \
+		j = gMsgTOC_ROS[j][MSG_CHAIN_ROS])
+	{
+		CHECK_ROS((gMsgTOC_ROS[j][MSG_LOC_ROS] == 1u) || (gMsgTOC_ROS[j][MSG_LOC_ROS] == 9u) || \
+				  (gMsgTOC_ROS[j][MSG_LOC_ROS] == 17u));
+		total_size += gMsgTOC_ROS[j][MSG_SIZE_ROS];
+		segments[num_segments++] = j;
+	}
+	CHECK_ROS((num_segments == 3u) && (total_size == 12u));
+
+	/* The segments read back as the data written, whole or gathered */
+	memset(buffer, 0, sizeof(buffer));
+	_GatherMessageData_ROS(message_index, buffer, 12u);
+	CHECK_ROS(memcmp(buffer, gData, 12u) == 0);
+	memset(buffer, 0, sizeof(buffer));
+	CHECK_ROS(ReadMessage_ROS(0x40u, 12u, buffer) == SUCCESS_ROS);
+	CHECK_ROS(memcmp(buffer, gData, 12u) == 0);
+
+	/* Deleting it frees every segment's entry, and its space becomes the three holes again */
+	CHECK_ROS(DeleteMessage_ROS(0x40u) == SUCCESS_ROS);
+	for(j = 0u; j < num_segments; j++)
+	{
+		CHECK_ROS(gMsgTOC_ROS[segments[j]][MSG_SIZE_ROS] == NULL_SIZE_ROS);
+	}
+	CHECK_ROS((gNumDelMsg_ROS == 3u) && (gNumDelBytes_ROS == 12u));
+	CHECK_ROS(OptimizeMessageStorage_ROS(0xFFu) == SUCCESS_ROS);
+	CHECK_ROS(gNextFreeMsgLoc_ROS == (MAX_MSG_STOR_BYTES_ROS - 13u));
+}
+#endif
+
+/* Waiting task body. The first run waits for the message ID given by the task's vector (two IDs
+   sharing a wait list), a later run records the wake */
+static void TaskWaiter(void)
+{
+	uint8_t vector = (uint8_t)TASK_VECTOR_ROS(RUNNING_TASK_ID_ROS);
+
+	if(ResumeMessageWait_ROS() == F_MSG_NOT_WAITING_ROS)
+	{
+		(void)WaitForMessage_ROS((vector == 7u) ? (0x41u + NUM_MSG_WAIT_BUCKETS_ROS) : 0x41u, \
+								 MSG_TARG_GLOBAL_ROS, 0u);
+	}
+	else
+	{
+		gWakeOrder[gNumWakes++] = (char)('0' + vector);
+	}
+}
+
+/* A message wakes the highest priority waiter on its ID at the priority it has then, past a
+   waiter on another ID sharing the wait list */
+static void TestWaitPriority(void)
+{
+	uint32_t used;
+	uint8_t i;
+
+	MountStore();
+	CHECK_ROS(MountTaskTables_ROS(gTestTaskMemory, sizeof(gTestTaskMemory), 4u, 32u, &used) == \
+			  SUCCESS_ROS);
+	for(i = 5u; i <= 7u; i++)
+	{
+		CHECK_ROS(CreateTask_ROS(i, 40u, 50u, false, (uint8_t *)"waiter", TaskWaiter) == SUCCESS_ROS);
+		CHECK_ROS(QueueTask_ROS(i) == SUCCESS_ROS);
+		CHECK_ROS(DispatchTask_ROS() == SUCCESS_ROS);
+	}
+
+	/* Lend the later of the two waiters on 0x41 a higher priority once it is waiting */
+	CHECK_ROS(InheritTaskPriority_ROS(6u, 200u) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x41u, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(DispatchTask_ROS() == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x41u + NUM_MSG_WAIT_BUCKETS_ROS, MSG_TARG_GLOBAL_ROS, 0u, 4u, \
+								gData) == SUCCESS_ROS);
+	CHECK_ROS(DispatchTask_ROS() == SUCCESS_ROS);
+	gWakeOrder[gNumWakes] = '\0';
+	CHECK_ROS(strcmp(gWakeOrder, "67") == 0);
+	CHECK_ROS(RestoreTaskPriority_ROS(6u) == SUCCESS_ROS);
+}
+
+/* Timed waiting task body. The first run starts the wait, a later run records how it ended */
+static void TaskTimedWaiter(void)
+{
+	uint8_t result = ResumeMessageWait_ROS();
+
+	if(result == F_MSG_NOT_WAITING_ROS)
+	{
+		gWaitResult = WaitForMessage_ROS(gWaitID, MSG_TARG_GLOBAL_ROS, gWaitTimeout);
+	}
+	else
+	{
+		gWaitResult = result;
+	}
+}
+
+/* Mount a fresh store and task tables, with the timed waiter at vector 8 (TestWaitPriority
+   leaves the task at vector 5 waiting) */
+static void SetUpTimedWaiter(MsgID_ROS message_id, uint32_t timeout)
+{
+	uint32_t used;
+
+	MountStore();
+	CHECK_ROS(MountTaskTables_ROS(gTestTaskMemory, sizeof(gTestTaskMemory), 4u, 32u, &used) == \
+			  SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(8u, 40u, 50u, false, (uint8_t *)"waiter", TaskTimedWaiter) == \
+			  SUCCESS_ROS);
+	gWaitID = message_id;
+	gWaitTimeout = timeout;
+}
+
+/* A waiter is queued by its timeout if the message does not come in time, and a message that
+   comes in time cancels the timeout */
+static void TestWaitTimeout(void)
+{
+	SetUpTimedWaiter(0x42u, 3u);
+	RunTask(8u);
+	CHECK_ROS(gWaitResult == FALSE_ROS);
+	TickScheduler_ROS();
+	TickScheduler_ROS();
+	CHECK_ROS(DispatchTask_ROS() != SUCCESS_ROS);
+	TickScheduler_ROS();
+	CHECK_ROS(DispatchTask_ROS() == SUCCESS_ROS);
+	CHECK_ROS(gWaitResult == F_MSG_WAIT_TIMEOUT_ROS);
+
+	/* The wait is over, so a late message does not queue the task */
+	CHECK_ROS(CreateMessage_ROS(0x42u, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(DispatchTask_ROS() != SUCCESS_ROS);
+	CHECK_ROS(DeleteMessage_ROS(0x42u) == SUCCESS_ROS);
+
+	/* The message comes first, and the timer no longer queues the task */
+	RunTask(8u);
+	CHECK_ROS(gWaitResult == FALSE_ROS);
+	TickScheduler_ROS();
+	CHECK_ROS(CreateMessage_ROS(0x42u, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(DispatchTask_ROS() == SUCCESS_ROS);
+	CHECK_ROS(gWaitResult == TRUE_ROS);
+	TickScheduler_ROS();
+	TickScheduler_ROS();
+	TickScheduler_ROS();
+	CHECK_ROS(DispatchTask_ROS() != SUCCESS_ROS);
+}
+
+/* An inbox waiter is only woken by a message addressed to it, and does not block while its inbox
+   holds a message */
+static void TestWaitInbox(void)
+{
+	SetUpTimedWaiter(MSG_WAIT_INBOX_ROS, 0u);
+	RunTask(8u);
+	CHECK_ROS(gWaitResult == FALSE_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x43u, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x44u, 6u, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(DispatchTask_ROS() != SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x45u, 8u, 0u, 4u, gData) == SUCCESS_ROS);
+	CHECK_ROS(DispatchTask_ROS() == SUCCESS_ROS);
+	CHECK_ROS(gWaitResult == TRUE_ROS);
+
+	/* 0x45 is still in the inbox */
+	RunTask(8u);
+	CHECK_ROS(gWaitResult == TRUE_ROS);
+}
+
+int main(void)
+{
+#if !(ENABLE_LOCK_FREE_MSGS_ROS)
+	TestHoleSplit();
+	TestHoleMerge();
+	TestHoleTableFull();
+#endif
+	TestDefragSteps();
+	TestReserveAndBorrow();
+#if (ENABLE_MSG_EXPIRY_ROS)
+	TestExpiryOrder();
+#endif
+#if (ENABLE_MSG_TOPICS_ROS)
+	TestTopicReferences();
+#endif
+	TestMountModes();
+	TestPersistentMount();
+	TestTargetRange();
+	TestBatchRollback();
+#if (ENABLE_MSG_CHAINS_ROS) && !(ENABLE_LOCK_FREE_MSGS_ROS)
+	TestChainScatterGather();
+#endif
+	TestWaitPriority();
+	TestWaitTimeout();
+	TestWaitInbox();
+	return CHECK_RESULT_ROS();
+}
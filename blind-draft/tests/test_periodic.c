@@ -0,0 +1,131 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: test_periodic.c
+* Description   	: Tests of the periodic task releases and their statistics
+*					  (schedule.c).
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <stdlib.h>
+#include "tasks.h"
+#include "check.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define F_TASK_QUEUE_EMPTY_ROS			0x47
+#define F_TASK_MEM_TOO_SMALL_ROS		0x0D
+extern uint16_t * gTaskMaxJitterArray_ROS;
+
+/* Task table memory block, grown to the size the tables report they need
+   (which includes the task stacks in preemptive mode) */
+static uint8_t * gTestTaskMemory;
+static uint32_t gTestTaskMemoryBytes;
+
+/* Number of runs of each task */
+static uint32_t gRunsA;
+static uint32_t gRunsB;
+
+static void TaskA(void) { gRunsA++; }
+static void TaskB(void) { gRunsB++; }
+
+/* Mount fresh task tables, growing the memory block first if it is too
+   small for them */
+static uint8_t MountTaskMemory(TaskID_ROS max_tasks, TaskID_ROS max_task_vectors)
+{
+	uint32_t required;
+	uint8_t result = MountTaskTables_ROS(gTestTaskMemory, gTestTaskMemoryBytes, max_tasks, \
+										 max_task_vectors, &required);
+
+	/* Check if the block was too small, and mount again in a big enough one */
+	if(result == F_TASK_MEM_TOO_SMALL_ROS)
+	{
+		free(gTestTaskMemory);
+		gTestTaskMemory = malloc(required);
+		gTestTaskMemoryBytes = (gTestTaskMemory != NULL) ? required : 0u;
+		result = MountTaskTables_ROS(gTestTaskMemory, gTestTaskMemoryBytes, max_tasks, \
+									 max_task_vectors, &required);
+	}
+	return result;
+}
+
+/* Mount fresh task tables for max_tasks tasks and 32 vectors */
+static void MountTables(TaskID_ROS max_tasks)
+{
+	CHECK_ROS(MountTaskMemory(max_tasks, 32u) == SUCCESS_ROS);
+	gRunsA = 0u;
+	gRunsB = 0u;
+}
+
+/* Advance the tick, dispatching everything ready after each tick */
+static void RunTicks(uint32_t ticks)
+{
+	while(ticks-- != 0u)
+	{
+		TickScheduler_ROS();
+		while(DispatchTask_ROS() == SUCCESS_ROS)
+		{
+		}
+	}
+}
+
+/* A destroyed periodic task is no longer released, and its reused ID starts
+   without a release timer */
+static void TestDestroyArmedTask(void)
+{
+	MountTables(2u);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"periodic", TaskA) == SUCCESS_ROS);
+	CHECK_ROS(CreatePeriodicTask_ROS(5u, 10u, 5u) == SUCCESS_ROS);
+	RunTicks(5u);
+	CHECK_ROS(gRunsA == 1u);
+
+	CHECK_ROS(DestroyTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(6u, 10u, 50u, false, (uint8_t *)"reuse", TaskB) == SUCCESS_ROS);
+	RunTicks(100u);
+	CHECK_ROS(gRunsA == 1u);
+	CHECK_ROS(gRunsB == 0u);
+	CHECK_ROS(DispatchTask_ROS() == F_TASK_QUEUE_EMPTY_ROS);
+}
+
+/* Only dispatches of a release are measured as jitter, not plain wake ups */
+static void TestJitterOnReleasesOnly(void)
+{
+	TaskID_ROS task_id;
+	uint8_t tick;
+
+	MountTables(2u);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"periodic", TaskA) == SUCCESS_ROS);
+	CHECK_ROS(CreatePeriodicTask_ROS(5u, 10u, 10u) == SUCCESS_ROS);
+	task_id = gTaskVectorLookupArray_ROS[5];
+
+	/* Released and dispatched on time */
+	RunTicks(10u);
+	CHECK_ROS(gRunsA == 1u);
+	CHECK_ROS(gTaskMaxJitterArray_ROS[task_id] == 0u);
+
+	/* Woken between releases */
+	RunTicks(6u);
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(DispatchTask_ROS() == SUCCESS_ROS);
+	CHECK_ROS(gRunsA == 2u);
+	CHECK_ROS(gTaskMaxJitterArray_ROS[task_id] == 0u);
+
+	/* Release at tick 20 dispatched at tick 23 */
+	for(tick = 0u; tick < 7u; tick++)
+	{
+		TickScheduler_ROS();
+	}
+	CHECK_ROS(DispatchTask_ROS() == SUCCESS_ROS);
+	CHECK_ROS(gRunsA == 3u);
+	CHECK_ROS(gTaskMaxJitterArray_ROS[task_id] == 3u);
+}
+
+int main(void)
+{
+	TestDestroyArmedTask();
+	TestJitterOnReleasesOnly();
+	return CHECK_RESULT_ROS();
+}
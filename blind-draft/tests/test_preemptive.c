@@ -0,0 +1,99 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: test_preemptive.c
+* Description   	: Tests of the preemptive kernel mode
+*					  (ENABLE_PREEMPTIVE_KERNEL_ROS, schedule.c).
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <string.h>
+#include "tasks.h"
+#include "check.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+
+/* Task table memory block, large enough for the task stacks */
+static uint8_t gTestTaskMemory[131072];
+
+/* Order the tasks' runs started and finished in: upper case on start, lower
+   case on finish */
+static char gRunOrder[32];
+static uint8_t gNumRuns;
+
+/* Low priority task. Its first run is preempted by the high one */
+static void TaskLow(void)
+{
+	bool is_first = (gNumRuns == 0u);
+
+	gRunOrder[gNumRuns++] = 'L';
+	if(is_first)
+	{
+		(void)KERNEL_CALL_ROS(QueueTask_ROS(6u));
+	}
+	gRunOrder[gNumRuns++] = 'l';
+}
+
+/* High priority task. Queues the preempted low task again, and lends it a
+   priority between the two, so its new run is ready above the preempted one */
+static void TaskHigh(void)
+{
+	gRunOrder[gNumRuns++] = 'H';
+	(void)KERNEL_CALL_ROS(QueueTask_ROS(5u));
+	(void)KERNEL_CALL_ROS(InheritTaskPriority_ROS(5u, 100u));
+	gRunOrder[gNumRuns++] = 'h';
+}
+
+/* Dispatch until nothing is ready, and return the run order */
+static const char * RunAll(void)
+{
+	uint8_t dispatches = 0u;
+
+	while((DispatchTask_ROS() == SUCCESS_ROS) && (++dispatches < 16u))
+	{
+	}
+	gRunOrder[gNumRuns] = '\0';
+	return gRunOrder;
+}
+
+/* A preempted task queued again finishes its preempted run before it starts
+   the new one, rather than being restarted over it */
+static void TestRequeuePreempted(void)
+{
+	uint32_t used;
+	uint8_t i;
+
+	CHECK_ROS(MountTaskTables_ROS(gTestTaskMemory, sizeof(gTestTaskMemory), 4u, 32u, &used) == \
+			  SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"low", TaskLow) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(6u, 150u, 50u, false, (uint8_t *)"high", TaskHigh) == SUCCESS_ROS);
+
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+
+	/* The low run is preempted, the high run queues it again, then the
+	   preempted run is resumed */
+	for(i = 0u; i < 3u; i++)
+	{
+		CHECK_ROS(DispatchTask_ROS() == SUCCESS_ROS);
+	}
+	gRunOrder[gNumRuns] = '\0';
+	CHECK_ROS(strcmp(gRunOrder, "LHhl") == 0);
+
+	/* The new run follows (a restarted task would have lost the preempted
+	   run's context, so is not dispatched further) */
+	if(gCheckFailures_ROS == 0u)
+	{
+		CHECK_ROS(strcmp(RunAll(), "LHhlLl") == 0);
+	}
+	CHECK_ROS(RestoreTaskPriority_ROS(5u) == SUCCESS_ROS);
+}
+
+int main(void)
+{
+	TestRequeuePreempted();
+	return CHECK_RESULT_ROS();
+}
@@ -0,0 +1,120 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: test_smp.c
+* Description   	: Tests of the SMP mode (ENABLE_SMP_ROS, schedule.c), with
+*					  every simulated core dispatching at once.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include "tasks.h"
+#include "port_posix.h"
+#include "check.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define MIN_TASK_VECTOR_ROS				5u
+
+/* Number of tasks, and the runs each task makes by queuing itself again */
+#define TEST_TASKS						16u
+#define TEST_RUNS						500u
+
+/* Task table memory block */
+static uint8_t gTestTaskMemory[16384];
+
+/* Runs of each task, whether it is running, and the cores it ran on, by
+   vector */
+static volatile uint32_t gRuns[MIN_TASK_VECTOR_ROS + TEST_TASKS];
+static volatile bool gIsRunning[MIN_TASK_VECTOR_ROS + TEST_TASKS];
+static volatile uint8_t gCoresUsed[MIN_TASK_VECTOR_ROS + TEST_TASKS];
+
+/* Runs still to make over every task, and failures seen on the cores */
+static volatile uint32_t gRunsLeft;
+static volatile uint32_t gCoreFailures;
+
+/* Counting task: checks it is not running on another core as well, records
+   its core, and queues itself again until it has made TEST_RUNS runs */
+static void CountingTask(void)
+{
+	TaskID_ROS vector = TASK_VECTOR_ROS(RUNNING_TASK_ID_ROS);
+
+	if(__atomic_exchange_n(&gIsRunning[vector], true, __ATOMIC_ACQ_REL))
+	{
+		__atomic_add_fetch(&gCoreFailures, 1u, __ATOMIC_RELAXED);
+	}
+	__atomic_or_fetch(&gCoresUsed[vector], (uint8_t)(1u << CURRENT_CORE_ROS()), __ATOMIC_RELAXED);
+	gRuns[vector]++;
+	__atomic_store_n(&gIsRunning[vector], false, __ATOMIC_RELEASE);
+
+	if((gRuns[vector] < TEST_RUNS) && \
+	   (KERNEL_CALL_ROS(QueueTask_ROS(vector)) != SUCCESS_ROS))
+	{
+		__atomic_add_fetch(&gCoreFailures, 1u, __ATOMIC_RELAXED);
+	}
+	__atomic_sub_fetch(&gRunsLeft, 1u, __ATOMIC_ACQ_REL);
+}
+
+/* Core loop: dispatch until every run is made */
+static void CoreLoop(void)
+{
+	while(__atomic_load_n(&gRunsLeft, __ATOMIC_ACQUIRE) != 0u)
+	{
+		(void)DispatchTask_ROS();
+	}
+}
+
+/* Mount fresh tables with the counting tasks, binding the task at vector 5 to
+   the last core and the task at vector 6 to cores 0 and 1 */
+static void SetUp(void)
+{
+	uint32_t used;
+	TaskID_ROS vector;
+
+	CHECK_ROS(MountTaskTables_ROS(gTestTaskMemory, sizeof(gTestTaskMemory), TEST_TASKS, \
+								  MIN_TASK_VECTOR_ROS + TEST_TASKS, &used) == SUCCESS_ROS);
+	for(vector = MIN_TASK_VECTOR_ROS; vector < (MIN_TASK_VECTOR_ROS + TEST_TASKS); vector++)
+	{
+		CHECK_ROS(CreateTask_ROS(vector, (uint8_t)(10u + vector), 50u, false, \
+								 (uint8_t *)"counting", CountingTask) == SUCCESS_ROS);
+		gRuns[vector] = 0u;
+		gCoresUsed[vector] = 0u;
+	}
+	CHECK_ROS(SetTaskAffinity_ROS(5u, (uint8_t)(1u << (NUM_CORES_ROS - 1u))) == SUCCESS_ROS);
+	CHECK_ROS(SetTaskAffinity_ROS(6u, 0x03u) == SUCCESS_ROS);
+	gRunsLeft = TEST_TASKS * TEST_RUNS;
+	gCoreFailures = 0u;
+}
+
+/* Every run is made exactly once, no task runs on two cores at once, and
+   bound tasks only run on the cores they are bound to */
+static void TestCoresShareTasks(void)
+{
+	TaskID_ROS vector;
+
+	SetUp();
+	for(vector = MIN_TASK_VECTOR_ROS; vector < (MIN_TASK_VECTOR_ROS + TEST_TASKS); vector++)
+	{
+		CHECK_ROS(QueueTask_ROS(vector) == SUCCESS_ROS);
+	}
+	CHECK_ROS(StartSimulatedCores_ROS(NUM_CORES_ROS, CoreLoop) == SUCCESS_ROS);
+	JoinSimulatedCores_ROS();
+
+	CHECK_ROS(gCoreFailures == 0u);
+	CHECK_ROS(gRunsLeft == 0u);
+	for(vector = MIN_TASK_VECTOR_ROS; vector < (MIN_TASK_VECTOR_ROS + TEST_TASKS); vector++)
+	{
+		CHECK_ROS(gRuns[vector] == TEST_RUNS);
+	}
+	CHECK_ROS(gCoresUsed[5u] == (uint8_t)(1u << (NUM_CORES_ROS - 1u)));
+	CHECK_ROS((gCoresUsed[6u] & ~0x03u) == 0u);
+	CHECK_ROS(DispatchTask_ROS() != SUCCESS_ROS);
+}
+
+int main(void)
+{
+	TestCoresShareTasks();
+	return CHECK_RESULT_ROS();
+}
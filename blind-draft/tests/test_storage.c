@@ -0,0 +1,123 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: test_storage.c
+* Description   	: Tests of the page buffered flash backend (storage.c), on a
+*					  RAM flash device that counts erases and programs.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <string.h>
+#include "tasks.h"
+#include "messages.h"
+#include "storage.h"
+#include "check.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+
+/* RAM flash device geometry */
+#define TEST_PAGE_BYTES					64u
+#define TEST_NUM_PAGES					16u
+
+/* RAM flash device, and its operation counts */
+static uint8_t gFlash[TEST_NUM_PAGES][TEST_PAGE_BYTES];
+static uint32_t gErases;
+static uint32_t gPrograms;
+
+/* Message store, and message data */
+static uint8_t gTestMsgStore[MSG_FS_BLOCK_BYTES_ROS];
+static uint8_t gData[MAX_MSG_BYTES_ROS];
+
+/* RAM flash driver functions */
+static uint8_t RamReadPage(void * device, uint16_t page, uint8_t * data)
+{
+	(void)device;
+	memcpy(data, gFlash[page], TEST_PAGE_BYTES);
+	return SUCCESS_ROS;
+}
+
+static uint8_t RamProgramPage(void * device, uint16_t page, const uint8_t * data)
+{
+	uint32_t i;
+
+	(void)device;
+	for(i = 0u; i < TEST_PAGE_BYTES; i++)
+	{
+		gFlash[page][i] &= data[i];
+	}
+	gPrograms++;
+	return SUCCESS_ROS;
+}
+
+static uint8_t RamErasePage(void * device, uint16_t page)
+{
+	(void)device;
+	memset(gFlash[page], 0xFF, TEST_PAGE_BYTES);
+	gErases++;
+	return SUCCESS_ROS;
+}
+
+static FlashDevice_ROS gDevice =
+{
+	RamReadPage, RamProgramPage, RamErasePage, NULL, TEST_PAGE_BYTES, TEST_NUM_PAGES
+};
+
+/* Small creates coalesce in the page buffers, so a burst of them costs a few page programs in
+   total rather than some per create, and the store reads back after a persistent mount */
+static void TestCreateCoalescing(void)
+{
+	FlashBackend_ROS flash;
+	MsgStorageBackend_ROS backend;
+	uint8_t buffer[4];
+	uint32_t failed_at, first_record, last_record;
+	size_t i;
+
+	memset(gFlash, 0xFF, sizeof(gFlash));
+	for(i = 0u; i < sizeof(gData); i++)
+	{
+		gData[i] = (uint8_t)(0xA0u + i);
+	}
+
+	CHECK_ROS(InitFlashBackend_ROS(&flash, &gDevice, MSG_FS_BLOCK_BYTES_ROS, &backend) == \
+			  SUCCESS_ROS);
+	CHECK_ROS(MountMessageFileSystem_ROS(gTestMsgStore, sizeof(gTestMsgStore), 0u, 0u, &failed_at, \
+										 &backend, MSG_MOUNT_TRUSTED_ROS) == SUCCESS_ROS);
+	CHECK_ROS(FlushMessageStorage_ROS() == SUCCESS_ROS);
+
+	/* 20 creates touch two data pages, and the pages holding records 1 to 20 (four with 8 bit
+	   fields, more with wider ones) */
+	first_record = MSG_FS_HEADER_LOC_ROS + MSG_FS_MAGIC_BYTES_ROS + MSG_FS_RECORD_BYTES_ROS;
+	last_record = first_record + (20u * MSG_FS_RECORD_BYTES_ROS) - 1u;
+	gErases = 0u;
+	gPrograms = 0u;
+	for(i = 0u; i < 20u; i++)
+	{
+		CHECK_ROS(CreateMessage_ROS(0x20u + i, MSG_TARG_GLOBAL_ROS, 0u, 4u, gData) == SUCCESS_ROS);
+	}
+	CHECK_ROS(FlushMessageStorage_ROS() == SUCCESS_ROS);
+	CHECK_ROS(gErases <= (2u + (last_record / flash.payload_bytes) - \
+						  (first_record / flash.payload_bytes) + 1u));
+	CHECK_ROS(gPrograms == gErases);
+
+	/* Everything created is on the device */
+	memset(gTestMsgStore, 0, sizeof(gTestMsgStore));
+	CHECK_ROS(InitFlashBackend_ROS(&flash, &gDevice, MSG_FS_BLOCK_BYTES_ROS, &backend) == \
+			  SUCCESS_ROS);
+	CHECK_ROS(MountMessageFileSystem_ROS(gTestMsgStore, sizeof(gTestMsgStore), 0u, 0u, &failed_at, \
+										 &backend, MSG_MOUNT_PERSISTENT_ROS) == SUCCESS_ROS);
+	for(i = 0u; i < 20u; i++)
+	{
+		CHECK_ROS(ReadMessage_ROS(0x20u + i, 4u, buffer) == SUCCESS_ROS);
+		CHECK_ROS(memcmp(buffer, gData, 4u) == 0);
+	}
+}
+
+int main(void)
+{
+	TestCreateCoalescing();
+	return CHECK_RESULT_ROS();
+}
@@ -0,0 +1,298 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: test_tasks.c
+* Description   	: Tests of the task administration API (tasks.c) and the
+*					  ready lists it feeds (schedule.c).
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <string.h>
+#include "tasks.h"
+#include "messages.h"
+#include "check.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define TRUE_ROS						0x02
+#define F_TASK_VECTOR_OCCUPIED_ROS		0x05
+#define F_TASK_VECTOR_EMPTY_ROS			0x06
+#define F_TASK_INFO_TOO_SMALL_ROS		0x07
+#define F_TASK_TIMEOUT_TOO_LOW_ROS		0x08
+#define F_TASK_TIMEOUT_TOO_HIGH_ROS		0x09
+#define F_TASK_PROTECTED_ROS			0x0A
+#define F_TASK_VECTOR_TOO_HIGH			0x0B
+#define F_TASK_VECTOR_TOO_LOW			0x0C
+#define F_MAX_TASKS_REACHED_ROS			0x0F
+#define F_TASK_QUEUE_EMPTY_ROS			0x47
+#define F_TASK_ALREADY_COROUTINE_ROS	0x5A
+
+/* Task table memory block, large enough for the preemptive task stacks */
+static uint8_t gTestTaskMemory[131072];
+
+/* Order the test tasks ran in */
+static char gRunOrder[32];
+static uint8_t gNumRuns;
+
+static void TaskA(void) { gRunOrder[gNumRuns++] = 'A'; }
+static void TaskB(void) { gRunOrder[gNumRuns++] = 'B'; }
+static void TaskC(void) { gRunOrder[gNumRuns++] = 'C'; }
+
+#if (ENABLE_COROUTINE_TASKS_ROS)
+/* Message store, for the coroutine message wait */
+static uint8_t gTestMsgStore[MSG_FS_BLOCK_BYTES_ROS];
+
+/* Tick the sleeping coroutine wakes at */
+static uint32_t gWakeTick;
+
+/* Yielding coroutine: records a, b and c, yielding between them */
+static uint8_t YieldingCoroutine(uint16_t * resume_point)
+{
+	COROUTINE_BEGIN_ROS(resume_point);
+	gRunOrder[gNumRuns++] = 'a';
+	COROUTINE_YIELD_ROS(resume_point);
+	gRunOrder[gNumRuns++] = 'b';
+	COROUTINE_YIELD_ROS(resume_point);
+	gRunOrder[gNumRuns++] = 'c';
+	COROUTINE_END_ROS(resume_point);
+}
+
+/* Sleeping coroutine: records s, sleeps until gWakeTick, then records w */
+static uint8_t SleepingCoroutine(uint16_t * resume_point)
+{
+	COROUTINE_BEGIN_ROS(resume_point);
+	gRunOrder[gNumRuns++] = 's';
+	COROUTINE_SLEEP_UNTIL_ROS(resume_point, gWakeTick);
+	gRunOrder[gNumRuns++] = 'w';
+	COROUTINE_END_ROS(resume_point);
+}
+
+/* Receiving coroutine: records r, waits for its inbox, then records m and the message's first
+   byte */
+static uint8_t ReceivingCoroutine(uint16_t * resume_point)
+{
+	uint8_t buffer[4];
+	MsgID_ROS message_id;
+	MsgSize_ROS message_size;
+
+	COROUTINE_BEGIN_ROS(resume_point);
+	gRunOrder[gNumRuns++] = 'r';
+	COROUTINE_WAIT_MESSAGE_ROS(resume_point);
+	gRunOrder[gNumRuns++] = 'm';
+	if(ReceiveMessage_ROS(sizeof(buffer), buffer, &message_id, &message_size) == SUCCESS_ROS)
+	{
+		gRunOrder[gNumRuns++] = (char)buffer[0];
+	}
+	COROUTINE_END_ROS(resume_point);
+}
+#endif
+
+/* Mount fresh task tables for max_tasks tasks and 32 vectors */
+static void MountTables(TaskID_ROS max_tasks)
+{
+	uint32_t used;
+
+	CHECK_ROS(MountTaskTables_ROS(gTestTaskMemory, sizeof(gTestTaskMemory), max_tasks, 32u, \
+								  &used) == SUCCESS_ROS);
+	gNumRuns = 0u;
+}
+
+/* Dispatch until nothing is ready, and return the run order */
+static const char * RunAll(void)
+{
+	gNumRuns = 0u;
+	while(DispatchTask_ROS() == SUCCESS_ROS)
+	{
+	}
+	gRunOrder[gNumRuns] = '\0';
+	return gRunOrder;
+}
+
+/* Creation input validation */
+static void TestCreateValidation(void)
+{
+	MountTables(4u);
+
+	CHECK_ROS(CreateTask_ROS(4u, 10u, 50u, false, (uint8_t *)"low", TaskA) == F_TASK_VECTOR_TOO_LOW);
+	CHECK_ROS(CreateTask_ROS(32u, 10u, 50u, false, (uint8_t *)"high", TaskA) == \
+			  F_TASK_VECTOR_TOO_HIGH);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 4u, false, (uint8_t *)"short", TaskA) == \
+			  F_TASK_TIMEOUT_TOO_LOW_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 201u, false, (uint8_t *)"long", TaskA) == \
+			  F_TASK_TIMEOUT_TOO_HIGH_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 300u, false, (uint8_t *)"wrap", TaskA) == \
+			  F_TASK_TIMEOUT_TOO_HIGH_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"ab", TaskA) == \
+			  F_TASK_INFO_TOO_SMALL_ROS);
+
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"alpha", TaskA) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"again", TaskA) == \
+			  F_TASK_VECTOR_OCCUPIED_ROS);
+	CHECK_ROS(strcmp((char *)TASK_INFO_ROS(gTaskVectorLookupArray_ROS[5]), "alpha") == 0);
+}
+
+/* Capacity limit */
+static void TestCapacity(void)
+{
+	TaskID_ROS vector;
+
+	MountTables(3u);
+	for(vector = 5u; vector < 8u; vector++)
+	{
+		CHECK_ROS(CreateTask_ROS(vector, 10u, 50u, false, (uint8_t *)"fill", TaskA) == SUCCESS_ROS);
+	}
+	CHECK_ROS(CreateTask_ROS(8u, 10u, 50u, false, (uint8_t *)"over", TaskA) == \
+			  F_MAX_TASKS_REACHED_ROS);
+}
+
+/* Sleep control */
+static void TestControlSleep(void)
+{
+	MountTables(4u);
+	CHECK_ROS(CreateTask_ROS(6u, 10u, 50u, false, (uint8_t *)"sleeper", TaskA) == SUCCESS_ROS);
+
+	CHECK_ROS(ControlSleepTask_ROS(6u, true) == SUCCESS_ROS);
+	CHECK_ROS(TASK_SLEEP_ROS(gTaskVectorLookupArray_ROS[6]) == true);
+	CHECK_ROS(ControlSleepTask_ROS(6u, false) == SUCCESS_ROS);
+	CHECK_ROS(TASK_SLEEP_ROS(gTaskVectorLookupArray_ROS[6]) == false);
+	CHECK_ROS(ControlSleepTask_ROS(7u, true) == F_TASK_VECTOR_EMPTY_ROS);
+}
+
+/* Dispatch order: highest priority first, first in first out within one */
+static void TestDispatchOrder(void)
+{
+	MountTables(4u);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"task a", TaskA) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(6u, 200u, 50u, false, (uint8_t *)"task b", TaskB) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(7u, 10u, 50u, false, (uint8_t *)"task c", TaskC) == SUCCESS_ROS);
+
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(7u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "BAC") == 0);
+	CHECK_ROS(DispatchTask_ROS() == F_TASK_QUEUE_EMPTY_ROS);
+}
+
+/* A destroyed task leaves the ready lists and is never dispatched */
+static void TestDestroyQueued(void)
+{
+	MountTables(4u);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"task a", TaskA) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(6u, 200u, 50u, false, (uint8_t *)"task b", TaskB) == SUCCESS_ROS);
+	CHECK_ROS(ProtectTask_ROS(5u, true) == SUCCESS_ROS);
+	CHECK_ROS(DestroyTask_ROS(5u) == F_TASK_PROTECTED_ROS);
+	CHECK_ROS(ProtectTask_ROS(5u, false) == SUCCESS_ROS);
+
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(DestroyTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(DestroyTask_ROS(6u) == F_TASK_VECTOR_EMPTY_ROS);
+	CHECK_ROS(strcmp(RunAll(), "A") == 0);
+}
+
+/* Destroyed task IDs are reused, so churn never exhausts the tables */
+static void TestTaskIDReuse(void)
+{
+	uint16_t round;
+
+	MountTables(3u);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"fixed", TaskA) == SUCCESS_ROS);
+	for(round = 0u; round < 100u; round++)
+	{
+		CHECK_ROS(CreateTask_ROS(6u, 10u, 50u, false, (uint8_t *)"churn", TaskB) == SUCCESS_ROS);
+		CHECK_ROS(gTaskVectorLookupArray_ROS[6] < 3u);
+		CHECK_ROS(DestroyTask_ROS(6u) == SUCCESS_ROS);
+	}
+	CHECK_ROS(CreateTask_ROS(6u, 10u, 50u, false, (uint8_t *)"six", TaskB) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(7u, 10u, 50u, false, (uint8_t *)"seven", TaskC) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(8u, 10u, 50u, false, (uint8_t *)"eight", TaskC) == \
+			  F_MAX_TASKS_REACHED_ROS);
+	CHECK_ROS(QueueTask_ROS(7u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "C") == 0);
+}
+
+#if (ENABLE_COROUTINE_TASKS_ROS)
+/* A yielding coroutine carries on from its yield behind the other ready tasks of its priority,
+   and starts from the beginning again once it ends */
+static void TestCoroutineYield(void)
+{
+	MountTables(4u);
+	CHECK_ROS(CreateCoroutineTask_ROS(5u, YieldingCoroutine) == F_TASK_VECTOR_EMPTY_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"yielding", TaskA) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(6u, 10u, 50u, false, (uint8_t *)"task b", TaskB) == SUCCESS_ROS);
+	CHECK_ROS(CreateCoroutineTask_ROS(5u, YieldingCoroutine) == SUCCESS_ROS);
+	CHECK_ROS(CreateCoroutineTask_ROS(5u, YieldingCoroutine) == F_TASK_ALREADY_COROUTINE_ROS);
+
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(6u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "aBbc") == 0);
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "abc") == 0);
+}
+
+/* A sleeping coroutine is queued at its wake tick and carries on from the sleep. Queued early, it
+   goes back to sleep, and a wake tick already reached does not sleep at all */
+static void TestCoroutineSleep(void)
+{
+	MountTables(4u);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"sleeping", TaskA) == SUCCESS_ROS);
+	CHECK_ROS(CreateCoroutineTask_ROS(5u, SleepingCoroutine) == SUCCESS_ROS);
+
+	gWakeTick = gSystemTick_ROS + 3u;
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "s") == 0);
+	TickScheduler_ROS();
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "") == 0);
+	TickScheduler_ROS();
+	CHECK_ROS(strcmp(RunAll(), "") == 0);
+	TickScheduler_ROS();
+	CHECK_ROS(gSystemTick_ROS == gWakeTick);
+	CHECK_ROS(strcmp(RunAll(), "w") == 0);
+
+	gWakeTick = gSystemTick_ROS;
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "sw") == 0);
+}
+
+/* A coroutine waiting on its inbox is queued by the next message addressed to it, and carries on
+   from the wait. It does not wait when a message is already there */
+static void TestCoroutineWaitMessage(void)
+{
+	uint32_t failed_at;
+
+	MountTables(4u);
+	CHECK_ROS(MountMessageFileSystem_ROS(gTestMsgStore, sizeof(gTestMsgStore), 0u, 0u, &failed_at, \
+										 NULL, MSG_MOUNT_TRUSTED_ROS) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"receiving", TaskA) == SUCCESS_ROS);
+	CHECK_ROS(CreateCoroutineTask_ROS(5u, ReceivingCoroutine) == SUCCESS_ROS);
+
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "r") == 0);
+	CHECK_ROS(CreateMessage_ROS(0x20u, 5u, 0u, 1u, (uint8_t *)"x") == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "mx") == 0);
+
+	CHECK_ROS(CreateMessage_ROS(0x21u, 5u, 0u, 1u, (uint8_t *)"y") == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(5u) == SUCCESS_ROS);
+	CHECK_ROS(strcmp(RunAll(), "rmy") == 0);
+}
+#endif
+
+int main(void)
+{
+	TestCreateValidation();
+	TestCapacity();
+	TestControlSleep();
+	TestDispatchOrder();
+	TestDestroyQueued();
+	TestTaskIDReuse();
+#if (ENABLE_COROUTINE_TASKS_ROS)
+	TestCoroutineYield();
+	TestCoroutineSleep();
+	TestCoroutineWaitMessage();
+#endif
+	return CHECK_RESULT_ROS();
+}
@@ -0,0 +1,251 @@
+/*******************************************************************************
+* RataOS Task Scheduler
+* File 				: test_tickless.c
+* Description   	: Tests of the tickless idle mode (ENABLE_TICKLESS_IDLE_ROS,
+*					  schedule.c), on a simulated clock.
+* Revision History	: Unreleased
+* License			: Eclipse Public License
+*					  http://www.opensource.org/licenses/eclipse-1.0.php
+* Author			: Oliver Kent
+* Project Location	: http://rataos.sourceforge.net/
+*******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "tasks.h"
+#include "messages.h"
+#include "check.h"
+
+/* Imported */
+#define SUCCESS_ROS						0x01
+#define TRUE_ROS						0x02
+#define FALSE_ROS						0x03
+#define F_TASK_MEM_TOO_SMALL_ROS		0x0D
+extern uint16_t * gTaskMaxJitterArray_ROS;
+extern uint16_t * gTaskOverrunArray_ROS;
+
+/* Ticks simulated by each run */
+#define RUN_TICKS						3000u
+
+/* Task table memory block, grown to the size the tables report they need
+   (which includes the task stacks in preemptive mode) */
+static uint8_t * gTestTaskMemory;
+static uint32_t gTestTaskMemoryBytes;
+
+/* Message store */
+static uint8_t gTestMsgStore[MSG_FS_BLOCK_BYTES_ROS];
+
+/* Events of a run, in ticks from its start: each periodic task's releases
+   with its overrun count and worst jitter, the sleeping task's wake ups, and
+   the tick the message expired at */
+typedef struct
+{
+	uint32_t releases[3][40];
+	uint8_t num_releases[3];
+	uint16_t overruns[3];
+	uint16_t max_jitter[3];
+	uint32_t wake_ups[3];
+	uint8_t num_wake_ups;
+	uint32_t expired_at;
+} RunTrace;
+
+static RunTrace gTrace;
+static uint32_t gRunStart;
+
+static void RecordRelease(uint8_t task)
+{
+	gTrace.releases[task][gTrace.num_releases[task]++] = gSystemTick_ROS - gRunStart;
+}
+
+static void TaskPeriodic0(void) { RecordRelease(0u); }
+static void TaskPeriodic1(void) { RecordRelease(1u); }
+static void TaskPeriodic2(void) { RecordRelease(2u); }
+static void TaskNone(void) { }
+
+/* Sleeping task, with sleeps crossing level 0 wraps and level 1 slots */
+static bool gIsSleeping;
+static void TaskSleeper(void)
+{
+	static const uint16_t sleeps[3] = { 37u, 413u, 2000u };
+
+	/* Check if the task is woken from a sleep, and record the wake up once
+	   the sleep is over */
+	if(gIsSleeping)
+	{
+		if(ResumeSleep_ROS() != TRUE_ROS)
+		{
+			return;
+		}
+		gIsSleeping = false;
+		gTrace.wake_ups[gTrace.num_wake_ups++] = gSystemTick_ROS - gRunStart;
+	}
+
+	/* Sleep again, until every sleep is done */
+	if(gTrace.num_wake_ups < 3u)
+	{
+		gIsSleeping = (SleepUntilTick_ROS(gSystemTick_ROS + sleeps[gTrace.num_wake_ups]) == \
+					   FALSE_ROS);
+	}
+}
+
+/* Mount fresh task tables, growing the memory block first if it is too
+   small for them */
+static uint8_t MountTaskMemory(TaskID_ROS max_tasks, TaskID_ROS max_task_vectors)
+{
+	uint32_t required;
+	uint8_t result = MountTaskTables_ROS(gTestTaskMemory, gTestTaskMemoryBytes, max_tasks, \
+										 max_task_vectors, &required);
+
+	/* Check if the block was too small, and mount again in a big enough one */
+	if(result == F_TASK_MEM_TOO_SMALL_ROS)
+	{
+		free(gTestTaskMemory);
+		gTestTaskMemory = malloc(required);
+		gTestTaskMemoryBytes = (gTestTaskMemory != NULL) ? required : 0u;
+		result = MountTaskTables_ROS(gTestTaskMemory, gTestTaskMemoryBytes, max_tasks, \
+									 max_task_vectors, &required);
+	}
+	return result;
+}
+
+/* Dispatch until nothing is ready, and note when the message expired */
+static void RunReady(void)
+{
+	while(DispatchTask_ROS() == SUCCESS_ROS)
+	{
+	}
+	if((gTrace.expired_at == 0u) && (NextMessageExpiry_ROS() == 0xFFFFFFFFul))
+	{
+		gTrace.expired_at = gSystemTick_ROS - gRunStart;
+	}
+}
+
+/* Mount fresh tables, set up three periodic tasks, a sleeping task and a
+   message with a time to live, and run what is ready */
+static void SetUpRun(void)
+{
+	uint32_t failed_at;
+	uint8_t data[4] = { 1u, 2u, 3u, 4u };
+
+	memset(&gTrace, 0, sizeof(gTrace));
+	gIsSleeping = false;
+	CHECK_ROS(MountTaskMemory(8u, 16u) == SUCCESS_ROS);
+	CHECK_ROS(MountMessageFileSystem_ROS(gTestMsgStore, sizeof(gTestMsgStore), 0u, 0u, \
+										 &failed_at, NULL, MSG_MOUNT_TRUSTED_ROS) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"periodic0", TaskPeriodic0) == \
+			  SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(6u, 20u, 50u, false, (uint8_t *)"periodic1", TaskPeriodic1) == \
+			  SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(7u, 30u, 50u, false, (uint8_t *)"periodic2", TaskPeriodic2) == \
+			  SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(8u, 40u, 50u, false, (uint8_t *)"sleeper", TaskSleeper) == \
+			  SUCCESS_ROS);
+
+	gRunStart = gSystemTick_ROS;
+	CHECK_ROS(CreatePeriodicTask_ROS(5u, 100u, 3u) == SUCCESS_ROS);
+	CHECK_ROS(CreatePeriodicTask_ROS(6u, 250u, 1u) == SUCCESS_ROS);
+	CHECK_ROS(CreatePeriodicTask_ROS(7u, 4000u, 1700u) == SUCCESS_ROS);
+	CHECK_ROS(QueueTask_ROS(8u) == SUCCESS_ROS);
+	CHECK_ROS(CreateMessage_ROS(0x30u, MSG_TARG_GLOBAL_ROS, 200u, 4u, data) == SUCCESS_ROS);
+	RunReady();
+}
+
+/* Keep the periodic tasks' statistics of a finished run */
+static void FinishRun(void)
+{
+	uint8_t i;
+
+	for(i = 0u; i < 3u; i++)
+	{
+		gTrace.overruns[i] = gTaskOverrunArray_ROS[gTaskVectorLookupArray_ROS[5u + i]];
+		gTrace.max_jitter[i] = gTaskMaxJitterArray_ROS[gTaskVectorLookupArray_ROS[5u + i]];
+	}
+}
+
+/* Run with the tick running */
+static void RunTicked(RunTrace *trace)
+{
+	SetUpRun();
+	while((gSystemTick_ROS - gRunStart) < RUN_TICKS)
+	{
+		TickScheduler_ROS();
+		(void)TickMessageExpiry_ROS();
+		RunReady();
+	}
+	FinishRun();
+	*trace = gTrace;
+}
+
+/* Run with the tick stopped while idle, sleeping until each next event. An
+   early wake up sleeps for half the ticks expected, once */
+static void RunTickless(RunTrace *trace, bool is_woken_early)
+{
+	uint32_t next_event;
+
+	SetUpRun();
+	while(((gSystemTick_ROS - gRunStart) + (next_event = NextSchedulerEvent_ROS())) <= RUN_TICKS)
+	{
+		CHECK_ROS(next_event != 0u);
+		if(next_event == 0u)
+		{
+			break;
+		}
+		if(is_woken_early && (next_event > 5u))
+		{
+			next_event /= 2u;
+			is_woken_early = false;
+		}
+		StepScheduler_ROS(next_event);
+		RunReady();
+	}
+	FinishRun();
+	*trace = gTrace;
+}
+
+/* Sleeping through idle ticks releases, wakes and expires the same as
+   ticking through them */
+static void TestMatchesTickedRun(void)
+{
+	static RunTrace ticked, tickless;
+
+	RunTicked(&ticked);
+	CHECK_ROS(ticked.num_releases[0] == 30u);
+	CHECK_ROS(ticked.releases[0][0] == 3u);
+	CHECK_ROS(ticked.num_releases[1] == 12u);
+	CHECK_ROS((ticked.num_releases[2] == 1u) && (ticked.releases[2][0] == 1700u));
+	CHECK_ROS(ticked.num_wake_ups == 3u);
+	CHECK_ROS(ticked.wake_ups[2] == 2450u);
+	CHECK_ROS(ticked.expired_at == 200u);
+
+	RunTickless(&tickless, false);
+	CHECK_ROS(memcmp(&ticked, &tickless, sizeof(ticked)) == 0);
+	RunTickless(&tickless, true);
+	CHECK_ROS(memcmp(&ticked, &tickless, sizeof(ticked)) == 0);
+}
+
+/* A level 1 timer cascaded at the level 0 wrap ahead is found before a later
+   level 0 timer past the wrap */
+static void TestNextEventAcrossWrap(void)
+{
+	CHECK_ROS(MountTaskMemory(8u, 16u) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(5u, 10u, 50u, false, (uint8_t *)"level1", TaskNone) == SUCCESS_ROS);
+	CHECK_ROS(CreateTask_ROS(6u, 10u, 50u, false, (uint8_t *)"level0", TaskNone) == SUCCESS_ROS);
+	while((gSystemTick_ROS & 63u) != 0u)
+	{
+		TickScheduler_ROS();
+	}
+
+	/* From tick 0 of a wrap: a timer due at 128 goes to level 1. At 100, a
+	   timer due at 130 goes to level 0 */
+	CHECK_ROS(CreatePeriodicTask_ROS(5u, 1000u, 128u) == SUCCESS_ROS);
+	StepScheduler_ROS(100u);
+	CHECK_ROS(CreatePeriodicTask_ROS(6u, 1000u, 30u) == SUCCESS_ROS);
+	CHECK_ROS(NextSchedulerEvent_ROS() == 28u);
+}
+
+int main(void)
+{
+	TestMatchesTickedRun();
+	TestNextEventAcrossWrap();
+	return CHECK_RESULT_ROS();
+}